@@ -36,6 +36,7 @@
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/MoveTypes/MoveType.h"
 #include "Sim/Path/IPathManager.h"
+#include "Sim/Path/PathTelemetry.h"
 #include "Game/UI/Groups/Group.h"
 #include "Game/UI/Groups/GroupHandler.h"
 #include "Sim/Units/CommandAI/CommandAI.h"
@@ -693,6 +694,7 @@ bool CAICallback::IsUnitNeutral(int unitId) {
 int CAICallback::InitPath(const float3& start, const float3& end, int pathType, float goalRadius)
 {
 	assert(((size_t)pathType) < moveDefHandler.GetNumMoveDefs());
+	const CPathTelemetry::ScopedCaller telemetryCaller(CPathTelemetry::CALLER_AI);
 	return pathManager->RequestPath(nullptr, moveDefHandler.GetMoveDefByPathType(pathType), start, end, goalRadius, false);
 }
 
@@ -44,6 +44,7 @@
 #include "Rendering/TeamHighlight.h"
 #include "Rendering/UnitDrawer.h"
 #include "Rendering/Map/InfoTexture/IInfoTextureHandler.h"
+#include "Rendering/Models/IModelParser.h"
 #include "Rendering/Textures/NamedTextures.h"
 #include "Lua/LuaGaia.h"
 #include "Lua/LuaHandle.h"
@@ -77,8 +78,10 @@
 #include "Sim/Misc/Wind.h"
 #include "Sim/Misc/ResourceHandler.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
+#include "Sim/MoveTypes/MoveMath/MoveMath.h"
 #include "Sim/MoveTypes/MoveTypeFactory.h"
 #include "Sim/Path/IPathManager.h"
+#include "Sim/Path/PathTelemetry.h"
 #include "Sim/Projectiles/ExplosionGenerator.h"
 #include "Sim/Projectiles/Projectile.h"
 #include "Sim/Projectiles/ProjectileHandler.h"
@@ -467,7 +470,7 @@ void CGame::LoadMap(const std::string& mapFileName)
 
 		// half size; building positions are snapped to multiples of BUILD_SQUARE_SIZE
 		buildingMaskMap.Init(mapDims.hmapx * mapDims.hmapy);
-		groundBlockingObjectMap.Init(mapDims.mapSquares);
+		groundBlockingObjectMap.Init(mapDims.mapx, mapDims.mapy);
 	}
 
 	LEAVE_SYNCED_CODE();
@@ -585,7 +588,7 @@ void CGame::PostLoadSimulation(LuaParser* defsParser)
 	projectileHandler.Init();
 	CLosHandler::InitStatic();
 
-	readMap->InitHeightMapDigestVectors(losHandler->los.size);
+	readMap->InitHeightMapChangeTracking();
 
 	// pre-load the PFS, gets finalized after Lua
 	//
@@ -605,6 +608,9 @@ void CGame::PostLoadSimulation(LuaParser* defsParser)
 	//   --> need a way to let Lua flush it or re-calculate map
 	//   checksum (over heightmap + blockmap, not raw archive)
 	mapDamage = IMapDamage::InitMapDamage();
+
+	CMoveMath::InitSpeedModCache();
+	pathTelemetry.Init(moveDefHandler.GetNumMoveDefs());
 	pathManager = IPathManager::GetInstance(modInfo.pathFinderSystem);
 
 	// load map-specific features
@@ -790,6 +796,8 @@ void CGame::LoadFinalize()
 		);
 	}
 
+	modelLoader.LogPreloadStats();
+
 	lastReadNetTime = spring_gettime();
 	lastSimFrameTime = lastReadNetTime;
 	lastDrawFrameTime = lastReadNetTime;
@@ -894,6 +902,8 @@ void CGame::KillSimulation()
 	LOG("[Game::%s][3]", __func__);
 	IPathManager::FreeInstance(pathManager);
 	IMapDamage::FreeMapDamage(mapDamage);
+	CMoveMath::KillSpeedModCache();
+	pathTelemetry.Kill();
 
 	spring::SafeDelete(readMap);
 	smoothGround.Kill();
@@ -1179,9 +1189,14 @@ void CGame::SimFrame() {
 
 		helper->Update();
 		mapDamage->Update();
+		smoothGround.Update(gs->frameNum);
 		pathManager->Update();
 		unitHandler.Update();
+		// cluster-munitions and chain-reactions tend to produce many
+		// overlapping explosions here; apply those in per-wave batches
+		helper->BeginExplosionBatch();
 		projectileHandler.Update();
+		helper->EndExplosionBatch();
 		featureHandler.Update();
 		{
 			SCOPED_TIMER("Sim::Script");
@@ -1199,6 +1214,8 @@ void CGame::SimFrame() {
 		playerHandler.GameFrame(gs->frameNum);
 	}
 
+	StreamTeamStats();
+
 	lastSimFrameTime = spring_gettime();
 	gu->avgSimFrameTime = mix(gu->avgSimFrameTime, (lastSimFrameTime - lastFrameTime).toMilliSecsf(), 0.05f);
 	gu->avgSimFrameTime = std::max(gu->avgSimFrameTime, 0.001f);
@@ -1280,11 +1297,53 @@ void CGame::GameEnd(const std::vector<unsigned char>& winningAllyTeams, bool tim
 	}
 	for (int i = 0; i < numTeams; ++i) {
 		const CTeam* team = teamHandler.Team(i);
-		record->SetTeamStats(i, team->statHistory);
+
+		// closed snapshots were streamed in by StreamTeamStats, add the running totals
+		if (record->GetNumTeamStats(i) == 0)
+			team->statHistory.ForEach(0, team->statHistory.size(), [&](const TeamStatistics& stats) { record->AddTeamStats(i, stats); });
+
+		record->AddTeamStats(i, team->GetCurrentStats());
 		clientNet->Send(CBaseNetProtocol::Get().SendTeamStat(team->teamNum, team->GetCurrentStats()));
 	}
 }
 
+void CGame::StreamTeamStats()
+{
+	// GameEnd has written the final running totals, nothing may follow them
+	if (gameOver)
+		return;
+	if ((gs->frameNum % TEAM_SLOWUPDATE_RATE) != 0)
+		return;
+
+	CDemoRecorder* record = clientNet->GetDemoRecorder();
+
+	const int numTeams = teamHandler.ActiveTeams() - int(gs->useLuaGaia);
+
+	for (int i = 0; i < numTeams; ++i) {
+		const CTeam* team = teamHandler.Team(i);
+		const CTeamStatsHistory& history = team->statHistory;
+
+		// nothing to emit unless SlowUpdate closed a snapshot this frame
+		if (history.GetLastFrame() != gs->frameNum)
+			continue;
+
+		const TeamStatistics stats = history.Back();
+
+		if (record != nullptr && record->IsValid()) {
+			// recording can start after the game did (e.g. when loading a save)
+			if (record->GetNumTeamStats(i) == 0) {
+				history.ForEach(0, history.size(), [&](const TeamStatistics& s) { record->AddTeamStats(i, s); });
+			} else {
+				record->AddTeamStats(i, stats);
+			}
+		}
+
+		// live stats for the autohost; every player reports its own team
+		if (i == gu->myTeam && !gu->spectating)
+			clientNet->Send(CBaseNetProtocol::Get().SendTeamStat(team->teamNum, stats));
+	}
+}
+
 void CGame::SendNetChat(std::string message, int destination)
 {
 	if (message.empty())
@@ -123,6 +123,7 @@ private:
 	void UpdateNumQueuedSimFrames();
 	void UpdateNetMessageProcessingTimeLeft();
 	void SimFrame();
+	void StreamTeamStats();
 	void StartPlaying();
 
 public:
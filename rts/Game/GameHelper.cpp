@@ -12,6 +12,7 @@
 #include "Rendering/Models/3DModel.h"
 #include "Sim/Features/Feature.h"
 #include "Sim/Features/FeatureDef.h"
+#include "Sim/Features/FeatureHandler.h"
 #include "Sim/Misc/BuildingMaskMap.h"
 #include "Sim/Misc/CollisionHandler.h"
 #include "Sim/Misc/CollisionVolume.h"
@@ -39,6 +40,8 @@
 #include "System/SpringMath.h"
 #include "System/Sound/ISoundChannels.h"
 
+#include <algorithm>
+
 
 static CGameHelper gGameHelper;
 CGameHelper* helper = &gGameHelper;
@@ -50,6 +53,13 @@ void CGameHelper::Init()
 		wdVec.clear();
 		wdVec.reserve(32);
 	}
+
+	queuedExplosions.clear();
+	queuedExplosions.reserve(64);
+	explosionWave.clear();
+	explosionWave.reserve(64);
+
+	explosionBatchDepth = 0;
 }
 
 void CGameHelper::Update()
@@ -193,45 +203,181 @@ void CGameHelper::DoExplosionDamage(
 
 
 
-void CGameHelper::DamageObjectsInExplosionRadius(
-	const CExplosionParams& params,
-	const float expRad,
-	const int weaponDefID
-) {
-	static std::vector<CUnit*> unitCache;
-	static std::vector<CFeature*> featureCache;
+CGameHelper::QueuedExplosion::QueuedExplosion(const CExplosionParams& params)
+	: pos(params.pos)
+	, dir(params.dir)
+	, damages(params.damages)
+	, weaponDef(params.weaponDef)
+	, ownerID((params.owner != nullptr)? params.owner->id: -1)
+	, hitUnitID((params.hitUnit != nullptr)? params.hitUnit->id: -1)
+	, hitFeatureID((params.hitFeature != nullptr)? params.hitFeature->id: -1)
+	, craterAreaOfEffect(params.craterAreaOfEffect)
+	, damageAreaOfEffect(params.damageAreaOfEffect)
+	, edgeEffectiveness(params.edgeEffectiveness)
+	, explosionSpeed(params.explosionSpeed)
+	, gfxMod(params.gfxMod)
+	, impactOnly(params.impactOnly)
+	, ignoreOwner(params.ignoreOwner)
+	, damageGround(params.damageGround)
+	, projectileID(params.projectileID)
+{}
+
+
+void CGameHelper::DamageObjectsInExplosionRadii(const std::vector<QueuedExplosion>& explosions)
+{
+	// (quadIdx << 32 | expIdx)
+	static std::vector<std::uint64_t> explosionQuads;
+
+	explosionQuads.clear();
+	explosionUnitPairs.clear();
+	explosionFeaturePairs.clear();
+
+	for (unsigned int n = 0; n < explosions.size(); n++) {
+		const QueuedExplosion& e = explosions[n];
+
+		if (e.impactOnly)
+			continue;
+
+		QuadFieldQuery qfQuery;
+		quadField.GetQuads(qfQuery, e.pos, std::max(1.0f, e.damageAreaOfEffect));
+
+		for (const int qi: *qfQuery.quads) {
+			explosionQuads.push_back((std::uint64_t(qi) << 32) | n);
+		}
+	}
+
+	// group explosions by quad, such that the objects in each quad
+	// are visited once per wave rather than once per explosion
+	std::sort(explosionQuads.begin(), explosionQuads.end());
+
+	for (size_t i = 0, j = 0; i < explosionQuads.size(); i = j) {
+		const unsigned int qi = explosionQuads[i] >> 32;
+
+		for (j = i + 1; j < explosionQuads.size() && (explosionQuads[j] >> 32) == qi; j++);
 
-	const unsigned int oldNumUnits = unitCache.size();
-	const unsigned int oldNumFeatures = featureCache.size();
+		const CQuadField::Quad& quad = quadField.GetQuad(qi);
 
-	quadField.GetUnitsAndFeaturesColVol(params.pos, expRad, unitCache, featureCache);
+		for (const CUnit* u: quad.units) {
+			const CollisionVolume* colvol = &u->collisionVolume;
+			const float3 colvolPos = colvol->GetWorldSpacePos(u);
 
-	const unsigned int newNumUnits = unitCache.size();
-	const unsigned int newNumFeatures = featureCache.size();
+			for (size_t k = i; k < j; k++) {
+				const unsigned int n = explosionQuads[k] & 0xFFFFFFFF;
+				const float totRad = std::max(1.0f, explosions[n].damageAreaOfEffect) + colvol->GetBoundingRadius();
 
-	// damage all units within the explosion radius
-	// NOTE:
-	//   this can recursively trigger ::Explosion() again
-	//   which would overwrite our object cache if we did
-	//   not keep track of end-markers --> certain objects
-	//   would not be damaged AT ALL (!)
-	for (unsigned int n = oldNumUnits; n < newNumUnits; n++)
-		DoExplosionDamage(unitCache[n], params.owner, params.pos, expRad, params.explosionSpeed, params.edgeEffectiveness, params.ignoreOwner, params.damages, weaponDefID, params.projectileID);
+				if (explosions[n].pos.SqDistance(colvolPos) >= (totRad * totRad))
+					continue;
+
+				explosionUnitPairs.push_back((std::uint64_t(n) << 32) | u->id);
+			}
+		}
+
+		for (const CFeature* f: quad.features) {
+			const CollisionVolume* colvol = &f->collisionVolume;
+			const float3 colvolPos = colvol->GetWorldSpacePos(f);
 
-	unitCache.resize(oldNumUnits);
+			for (size_t k = i; k < j; k++) {
+				const unsigned int n = explosionQuads[k] & 0xFFFFFFFF;
+				const float totRad = std::max(1.0f, explosions[n].damageAreaOfEffect) + colvol->GetBoundingRadius();
+
+				if (explosions[n].pos.SqDistance(colvolPos) >= (totRad * totRad))
+					continue;
+
+				explosionFeaturePairs.push_back((std::uint64_t(n) << 32) | f->id);
+			}
+		}
+	}
 
-	// damage all features within the explosion radius
-	for (unsigned int n = oldNumFeatures; n < newNumFeatures; n++)
-		DoExplosionDamage(featureCache[n], params.owner, params.pos, expRad, params.edgeEffectiveness, params.damages, weaponDefID, params.projectileID);
+	// damage is applied per explosion in order of arrival, then by object
+	// ID; objects spanning multiple quads of one explosion appear twice
+	std::sort(explosionUnitPairs.begin(), explosionUnitPairs.end());
+	std::sort(explosionFeaturePairs.begin(), explosionFeaturePairs.end());
 
-	featureCache.resize(oldNumFeatures);
+	explosionUnitPairs.erase(std::unique(explosionUnitPairs.begin(), explosionUnitPairs.end()), explosionUnitPairs.end());
+	explosionFeaturePairs.erase(std::unique(explosionFeaturePairs.begin(), explosionFeaturePairs.end()), explosionFeaturePairs.end());
 }
 
+
 void CGameHelper::Explosion(const CExplosionParams& params) {
-	const DamageArray& damages = params.damages;
+	queuedExplosions.emplace_back(params);
 
-	// if weaponDef is NULL, this is a piece-explosion
-	// (implicit damage-type -DAMAGE_EXPLOSION_DEBRIS)
+	if (explosionBatchDepth > 0)
+		return;
+
+	// not batching, apply right away as a wave of one
+	BeginExplosionBatch();
+	EndExplosionBatch();
+}
+
+void CGameHelper::EndExplosionBatch()
+{
+	assert(explosionBatchDepth > 0);
+
+	if (explosionBatchDepth > 1) {
+		explosionBatchDepth -= 1;
+		return;
+	}
+
+	// stay in batching mode while applying; explosions raised by the
+	// current wave (chain-reactions via unit deaths, Lua call-ins) are
+	// queued and form the next wave instead of recursing
+	while (!queuedExplosions.empty()) {
+		explosionWave.swap(queuedExplosions);
+		ApplyExplosions(explosionWave);
+		explosionWave.clear();
+	}
+
+	explosionBatchDepth = 0;
+}
+
+void CGameHelper::ApplyExplosions(const std::vector<QueuedExplosion>& explosions)
+{
+	static std::vector<ExplosionEvent> events;
+	static std::vector<bool> noGfx;
+
+	events.clear();
+	events.reserve(explosions.size());
+
+	for (const QueuedExplosion& e: explosions) {
+		// if weaponDef is NULL, this is a piece-explosion
+		// (implicit damage-type -DAMAGE_EXPLOSION_DEBRIS)
+		const int weaponDefID = (e.weaponDef != nullptr)? e.weaponDef->id: -CSolidObject::DAMAGE_EXPLOSION_DEBRIS;
+
+		events.push_back({weaponDefID, int(e.projectileID), e.pos, unitHandler.GetUnit(e.ownerID)});
+	}
+
+	// NOTE: events trigger (in one go) before damage is applied to objects
+	eventHandler.Explosions(events, noGfx);
+
+	DamageObjectsInExplosionRadii(explosions);
+
+	for (unsigned int n = 0; n < explosions.size(); n++) {
+		const QueuedExplosion& e = explosions[n];
+		const CExplosionParams params = {
+			e.pos,
+			e.dir,
+			e.damages,
+			e.weaponDef,
+			unitHandler.GetUnit(e.ownerID),
+			unitHandler.GetUnit(e.hitUnitID),
+			featureHandler.GetFeature(e.hitFeatureID),
+			e.craterAreaOfEffect,
+			e.damageAreaOfEffect,
+			e.edgeEffectiveness,
+			e.explosionSpeed,
+			e.gfxMod,
+			e.impactOnly,
+			e.ignoreOwner,
+			e.damageGround,
+			e.projectileID
+		};
+
+		ApplyExplosion(params, noGfx[n], n);
+	}
+}
+
+void CGameHelper::ApplyExplosion(const CExplosionParams& params, bool noGfx, unsigned int expIdx) {
+	const DamageArray& damages = params.damages;
 	const WeaponDef* weaponDef = params.weaponDef;
 
 	const int weaponDefID = (weaponDef != nullptr)? weaponDef->id: -CSolidObject::DAMAGE_EXPLOSION_DEBRIS;
@@ -244,9 +390,6 @@ void CGameHelper::Explosion(const CExplosionParams& params) {
 	const float realHeight = CGround::GetHeightReal(params.pos);
 	const float altitude = (params.pos).y - realHeight;
 
-	// NOTE: event triggers before damage is applied to objects
-	const bool noGfx = eventHandler.Explosion(weaponDefID, params.projectileID, params.pos, params.owner);
-
 	if (luaUI != nullptr && weaponDef != nullptr)
 		luaUI->ShockFront(params.pos, weaponDef->cameraShake, damageAOE);
 
@@ -279,7 +422,26 @@ void CGameHelper::Explosion(const CExplosionParams& params) {
 			);
 		}
 	} else {
-		DamageObjectsInExplosionRadius(params, damageAOE, weaponDefID);
+		// damage all objects within the explosion radius, gathered
+		// (and ordered) for the whole wave by DamageObjectsInExplosionRadii
+		// NOTE: units killed by an earlier explosion of the same wave are
+		// still included, DoDamage ignores them
+		const std::uint64_t minKey = std::uint64_t(expIdx    ) << 32;
+		const std::uint64_t maxKey = std::uint64_t(expIdx + 1) << 32;
+
+		const auto unitPairsBeg = std::lower_bound(explosionUnitPairs.begin(), explosionUnitPairs.end(), minKey);
+		const auto unitPairsEnd = std::lower_bound(unitPairsBeg, explosionUnitPairs.end(), maxKey);
+
+		for (auto it = unitPairsBeg; it != unitPairsEnd; ++it) {
+			DoExplosionDamage(unitHandler.GetUnit(*it & 0xFFFFFFFF), params.owner, params.pos, damageAOE, params.explosionSpeed, params.edgeEffectiveness, params.ignoreOwner, params.damages, weaponDefID, params.projectileID);
+		}
+
+		const auto featurePairsBeg = std::lower_bound(explosionFeaturePairs.begin(), explosionFeaturePairs.end(), minKey);
+		const auto featurePairsEnd = std::lower_bound(featurePairsBeg, explosionFeaturePairs.end(), maxKey);
+
+		for (auto it = featurePairsBeg; it != featurePairsEnd; ++it) {
+			DoExplosionDamage(featureHandler.GetFeature(*it & 0xFFFFFFFF), params.owner, params.pos, damageAOE, params.edgeEffectiveness, params.damages, weaponDefID, params.projectileID);
+		}
 
 		// deform the map if the explosion was above-ground
 		// (but had large enough radius to touch the ground)
@@ -958,23 +1120,10 @@ float3 CGameHelper::ClosestBuildPos(
 		int xmax = std::min(mapDims.mapx, xsqr + (xsize + 1) / 2 + minDistance);
 		int zmax = std::min(mapDims.mapy, zsqr + (zsize + 1) / 2 + minDistance);
 
-		bool free = true;
-
-		// check for nearby blocking objects
-		for (int z = zmin; z < zmax; ++z) {
-			for (int x = xmin; x < xmax; ++x) {
-				const CSolidObject* solObj = groundBlockingObjectMap.GroundBlockedUnsafe(z * mapDims.mapx + x);
-
-				if (solObj == nullptr)
-					continue;
-				// immobile=true implies Feature or Building
-				if (!solObj->immobile)
-					continue;
-
-				free = false;
-				break;
-			}
-		}
+		// check for nearby blocking objects; immobile=true implies Feature or Building
+		bool free = !groundBlockingObjectMap.FindOccupiedSquare(xmin, zmin, xmax, zmax, [](unsigned int mapSquare) {
+			return (groundBlockingObjectMap.GroundBlockedUnsafe(mapSquare)->immobile);
+		});
 
 		if (free) {
 			xmin = std::max(           0, xmin - 2);
@@ -983,21 +1132,10 @@ float3 CGameHelper::ClosestBuildPos(
 			zmax = std::min(mapDims.mapy, zmax + 2);
 
 			// none found, check for nearby factories with open yards
-			for (int z = zmin; z < zmax; ++z) {
-				for (int x = xmin; x < xmax; ++x) {
-					const CSolidObject* solObj = groundBlockingObjectMap.GroundBlockedUnsafe(z * mapDims.mapx + x);
-
-					if (solObj == nullptr)
-						continue;
-					if (!solObj->immobile)
-						continue;
-					if (!solObj->yardOpen)
-						continue;
-
-					free = false;
-					break;
-				}
-			}
+			free = !groundBlockingObjectMap.FindOccupiedSquare(xmin, zmin, xmax, zmax, [](unsigned int mapSquare) {
+				const CSolidObject* solObj = groundBlockingObjectMap.GroundBlockedUnsafe(mapSquare);
+				return (solObj->immobile && solObj->yardOpen);
+			});
 		}
 
 		if (free)
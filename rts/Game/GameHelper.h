@@ -10,6 +10,7 @@
 #include "System/type2.h"
 
 #include <array>
+#include <cinttypes>
 #include <vector>
 
 
@@ -156,9 +157,43 @@ public:
 		const int projectileID
 	);
 
-	void DamageObjectsInExplosionRadius(const CExplosionParams& params, const float expRad, const int weaponDefID);
 	void Explosion(const CExplosionParams& params);
 
+	// explosions raised between Begin and End are queued and applied
+	// together (in order of arrival) when the outermost batch ends
+	void BeginExplosionBatch() { explosionBatchDepth += 1; }
+	void EndExplosionBatch();
+
+private:
+	struct QueuedExplosion {
+		QueuedExplosion(const CExplosionParams& params);
+
+		float3 pos;
+		float3 dir;
+		DamageArray damages;
+		const WeaponDef* weaponDef;
+
+		int ownerID;
+		int hitUnitID;
+		int hitFeatureID;
+
+		float craterAreaOfEffect;
+		float damageAreaOfEffect;
+		float edgeEffectiveness;
+		float explosionSpeed;
+		float gfxMod;
+
+		bool impactOnly;
+		bool ignoreOwner;
+		bool damageGround;
+
+		unsigned int projectileID;
+	};
+
+	void ApplyExplosions(const std::vector<QueuedExplosion>& explosions);
+	void ApplyExplosion(const CExplosionParams& params, bool noGfx, unsigned int expIdx);
+	void DamageObjectsInExplosionRadii(const std::vector<QueuedExplosion>& explosions);
+
 private:
 	struct WaitingDamage {
 		WaitingDamage(const DamageArray& _damage, const float3& _impulse, int _attackerID, int _targetID, int _weaponID, int _projectileID)
@@ -182,6 +217,15 @@ private:
 	// note: size must be a power of two
 	std::array<std::vector<WaitingDamage>, 128> waitingDamages;
 
+	std::vector<QueuedExplosion> queuedExplosions;
+	std::vector<QueuedExplosion> explosionWave;
+
+	// (expIdx << 32 | objectID), sorted; filled per wave
+	std::vector<std::uint64_t> explosionUnitPairs;
+	std::vector<std::uint64_t> explosionFeaturePairs;
+
+	unsigned int explosionBatchDepth = 0;
+
 public:
 	std::vector<int> targetUnitIDs; // GetEnemyUnits{NoLosTest}
 	std::vector<std::pair<float, CUnit*>> targetPairs; // GenerateWeaponTargets
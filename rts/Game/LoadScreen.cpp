@@ -149,6 +149,25 @@ void CLoadScreen::Kill()
 	gameLoadThread.join();
 
 	CglFont::threadSafety = false;
+
+	LogLoadPhases();
+}
+
+void CLoadScreen::LogLoadPhases() const
+{
+	if (loadPhases.empty())
+		return;
+
+	const spring_time endTime = spring_now();
+
+	LOG("[LoadScreen::%s] %ums total", __func__, unsigned((endTime - loadPhases.front().second).toMilliSecsi()));
+
+	for (size_t n = 0, k = loadPhases.size(); n < k; n++) {
+		const spring_time phaseEnd = (n + 1 < k)? loadPhases[n + 1].second: endTime;
+		const spring_time phaseDur = phaseEnd - loadPhases[n].second;
+
+		LOG("\t%6ums \"%s\"", unsigned(phaseDur.toMilliSecsi()), loadPhases[n].first.c_str());
+	}
 }
 
 
@@ -304,6 +323,9 @@ void CLoadScreen::SetLoadMessage(const std::string& text, bool replaceLast)
 
 	loadMessages.emplace_back(text, replaceLast);
 
+	if (!replaceLast)
+		loadPhases.emplace_back(text, spring_now());
+
 	LOG("[LoadScreen::%s] text=\"%s\"", __func__, text.c_str());
 	LOG_CLEANUP();
 
@@ -44,11 +44,15 @@ public:
 private:
 	CLoadScreen(std::string&& mapFileName, std::string&& modFileName, ILoadSaveHandler* saveFile);
 
+	void LogLoadPhases() const;
+
 	static CLoadScreen* singleton;
 
 	ILoadSaveHandler* saveFile;
 
 	std::vector< std::pair<std::string, bool> > loadMessages;
+	// start-time of each phase, delimited by non-replacing messages
+	std::vector< std::pair<std::string, spring_time> > loadPhases;
 
 	std::string mapFileName;
 	std::string modFileName;
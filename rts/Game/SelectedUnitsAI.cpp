@@ -17,6 +17,15 @@
 #include "Sim/Units/Unit.h"
 #include "Sim/Units/UnitDef.h"
 #include "Net/Protocol/NetProtocol.h"
+#include "System/Threading/ThreadPool.h"
+
+#include <cinttypes>
+#include <limits>
+
+// formation rows are split into chunks of at most this many slots, each of
+// which is matched optimally (O(n^3)) against the units nearest to it along
+// the front; keeps a 500-unit line order bounded instead of O(500^3)
+#define FORMATION_ASSIGN_CHUNK_SIZE 48
 
 static constexpr int CMDPARAM_MOVE_X = 0;
 static constexpr int CMDPARAM_MOVE_Y = 1;
@@ -32,6 +41,81 @@ static const auto idPairComp = [](const std::pair<float, int>& a, const std::pai
 CSelectedUnitsHandlerAI selectedUnitsAI;
 
 
+// minimum-cost perfect matching of <n> units (rows) to <n> slots (columns)
+// via the Hungarian method; costs are integral so the result is identical
+// on every client regardless of which thread computes it
+static void SolveFormationAssignment(const std::vector<std::int64_t>& costs, size_t n, std::vector<size_t>& slotUnits)
+{
+	constexpr std::int64_t INF = std::numeric_limits<std::int64_t>::max() / 4;
+
+	std::vector<std::int64_t> u(n + 1, 0);
+	std::vector<std::int64_t> v(n + 1, 0);
+	std::vector<std::int64_t> minv(n + 1, INF);
+
+	std::vector<size_t> p(n + 1, 0);
+	std::vector<size_t> way(n + 1, 0);
+	std::vector<bool> used(n + 1, false);
+
+	for (size_t i = 1; i <= n; i++) {
+		size_t j0 = 0;
+
+		p[0] = i;
+
+		std::fill(minv.begin(), minv.end(), INF);
+		std::fill(used.begin(), used.end(), false);
+
+		do {
+			const size_t i0 = p[j0];
+
+			std::int64_t delta = INF;
+			size_t j1 = 0;
+
+			used[j0] = true;
+
+			for (size_t j = 1; j <= n; j++) {
+				if (used[j])
+					continue;
+
+				const std::int64_t cur = costs[(i0 - 1) * n + (j - 1)] - u[i0] - v[j];
+
+				if (cur < minv[j]) {
+					minv[j] = cur;
+					way[j] = j0;
+				}
+				if (minv[j] < delta) {
+					delta = minv[j];
+					j1 = j;
+				}
+			}
+
+			for (size_t j = 0; j <= n; j++) {
+				if (used[j]) {
+					u[p[j]] += delta;
+					v[j] -= delta;
+				} else {
+					minv[j] -= delta;
+				}
+			}
+
+			j0 = j1;
+		} while (p[j0] != 0);
+
+		// augment along the alternating path
+		do {
+			const size_t j1 = way[j0];
+			p[j0] = p[j1];
+			j0 = j1;
+		} while (j0 != 0);
+	}
+
+	slotUnits.resize(n);
+
+	for (size_t j = 1; j <= n; j++) {
+		slotUnits[j - 1] = p[j] - 1;
+	}
+}
+
+
 inline void CSelectedUnitsHandlerAI::SetUnitWantedMaxSpeedNet(CUnit* unit)
 {
 	AMoveType* mt = unit->moveType;
@@ -353,6 +437,12 @@ void CSelectedUnitsHandlerAI::MakeFormationFrontOrder(Command* c, int playerNum)
 	sortedUnitGroups.clear();
 	frontMoveCommands.clear();
 
+	formationCommands.clear();
+	formationUnitIDs.clear();
+	formationSlotGroups.clear();
+	formationRowOffsets.clear();
+	formationRowOffsets.push_back(0);
+
 	CreateUnitOrder(sortedUnitPairs, playerNum);
 
 	for (size_t k = 0; k < sortedUnitPairs.size(); ) {
@@ -425,18 +515,115 @@ void CSelectedUnitsHandlerAI::MakeFormationFrontOrder(Command* c, int playerNum)
 			const auto& groupUnitIDs = groupPair.second;
 
 			mixedUnitIDs.push_back(groupUnitIDs[unitIndex]);
+			formationSlotGroups.push_back(bestGroupNum);
 		}
 
+		// the mixing fixes which group fills each slot; which of the group's
+		// units goes to which of these slots is decided below
 		for (size_t i = 0; i < frontMoveCommands.size(); i++) {
-			CUnit* unit = unitHandler.GetUnit(mixedUnitIDs[i]);
-			CCommandAI* cai = unit->commandAI;
-
-			cai->GiveCommand(frontMoveCommands[i].second, playerNum, false, false);
+			formationCommands.push_back(std::move(frontMoveCommands[i].second));
+			formationUnitIDs.push_back(mixedUnitIDs[i]);
 		}
 
+		formationRowOffsets.push_back(formationCommands.size());
+
 		frontMoveCommands.clear();
 		sortedUnitGroups.clear();
 	}
+
+	AssignFormationSlots(formationSideDir, !!(c->GetOpts() & SHIFT_KEY));
+
+	for (size_t i = 0; i < formationCommands.size(); i++) {
+		CUnit* unit = unitHandler.GetUnit(formationSlotUnitIDs[i]);
+		CCommandAI* cai = unit->commandAI;
+
+		cai->GiveCommand(formationCommands[i], playerNum, false, false);
+	}
+}
+
+
+void CSelectedUnitsHandlerAI::AssignFormationSlots(const float3& formationDir, bool queueing)
+{
+	// units and slots of each group within a row are ordered by projection
+	// onto the front, then matched chunk by chunk such that total squared
+	// travel is minimal within each chunk; this replaces the former fixed
+	// pairing (which made units cross each other's paths to reach their
+	// slots) but keeps the group interleaving of the row-mixing intact
+	const float3 frontDir = (formationDir * XZVector).SafeANormalize();
+	const auto groupProjComp = [&](const std::pair<float, size_t>& a, const std::pair<float, size_t>& b) {
+		// slot i and unit i always share a group, see MakeFormationFrontOrder
+		if (formationSlotGroups[a.second] != formationSlotGroups[b.second])
+			return (formationSlotGroups[a.second] < formationSlotGroups[b.second]);
+
+		// pairs compare by index on ties, so the order is fully determined
+		return (a < b);
+	};
+
+	formationSlotUnitIDs.clear();
+	formationSlotUnitIDs.resize(formationCommands.size(), -1);
+	formationChunks.clear();
+
+	formationSortedSlots.clear();
+	formationSortedUnits.clear();
+	formationUnitPositions.clear();
+
+	for (size_t i = 0; i < formationUnitIDs.size(); i++) {
+		const CUnit* unit = unitHandler.GetUnit(formationUnitIDs[i]);
+		const float3 unitPos = (queueing? LastQueuePosition(unit): float3(unit->midPos));
+
+		formationUnitPositions.push_back(unitPos);
+		formationSortedSlots.emplace_back(formationCommands[i].GetPos(0).dot(frontDir), i);
+		formationSortedUnits.emplace_back(unitPos.dot(frontDir), i);
+	}
+
+	for (size_t r = 0; (r + 1) < formationRowOffsets.size(); r++) {
+		const size_t rowBeg = formationRowOffsets[r    ];
+		const size_t rowEnd = formationRowOffsets[r + 1];
+
+		std::sort(formationSortedSlots.begin() + rowBeg, formationSortedSlots.begin() + rowEnd, groupProjComp);
+		std::sort(formationSortedUnits.begin() + rowBeg, formationSortedUnits.begin() + rowEnd, groupProjComp);
+
+		// both are now partitioned into equally large per-group spans
+		for (size_t grpBeg = rowBeg, grpEnd = rowBeg; grpBeg < rowEnd; grpBeg = grpEnd) {
+			const size_t groupNum = formationSlotGroups[formationSortedSlots[grpBeg].second];
+
+			while (grpEnd < rowEnd && formationSlotGroups[formationSortedSlots[grpEnd].second] == groupNum) {
+				assert(formationSlotGroups[formationSortedUnits[grpEnd].second] == groupNum);
+				grpEnd++;
+			}
+
+			// spread the remainder s.t. no chunk is much smaller than the others
+			const size_t numChunks = (grpEnd - grpBeg + FORMATION_ASSIGN_CHUNK_SIZE - 1) / FORMATION_ASSIGN_CHUNK_SIZE;
+
+			for (size_t k = 0; k < numChunks; k++) {
+				formationChunks.emplace_back(grpBeg + ((grpEnd - grpBeg) * k) / numChunks, grpBeg + ((grpEnd - grpBeg) * (k + 1)) / numChunks);
+			}
+		}
+	}
+
+	for_mt(0, formationChunks.size(), [&](const int k) {
+		const size_t chunkBeg = formationChunks[k].first;
+		const size_t chunkLen = formationChunks[k].second - chunkBeg;
+
+		std::vector<std::int64_t> costs(chunkLen * chunkLen);
+		std::vector<size_t> slotUnits;
+
+		for (size_t i = 0; i < chunkLen; i++) {
+			const float3& unitPos = formationUnitPositions[formationSortedUnits[chunkBeg + i].second];
+
+			for (size_t j = 0; j < chunkLen; j++) {
+				const float3& slotPos = formationCommands[formationSortedSlots[chunkBeg + j].second].GetPos(0);
+
+				costs[i * chunkLen + j] = static_cast<std::int64_t>((slotPos - unitPos).SqLength2D());
+			}
+		}
+
+		SolveFormationAssignment(costs, chunkLen, slotUnits);
+
+		for (size_t j = 0; j < chunkLen; j++) {
+			formationSlotUnitIDs[formationSortedSlots[chunkBeg + j].second] = formationUnitIDs[formationSortedUnits[chunkBeg + slotUnits[j]].second];
+		}
+	});
 }
 
 
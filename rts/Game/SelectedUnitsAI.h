@@ -20,6 +20,7 @@ private:
 	void CalculateGroupData(int playerNum, bool queueing);
 	void MakeFormationFrontOrder(Command* c, int playerNum);
 	void CreateUnitOrder(std::vector< std::pair<float, int> >& out, int playerNum);
+	void AssignFormationSlots(const float3& formationDir, bool queueing);
 
 	float3 MoveToPos(float3 nextCornerPos, float3 dir, const CUnit* unit, Command* command, std::vector<std::pair<int, Command> >* frontcmds, bool* newline);
 
@@ -53,6 +54,21 @@ private:
 	std::vector<size_t> mixedUnitIDs;
 	std::vector<size_t> mixedGroupSizes;
 
+	// all rows of a front order, flattened; row r spans slots
+	// [formationRowOffsets[r], formationRowOffsets[r + 1])
+	std::vector<Command> formationCommands;
+	std::vector<int> formationUnitIDs;
+	std::vector<int> formationSlotUnitIDs;
+	// group (class) each slot was given by the row-mixing, units
+	// are only ever assigned to slots of their own group
+	std::vector<size_t> formationSlotGroups;
+	std::vector<size_t> formationRowOffsets;
+
+	std::vector<float3> formationUnitPositions;
+	std::vector< std::pair<float, size_t> > formationSortedSlots;
+	std::vector< std::pair<float, size_t> > formationSortedUnits;
+	std::vector< std::pair<size_t, size_t> > formationChunks;
+
 
 	std::vector<int> targetUnitIDs;
 };
@@ -730,7 +730,7 @@ void CSelectedUnitsHandler::ClearNetSelect(int playerId)
 }
 
 // handles NETMSG_AICOMMAND{S}'s sent by AICallback / LuaUnsyncedCtrl (!)
-void CSelectedUnitsHandler::AINetOrder(int unitID, int aiTeamID, int playerID, const Command& c)
+void CSelectedUnitsHandler::AINetOrders(int unitID, int aiTeamID, int playerID, const Command* cmds, size_t numCmds)
 {
 	CUnit* unit = unitHandler.GetUnit(unitID);
 
@@ -754,7 +754,7 @@ void CSelectedUnitsHandler::AINetOrder(int unitID, int aiTeamID, int playerID, c
 	// always pulled from net, synced command by definition
 	// (fromSynced determines whether CMD_UNLOAD_UNITS uses
 	// synced or unsynced randomized position sampling, etc)
-	unit->commandAI->GiveCommand(c, playerID, true, false);
+	unit->commandAI->GiveCommands(cmds, numCmds, playerID, true, false);
 }
 
 
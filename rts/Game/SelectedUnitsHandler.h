@@ -20,7 +20,8 @@ class CSelectedUnitsHandler : public CObject
 public:
 	void Init(unsigned numPlayers);
 	void SelectGroup(int num);
-	void AINetOrder(int unitID, int aiTeamID, int playerID, const Command& c);
+	void AINetOrder(int unitID, int aiTeamID, int playerID, const Command& c) { AINetOrders(unitID, aiTeamID, playerID, &c, 1); }
+	void AINetOrders(int unitID, int aiTeamID, int playerID, const Command* cmds, size_t numCmds);
 	int GetDefaultCmd(const CUnit* unit, const CFeature* feature);
 
 	void NetOrder(Command& c, int playerId);
@@ -9,6 +9,7 @@
 #include "Sim/Features/Feature.h"
 #include "Sim/Misc/CollisionHandler.h"
 #include "Sim/Misc/CollisionVolume.h"
+#include "Sim/Misc/CollisionVolumeBatch.h"
 #include "Sim/Misc/GeometricObjects.h"
 #include "Sim/Misc/LosHandler.h"
 #include "Sim/Misc/QuadField.h"
@@ -19,10 +20,53 @@
 #include "Sim/Weapons/PlasmaRepulser.h"
 #include "Sim/Weapons/WeaponDef.h"
 #include "System/SpringMath.h"
+#include "System/Threading/ThreadPool.h"
 
 #include <algorithm>
+#include <array>
 #include <vector>
 
+// added to the bounding-radius of each batched volume, covers
+// rounding differences wrt. the transforms in CollisionHandler
+#define RAY_CANDIDATE_RADIUS_PAD 1.0f
+
+
+// objects gathered from the quads along a ray, in quad-iteration order;
+// only those whose volume passes the batched broad-phase are hit-tested
+struct RayCandidates {
+	void Clear() {
+		batch.Clear();
+		objects.clear();
+		hits.clear();
+	}
+
+	void AddObject(const CSolidObject* obj, const CollisionVolume* vol, const CMatrix44f& mat) {
+		// place the sphere where CCollisionHandler positions the volume; piece-tree
+		// hit-tests are culled by the model's bounding-volume (scaled by 0 there)
+		if (vol->DefaultToPieceTree()) {
+			const CollisionVolume* bv = obj->localModel.GetBoundingVolume();
+
+			batch.AddSphere(mat.Mul(bv->GetOffsets()), bv->GetBoundingRadius() + RAY_CANDIDATE_RADIUS_PAD);
+		} else {
+			batch.AddSphere(mat.Mul(obj->relMidPos + vol->GetOffsets()), vol->GetBoundingRadius() + RAY_CANDIDATE_RADIUS_PAD);
+		}
+
+		objects.push_back(const_cast<CSolidObject*>(obj));
+	}
+
+	void TestRay(const float3& p0, const float3& p1) {
+		batch.TestRay(p0, p1, hits);
+	}
+
+	CollisionVolumeBatch batch;
+
+	std::vector<CSolidObject*> objects;
+	std::vector<unsigned int> hits;
+};
+
+// traces also run on worker threads (weapon line-of-fire tests)
+static std::array<RayCandidates, ThreadPool::MAX_THREADS> rayCandidates;
+
 //////////////////////////////////////////////////////////////////////
 // Local/Helper functions
 //////////////////////////////////////////////////////////////////////
@@ -158,6 +202,32 @@ inline static bool TestTrajectoryConeHelper(
 
 
 
+/**
+ * helper for GuiTraceRay
+ * @return false if unit <u> is not visible to the local player, else
+ * true and its selection-volume in <cv> (iconified units and radar
+ * blips are treated as spheres of radius <u->iconRadius>)
+ */
+inline static bool GuiTraceUnitVolume(const CUnit* u, bool useRadar, CollisionVolume& cv)
+{
+	const bool unitIsEnemy = !teamHandler.Ally(u->allyteam, gu->myAllyTeam);
+	const bool unitOnRadar = (useRadar && losHandler->InRadar(u, gu->myAllyTeam));
+	const bool unitInSight = (u->losStatus[gu->myAllyTeam] & (LOS_INLOS | LOS_CONTRADAR));
+	const bool unitVisible = !unitIsEnemy || unitOnRadar || unitInSight || gu->spectatingFullView;
+
+	if (!unitVisible)
+		return false;
+
+	cv = u->selectionVolume;
+
+	if (u->isIcon || (!unitInSight && unitOnRadar && unitIsEnemy))
+		cv.InitSphere(u->iconRadius);
+
+	return true;
+}
+
+
+
 //////////////////////////////////////////////////////////////////////
 // Raytracing
 //////////////////////////////////////////////////////////////////////
@@ -208,6 +278,8 @@ float TraceRay(
 		QuadFieldQuery qfQuery;
 		quadField.GetQuadsOnRay(qfQuery, pos, dir, traceLength);
 
+		RayCandidates& candidates = rayCandidates[ThreadPool::GetThreadNum()];
+
 		// locally point somewhere non-NULL; we cannot pass hitColQuery
 		// to DetectHit directly because each call resets it internally
 		if (hitColQuery == nullptr)
@@ -215,38 +287,50 @@ float TraceRay(
 
 		// feature intersection
 		if (scanForFeatures) {
+			candidates.Clear();
+
 			for (const int quadIdx: *qfQuery.quads) {
 				const CQuadField::Quad& quad = quadField.GetQuad(quadIdx);
 
-				for (CFeature* f: quad.features) {
+				for (const CFeature* f: quad.features) {
 					// NOTE:
 					//   if f is non-blocking, ProjectileHandler will not test
 					//   for collisions with projectiles so we can skip it here
 					if (!f->HasCollidableStateBit(CSolidObject::CSTATE_BIT_QUADMAPRAYS))
 						continue;
 
-					if (CCollisionHandler::DetectHit(f, f->GetTransformMatrix(true), pos, pos + dir * traceLength, &cq, true)) {
-						const float len = cq.GetHitPosDist(pos, dir);
+					candidates.AddObject(f, &f->collisionVolume, f->GetTransformMatrixRef(true));
+				}
+			}
+
+			candidates.TestRay(pos, pos + dir * traceLength);
+
+			for (const unsigned int idx: candidates.hits) {
+				CFeature* f = static_cast<CFeature*>(candidates.objects[idx]);
 
-						// we want the closest feature (intersection point) on the ray
-						if (len >= traceLength)
-							continue;
+				if (CCollisionHandler::DetectHit(f, f->GetTransformMatrix(true), pos, pos + dir * traceLength, &cq, true)) {
+					const float len = cq.GetHitPosDist(pos, dir);
 
-						traceLength = len;
+					// we want the closest feature (intersection point) on the ray
+					if (len >= traceLength)
+						continue;
 
-						hitFeature = f;
-						*hitColQuery = cq;
-					}
+					traceLength = len;
+
+					hitFeature = f;
+					*hitColQuery = cq;
 				}
 			}
 		}
 
 		// unit intersection
 		if (scanForAnyUnits) {
+			candidates.Clear();
+
 			for (const int quadIdx: *qfQuery.quads) {
 				const CQuadField::Quad& quad = quadField.GetQuad(quadIdx);
 
-				for (CUnit* u: quad.units) {
+				for (const CUnit* u: quad.units) {
 					if (u == owner)
 						continue;
 
@@ -263,18 +347,26 @@ float TraceRay(
 					if (!doHitTest)
 						continue;
 
-					if (CCollisionHandler::DetectHit(u, u->GetTransformMatrix(true), pos, pos + dir * traceLength, &cq, true)) {
-						const float len = cq.GetHitPosDist(pos, dir);
+					candidates.AddObject(u, &u->collisionVolume, u->GetTransformMatrix(true));
+				}
+			}
+
+			candidates.TestRay(pos, pos + dir * traceLength);
+
+			for (const unsigned int idx: candidates.hits) {
+				CUnit* u = static_cast<CUnit*>(candidates.objects[idx]);
 
-						// we want the closest unit (intersection point) on the ray
-						if (len >= traceLength)
-							continue;
+				if (CCollisionHandler::DetectHit(u, u->GetTransformMatrix(true), pos, pos + dir * traceLength, &cq, true)) {
+					const float len = cq.GetHitPosDist(pos, dir);
 
-						traceLength = len;
+					// we want the closest unit (intersection point) on the ray
+					if (len >= traceLength)
+						continue;
+
+					traceLength = len;
 
-						hitUnit = u;
-						*hitColQuery = cq;
-					}
+					hitUnit = u;
+					*hitColQuery = cq;
 				}
 			}
 
@@ -376,20 +468,20 @@ float GuiTraceRay(
 		return minRayLength;
 
 	CollisionQuery cq;
+	CollisionVolume cv;
 
 	QuadFieldQuery qfQuery;
 	quadField.GetQuadsOnRay(qfQuery, start, dir, length);
 
+	RayCandidates& candidates = rayCandidates[ThreadPool::GetThreadNum()];
+
+	candidates.Clear();
+
 	for (const int quadIdx: *qfQuery.quads) {
 		const CQuadField::Quad& quad = quadField.GetQuad(quadIdx);
 
 		// Unit Intersection
 		for (const CUnit* u: quad.units) {
-			const bool unitIsEnemy = !teamHandler.Ally(u->allyteam, gu->myAllyTeam);
-			const bool unitOnRadar = (useRadar && losHandler->InRadar(u, gu->myAllyTeam));
-			const bool unitInSight = (u->losStatus[gu->myAllyTeam] & (LOS_INLOS | LOS_CONTRADAR));
-			const bool unitVisible = !unitIsEnemy || unitOnRadar || unitInSight || gu->spectatingFullView;
-
 			if (u == exclude)
 				continue;
 			#if 0
@@ -399,16 +491,38 @@ float GuiTraceRay(
 			#endif
 			if (u->noSelect)
 				continue;
-			if (!unitVisible)
+			if (!GuiTraceUnitVolume(u, useRadar, cv))
+				continue;
+
+			candidates.AddObject(u, &cv, u->GetTransformMatrix(false));
+		}
+
+		// Feature Intersection
+		for (const CFeature* f: quad.features) {
+			if (!gu->spectatingFullView && !f->IsInLosForAllyTeam(gu->myAllyTeam))
+				continue;
+			#if 0
+			// test this bit only in synced traces, rely on noSelect here
+			if (!f->HasCollidableStateBit(CSolidObject::CSTATE_BIT_QUADMAPRAYS))
+				continue;
+			#endif
+			if (f->noSelect)
 				continue;
 
-			CollisionVolume cv = u->selectionVolume;
+			candidates.AddObject(f, &f->selectionVolume, f->GetTransformMatrix(false));
+		}
+	}
+
+	candidates.TestRay(start, start + dir * guiRayLength);
+
+	// units and features stay interleaved as in the quads, ties resolve as before
+	for (const unsigned int idx: candidates.hits) {
+		const CSolidObject* obj = candidates.objects[idx];
+
+		if (obj->GetBlockingMapID() < unitHandler.MaxUnits()) {
+			const CUnit* u = static_cast<const CUnit*>(obj);
 
-			// for iconified units, just pretend the collision
-			// volume is a sphere of radius <unit->IconRadius>
-			// (count radar blips as such too)
-			if (u->isIcon || (!unitInSight && unitOnRadar && unitIsEnemy))
-				cv.InitSphere(u->iconRadius);
+			GuiTraceUnitVolume(u, useRadar, cv);
 
 			if (CCollisionHandler::MouseHit(u, u->GetTransformMatrix(false), start, start + dir * guiRayLength, &cv, &cq)) {
 				// get the distance to the ray-volume ingress point
@@ -430,23 +544,10 @@ float GuiTraceRay(
 					hitFeature = nullptr;
 				}
 			}
-		}
-
-		// Feature Intersection
-		for (const CFeature* f: quad.features) {
-			if (!gu->spectatingFullView && !f->IsInLosForAllyTeam(gu->myAllyTeam))
-				continue;
-			#if 0
-			// test this bit only in synced traces, rely on noSelect here
-			if (!f->HasCollidableStateBit(CSolidObject::CSTATE_BIT_QUADMAPRAYS))
-				continue;
-			#endif
-			if (f->noSelect)
-				continue;
-
-			const CollisionVolume& cv = f->selectionVolume;
+		} else {
+			const CFeature* f = static_cast<const CFeature*>(obj);
 
-			if (CCollisionHandler::MouseHit(f, f->GetTransformMatrix(false), start, start + dir * guiRayLength, &cv, &cq)) {
+			if (CCollisionHandler::MouseHit(f, f->GetTransformMatrix(false), start, start + dir * guiRayLength, &f->selectionVolume, &cq)) {
 				const float hitDist = cq.GetHitPosDist(start, dir);
 
 				const bool factoryHitBeforeUnit = ( hitFactory && hitDist <  minEgressDist);
@@ -549,7 +549,7 @@ void CEndGameBox::FillTeamStats()
 		if (pteam->gaia)
 			continue;
 
-		for (const auto& si: pteam->statHistory) {
+		const auto AddTeamStats = [&](const TeamStatistics& si) {
 			stats[ 0].AddStat(team, 0);
 
 			stats[ 1].AddStat(team, si.metalUsed);
@@ -582,6 +582,10 @@ void CEndGameBox::FillTeamStats()
 
 			stats[21].AddStat(team, si.damageDealt);
 			stats[22].AddStat(team, si.damageReceived);
-		}
+		};
+
+		// closed snapshots, then the running totals
+		pteam->statHistory.ForEach(0, pteam->statHistory.size(), AddTeamStats);
+		AddTeamStats(pteam->GetCurrentStats());
 	}
 }
@@ -81,6 +81,7 @@
 #include "Rendering/Shaders/ShaderHandler.h"
 
 #include "Sim/MoveTypes/MoveDefHandler.h"
+#include "Sim/Path/PathTelemetry.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/Misc/ModInfo.h"
 #include "Sim/Projectiles/ProjectileHandler.h"
@@ -3027,6 +3028,34 @@ public:
 
 
 
+class DumpPathTelemetryActionExecutor: public IUnsyncedActionExecutor {
+public:
+	DumpPathTelemetryActionExecutor(): IUnsyncedActionExecutor("DumpPathTelemetry", "dump path-request statistics per MoveDef and caller to file, add -r to reset them afterwards") {
+	}
+
+	bool Execute(const UnsyncedAction& action) const final override {
+		const std::vector<std::string>& args = _local_strSpaceTokenize(action.GetArgs());
+
+		std::string fileName = "pathtelemetry.txt";
+		bool resetStats = false;
+
+		for (const std::string& arg: args) {
+			if (arg == "-r") {
+				resetStats = true;
+			} else {
+				fileName = arg;
+			}
+		}
+
+		if (pathTelemetry.Dump(fileName) && resetStats)
+			pathTelemetry.Reset();
+
+		return true;
+	}
+};
+
+
+
 /// /save [-y ]<savename>
 class SaveActionExecutor : public IUnsyncedActionExecutor {
 public:
@@ -3462,6 +3491,7 @@ void UnsyncedGameCommands::AddDefaultActionExecutors()
 	AddActionExecutor(AllocActionExecutor<DestroyActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<SendActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<DumpStateActionExecutor>());
+	AddActionExecutor(AllocActionExecutor<DumpPathTelemetryActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<SaveActionExecutor>(true));
 	AddActionExecutor(AllocActionExecutor<SaveActionExecutor>(false));
 	AddActionExecutor(AllocActionExecutor<ReloadGameActionExecutor>());
@@ -1535,6 +1535,52 @@ bool CLuaHandle::Explosion(int weaponDefID, int projectileID, const float3& pos,
 	return retval;
 }
 
+void CLuaHandle::Explosions(const std::vector<ExplosionEvent>& events, std::vector<bool>& noGfx)
+{
+	// if empty, we are not a LuaHandleSynced
+	if (watchExplosionDefs.empty())
+		return;
+
+	// one stack-check for the whole batch; the call-in
+	// itself is still invoked once per watched explosion
+	LUA_CALL_IN_CHECK(L);
+	luaL_checkstack(L, 7, __func__);
+
+	static const LuaHashString cmdStr("Explosion");
+
+	for (size_t i = 0; i < events.size(); i++) {
+		const ExplosionEvent& e = events[i];
+
+		if (noGfx[i])
+			continue;
+		// piece-projectile collision
+		if (e.weaponDefID < 0)
+			continue;
+		if (!watchExplosionDefs[e.weaponDefID])
+			continue;
+
+		if (!cmdStr.GetGlobalFunc(L))
+			return;
+
+		lua_pushnumber(L, e.weaponDefID);
+		lua_pushnumber(L, e.pos.x);
+		lua_pushnumber(L, e.pos.y);
+		lua_pushnumber(L, e.pos.z);
+		if (e.owner != nullptr) {
+			lua_pushnumber(L, e.owner->id);
+		} else {
+			lua_pushnil(L); // for backward compatibility
+		}
+		lua_pushnumber(L, e.projectileID);
+
+		if (!RunCallIn(L, cmdStr, 6, 1))
+			continue;
+
+		noGfx[i] = (luaL_optboolean(L, -1, false) && GetFullRead());
+		lua_pop(L, 1);
+	}
+}
+
 
 void CLuaHandle::StockpileChanged(const CUnit* unit,
                                   const CWeapon* weapon, int oldCount)
@@ -176,6 +176,7 @@ class CLuaHandle : public CEventClient
 		void ProjectileDestroyed(const CProjectile* p) override;
 
 		bool Explosion(int weaponID, int projectileID, const float3& pos, const CUnit* owner) override;
+		void Explosions(const std::vector<ExplosionEvent>& events, std::vector<bool>& noGfx) override;
 
 		void StockpileChanged(const CUnit* owner,
 		                      const CWeapon* weapon, int oldCount) override;
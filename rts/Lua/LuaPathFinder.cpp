@@ -6,6 +6,7 @@
 #include "LuaHandle.h"
 #include "LuaUtils.h"
 #include "Sim/Path/IPathManager.h"
+#include "Sim/Path/PathTelemetry.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
 
 #include <algorithm>
@@ -235,6 +236,7 @@ int LuaPathFinder::RequestPath(lua_State* L)
 	const float radius = luaL_optfloat(L, 8, 8.0f);
 
 	const bool synced = CLuaHandle::GetHandleSynced(L);
+	const CPathTelemetry::ScopedCaller telemetryCaller(CPathTelemetry::CALLER_LUA);
 	const int pathID = pathManager->RequestPath(nullptr, moveDef, start, end, radius, synced);
 
 	if (pathID == 0)
@@ -45,6 +45,7 @@
 #include "Sim/Misc/QuadField.h"
 #include "Sim/Misc/Wind.h"
 #include "Sim/MoveTypes/AAirMoveType.h"
+#include "Sim/MoveTypes/MoveMath/MoveMath.h"
 #include "Sim/Path/IPathManager.h"
 #include "Sim/Projectiles/ExplosionGenerator.h"
 #include "Sim/Projectiles/Projectile.h"
@@ -3670,9 +3671,7 @@ int LuaSyncedCtrl::GiveOrderArrayToUnitMap(lua_State* L)
 	int count = 0;
 	for (CUnit* unit: units) {
 		if (CanControlUnit(L, unit)) {
-			for (const Command& c: commands) {
-				unit->commandAI->GiveCommand(c, -1, true, true);
-			}
+			unit->commandAI->GiveCommands(commands.data(), commands.size(), -1, true, true);
 			count++;
 		}
 	}
@@ -3718,9 +3717,7 @@ int LuaSyncedCtrl::GiveOrderArrayToUnitArray(lua_State* L)
 	} else {
 		for (CUnit* unit: units) {
 			if (CanControlUnit(L, unit)) {
-				for (const Command& c: commands) {
-					unit->commandAI->GiveCommand(c, -1, true, true);
-				}
+				unit->commandAI->GiveCommands(commands.data(), commands.size(), -1, true, true);
 				count++;
 			}
 		}
@@ -4006,7 +4003,7 @@ int LuaSyncedCtrl::LevelSmoothMesh(lua_State* L)
 
 	for (int z = z1; z <= z2; z++) {
 		for (int x = x1; x <= x2; x++) {
-			const int index = (z * smoothGround.GetMaxX()) + x;
+			const int index = smoothGround.GetMeshIndex(x, z);
 			smoothGround.SetHeight(index, height);
 		}
 	}
@@ -4021,7 +4018,7 @@ int LuaSyncedCtrl::AdjustSmoothMesh(lua_State* L)
 
 	for (int z = z1; z <= z2; z++) {
 		for (int x = x1; x <= x2; x++) {
-			const int index = (z * smoothGround.GetMaxX()) + x;
+			const int index = smoothGround.GetMeshIndex(x, z);
 			smoothGround.AddHeight(index, height);
 		}
 	}
@@ -4041,7 +4038,7 @@ int LuaSyncedCtrl::RevertSmoothMesh(lua_State* L)
 	if (origFactor == 1.0f) {
 		for (int z = z1; z <= z2; z++) {
 			for (int x = x1; x <= x2; x++) {
-				const int idx = (z * smoothGround.GetMaxX()) + x;
+				const int idx = smoothGround.GetMeshIndex(x, z);
 				smoothGround.SetHeight(idx, origMap[idx]);
 			}
 		}
@@ -4050,7 +4047,7 @@ int LuaSyncedCtrl::RevertSmoothMesh(lua_State* L)
 		const float currFactor = (1.0f - origFactor);
 		for (int z = z1; z <= z2; z++) {
 			for (int x = x1; x <= x2; x++) {
-				const int index = (z * smoothGround.GetMaxX()) + x;
+				const int index = smoothGround.GetMeshIndex(x, z);
 				const float ofh = origFactor * origMap[index];
 				const float cfh = currFactor * currMap[index];
 				smoothGround.SetHeight(index, ofh + cfh);
@@ -4082,7 +4079,7 @@ int LuaSyncedCtrl::AddSmoothMesh(lua_State* L)
 		return 0;
 	}
 
-	const int index = (z * smoothGround.GetMaxX()) + x;
+	const int index = smoothGround.GetMeshIndex(x, z);
 	const float oldHeight = smoothGround.GetMeshData()[index];
 	smoothMeshAmountChanged += math::fabsf(h);
 
@@ -4112,7 +4109,7 @@ int LuaSyncedCtrl::SetSmoothMesh(lua_State* L)
 		return 0;
 	}
 
-	const int index = (z * (smoothGround.GetMaxX())) + x;
+	const int index = smoothGround.GetMeshIndex(x, z);
 	const float oldHeight = smoothGround.GetMeshData()[index];
 	float height = oldHeight;
 
@@ -4178,6 +4175,7 @@ int LuaSyncedCtrl::SetMapSquareTerrainType(lua_State* L)
 	const int ntt = luaL_checkint(L, 3);
 
 	readMap->GetTypeMapSynced()[tz * mapDims.hmapx + tx] = std::max(0, std::min(ntt, (CMapInfo::NUM_TERRAIN_TYPES - 1)));
+	CMoveMath::UpdateSpeedModCache(hx, hz,  hx + 1, hz + 1);
 	pathManager->TerrainChange(hx, hz,  hx + 1, hz + 1,  TERRAINCHANGE_SQUARE_TYPEMAP_INDEX);
 
 	lua_pushnumber(L, ott);
@@ -1379,6 +1379,46 @@ int LuaSyncedRead::GetTeamRulesParam(lua_State* L)
 }
 
 
+static void PushTeamStats(lua_State* L, const TeamStatistics& stats, bool current)
+{
+	lua_newtable(L); {
+		if (current) {
+			// the `stats.frame` var indicates the frame when a new entry needs to get added,
+			// for the most recent stats entry this lies obviously in the future,
+			// so we just output the current frame here
+			HSTR_PUSH_NUMBER(L, "time",         gs->GetLuaSimFrame() / GAME_SPEED);
+			HSTR_PUSH_NUMBER(L, "frame",        gs->GetLuaSimFrame());
+		} else {
+			HSTR_PUSH_NUMBER(L, "time",         stats.frame / GAME_SPEED);
+			HSTR_PUSH_NUMBER(L, "frame",        stats.frame);
+		}
+
+		HSTR_PUSH_NUMBER(L, "metalUsed",        stats.metalUsed);
+		HSTR_PUSH_NUMBER(L, "metalProduced",    stats.metalProduced);
+		HSTR_PUSH_NUMBER(L, "metalExcess",      stats.metalExcess);
+		HSTR_PUSH_NUMBER(L, "metalReceived",    stats.metalReceived);
+		HSTR_PUSH_NUMBER(L, "metalSent",        stats.metalSent);
+
+		HSTR_PUSH_NUMBER(L, "energyUsed",       stats.energyUsed);
+		HSTR_PUSH_NUMBER(L, "energyProduced",   stats.energyProduced);
+		HSTR_PUSH_NUMBER(L, "energyExcess",     stats.energyExcess);
+		HSTR_PUSH_NUMBER(L, "energyReceived",   stats.energyReceived);
+		HSTR_PUSH_NUMBER(L, "energySent",       stats.energySent);
+
+		HSTR_PUSH_NUMBER(L, "damageDealt",      stats.damageDealt);
+		HSTR_PUSH_NUMBER(L, "damageReceived",   stats.damageReceived);
+
+		HSTR_PUSH_NUMBER(L, "unitsProduced",    stats.unitsProduced);
+		HSTR_PUSH_NUMBER(L, "unitsDied",        stats.unitsDied);
+		HSTR_PUSH_NUMBER(L, "unitsReceived",    stats.unitsReceived);
+		HSTR_PUSH_NUMBER(L, "unitsSent",        stats.unitsSent);
+		HSTR_PUSH_NUMBER(L, "unitsCaptured",    stats.unitsCaptured);
+		HSTR_PUSH_NUMBER(L, "unitsOutCaptured", stats.unitsOutCaptured);
+		HSTR_PUSH_NUMBER(L, "unitsKilled",      stats.unitsKilled);
+	}
+}
+
+
 int LuaSyncedRead::GetTeamStatsHistory(lua_State* L)
 {
 	const CTeam* team = ParseTeam(L, __func__, 1);
@@ -1391,17 +1431,17 @@ int LuaSyncedRead::GetTeamStatsHistory(lua_State* L)
 	if (!IsAlliedTeam(L, teamID) && !game->IsGameOver())
 		return 0;
 
+	// closed snapshots, followed by the running totals as newest entry
+	const CTeamStatsHistory& teamStats = team->statHistory;
+	const int statCount = teamStats.size() + 1;
+
 	const int args = lua_gettop(L);
 
 	if (args == 1) {
-		lua_pushnumber(L, team->statHistory.size());
+		lua_pushnumber(L, statCount);
 		return 1;
 	}
 
-	const auto& teamStats = team->statHistory;
-	auto it = teamStats.cbegin();
-	const int statCount = teamStats.size();
-
 	int start = 0;
 	if ((args >= 2) && lua_isnumber(L, 2)) {
 		start = lua_toint(L, 2) - 1;
@@ -1414,50 +1454,18 @@ int LuaSyncedRead::GetTeamStatsHistory(lua_State* L)
 		end = max(0, min(statCount - 1, end));
 	}
 
-	std::advance(it, start);
+	int count = 1;
 
 	lua_newtable(L);
-	if (statCount > 0) {
-		int count = 1;
-		for (int i = start; i <= end; ++i, ++it) {
-			const TeamStatistics& stats = *it;
-			lua_newtable(L); {
-				if (i+1 == teamStats.size()) {
-					// the `stats.frame` var indicates the frame when a new entry needs to get added,
-					// for the most recent stats entry this lies obviously in the future,
-					// so we just output the current frame here
-					HSTR_PUSH_NUMBER(L, "time",         gs->GetLuaSimFrame() / GAME_SPEED);
-					HSTR_PUSH_NUMBER(L, "frame",        gs->GetLuaSimFrame());
-				} else {
-					HSTR_PUSH_NUMBER(L, "time",         stats.frame / GAME_SPEED);
-					HSTR_PUSH_NUMBER(L, "frame",        stats.frame);
-				}
 
-				HSTR_PUSH_NUMBER(L, "metalUsed",        stats.metalUsed);
-				HSTR_PUSH_NUMBER(L, "metalProduced",    stats.metalProduced);
-				HSTR_PUSH_NUMBER(L, "metalExcess",      stats.metalExcess);
-				HSTR_PUSH_NUMBER(L, "metalReceived",    stats.metalReceived);
-				HSTR_PUSH_NUMBER(L, "metalSent",        stats.metalSent);
-
-				HSTR_PUSH_NUMBER(L, "energyUsed",       stats.energyUsed);
-				HSTR_PUSH_NUMBER(L, "energyProduced",   stats.energyProduced);
-				HSTR_PUSH_NUMBER(L, "energyExcess",     stats.energyExcess);
-				HSTR_PUSH_NUMBER(L, "energyReceived",   stats.energyReceived);
-				HSTR_PUSH_NUMBER(L, "energySent",       stats.energySent);
-
-				HSTR_PUSH_NUMBER(L, "damageDealt",      stats.damageDealt);
-				HSTR_PUSH_NUMBER(L, "damageReceived",   stats.damageReceived);
-
-				HSTR_PUSH_NUMBER(L, "unitsProduced",    stats.unitsProduced);
-				HSTR_PUSH_NUMBER(L, "unitsDied",        stats.unitsDied);
-				HSTR_PUSH_NUMBER(L, "unitsReceived",    stats.unitsReceived);
-				HSTR_PUSH_NUMBER(L, "unitsSent",        stats.unitsSent);
-				HSTR_PUSH_NUMBER(L, "unitsCaptured",    stats.unitsCaptured);
-				HSTR_PUSH_NUMBER(L, "unitsOutCaptured", stats.unitsOutCaptured);
-				HSTR_PUSH_NUMBER(L, "unitsKilled",      stats.unitsKilled);
-			}
-			lua_rawseti(L, -2, count++);
-		}
+	teamStats.ForEach(start, min(end + 1, statCount - 1), [&](const TeamStatistics& stats) {
+		PushTeamStats(L, stats, false);
+		lua_rawseti(L, -2, count++);
+	});
+
+	if (end == (statCount - 1)) {
+		PushTeamStats(L, team->GetCurrentStats(), true);
+		lua_rawseti(L, -2, count++);
 	}
 
 	return 1;
@@ -5269,32 +5277,41 @@ int LuaSyncedRead::GetGroundBlocked(lua_State* L)
 	int tx1, tx2, tz1, tz2;
 	ParseMapCoords(L, __func__, tx1, tz1, tx2, tz2);
 
-	for (int z = tz1; z <= tz2; z++){
-		for (int x = tx1; x <= tx2; x++){
-			const CSolidObject* s = groundBlockingObjectMap.GroundBlocked(x, z);
+	const CFeature* feature = nullptr;
+	const CUnit* unit = nullptr;
 
-			const CFeature* feature = dynamic_cast<const CFeature*>(s);
-			if (feature != nullptr) {
-				if (IsFeatureVisible(L, feature)) {
-					HSTR_PUSH(L, "feature");
-					lua_pushnumber(L, feature->id);
-					return 2;
-				}
+	// only visits non-empty squares (in the same order as a row-major scan)
+	groundBlockingObjectMap.FindOccupiedSquare(tx1, tz1, tx2 + 1, tz2 + 1, [&](unsigned int mapSquare) {
+		const CSolidObject* s = groundBlockingObjectMap.GroundBlockedUnsafe(mapSquare);
 
-				continue;
-			}
+		if ((feature = dynamic_cast<const CFeature*>(s)) != nullptr) {
+			if (IsFeatureVisible(L, feature))
+				return true;
 
-			const CUnit* unit = dynamic_cast<const CUnit*>(s);
-			if (unit != nullptr) {
-				if (CLuaHandle::GetHandleFullRead(L) || (unit->losStatus[CLuaHandle::GetHandleReadAllyTeam(L)] & LOS_INLOS)) {
-					HSTR_PUSH(L, "unit");
-					lua_pushnumber(L, unit->id);
-					return 2;
-				}
+			feature = nullptr;
+			return false;
+		}
 
-				continue;
-			}
+		if ((unit = dynamic_cast<const CUnit*>(s)) != nullptr) {
+			if (CLuaHandle::GetHandleFullRead(L) || (unit->losStatus[CLuaHandle::GetHandleReadAllyTeam(L)] & LOS_INLOS))
+				return true;
+
+			unit = nullptr;
+			return false;
 		}
+
+		return false;
+	});
+
+	if (feature != nullptr) {
+		HSTR_PUSH(L, "feature");
+		lua_pushnumber(L, feature->id);
+		return 2;
+	}
+	if (unit != nullptr) {
+		HSTR_PUSH(L, "unit");
+		lua_pushnumber(L, unit->id);
+		return 2;
 	}
 
 	lua_pushboolean(L, false);
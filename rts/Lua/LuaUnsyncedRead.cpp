@@ -48,6 +48,8 @@
 #include "Sim/Misc/ModInfo.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/Misc/QuadField.h"
+#include "Sim/MoveTypes/MoveDefHandler.h"
+#include "Sim/Path/PathTelemetry.h"
 #include "Sim/Projectiles/Projectile.h"
 #include "Sim/Units/Unit.h"
 #include "Sim/Units/UnitHandler.h"
@@ -91,6 +93,7 @@ bool LuaUnsyncedRead::PushEntries(lua_State* L)
 
 	REGISTER_LUA_CFUNC(GetProfilerTimeRecord);
 	REGISTER_LUA_CFUNC(GetProfilerRecordNames);
+	REGISTER_LUA_CFUNC(GetPathTelemetry);
 
 	REGISTER_LUA_CFUNC(GetLuaMemUsage);
 	REGISTER_LUA_CFUNC(GetVidMemUsage);
@@ -405,6 +408,72 @@ int LuaUnsyncedRead::GetProfilerRecordNames(lua_State* L)
 	return 1;
 }
 
+// returns {[moveDefName] = {[callerName] = {requests = n, ..., levels = {...}}}}
+// for every MoveDef, or only for the one given by name or pathType
+int LuaUnsyncedRead::GetPathTelemetry(lua_State* L)
+{
+	unsigned int minPathType = 0;
+	unsigned int maxPathType = pathTelemetry.GetNumPathTypes();
+
+	if (lua_israwstring(L, 1)) {
+		const MoveDef* moveDef = moveDefHandler.GetMoveDefByName(lua_tostring(L, 1));
+
+		if (moveDef == nullptr)
+			return 0;
+
+		minPathType = moveDef->pathType;
+		maxPathType = minPathType + 1;
+	} else if (lua_isnumber(L, 1)) {
+		minPathType = lua_toint(L, 1);
+		maxPathType = minPathType + 1;
+	}
+
+	if (maxPathType > pathTelemetry.GetNumPathTypes())
+		return 0;
+
+	lua_createtable(L, 0, maxPathType - minPathType);
+
+	for (unsigned int pathType = minPathType; pathType < maxPathType; pathType++) {
+		lua_pushsstring(L, moveDefHandler.GetMoveDefByPathType(pathType)->name);
+		lua_createtable(L, 0, CPathTelemetry::CALLER_COUNT);
+
+		for (unsigned int callerType = 0; callerType < CPathTelemetry::CALLER_COUNT; callerType++) {
+			const CPathTelemetry::Stats& stats = pathTelemetry.GetStats(pathType, callerType);
+
+			if (stats.numRequests == 0)
+				continue;
+
+			lua_pushstring(L, CPathTelemetry::GetCallerName(callerType));
+			lua_createtable(L, 0, 11);
+
+			LuaPushNamedNumber(L, "requests", stats.numRequests);
+			LuaPushNamedNumber(L, "failures", stats.numFailures);
+			LuaPushNamedNumber(L, "nodes", stats.numNodes);
+			LuaPushNamedNumber(L, "maxNodes", stats.maxNodes);
+			LuaPushNamedNumber(L, "cacheHits", stats.numCacheHits);
+			LuaPushNamedNumber(L, "cacheMisses", stats.numCacheMisses);
+			LuaPushNamedNumber(L, "wallTime", stats.sumWallTime * 0.001);
+			LuaPushNamedNumber(L, "maxWallTime", stats.maxWallTime * 0.001);
+			LuaPushNamedNumber(L, "avgDistance", stats.sumDistance / stats.numRequests);
+			LuaPushNamedNumber(L, "maxDistance", stats.maxDistance);
+
+			lua_pushliteral(L, "levels");
+			lua_createtable(L, 0, CPathTelemetry::RES_COUNT);
+
+			for (unsigned int level = 0; level < CPathTelemetry::RES_COUNT; level++) {
+				LuaPushNamedNumber(L, CPathTelemetry::GetLevelName(level), stats.numLevelSearches[level]);
+			}
+
+			lua_rawset(L, -3); // levels
+			lua_rawset(L, -3); // caller
+		}
+
+		lua_rawset(L, -3); // moveDef
+	}
+
+	return 1;
+}
+
 
 int LuaUnsyncedRead::GetLuaMemUsage(lua_State* L)
 {
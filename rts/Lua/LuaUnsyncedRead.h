@@ -21,6 +21,7 @@ class LuaUnsyncedRead {
 
 		static int GetProfilerTimeRecord(lua_State* L);
 		static int GetProfilerRecordNames(lua_State* L);
+		static int GetPathTelemetry(lua_State* L);
 
 		static int GetLuaMemUsage(lua_State* L);
 		static int GetVidMemUsage(lua_State* L);
@@ -8,10 +8,10 @@
 #include "Sim/Misc/GroundBlockingObjectMap.h"
 #include "Sim/Misc/LosHandler.h"
 #include "Sim/Misc/QuadField.h"
+#include "Sim/MoveTypes/MoveMath/MoveMath.h"
 #include "Sim/Units/Unit.h"
 #include "Sim/Units/UnitHandler.h"
 #include "Sim/Path/IPathManager.h"
-#include "Sim/Features/FeatureHandler.h"
 #include "System/TimeProfiler.h"
 
 
@@ -73,6 +73,7 @@ void CBasicMapDamage::TerrainTypeSpeedModChanged(int ttIndex)
 			if (typeMap[tz * mapDims.hmapx + tx] != ttIndex)
 				continue;
 
+			CMoveMath::UpdateSpeedModCache((tx << 1), (tz << 1),  (tx << 1) + 1, (tz << 1) + 1);
 			pathManager->TerrainChange((tx << 1), (tz << 1),  (tx << 1) + 1, (tz << 1) + 1,  TERRAINCHANGE_TYPEMAP_SPEED_VALUES);
 		}
 	}
@@ -215,14 +216,37 @@ void CBasicMapDamage::Explosion(const float3& pos, float strength, float radius)
 void CBasicMapDamage::RecalcArea(int x1, int x2, int y1, int y2)
 {
 	readMap->UpdateHeightMapSynced(SRectangle(x1, y1, x2, y2));
-	featureHandler.TerrainChanged(x1, y1, x2, y2);
+	RecalcDependents(SRectangle(x1, y1, x2, y2));
+}
+
+void CBasicMapDamage::RecalcDamagedAreas()
+{
+	if (damagedAreas.empty())
+		return;
+
+	// coalesces the rectangles, so each dependent below sees disjoint areas
+	readMap->UpdateHeightMapSynced(damagedAreas);
+
+	for (const SRectangle& rect: damagedAreas) {
+		RecalcDependents(rect);
+	}
+
+	damagedAreas.clear();
+}
+
+// NOTE:
+//   features, the smooth-mesh and the path-manager poll readMap's heightmap
+//   change tracker from their own Update's, the speed-mod cache must be
+//   current by then
+void CBasicMapDamage::RecalcDependents(const SRectangle& rect)
+{
 	{
 		SCOPED_TIMER("Sim::BasicMapDamage::Los");
-		losHandler->UpdateHeightMapSynced(SRectangle(x1, y1, x2, y2));
+		losHandler->UpdateHeightMapSynced(rect);
 	}
 	{
 		SCOPED_TIMER("Sim::BasicMapDamage::Path");
-		pathManager->TerrainChange(x1, y1, x2, y2, TERRAINCHANGE_DAMAGE_RECALCULATION);
+		CMoveMath::UpdateSpeedModCache(rect.x1, rect.z1, rect.x2, rect.z2);
 	}
 }
 
@@ -266,9 +290,12 @@ void CBasicMapDamage::Update()
 		if (e.ttl != 0)
 			continue;
 
-		RecalcArea(e.x1 - 1, e.x2 + 1, e.y1 - 1, e.y2 + 1);
+		// defer, overlapping craters are merged and recalculated once
+		damagedAreas.push_back({e.x1 - 1, e.y1 - 1, e.x2 + 1, e.y2 + 1});
 	}
 
+	RecalcDamagedAreas();
+
 
 	// pop explosions that are no longer being processed
 	while (explUpdateQueueIdx < explosionUpdateQueue.size()) {
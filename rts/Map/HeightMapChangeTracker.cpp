@@ -0,0 +1,60 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <cassert>
+
+#include "HeightMapChangeTracker.h"
+
+
+void CHeightMapChangeTracker::Init(const int2 mapSize_, int tileSize_)
+{
+	assert(tileSize_ > 0);
+
+	mapSize = mapSize_;
+	tileSize = tileSize_;
+	version = 0;
+
+	// include the far edge, corner-rectangles can reach it
+	numTiles.x = mapSize.x / tileSize + 1;
+	numTiles.y = mapSize.y / tileSize + 1;
+
+	tileVersions.clear();
+	tileVersions.resize(numTiles.x * numTiles.y, 0);
+}
+
+void CHeightMapChangeTracker::Kill()
+{
+	tileVersions.clear();
+
+	mapSize = {0, 0};
+	numTiles = {0, 0};
+	tileSize = 0;
+	version = 0;
+}
+
+
+SRectangle CHeightMapChangeTracker::GetTileBounds(const SRectangle& hgtMapRect) const
+{
+	return {
+		std::max(0, std::min(hgtMapRect.x1 / tileSize, numTiles.x - 1)),
+		std::max(0, std::min(hgtMapRect.z1 / tileSize, numTiles.y - 1)),
+		std::max(0, std::min(hgtMapRect.x2 / tileSize, numTiles.x - 1)),
+		std::max(0, std::min(hgtMapRect.z2 / tileSize, numTiles.y - 1)),
+	};
+}
+
+void CHeightMapChangeTracker::MarkChanged(const SRectangle& hgtMapRect)
+{
+	if (!Initialized())
+		return;
+
+	const SRectangle tileRect = GetTileBounds(hgtMapRect);
+
+	version += 1;
+
+	for (int tz = tileRect.z1; tz <= tileRect.z2; tz++) {
+		for (int tx = tileRect.x1; tx <= tileRect.x2; tx++) {
+			tileVersions[tz * numTiles.x + tx] = version;
+		}
+	}
+}
@@ -0,0 +1,98 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef HEIGHTMAP_CHANGE_TRACKER_H
+#define HEIGHTMAP_CHANGE_TRACKER_H
+
+#include <algorithm>
+#include <cinttypes>
+#include <vector>
+
+#include "System/Rectangle.h"
+#include "System/type2.h"
+
+/**
+ * Versioned dirty-tracking for the (synced) heightmap.
+ *
+ * The map is divided into square tiles, each of which stores the version
+ * at which it was last deformed. Consumers remember the version they last
+ * synced to and ask for the areas that changed since, instead of relying
+ * on receiving every individual rectangle notification.
+ */
+class CHeightMapChangeTracker
+{
+public:
+	/**
+	 * @param mapSize size of the map in heightmap squares
+	 * @param tileSize size of a tile in heightmap squares
+	 */
+	void Init(const int2 mapSize, int tileSize);
+	void Kill();
+
+	/// @param hgtMapRect inclusive rectangle in heightmap-square coordinates
+	void MarkChanged(const SRectangle& hgtMapRect);
+
+	/**
+	 * Calls func(rect) with inclusive heightmap-square rectangles (clamped
+	 * to the map) covering every tile modified after version syncedVersion,
+	 * merging horizontal runs of changed tiles; syncedVersion is advanced
+	 * to GetVersion() afterwards.
+	 */
+	template<typename F> void ForEachChangedRect(uint32_t& syncedVersion, F&& func) const {
+		if (syncedVersion >= version) {
+			syncedVersion = version;
+			return;
+		}
+
+		for (int tz = 0; tz < numTiles.y; tz++) {
+			for (int tx = 0; tx < numTiles.x; tx++) {
+				if (tileVersions[tz * numTiles.x + tx] <= syncedVersion)
+					continue;
+
+				const int rx = tx;
+
+				while ((tx + 1) < numTiles.x && tileVersions[tz * numTiles.x + tx + 1] > syncedVersion)
+					tx++;
+
+				const SRectangle r0 = GetTileRect(rx, tz);
+				const SRectangle r1 = GetTileRect(tx, tz);
+
+				// the far-edge tiles start past the last center square
+				func(SRectangle{
+					std::min(r0.x1, mapSize.x - 1), std::min(r0.z1, mapSize.y - 1),
+					std::min(r1.x2, mapSize.x - 1), std::min(r1.z2, mapSize.y - 1)
+				});
+			}
+		}
+
+		syncedVersion = version;
+	}
+
+	bool Initialized() const { return (tileSize > 0); }
+
+	uint32_t GetVersion() const { return version; }
+	uint32_t GetTileVersion(int tileX, int tileZ) const { return tileVersions[tileZ * numTiles.x + tileX]; }
+
+	int2 GetNumTiles() const { return numTiles; }
+	int GetTileSize() const { return tileSize; }
+
+	/// @return inclusive heightmap-square rectangle covered by a tile (may extend past the map edge)
+	SRectangle GetTileRect(int tileX, int tileZ) const {
+		return {tileX * tileSize, tileZ * tileSize, (tileX + 1) * tileSize - 1, (tileZ + 1) * tileSize - 1};
+	}
+
+private:
+	SRectangle GetTileBounds(const SRectangle& hgtMapRect) const;
+
+private:
+	std::vector<uint32_t> tileVersions;
+
+	int2 mapSize;
+	int2 numTiles;
+
+	int tileSize = 0;
+
+	// zero means "never changed", so every consumer starts out in sync
+	uint32_t version = 0;
+};
+
+#endif
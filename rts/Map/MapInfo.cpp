@@ -434,6 +434,8 @@ void CMapInfo::ReadPFSConstants()
 	qtpfsConsts.numSpeedModBins = qtpfsTable.GetInt("numSpeedModBins", 10);
 	qtpfsConsts.minSpeedModVal  = std::max(                      0.0f, qtpfsTable.GetFloat("minSpeedModVal", 0.0f));
 	qtpfsConsts.maxSpeedModVal  = std::max(qtpfsConsts.minSpeedModVal, qtpfsTable.GetFloat("maxSpeedModVal", 2.0f));
+	qtpfsConsts.maxLayerMemory  = qtpfsTable.GetInt("maxLayerMemory",   0);
+	qtpfsConsts.layerIdleTime   = qtpfsTable.GetInt("layerIdleTime",   GAME_SPEED * 60);
 }
 
 void CMapInfo::ReadSound()
@@ -213,6 +213,10 @@ public:
 			unsigned int numSpeedModBins;
 			float        minSpeedModVal;
 			float        maxSpeedModVal;
+			// MB; 0 keeps all node-layers resident
+			unsigned int maxLayerMemory;
+			// sim-frames a layer must be unused for before it can be evicted
+			unsigned int layerIdleTime;
 		} qtpfs_constants;
 	} pfs;
 
@@ -90,11 +90,12 @@ CR_REG_METADATA(CReadMap, (
 
 	CR_IGNORED(unsyncedHeightMapUpdates),
 	CR_IGNORED(unsyncedHeightMapUpdatesTemp),
+	CR_IGNORED(heightMapUpdateTiles),
+	CR_IGNORED(heightMapChangeTracker),
 
 	/*
 	#ifdef USE_UNSYNCED_HEIGHTMAP
-	CR_IGNORED(  syncedHeightMapDigests),
-	CR_IGNORED(unsyncedHeightMapDigests),
+	CR_IGNORED(unsyncedHeightMapVersions),
 	#endif
 	*/
 
@@ -124,8 +125,7 @@ std::vector<uint8_t> CReadMap::typeMap;
 std::vector<float3> CReadMap::centerNormals2D;
 
 #ifdef USE_UNSYNCED_HEIGHTMAP
-std::vector<uint8_t> CReadMap::  syncedHeightMapDigests;
-std::vector<uint8_t> CReadMap::unsyncedHeightMapDigests;
+std::vector<uint32_t> CReadMap::unsyncedHeightMapVersions;
 #endif
 
 
@@ -366,11 +366,13 @@ void CReadMap::Initialize()
 
 	mapChecksum = CalcHeightmapChecksum();
 
-	syncedHeightMapDigests.clear();
-	unsyncedHeightMapDigests.clear();
+	heightMapChangeTracker.Kill();
+	#ifdef USE_UNSYNCED_HEIGHTMAP
+	unsyncedHeightMapVersions.clear();
+	#endif
 
 	// not callable here because losHandler is still uninitialized, deferred to Game::PostLoadSim
-	// InitHeightMapDigestVectors();
+	// InitHeightMapChangeTracking();
 	UpdateHeightMapSynced({0, 0, mapDims.mapx, mapDims.mapy}, true);
 
 	// FIXME: sky & skyLight aren't created yet (crashes in SMFReadMap.cpp)
@@ -490,49 +492,141 @@ void CReadMap::UpdateHeightMapSynced(const SRectangle& hgtMapRect, bool initiali
 	if (hgtMapRect.GetArea() <= 0)
 		return;
 
-	const int2 mins = {hgtMapRect.x1 - 1, hgtMapRect.z1 - 1};
-	const int2 maxs = {hgtMapRect.x2 + 1, hgtMapRect.z2 + 1};
+	UpdateHeightMapSynced(&hgtMapRect, 1, initialize);
+}
 
-	// NOTE:
-	//   rectangles are clamped to map{x,y}m1 which are the proper inclusive bounds for center heightmaps
-	//   parts of UpdateHeightMapUnsynced() (vertex normals, normal texture) however inclusively clamp to
-	//   map{x,y} since they index corner heightmaps, while UnsyncedHeightMapUpdate() EventClients should
-	//   already expect {x,z}2 <= map{x,y} and do internal clamping as well
-	const SRectangle centerRect = {std::max(mins.x, 0), std::max(mins.y, 0),  std::min(maxs.x, mapDims.mapxm1),  std::min(maxs.y, mapDims.mapym1)};
-	const SRectangle cornerRect = {std::max(mins.x, 0), std::max(mins.y, 0),  std::min(maxs.x, mapDims.mapx  ),  std::min(maxs.y, mapDims.mapy  )};
-
-	UpdateCenterHeightmap(centerRect, initialize);
-	UpdateMipHeightmaps(centerRect, initialize);
-	UpdateFaceNormals(centerRect, initialize);
-	UpdateSlopemap(centerRect, initialize); // must happen after UpdateFaceNormals()!
+void CReadMap::UpdateHeightMapSynced(CRectangleOverlapHandler& hgtMapRects)
+{
+	if (hgtMapRects.empty())
+		return;
 
-	#ifdef USE_UNSYNCED_HEIGHTMAP
-	// push the unsynced update; initial one without LOS check
-	if (initialize) {
-		unsyncedHeightMapUpdates.push_back(cornerRect);
-	} else {
-		#ifdef USE_HEIGHTMAP_DIGESTS
-		// convert heightmap rectangle to LOS-map space
-		const       int2 losMapSize = losHandler->los.size;
-		const SRectangle losMapRect = centerRect * (SQUARE_SIZE * losHandler->los.invDiv);
+	// merge overlapping rectangles (e.g. neighbouring craters) first
+	// so every square is recomputed at most once per batch
+	hgtMapRects.Process();
 
-		// heightmap updated, increment digests (byte-overflow is intentional!)
-		for (int lmz = losMapRect.z1; lmz <= losMapRect.z2; ++lmz) {
-			for (int lmx = losMapRect.x1; lmx <= losMapRect.x2; ++lmx) {
-				const int losMapIdx = lmx + lmz * (losMapSize.x + 1);
+	if (hgtMapRects.empty())
+		return;
 
-				assert(losMapIdx < syncedHeightMapDigests.size());
+	UpdateHeightMapSynced(&*hgtMapRects.cbegin(), hgtMapRects.size(), false);
+}
 
-				syncedHeightMapDigests[losMapIdx]++;
+void CReadMap::UpdateHeightMapSynced(const SRectangle* hgtMapRects, size_t numRects, bool initialize)
+{
+	// splits an inclusive rectangle into inclusive tiles; these always start at even
+	// offsets from rect.{x,z}1 as required by the mipmap stage
+	const auto AddTiles = [&](const SRectangle& rect) {
+		for (int z = rect.z1; z <= rect.z2; z += HEIGHTMAP_UPDATE_TILE_SIZE) {
+			for (int x = rect.x1; x <= rect.x2; x += HEIGHTMAP_UPDATE_TILE_SIZE) {
+				heightMapUpdateTiles.emplace_back(x, z, std::min(x + HEIGHTMAP_UPDATE_TILE_SIZE - 1, rect.x2), std::min(z + HEIGHTMAP_UPDATE_TILE_SIZE - 1, rect.z2));
 			}
 		}
-		#endif
+	};
 
-		HeightMapUpdateLOSCheck(cornerRect);
+	// NOTE:
+	//   stages depend on the output of their predecessors but tiles within a stage only read
+	//   data written by earlier stages, so each runs as one parallel pass over all tiles of
+	//   all rectangles; where (clamped) tiles overlap they write identical values
+	heightMapUpdateTiles.clear();
+
+	for (size_t i = 0; i < numRects; i++) {
+		AddTiles(GetCenterRect(hgtMapRects[i]));
+	}
+
+	for_mt(0, heightMapUpdateTiles.size(), [&](const int i) {
+		UpdateCenterHeightmap(heightMapUpdateTiles[i], initialize);
+	});
+
+	for (int mipLevel = 0; mipLevel < numHeightMipMaps - 1; mipLevel++) {
+		heightMapUpdateTiles.clear();
+
+		for (size_t i = 0; i < numRects; i++) {
+			const SRectangle rect = GetCenterRect(hgtMapRects[i]);
+
+			const int sx = (rect.x1 >> mipLevel) & (~1);
+			const int ex = (rect.x2 >> mipLevel);
+			const int sy = (rect.z1 >> mipLevel) & (~1);
+			const int ey = (rect.z2 >> mipLevel);
+
+			if (ex <= sx || ey <= sy)
+				continue;
+
+			AddTiles({sx, sy, ex - 1, ey - 1});
+		}
+
+		for_mt(0, heightMapUpdateTiles.size(), [&](const int i) {
+			UpdateMipHeightmap(heightMapUpdateTiles[i], mipLevel);
+		});
+	}
+
+	heightMapUpdateTiles.clear();
+
+	for (size_t i = 0; i < numRects; i++) {
+		const SRectangle rect = GetCenterRect(hgtMapRects[i]);
+
+		const int z1 = std::max(             0, rect.z1 - 1);
+		const int x1 = std::max(             0, rect.x1 - 1);
+		const int z2 = std::min(mapDims.mapym1, rect.z2 + 1);
+		const int x2 = std::min(mapDims.mapxm1, rect.x2 + 1);
+
+		AddTiles({x1, z1, x2, z2});
+	}
+
+	for_mt(0, heightMapUpdateTiles.size(), [&](const int i) {
+		UpdateFaceNormals(heightMapUpdateTiles[i], initialize);
+	});
+
+	heightMapUpdateTiles.clear();
+
+	for (size_t i = 0; i < numRects; i++) {
+		const SRectangle rect = GetCenterRect(hgtMapRects[i]);
+
+		const int sx = std::max(0,                 (rect.x1 / 2) - 1);
+		const int ex = std::min(mapDims.hmapx - 1, (rect.x2 / 2) + 1);
+		const int sy = std::max(0,                 (rect.z1 / 2) - 1);
+		const int ey = std::min(mapDims.hmapy - 1, (rect.z2 / 2) + 1);
+
+		AddTiles({sx, sy, ex, ey});
+	}
+
+	// must happen after UpdateFaceNormals()!
+	for_mt(0, heightMapUpdateTiles.size(), [&](const int i) {
+		UpdateSlopemap(heightMapUpdateTiles[i], initialize);
+	});
+
+	for (size_t i = 0; i < numRects; i++) {
+		const SRectangle cornerRect = GetCornerRect(hgtMapRects[i]);
+
+		// the initial update is not a deformation
+		if (!initialize)
+			heightMapChangeTracker.MarkChanged(GetCenterRect(hgtMapRects[i]));
+
+		#ifdef USE_UNSYNCED_HEIGHTMAP
+		// push the unsynced update; initial one without LOS check
+		if (initialize) {
+			unsyncedHeightMapUpdates.push_back(cornerRect);
+		} else {
+			HeightMapUpdateLOSCheck(cornerRect);
+		}
+		#else
+		unsyncedHeightMapUpdates.push_back(cornerRect);
+		#endif
 	}
-	#else
-	unsyncedHeightMapUpdates.push_back(cornerRect);
-	#endif
+}
+
+
+// NOTE:
+//   rectangles are clamped to map{x,y}m1 which are the proper inclusive bounds for center heightmaps
+//   parts of UpdateHeightMapUnsynced() (vertex normals, normal texture) however inclusively clamp to
+//   map{x,y} since they index corner heightmaps, while UnsyncedHeightMapUpdate() EventClients should
+//   already expect {x,z}2 <= map{x,y} and do internal clamping as well
+SRectangle CReadMap::GetCenterRect(const SRectangle& hgtMapRect) const
+{
+	return {std::max(hgtMapRect.x1 - 1, 0), std::max(hgtMapRect.z1 - 1, 0),  std::min(hgtMapRect.x2 + 1, mapDims.mapxm1),  std::min(hgtMapRect.z2 + 1, mapDims.mapym1)};
+}
+
+SRectangle CReadMap::GetCornerRect(const SRectangle& hgtMapRect) const
+{
+	return {std::max(hgtMapRect.x1 - 1, 0), std::max(hgtMapRect.z1 - 1, 0),  std::min(hgtMapRect.x2 + 1, mapDims.mapx  ),  std::min(hgtMapRect.z2 + 1, mapDims.mapy  )};
 }
 
 
@@ -558,28 +652,22 @@ void CReadMap::UpdateCenterHeightmap(const SRectangle& rect, bool initialize)
 }
 
 
-void CReadMap::UpdateMipHeightmaps(const SRectangle& rect, bool initialize)
+void CReadMap::UpdateMipHeightmap(const SRectangle& rect, int mipLevel)
 {
-	for (int i = 0; i < numHeightMipMaps - 1; i++) {
-		const int hmapx = mapDims.mapx >> i;
-
-		const int sx = (rect.x1 >> i) & (~1);
-		const int ex = (rect.x2 >> i);
-		const int sy = (rect.z1 >> i) & (~1);
-		const int ey = (rect.z2 >> i);
-
-		float* topMipMap = mipPointerHeightMaps[i    ];
-		float* subMipMap = mipPointerHeightMaps[i + 1];
-
-		for (int y = sy; y < ey; y += 2) {
-			for (int x = sx; x < ex; x += 2) {
-				const float height =
-					topMipMap[(x    ) + (y    ) * hmapx] +
-					topMipMap[(x    ) + (y + 1) * hmapx] +
-					topMipMap[(x + 1) + (y    ) * hmapx] +
-					topMipMap[(x + 1) + (y + 1) * hmapx];
-				subMipMap[(x / 2) + (y / 2) * hmapx / 2] = height * 0.25f;
-			}
+	const int hmapx = mapDims.mapx >> mipLevel;
+
+	const float* topMipMap = mipPointerHeightMaps[mipLevel    ];
+	      float* subMipMap = mipPointerHeightMaps[mipLevel + 1];
+
+	// rect is in (mipLevel) top-map space, x1 and z1 are even
+	for (int y = rect.z1; y <= rect.z2; y += 2) {
+		for (int x = rect.x1; x <= rect.x2; x += 2) {
+			const float height =
+				topMipMap[(x    ) + (y    ) * hmapx] +
+				topMipMap[(x    ) + (y + 1) * hmapx] +
+				topMipMap[(x + 1) + (y    ) * hmapx] +
+				topMipMap[(x + 1) + (y + 1) * hmapx];
+			subMipMap[(x / 2) + (y / 2) * hmapx / 2] = height * 0.25f;
 		}
 	}
 }
@@ -589,16 +677,11 @@ void CReadMap::UpdateFaceNormals(const SRectangle& rect, bool initialize)
 {
 	const float* heightmapSynced = GetCornerHeightMapSynced();
 
-	const int z1 = std::max(             0, rect.z1 - 1);
-	const int x1 = std::max(             0, rect.x1 - 1);
-	const int z2 = std::min(mapDims.mapym1, rect.z2 + 1);
-	const int x2 = std::min(mapDims.mapxm1, rect.x2 + 1);
-
-	for_mt(z1, z2+1, [&](const int y) {
+	for (int y = rect.z1; y <= rect.z2; y++) {
 		float3 fnTL;
 		float3 fnBR;
 
-		for (int x = x1; x <= x2; x++) {
+		for (int x = rect.x1; x <= rect.x2; x++) {
 			const int idxTL = (y    ) * mapDims.mapxp1 + x; // TL
 			const int idxBL = (y + 1) * mapDims.mapxp1 + x; // BL
 
@@ -651,19 +734,15 @@ void CReadMap::UpdateFaceNormals(const SRectangle& rect, bool initialize)
 			}
 			#endif
 		}
-	});
+	}
 }
 
 
 void CReadMap::UpdateSlopemap(const SRectangle& rect, bool initialize)
 {
-	const int sx = std::max(0,                 (rect.x1 / 2) - 1);
-	const int ex = std::min(mapDims.hmapx - 1, (rect.x2 / 2) + 1);
-	const int sy = std::max(0,                 (rect.z1 / 2) - 1);
-	const int ey = std::min(mapDims.hmapy - 1, (rect.z2 / 2) + 1);
-
-	for (int y = sy; y <= ey; y++) {
-		for (int x = sx; x <= ex; x++) {
+	// rect is in slopemap space
+	for (int y = rect.z1; y <= rect.z2; y++) {
+		for (int x = rect.x1; x <= rect.x2; x++) {
 			const int idx0 = (y*2    ) * (mapDims.mapx) + x*2;
 			const int idx1 = (y*2 + 1) * (mapDims.mapx) + x*2;
 
@@ -751,19 +830,19 @@ void CReadMap::HeightMapUpdateLOSCheck(const SRectangle& hgtMapRect)
 }
 
 
-void CReadMap::InitHeightMapDigestVectors(const int2 losMapSize)
+void CReadMap::InitHeightMapChangeTracking()
 {
-#if (defined(USE_HEIGHTMAP_DIGESTS) && defined(USE_UNSYNCED_HEIGHTMAP))
 	assert(losHandler != nullptr);
-	assert(syncedHeightMapDigests.empty());
+	assert(!heightMapChangeTracker.Initialized());
+
+	// tiles coincide with LOS-map squares, see HeightMapUpdateLOSCheck
+	heightMapChangeTracker.Init({mapDims.mapx, mapDims.mapy}, losHandler->los.mipDiv / SQUARE_SIZE);
 
-	const int xsize = losMapSize.x + 1;
-	const int ysize = losMapSize.y + 1;
+#if (defined(USE_HEIGHTMAP_DIGESTS) && defined(USE_UNSYNCED_HEIGHTMAP))
+	const int2 numTiles = heightMapChangeTracker.GetNumTiles();
 
-	syncedHeightMapDigests.clear();
-	syncedHeightMapDigests.resize(xsize * ysize, 0);
-	unsyncedHeightMapDigests.clear();
-	unsyncedHeightMapDigests.resize(xsize * ysize, 0);
+	unsyncedHeightMapVersions.clear();
+	unsyncedHeightMapVersions.resize(numTiles.x * numTiles.y, 0);
 #endif
 }
 
@@ -771,13 +850,15 @@ void CReadMap::InitHeightMapDigestVectors(const int2 losMapSize)
 bool CReadMap::HasHeightMapChanged(const int2 losMapPos)
 {
 #if (defined(USE_HEIGHTMAP_DIGESTS) && defined(USE_UNSYNCED_HEIGHTMAP))
-	const int2 losMapSize = losHandler->los.size;
-	const int losMapIdx = losMapPos.x + losMapPos.y * (losMapSize.x + 1);
+	const int2 numTiles = heightMapChangeTracker.GetNumTiles();
+	const int losMapIdx = losMapPos.x + losMapPos.y * numTiles.x;
+
+	assert(losMapIdx < unsyncedHeightMapVersions.size() && losMapIdx >= 0);
 
-	assert(losMapIdx < syncedHeightMapDigests.size() && losMapIdx >= 0);
+	const uint32_t tileVersion = heightMapChangeTracker.GetTileVersion(losMapPos.x, losMapPos.y);
 
-	if (unsyncedHeightMapDigests[losMapIdx] != syncedHeightMapDigests[losMapIdx]) {
-		unsyncedHeightMapDigests[losMapIdx] = syncedHeightMapDigests[losMapIdx];
+	if (unsyncedHeightMapVersions[losMapIdx] != tileVersion) {
+		unsyncedHeightMapVersions[losMapIdx] = tileVersion;
 		return true;
 	}
 
@@ -796,7 +877,7 @@ void CReadMap::UpdateLOS(const SRectangle& hgtMapRect)
 
 	// currently we use the LOS for view updates (alternatives are AirLOS and/or radar)
 	// the other maps use different resolutions, must check size here for safety
-	// (if another source is used, change the res. of syncedHeightMapDigests etc)
+	// (if another source is used, change the tile-size of heightMapChangeTracker)
 	assert(hgtMapRect.GetWidth() <= (losHandler->los.mipDiv / SQUARE_SIZE));
 	assert(losHandler != nullptr);
 
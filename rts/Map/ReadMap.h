@@ -8,6 +8,7 @@
 
 #include "MapTexture.h"
 #include "MapDimensions.h"
+#include "HeightMapChangeTracker.h"
 #include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/GlobalSynced.h"
 #include "System/float3.h"
@@ -88,13 +89,18 @@ public:
 	void Serialize(creg::ISerializer* s);
 	void PostLoad();
 
-	void InitHeightMapDigestVectors(const int2 losMapSize);
+	void InitHeightMapChangeTracking();
 
 	/**
 	 * calculates derived heightmap information
 	 * such as normals, centerheightmap and slopemap
 	 */
 	void UpdateHeightMapSynced(const SRectangle& hgtMapRect, bool initialize = false);
+	/**
+	 * coalesces all rectangles in hgtMapRects and recalculates
+	 * derived information for them in a single parallel pass
+	 */
+	void UpdateHeightMapSynced(CRectangleOverlapHandler& hgtMapRects);
 	void UpdateLOS(const SRectangle& hgtMapRect);
 	void BecomeSpectator();
 	void UpdateDraw(bool firstCall);
@@ -203,12 +209,21 @@ public:
 	bool HasOnlyVoidWater() const;
 
 	unsigned int GetMapChecksum() const { return mapChecksum; }
+
+	/// version-based change tracking for consumers of the synced heightmap
+	const CHeightMapChangeTracker& GetHeightMapChangeTracker() const { return heightMapChangeTracker; }
+
 	unsigned int CalcHeightmapChecksum();
 	unsigned int CalcTypemapChecksum();
 
 private:
+	void UpdateHeightMapSynced(const SRectangle* hgtMapRects, size_t numRects, bool initialize);
+
+	SRectangle GetCenterRect(const SRectangle& hgtMapRect) const;
+	SRectangle GetCornerRect(const SRectangle& hgtMapRect) const;
+
 	void UpdateCenterHeightmap(const SRectangle& rect, bool initialize);
-	void UpdateMipHeightmaps(const SRectangle& rect, bool initialize);
+	void UpdateMipHeightmap(const SRectangle& rect, int mipLevel);
 	void UpdateFaceNormals(const SRectangle& rect, bool initialize);
 	void UpdateSlopemap(const SRectangle& rect, bool initialize);
 
@@ -219,6 +234,9 @@ public:
 	/// number of heightmap mipmaps, including full resolution
 	static constexpr int numHeightMipMaps = 7;
 
+	/// squares per side of the work-items derived maps are updated in; must be even
+	static constexpr int HEIGHTMAP_UPDATE_TILE_SIZE = 32;
+
 protected:
 	// these point to the actual heightmap data
 	// which is allocated by subclass instances
@@ -253,6 +271,9 @@ protected:
 	CRectangleOverlapHandler unsyncedHeightMapUpdates;
 	CRectangleOverlapHandler unsyncedHeightMapUpdatesTemp;
 
+	// scratch-space for UpdateHeightMapSynced
+	std::vector<SRectangle> heightMapUpdateTiles;
+
 private:
 	// these combine the various synced and unsynced arrays
 	// for branch-less access: [0] = !synced, [1] = synced
@@ -262,13 +283,14 @@ private:
 	const float3* sharedCenterNormals[2];
 	const float* sharedSlopeMaps[2];
 
+	/// tracks synced deformations, with one tile per LOS-map square
+	CHeightMapChangeTracker heightMapChangeTracker;
+
 #ifdef USE_UNSYNCED_HEIGHTMAP
-	/// these are not "digests", just simple rolling counters
-	/// for each LOS-map square the counter value indicates how many times
-	/// the synced heightmap block of squares corresponding to it has been
-	/// changed, s.t. UHM updates are only pushed when necessary
-	static std::vector<uint8_t>   syncedHeightMapDigests;
-	static std::vector<uint8_t> unsyncedHeightMapDigests;
+	/// for each LOS-map square, the tracker version of its tile at the
+	/// time the unsynced heightmap was last updated from it, s.t. UHM
+	/// updates are only pushed when necessary
+	static std::vector<uint32_t> unsyncedHeightMapVersions;
 #endif
 
 	unsigned int mapChecksum = 0;
@@ -810,11 +810,10 @@ void CGame::ClientReadNet()
 						for (int16_t x = 0; x < std::min(unitCount, commandCount); ++x) {
 							selectedUnitsHandler.AINetOrder(unitIDs[x], aiInstID, playerID, commands[x]);
 						}
-					} else {
-						for (int16_t c = 0; c < commandCount; c++) {
-							for (int16_t u = 0; u < unitCount; u++) {
-								selectedUnitsHandler.AINetOrder(unitIDs[u], aiInstID, playerID, commands[c]);
-							}
+					} else if (commandCount > 0) {
+						// hand each unit the whole batch, like GiveOrderArrayToUnitArray
+						for (int16_t u = 0; u < unitCount; u++) {
+							selectedUnitsHandler.AINetOrders(unitIDs[u], aiInstID, playerID, commands.data(), commands.size());
 						}
 					}
 					AddTraffic(playerID, packetCode, dataLength);
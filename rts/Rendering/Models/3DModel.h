@@ -488,6 +488,13 @@ struct LocalModel
 
 	void UpdateBoundingVolume();
 	void UpdatePieceMatrices() { UpdatePieceMatrices(pmuFrameNum + 1); }
+	// resolves all lazily updated piece matrices, after which concurrent
+	// readers (e.g. ray vs. piece-tree hit-tests) no longer write to them
+	void UpdateDirtyPieceMatrices() const {
+		for (const LocalModelPiece& lmp: pieces) {
+			lmp.GetModelSpaceMatrix();
+		}
+	}
 	void UpdatePieceMatrices(unsigned int gsFrameNum);
 	void UpdateVolumeAndMatrices(bool updateChildMatrices) {
 		pieces[0].UpdateChildMatricesRec(updateChildMatrices);
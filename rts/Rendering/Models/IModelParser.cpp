@@ -15,10 +15,13 @@
 #include "System/Exceptions.h"
 #include "System/MainDefines.h" // SNPRINTF
 #include "System/SafeUtil.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/Threading/ThreadPool.h"
 #include "lib/assimp/include/assimp/Importer.hpp"
 
 
+CONFIG(bool, PrefetchDefModels).defaultValue(true).description("Start parsing the models (and textures) of all unit and feature definitions in the background while the game is loading.");
+
 CModelLoader modelLoader;
 
 static C3DOParser g3DOParser;
@@ -131,6 +134,11 @@ void CModelLoader::Init()
 
 	// dummy first model, legitimate model IDs start at 1
 	models[0] = std::move(CreateDummyModel(numModels = 0));
+
+	preloadQueue.clear();
+	preloadStats = {};
+
+	prefetchDefModels = configHandler->GetBool("PrefetchDefModels");
 }
 
 void CModelLoader::InitParsers()
@@ -207,23 +215,72 @@ std::string CModelLoader::FindModelPath(std::string name) const
 
 void CModelLoader::PreloadModel(const std::string& modelName)
 {
-	assert(Threading::IsMainThread());
+	// defs are parsed (and start prefetching) on the loading thread
+	assert(Threading::IsMainThread() || Threading::IsGameLoadThread());
 
 	if (modelName.empty())
 		return;
 	if (!ThreadPool::HasThreads())
 		return;
 
-	// if already in cache, thread just returns early
-	// not spawning the thread at all would be better but still
-	// requires locking around cache.find(...) since some other
-	// preload worker might be down in CreateModel modifying it
-	// at the same time
-	ThreadPool::Enqueue([modelName]() {
-		modelLoader.LoadModel(modelName, true);
+	const std::string& lcModelName = StringToLower(modelName);
+
+	{
+		std::lock_guard<spring::mutex> lock(mutex);
+
+		// already parsed or in flight; defs commonly share models
+		if (cache.find(lcModelName) != cache.end())
+			return;
+		if (!preloadQueue.insert(lcModelName).second)
+			return;
+
+		preloadStats.numQueued += 1;
+	}
+
+	ThreadPool::Enqueue([lcModelName]() {
+		// dequeues the model and wakes up waiters however parsing ends, else
+		// a LoadModel caller waiting for <lcModelName> would block forever
+		struct PreloadGuard {
+			~PreloadGuard() {
+				{
+					std::lock_guard<spring::mutex> lock(modelLoader.mutex);
+
+					modelLoader.preloadQueue.erase(name);
+					modelLoader.preloadStats.numParsed += 1;
+					modelLoader.preloadStats.parseTime += (spring_now() - t0).toMilliSecsi();
+				}
+
+				// hand the parsed model over to any LoadModel caller waiting for it
+				modelLoader.preloadCond.notify_all();
+			}
+
+			const std::string& name;
+			const spring_time t0;
+		} guard{lcModelName, spring_now()};
+
+		try {
+			modelLoader.LoadModel(lcModelName, true);
+		} catch (const std::exception& ex) {
+			// not cached, LoadModel parses it again and reports the error
+			LOG_L(L_WARNING, "[%s] failed to preload model \"%s\": %s", __func__, lcModelName.c_str(), ex.what());
+		} catch (...) {
+			LOG_L(L_WARNING, "[%s] failed to preload model \"%s\"", __func__, lcModelName.c_str());
+		}
 	});
 }
 
+void CModelLoader::LogPreloadStats()
+{
+	std::lock_guard<spring::mutex> lock(mutex);
+
+	const PreloadStats& ps = preloadStats;
+
+	if (ps.numQueued == 0)
+		return;
+
+	LOG("[ModelLoader::%s] {queued,parsed,waited}={%u,%u,%u} models, worker-time=%ldms, wait-time=%ldms", __func__, ps.numQueued, ps.numParsed, ps.numWaited, long(ps.parseTime), long(ps.waitTime));
+}
+
 void CModelLoader::LogErrors()
 {
 	assert(Threading::IsMainThread());
@@ -259,7 +316,17 @@ S3DModel* CModelLoader::LoadModel(std::string name, bool preload)
 	StringToLowerInPlace(name);
 
 	{
-		std::lock_guard<spring::mutex> lock(mutex);
+		std::unique_lock<spring::mutex> lock(mutex);
+
+		// do not parse a model twice if a preload worker is already on it
+		if (!preload && preloadQueue.find(name) != preloadQueue.end()) {
+			const spring_time t0 = spring_now();
+
+			preloadCond.wait(lock, [&]() { return (preloadQueue.find(name) == preloadQueue.end()); });
+
+			preloadStats.numWaited += 1;
+			preloadStats.waitTime += (spring_now() - t0).toMilliSecsi();
+		}
 
 		// search in cache first
 		for (const auto& ref: refs) {
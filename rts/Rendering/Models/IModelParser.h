@@ -8,6 +8,7 @@
 
 #include "3DModel.h"
 #include "System/UnorderedMap.hpp"
+#include "System/UnorderedSet.hpp"
 #include "System/Threading/SpringThreading.h"
 
 
@@ -31,8 +32,10 @@ public:
 	std::string FindModelPath(std::string name) const;
 
 	bool IsValid() const { return (!formats.empty()); }
+	bool PrefetchDefModels() const { return prefetchDefModels; }
 	void PreloadModel(const std::string& name);
 	void LogErrors();
+	void LogPreloadStats();
 
 public:
 	typedef spring::unordered_map<std::string, unsigned int> ModelMap; // "armflash.3do" --> id
@@ -58,12 +61,32 @@ private:
 	ParserMap parsers;
 
 	spring::mutex mutex;
+	// signalled whenever a preload worker finishes a model
+	spring::condition_variable_any preloadCond;
 
 	std::vector<S3DModel> models;
 	std::vector< std::pair<std::string, std::string> > errors;
 
+	// names of models queued by PreloadModel but not yet parsed
+	spring::unordered_set<std::string> preloadQueue;
+
+	struct PreloadStats {
+		unsigned int numQueued = 0;
+		unsigned int numParsed = 0;
+		unsigned int numWaited = 0;
+
+		// summed over all workers
+		std::int64_t parseTime = 0;
+		// spent by LoadModel waiting for in-flight preloads
+		std::int64_t waitTime = 0;
+	};
+
+	PreloadStats preloadStats;
+
 	// all unique models loaded so far
 	unsigned int numModels = 0;
+
+	bool prefetchDefModels = true;
 };
 
 extern CModelLoader modelLoader;
@@ -42,6 +42,9 @@ void QTPFSPathDrawer::DrawAll() const {
 
 	if (md == nullptr)
 		return;
+	// nothing to show until the layer is rebuilt
+	if (pm->IsNodeLayerEvicted(md->pathType))
+		return;
 
 	if (!enabled)
 		return;
@@ -56,7 +59,9 @@ void QTPFSPathDrawer::DrawAll() const {
 	visibleNodes.clear();
 	visibleNodes.reserve(256);
 
-	GetVisibleNodes(pm->GetNodeTree(md->pathType), pm->GetNodeLayer(md->pathType), visibleNodes);
+	// null while the layer is evicted
+	if (pm->GetNodeTree(md->pathType) != nullptr)
+		GetVisibleNodes(pm->GetNodeTree(md->pathType), pm->GetNodeLayer(md->pathType), visibleNodes);
 
 	if (!visibleNodes.empty()) {
 		GL::RenderDataBufferC* rdb = GL::GetRenderBufferC();
@@ -470,7 +470,9 @@ bool CBitmap::Load(const std::string& filename, uint8_t defaultAlpha)
 		return false;
 	}
 
-	if (!file.IsBuffered()) {
+	if (file.IsMapped()) {
+		// stored archive entry, decoded straight from the mapping below
+	} else if (!file.IsBuffered()) {
 		buffer.resize(file.FileSize(), 0);
 		file.Read(buffer.data(), buffer.size());
 	} else {
@@ -478,6 +480,9 @@ bool CBitmap::Load(const std::string& filename, uint8_t defaultAlpha)
 		buffer = std::move(file.GetBuffer());
 	}
 
+	const uint8_t* fileData = file.IsMapped()? file.GetMapping().GetData(): buffer.data();
+	const size_t    fileSize = file.IsMapped()? file.GetMapping().GetSize(): buffer.size();
+
 
 	{
 		std::lock_guard<spring::mutex> lck(texMemPool.GetMutex());
@@ -495,7 +500,7 @@ bool CBitmap::Load(const std::string& filename, uint8_t defaultAlpha)
 			// do not signal floating point exceptions in devil library
 			ScopedDisableFpuExceptions fe;
 
-			isLoaded = !!ilLoadL(IL_TYPE_UNKNOWN, buffer.data(), buffer.size());
+			isLoaded = !!ilLoadL(IL_TYPE_UNKNOWN, fileData, fileSize);
 			isValid = (isLoaded && IsValidImageFormat(ilGetInteger(IL_IMAGE_FORMAT)));
 			noAlpha = (isValid && (ilGetInteger(IL_IMAGE_BYTES_PER_PIXEL) != 4));
 
@@ -561,7 +566,9 @@ bool CBitmap::LoadGrayscale(const std::string& filename)
 
 	std::vector<uint8_t> buffer;
 
-	if (!file.IsBuffered()) {
+	if (file.IsMapped()) {
+		// stored archive entry, decoded straight from the mapping below
+	} else if (!file.IsBuffered()) {
 		buffer.resize(file.FileSize() + 1, 0);
 		file.Read(buffer.data(), file.FileSize());
 	} else {
@@ -569,6 +576,9 @@ bool CBitmap::LoadGrayscale(const std::string& filename)
 		buffer = std::move(file.GetBuffer());
 	}
 
+	const uint8_t* fileData = file.IsMapped()? file.GetMapping().GetData(): buffer.data();
+	const size_t    fileSize = file.IsMapped()? file.GetMapping().GetSize(): buffer.size();
+
 	{
 		std::lock_guard<spring::mutex> lck(texMemPool.GetMutex());
 
@@ -579,7 +589,7 @@ bool CBitmap::LoadGrayscale(const std::string& filename)
 		ilGenImages(1, &imageID);
 		ilBindImage(imageID);
 
-		const bool success = !!ilLoadL(IL_TYPE_UNKNOWN, buffer.data(), buffer.size());
+		const bool success = !!ilLoadL(IL_TYPE_UNKNOWN, fileData, fileSize);
 		ilDisable(IL_ORIGIN_SET);
 
 		if (!success)
@@ -5,6 +5,7 @@
 #include "FeatureDef.h"
 #include "Lua/LuaParser.h"
 #include "Map/ReadMap.h"
+#include "Rendering/Models/IModelParser.h"
 #include "Sim/Misc/CollisionVolume.h"
 #include "Sim/Objects/SolidObject.h"
 #include "System/Exceptions.h"
@@ -35,7 +36,13 @@ void CFeatureDefHandler::Init(LuaParser* defsParser)
 		const std::string& nameLowerCase = StringToLower(nameMixedCase);
 		const LuaTable& fdTable = rootTable.SubTable(nameMixedCase);
 
-		AddFeatureDef(nameLowerCase, CreateFeatureDef(fdTable, nameLowerCase), false);
+		FeatureDef* fd = CreateFeatureDef(fdTable, nameLowerCase);
+
+		AddFeatureDef(nameLowerCase, fd, false);
+
+		// parse the model on a worker while the remaining defs are processed
+		if (fd != nullptr && modelLoader.PrefetchDefModels())
+			fd->PreloadModel();
 	}
 	for (unsigned int i = 0; i < keys.size(); i++) {
 		const std::string& nameMixedCase = keys[i];
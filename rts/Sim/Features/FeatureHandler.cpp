@@ -21,7 +21,8 @@ CR_REG_METADATA(CFeatureHandler, (
 	CR_MEMBER(deletedFeatureIDs),
 	CR_MEMBER(activeFeatureIDs),
 	CR_MEMBER(features),
-	CR_MEMBER(updateFeatures)
+	CR_MEMBER(updateFeatures),
+	CR_IGNORED(heightMapVersion)
 ))
 
 /******************************************************************************/
@@ -52,6 +53,8 @@ void CFeatureHandler::Kill() {
 	deletedFeatureIDs.clear();
 	features.clear();
 	updateFeatures.clear();
+
+	heightMapVersion = 0;
 }
 
 
@@ -178,6 +181,11 @@ void CFeatureHandler::Update()
 {
 	SCOPED_TIMER("Sim::Features");
 
+	// re-check features standing on terrain deformed since the last update
+	readMap->GetHeightMapChangeTracker().ForEachChangedRect(heightMapVersion, [this](const SRectangle& r) {
+		TerrainChanged(r.x1, r.z1, r.x2, r.z2);
+	});
+
 	if ((gs->frameNum & 31) == 0) {
 		const auto& pred = [this](int id) { return (this->TryFreeFeatureID(id)); };
 		const auto& iter = std::remove_if(deletedFeatureIDs.begin(), deletedFeatureIDs.end(), pred);
@@ -252,6 +260,19 @@ void CFeatureHandler::SetFeatureUpdateable(CFeature* feature)
 }
 
 
+void CFeatureHandler::UpdateDirtyPieceMatrices() const
+{
+	for (const int featureID: activeFeatureIDs) {
+		const CFeature* f = features[featureID];
+
+		if (!f->collisionVolume.DefaultToPieceTree())
+			continue;
+
+		f->localModel.UpdateDirtyPieceMatrices();
+	}
+}
+
+
 void CFeatureHandler::TerrainChanged(int x1, int y1, int x2, int y2)
 {
 	const float3 mins(x1 * SQUARE_SIZE, 0, y1 * SQUARE_SIZE);
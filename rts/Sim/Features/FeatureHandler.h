@@ -3,6 +3,7 @@
 #ifndef _FEATURE_HANDLER_H
 #define _FEATURE_HANDLER_H
 
+#include <cinttypes>
 #include <vector>
 
 #include "System/float3.h"
@@ -64,6 +65,9 @@ public:
 
 	void SetFeatureUpdateable(CFeature* feature);
 	void TerrainChanged(int x1, int y1, int x2, int y2);
+	// resolves the lazily updated piece matrices of all features with
+	// piece-tree collision volumes, see CUnitHandler::UpdateUnitWeapons
+	void UpdateDirtyPieceMatrices() const;
 
 	const spring::unordered_set<int>& GetActiveFeatureIDs() const { return activeFeatureIDs; }
 
@@ -88,6 +92,9 @@ private:
 	std::vector<int> deletedFeatureIDs;
 	std::vector<CFeature*> features;
 	std::vector<CFeature*> updateFeatures;
+
+	// version of the heightmap-change tracker as of the last Update
+	std::uint32_t heightMapVersion = 0;
 };
 
 extern CFeatureHandler featureHandler;
@@ -10,14 +10,14 @@
 #include "System/Matrix44f.h"
 #include "System/Log/ILog.h"
 
-unsigned int CCollisionHandler::numDiscTests = 0;
-unsigned int CCollisionHandler::numContTests = 0;
+std::atomic<unsigned int> CCollisionHandler::numDiscTests = {0};
+std::atomic<unsigned int> CCollisionHandler::numContTests = {0};
 
 
 
 void CCollisionHandler::PrintStats()
 {
-	LOG("[CCollisionHandler] dis-/continuous tests: %i/%i", numDiscTests, numContTests);
+	LOG("[CCollisionHandler] dis-/continuous tests: %u/%u", numDiscTests.load(), numContTests.load());
 }
 
 
@@ -0,0 +1,140 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <xmmintrin.h>
+
+#include "CollisionVolumeBatch.h"
+#include "System/MainDefines.h"
+
+#include <algorithm>
+#include <cassert>
+
+
+// one ray segment broadcast over four lanes
+struct RayLanes {
+	RayLanes() = default;
+	RayLanes(const float3& p0, const float3& p1) {
+		const float3 dir = p1 - p0;
+		const float dirSqLen = dir.SqLength();
+
+		px = _mm_set1_ps(p0.x);
+		py = _mm_set1_ps(p0.y);
+		pz = _mm_set1_ps(p0.z);
+		dx = _mm_set1_ps(dir.x);
+		dy = _mm_set1_ps(dir.y);
+		dz = _mm_set1_ps(dir.z);
+		// zero-length segments degenerate into point tests (t=0)
+		is = _mm_set1_ps((dirSqLen > 0.0f)? (1.0f / dirSqLen): 0.0f);
+	}
+
+	__m128 px, py, pz;
+	__m128 dx, dy, dz;
+	__m128 is;
+};
+
+
+// returns a 4-bit mask of the spheres <c, rs> touched by segment <r>
+static inline int TestSegmentSpheres(const RayLanes& r, const __m128 cx, const __m128 cy, const __m128 cz, const __m128 rs)
+{
+	// sphere-centers relative to the start of the segment
+	const __m128 wx = _mm_sub_ps(cx, r.px);
+	const __m128 wy = _mm_sub_ps(cy, r.py);
+	const __m128 wz = _mm_sub_ps(cz, r.pz);
+
+	// parameter of the point on the segment closest to each center
+	__m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(wx, r.dx), _mm_mul_ps(wy, r.dy)), _mm_mul_ps(wz, r.dz));
+	t = _mm_mul_ps(t, r.is);
+	t = _mm_max_ps(t, _mm_setzero_ps());
+	t = _mm_min_ps(t, _mm_set1_ps(1.0f));
+
+	const __m128 ex = _mm_sub_ps(wx, _mm_mul_ps(r.dx, t));
+	const __m128 ey = _mm_sub_ps(wy, _mm_mul_ps(r.dy, t));
+	const __m128 ez = _mm_sub_ps(wz, _mm_mul_ps(r.dz, t));
+	const __m128 sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)), _mm_mul_ps(ez, ez));
+
+	return (_mm_movemask_ps(_mm_cmple_ps(sq, rs)));
+}
+
+
+
+void CollisionVolumeBatch::Pad()
+{
+	for (unsigned int n = 0; n < 4; n++) {
+		posx.push_back(0.0f);
+		posy.push_back(0.0f);
+		posz.push_back(0.0f);
+		radSq.push_back(-1.0f);
+	}
+}
+
+unsigned int CollisionVolumeBatch::AddSphere(const float3& pos, float radius)
+{
+	if ((numVolumes & 3) == 0)
+		Pad();
+
+	posx[numVolumes] = pos.x;
+	posy[numVolumes] = pos.y;
+	posz[numVolumes] = pos.z;
+	radSq[numVolumes] = radius * radius;
+
+	return (numVolumes++);
+}
+
+
+__FORCE_ALIGN_STACK__
+unsigned int CollisionVolumeBatch::TestRay(const float3& p0, const float3& p1, std::vector<unsigned int>& hits) const
+{
+	const RayLanes ray(p0, p1);
+	const size_t numHits = hits.size();
+
+	for (unsigned int i = 0; i < numVolumes; i += 4) {
+		const __m128 cx = _mm_loadu_ps(&posx[i]);
+		const __m128 cy = _mm_loadu_ps(&posy[i]);
+		const __m128 cz = _mm_loadu_ps(&posz[i]);
+		const __m128 rs = _mm_loadu_ps(&radSq[i]);
+
+		const int mask = TestSegmentSpheres(ray, cx, cy, cz, rs);
+
+		if (mask == 0)
+			continue;
+
+		for (unsigned int j = 0; j < 4; j++) {
+			if ((mask & (1 << j)) != 0)
+				hits.push_back(i + j);
+		}
+	}
+
+	return (hits.size() - numHits);
+}
+
+__FORCE_ALIGN_STACK__
+void CollisionVolumeBatch::TestRays(const float3* p0s, const float3* p1s, unsigned int numRays, std::vector<std::uint32_t>& masks) const
+{
+	assert(numRays <= MAX_RAYS);
+
+	RayLanes rays[MAX_RAYS];
+
+	for (unsigned int r = 0; r < numRays; r++) {
+		rays[r] = RayLanes(p0s[r], p1s[r]);
+	}
+
+	masks.clear();
+	masks.resize(numVolumes, 0);
+
+	// volume-major, each group of four stays in registers for all rays
+	for (unsigned int i = 0; i < numVolumes; i += 4) {
+		const __m128 cx = _mm_loadu_ps(&posx[i]);
+		const __m128 cy = _mm_loadu_ps(&posy[i]);
+		const __m128 cz = _mm_loadu_ps(&posz[i]);
+		const __m128 rs = _mm_loadu_ps(&radSq[i]);
+
+		const unsigned int numLanes = std::min(4u, numVolumes - i);
+
+		for (unsigned int r = 0; r < numRays; r++) {
+			const int mask = TestSegmentSpheres(rays[r], cx, cy, cz, rs);
+
+			for (unsigned int j = 0; j < numLanes; j++) {
+				masks[i + j] |= (((mask >> j) & 1u) << r);
+			}
+		}
+	}
+}
@@ -0,0 +1,60 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef COLLISION_VOLUME_BATCH_H
+#define COLLISION_VOLUME_BATCH_H
+
+#include <cinttypes>
+#include <vector>
+
+#include "System/float3.h"
+
+// packed (SoA) bounding-spheres of the candidate volumes of a ray-query,
+// tested four at a time against one or more ray segments; this is only a
+// broad-phase: spheres are exact for COLVOL_TYPE_SPHERE and conservative
+// for the other types, so callers still run CCollisionHandler's per-type
+// tests on whatever passes (which keeps synced results unchanged)
+struct CollisionVolumeBatch {
+public:
+	static constexpr unsigned int MAX_RAYS = 32;
+
+	void Clear() {
+		numVolumes = 0;
+
+		posx.clear();
+		posy.clear();
+		posz.clear();
+		radSq.clear();
+	}
+	void Reserve(unsigned int n) {
+		posx.reserve(n + 3);
+		posy.reserve(n + 3);
+		posz.reserve(n + 3);
+		radSq.reserve(n + 3);
+	}
+
+	// volumes are referred to by their insertion index
+	unsigned int AddSphere(const float3& pos, float radius);
+
+	// appends the indices (in ascending order) of all volumes whose
+	// sphere is touched by segment <p0, p1> to <hits>, returns count
+	unsigned int TestRay(const float3& p0, const float3& p1, std::vector<unsigned int>& hits) const;
+	// multi-ray variant for salvos; bit r of <masks[i]> is set iff ray
+	// <p0s[r], p1s[r]> touches volume i (at most MAX_RAYS rays per call)
+	void TestRays(const float3* p0s, const float3* p1s, unsigned int numRays, std::vector<std::uint32_t>& masks) const;
+
+	unsigned int GetNumVolumes() const { return numVolumes; }
+
+private:
+	void Pad();
+
+private:
+	// padded to a multiple of four; padding-lanes have a negative radSq
+	std::vector<float> posx;
+	std::vector<float> posy;
+	std::vector<float> posz;
+	std::vector<float> radSq;
+
+	unsigned int numVolumes = 0;
+};
+
+#endif
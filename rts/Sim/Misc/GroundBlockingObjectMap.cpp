@@ -22,7 +22,12 @@ CR_BIND(CGroundBlockingObjectMap, )
 CR_REG_METADATA(CGroundBlockingObjectMap, (
 	CR_MEMBER(arrCells),
 	CR_MEMBER(vecCells),
-	CR_MEMBER(vecIndcs)
+	CR_MEMBER(vecIndcs),
+	CR_MEMBER(cellBlockBits),
+	CR_MEMBER(occupancyBits),
+	CR_MEMBER(numSqrsX),
+	CR_MEMBER(numSqrsZ),
+	CR_MEMBER(occupancyStride)
 ))
 
 
@@ -213,14 +218,8 @@ bool CGroundBlockingObjectMap::CheckYard(const CSolidObject* yardUnit, const Yar
 
 unsigned int CGroundBlockingObjectMap::CalcChecksum() const
 {
-	unsigned int checksum = 666;
-
-	for (unsigned int i = 0; i < arrCells.size(); ++i) {
-		if (!arrCells[i].Empty())
-			checksum = HsiehHash(&i, sizeof(i), checksum);
-	}
-
-	return checksum;
+	// the occupancy bitmap encodes exactly which cells are non-empty
+	return (HsiehHash(occupancyBits.data(), occupancyBits.size() * sizeof(uint64_t), 666));
 }
 
 
@@ -231,6 +230,10 @@ bool CGroundBlockingObjectMap::CellInsertUnique(unsigned int sqr, CSolidObject*
 
 	if (ac.Contains(o))
 		return false;
+
+	cellBlockBits[sqr] |= CalcObjectBlockBits(o);
+	SetOccupancyBit(sqr, true);
+
 	if (ac.Insert(o))
 		return true;
 
@@ -254,8 +257,10 @@ bool CGroundBlockingObjectMap::CellErase(unsigned int sqr, CSolidObject* o) {
 	VecCell* vc = nullptr;
 
 	if (ac.Erase(o)) {
-		if (ac.GetVecIndx() == 0)
+		if (ac.GetVecIndx() == 0) {
+			UpdateCellBlockBits(sqr);
 			return true;
+		}
 
 		// never allow a hole between array and vector parts
 		assert(!vecCells[ac.GetVecIndx()].empty());
@@ -284,6 +289,20 @@ CommonExit:
 		ac.SetVecIndx(0);
 	}
 
+	UpdateCellBlockBits(sqr);
 	return true;
 }
 
+void CGroundBlockingObjectMap::UpdateCellBlockBits(unsigned int sqr) {
+	const BlockingMapCell& cell = GetCellUnsafeConst(sqr);
+
+	uint8_t bits = 0;
+
+	for (size_t i = 0, n = cell.size(); i < n; i++) {
+		bits |= CalcObjectBlockBits(cell[i]);
+	}
+
+	cellBlockBits[sqr] = bits;
+	SetOccupancyBit(sqr, bits != 0);
+}
+
@@ -3,10 +3,12 @@
 #ifndef GROUNDBLOCKINGOBJECTMAP_H
 #define GROUNDBLOCKINGOBJECTMAP_H
 
+#include <algorithm>
 #include <array>
 #include <vector>
 
 #include "Sim/Objects/SolidObject.h"
+#include "System/bitops.h"
 #include "System/creg/creg_cond.h"
 #include "System/float3.h"
 
@@ -15,7 +17,7 @@ class CGroundBlockingObjectMap
 	CR_DECLARE_STRUCT(CGroundBlockingObjectMap)
 
 private:
-	template<typename T, uint32_t S = 8> struct ArrayCell {
+	template<typename T, uint32_t S = 3> struct ArrayCell {
 	public:
 		CR_DECLARE_STRUCT(ArrayCell)
 
@@ -69,10 +71,17 @@ private:
 		std::array<T*, S> arr;
 	};
 
+	// three inline slots keep a cell at 32 bytes (two per cache-line);
+	// most squares hold at most one or two objects, the rest spill over
 	typedef ArrayCell<CSolidObject> ArrCell;
 	typedef std::vector<CSolidObject*> VecCell;
 
 public:
+	enum {
+		CELL_BIT_MOBILE   = 1, // cell contains at least one object with a MoveDef
+		CELL_BIT_IMMOBILE = 2, // cell contains at least one object without a MoveDef
+	};
+
 	struct BlockingMapCell {
 	public:
 		BlockingMapCell() = delete;
@@ -97,8 +106,14 @@ public:
 	};
 
 
-	void Init(unsigned int numSquares) {
-		arrCells.resize(numSquares);
+	void Init(unsigned int numSquaresX, unsigned int numSquaresZ) {
+		numSqrsX = numSquaresX;
+		numSqrsZ = numSquaresZ;
+		occupancyStride = (numSquaresX + 63) / 64;
+
+		arrCells.resize(numSquaresX * numSquaresZ);
+		cellBlockBits.resize(numSquaresX * numSquaresZ, 0);
+		occupancyBits.resize(occupancyStride * numSquaresZ, 0);
 		vecCells.reserve(32);
 		vecIndcs.reserve(32);
 
@@ -116,6 +131,9 @@ public:
 			v.clear();
 		}
 
+		std::fill(cellBlockBits.begin(), cellBlockBits.end(), 0);
+		std::fill(occupancyBits.begin(), occupancyBits.end(), 0);
+
 		vecIndcs.clear();
 	}
 
@@ -150,6 +168,55 @@ public:
 	bool GroundBlocked(int x, int z, const CSolidObject* ignoreObj) const;
 	bool GroundBlocked(const float3& pos, const CSolidObject* ignoreObj) const;
 
+
+	// bulk queries over the occupancy bitmap; these take half-open square
+	// ranges [x1,x2)*[z1,z2) which are clipped to the map (squares outside
+	// it are never blocked) and test 64 squares of a row at a time
+	bool RangeOccupied(int x1, int z1, int x2, int z2) const {
+		return (FindOccupiedSquare(x1, z1, x2, z2, [](unsigned int) { return true; }));
+	}
+	// true iff no square in range contains an object other than ignoreObj
+	bool IsFootprintFree(int x1, int z1, int x2, int z2, const CSolidObject* ignoreObj = nullptr) const {
+		return (!FindOccupiedSquare(x1, z1, x2, z2, [&](unsigned int mapSquare) {
+			const BlockingMapCell& cell = GetCellUnsafeConst(mapSquare);
+			return (cell[0] != ignoreObj || cell.size() >= 2);
+		}));
+	}
+
+	// calls pred(mapSquare) for each non-empty square in range (in row-major
+	// order) until it returns true, returns whether any call did
+	template<typename P> bool FindOccupiedSquare(int x1, int z1, int x2, int z2, P&& pred) const {
+		x1 = std::max(x1, 0); x2 = std::min(x2, int(numSqrsX));
+		z1 = std::max(z1, 0); z2 = std::min(z2, int(numSqrsZ));
+
+		if (x1 >= x2 || z1 >= z2)
+			return false;
+
+		const int w1 = x1 >> 6;
+		const int w2 = (x2 - 1) >> 6;
+
+		const uint64_t mask1 = ~0ull << (x1 & 63);
+		const uint64_t mask2 = ~0ull >> (63 - ((x2 - 1) & 63));
+
+		for (int z = z1; z < z2; z++) {
+			const uint64_t* rowBits = &occupancyBits[z * occupancyStride];
+
+			for (int w = w1; w <= w2; w++) {
+				uint64_t bits = rowBits[w];
+
+				bits &= ((w == w1)? mask1: ~0ull);
+				bits &= ((w == w2)? mask2: ~0ull);
+
+				for (; bits != 0; bits &= (bits - 1)) {
+					if (pred(z * numSqrsX + (w << 6) + count_trailing_zeros64(bits)))
+						return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
 	bool ObjectInCell(unsigned int mapSquare, const CSolidObject* obj) const {
 		if (mapSquare >= arrCells.size())
 			return false;
@@ -164,6 +231,12 @@ public:
 	}
 
 
+	// packed summary of the objects in a cell (CELL_BIT_*), zero iff empty
+	uint8_t GetCellBlockBits(unsigned int mapSquare) const {
+		assert(mapSquare < cellBlockBits.size());
+		return cellBlockBits[mapSquare];
+	}
+
 	BlockingMapCell GetCellUnsafeConst(const float3& pos) const;
 	BlockingMapCell GetCellUnsafeConst(unsigned int mapSquare) const {
 		assert(mapSquare < arrCells.size());
@@ -182,10 +255,28 @@ private:
 	bool CellInsertUnique(unsigned int sqr, CSolidObject* o);
 	bool CellErase(unsigned int sqr, CSolidObject* o);
 
+	void UpdateCellBlockBits(unsigned int sqr);
+	void SetOccupancyBit(unsigned int sqr, bool occupied) {
+		uint64_t& word = occupancyBits[(sqr / numSqrsX) * occupancyStride + ((sqr % numSqrsX) >> 6)];
+		const uint64_t bit = 1ull << ((sqr % numSqrsX) & 63);
+
+		word = (occupied)? (word | bit): (word & ~bit);
+	}
+
+	static uint8_t CalcObjectBlockBits(const CSolidObject* o) { return ((o->moveDef != nullptr)? CELL_BIT_MOBILE: CELL_BIT_IMMOBILE); }
+
 private:
 	std::vector<ArrCell> arrCells;
 	std::vector<VecCell> vecCells;
 	std::vector<uint32_t> vecIndcs;
+
+	std::vector<uint8_t> cellBlockBits;
+	// one bit per square, set iff the cell is non-empty; rows are padded to whole words
+	std::vector<uint64_t> occupancyBits;
+
+	unsigned int numSqrsX = 0;
+	unsigned int numSqrsZ = 0;
+	unsigned int occupancyStride = 0;
 };
 
 extern CGroundBlockingObjectMap groundBlockingObjectMap;
@@ -14,6 +14,7 @@
 #include "Sim/Weapons/WeaponDef.h"
 #include "System/EventHandler.h"
 #include "System/float3.h"
+#include "System/Rectangle.h"
 #include "System/SpringMath.h"
 #include "System/creg/STL_Deque.h"
 
@@ -28,93 +29,348 @@ CInterceptHandler interceptHandler;
 
 
 
+#define INTERCEPT_GRID_CELL_SIZE      512.0f
+#define INTERCEPT_GRID_MAX_CELLS       64
+#define INTERCEPT_GRID_MAX_ITEM_CELLS  64
+// absorbs rounding errors of the ray traversal near cell corners
+#define INTERCEPT_GRID_MARGIN           8.0f
+
+
 void CInterceptHandler::Update(bool forced) {
 	if (((gs->frameNum % UNIT_SLOWUPDATE_RATE) != 0) && !forced)
 		return;
+	if (interceptors.empty() || interceptables.empty())
+		return;
 
-	for (CWeapon* w: interceptors) {
-		const WeaponDef* wDef = w->weaponDef;
-		const CUnit* wOwner = w->owner;
-
-		assert(wDef->interceptor || wDef->isShield);
-
-		for (CWeaponProjectile* p: interceptables) {
-			if (!p->CanBeInterceptedBy(wDef))
-				continue;
-			if (w->HasIncomingProjectile(p->id))
-				continue;
-
-			const int pAllyTeam = p->GetAllyteamID();
-
-			if (teamHandler.IsValidAllyTeam(pAllyTeam) && teamHandler.Ally(wOwner->allyteam, pAllyTeam))
-				continue;
-
-			// note: will be called every Update so long as gadget does not return true
-			if (!eventHandler.AllowWeaponInterceptTarget(wOwner, w, p))
-				continue;
-
-			// there are four cases when an interceptor <w> should fire at a projectile <p>:
-			//     1. p's target position inside w's interception circle (w's owner can move!)
-			//     2. p's current position inside w's interception circle
-			//     3. p's projected impact position inside w's interception circle
-			//     4. p's trajectory intersects w's interception circle
-			//
-			// these checks all need to be evaluated periodically, not just
-			// when a projectile is created and handed to AddInterceptTarget
-			const float weaponDist = w->aimFromPos.distance(p->pos);
-			const float impactDist = CGround::LineGroundCol(p->pos, p->pos + p->dir * weaponDist);
-
-			const float3& pImpactPos = p->pos + p->dir * impactDist;
-			const float3& pTargetPos = p->GetTargetPos();
-			const float3  pWeaponVec = p->pos - w->aimFromPos;
-
-			if (w->aimFromPos.SqDistance2D(pTargetPos) < Square(wDef->coverageRange)) {
-				w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
-				w->AddIncomingProjectile(p->id);
-				continue; // 1
-			}
+	BuildInterceptorGrid();
 
-			if (false /*wDef->noFlyThroughIntercept*/) {
-				// <w> is just a static interceptor and fires only at projectiles
-				// TARGETED within its current interception area; any projectiles
-				// CROSSING its interception area aren't targeted
-				//XXX implement in lua?
-				continue;
-			}
+	candidatePairs.clear();
 
-			if (pWeaponVec.SqLength2D() < Square(wDef->coverageRange)) {
-				w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
-				w->AddIncomingProjectile(p->id);
-				continue; // 2
-			}
+	for (unsigned int pIdx = 0; pIdx < interceptables.size(); pIdx++) {
+		GatherCandidates(interceptables[pIdx], pIdx);
+	}
+
+	// restore the interceptor-major order of the all-pairs loop, s.t. all
+	// dependencies and AllowWeaponInterceptTarget calls happen in the same
+	// sequence (minus the pairs that were culled)
+	std::sort(candidatePairs.begin(), candidatePairs.end());
+
+	// a gadget might spawn interceptable projectiles from within the event
+	std::vector<std::uint64_t> pairs;
+	std::swap(pairs, candidatePairs);
+
+	for (const std::uint64_t key: pairs) {
+		TestInterceptPair(interceptors[key >> 32], interceptables[key & 0xFFFFFFFFu]);
+	}
+
+	std::swap(pairs, candidatePairs);
+}
+
+
+void CInterceptHandler::BuildInterceptorGrid()
+{
+	numAllyTeams = teamHandler.ActiveAllyTeams();
+
+	enemyAllyTeams.clear();
+	enemyAllyTeams.resize(numAllyTeams * numAllyTeams);
+
+	for (int a = 0; a < numAllyTeams; a++) {
+		for (int b = 0; b < numAllyTeams; b++) {
+			enemyAllyTeams[a * numAllyTeams + b] = !teamHandler.Ally(b, a);
+		}
+	}
+
+	interceptorAllyTeams.clear();
+	interceptorAllyTeams.resize(interceptors.size());
+	interceptorStamps.clear();
+	interceptorStamps.resize(interceptors.size(), -1u);
+
+	gridMins = { std::numeric_limits<float>::max(),  std::numeric_limits<float>::max()};
+	gridMaxs = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+
+	for (unsigned int wIdx = 0; wIdx < interceptors.size(); wIdx++) {
+		const CWeapon* w = interceptors[wIdx];
+		const float r = w->weaponDef->coverageRange + INTERCEPT_GRID_MARGIN;
+
+		gridMins.x = std::min(gridMins.x, w->aimFromPos.x - r);
+		gridMins.y = std::min(gridMins.y, w->aimFromPos.z - r);
+		gridMaxs.x = std::max(gridMaxs.x, w->aimFromPos.x + r);
+		gridMaxs.y = std::max(gridMaxs.y, w->aimFromPos.z + r);
+
+		interceptorAllyTeams[wIdx] = w->owner->allyteam;
+	}
+
+	gridCellSize = std::max(INTERCEPT_GRID_CELL_SIZE, std::max(gridMaxs.x - gridMins.x, gridMaxs.y - gridMins.y) / INTERCEPT_GRID_MAX_CELLS);
+	gridSizeX = Clamp(int(math::ceil((gridMaxs.x - gridMins.x) / gridCellSize)), 1, INTERCEPT_GRID_MAX_CELLS);
+	gridSizeZ = Clamp(int(math::ceil((gridMaxs.y - gridMins.y) / gridCellSize)), 1, INTERCEPT_GRID_MAX_CELLS);
+
+	const auto GetCellRect = [&](const CWeapon* w) {
+		const float r = w->weaponDef->coverageRange + INTERCEPT_GRID_MARGIN;
+
+		return SRectangle(
+			Clamp(int((w->aimFromPos.x - r - gridMins.x) / gridCellSize), 0, gridSizeX - 1),
+			Clamp(int((w->aimFromPos.z - r - gridMins.y) / gridCellSize), 0, gridSizeZ - 1),
+			Clamp(int((w->aimFromPos.x + r - gridMins.x) / gridCellSize), 0, gridSizeX - 1),
+			Clamp(int((w->aimFromPos.z + r - gridMins.y) / gridCellSize), 0, gridSizeZ - 1)
+		);
+	};
+	const auto IsGlobalItem = [&](const SRectangle& rect) {
+		return (((rect.x2 - rect.x1 + 1) * (rect.z2 - rect.z1 + 1)) > INTERCEPT_GRID_MAX_ITEM_CELLS);
+	};
+
+	gridCellOffsets.clear();
+	gridCellOffsets.resize(gridSizeX * gridSizeZ + 1, 0);
+	gridGlobalItems.clear();
+
+	// count the items per cell, then turn the counts into end-offsets
+	for (unsigned int wIdx = 0; wIdx < interceptors.size(); wIdx++) {
+		const SRectangle rect = GetCellRect(interceptors[wIdx]);
+
+		if (IsGlobalItem(rect)) {
+			gridGlobalItems.push_back(wIdx);
+			continue;
+		}
 
-			if (w->aimFromPos.SqDistance2D(pImpactPos) < Square(wDef->coverageRange)) {
-				const float3 pTargetDir = (pTargetPos - p->pos).SafeNormalize();
-				const float3 pImpactDir = (pImpactPos - p->pos).SafeNormalize();
-
-				// the projected impact position can briefly shift into the covered
-				// area during transition from vertical to horizontal flight, so we
-				// perform an extra test (NOTE: assumes non-parabolic trajectory)
-				if (pTargetDir.dot(pImpactDir) >= 0.999f) {
-					w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
-					w->AddIncomingProjectile(p->id);
-					continue; // 3
-				}
+		for (int z = rect.z1; z <= rect.z2; z++) {
+			for (int x = rect.x1; x <= rect.x2; x++) {
+				gridCellOffsets[z * gridSizeX + x] += 1;
 			}
+		}
+	}
+
+	for (size_t i = 1, n = gridCellOffsets.size() - 1; i < n; i++) {
+		gridCellOffsets[i] += gridCellOffsets[i - 1];
+	}
+
+	gridCellOffsets.back() = gridCellOffsets[gridCellOffsets.size() - 2];
+
+	gridCellItems.clear();
+	gridCellItems.resize(gridCellOffsets.back());
+
+	// filling in reverse turns the end-offsets into start-offsets and
+	// keeps the items of each cell sorted by index
+	for (unsigned int wIdx = interceptors.size(); wIdx-- > 0; ) {
+		const SRectangle rect = GetCellRect(interceptors[wIdx]);
 
-			const float3 pMinSepPos = p->pos + p->dir * Clamp(-(pWeaponVec.dot(p->dir)), 0.0f, impactDist);
-			const float3 pMinSepVec = w->aimFromPos - pMinSepPos;
+		if (IsGlobalItem(rect))
+			continue;
 
-			if (pMinSepVec.SqLength() < Square(wDef->coverageRange)) {
-				w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
-				w->AddIncomingProjectile(p->id);
-				continue; // 4
+		for (int z = rect.z1; z <= rect.z2; z++) {
+			for (int x = rect.x1; x <= rect.x2; x++) {
+				gridCellItems[--gridCellOffsets[z * gridSizeX + x]] = wIdx;
 			}
 		}
 	}
 }
 
 
+void CInterceptHandler::GatherCandidates(const CWeaponProjectile* p, unsigned int pIdx)
+{
+	const int pAllyTeam = p->GetAllyteamID();
+
+	for (const unsigned int wIdx: gridGlobalItems) {
+		AddCandidate(wIdx, pIdx, pAllyTeam);
+	}
+
+	const auto CellX = [&](float x) { return Clamp(int((x - gridMins.x) / gridCellSize), 0, gridSizeX - 1); };
+	const auto CellZ = [&](float z) { return Clamp(int((z - gridMins.y) / gridCellSize), 0, gridSizeZ - 1); };
+
+	const float3& pTargetPos = p->GetTargetPos();
+
+	// case 1 (see TestInterceptPair) only involves the target-position
+	if (pTargetPos.x >= gridMins.x && pTargetPos.x <= gridMaxs.x && pTargetPos.z >= gridMins.y && pTargetPos.z <= gridMaxs.y)
+		AddGridCellCandidates(CellX(pTargetPos.x), CellZ(pTargetPos.z), pIdx, pAllyTeam);
+
+	// every point tested by cases 2-4 is of the form pos + dir * t with
+	// t >= -1 (-1 if the ground-raycast misses) and must lie within the
+	// coverage-circle of an interceptor, so walk the cells crossed by
+	// that ray's 2D projection
+	const float2 rayPos = {p->pos.x - p->dir.x, p->pos.z - p->dir.z};
+	const float2 rayDir = {p->dir.x, p->dir.z};
+
+	float tmin = 0.0f;
+	float tmax = std::numeric_limits<float>::max();
+
+	for (int axis = 0; axis < 2; axis++) {
+		const float o = (axis == 0)? rayPos.x: rayPos.y;
+		const float d = (axis == 0)? rayDir.x: rayDir.y;
+		const float a = (axis == 0)? gridMins.x: gridMins.y;
+		const float b = (axis == 0)? gridMaxs.x: gridMaxs.y;
+
+		if (d == 0.0f) {
+			if (o < a || o > b)
+				return;
+
+			continue;
+		}
+
+		const float t1 = (a - o) / d;
+		const float t2 = (b - o) / d;
+
+		tmin = std::max(tmin, std::min(t1, t2));
+		tmax = std::min(tmax, std::max(t1, t2));
+	}
+
+	if (tmin > tmax)
+		return;
+
+	const float2 p0 = rayPos + rayDir * tmin;
+
+	int cellX = CellX(p0.x);
+	int cellZ = CellZ(p0.y);
+
+	// vertical trajectory
+	if (rayDir.x == 0.0f && rayDir.y == 0.0f) {
+		AddGridCellCandidates(cellX, cellZ, pIdx, pAllyTeam);
+		return;
+	}
+
+	const float2 p1 = rayPos + rayDir * tmax;
+
+	const int lastCellX = CellX(p1.x);
+	const int lastCellZ = CellZ(p1.y);
+
+	const int stepX = (rayDir.x > 0.0f) - (rayDir.x < 0.0f);
+	const int stepZ = (rayDir.y > 0.0f) - (rayDir.y < 0.0f);
+
+	const float tDeltaX = (stepX != 0)? (gridCellSize / math::fabs(rayDir.x)): std::numeric_limits<float>::max();
+	const float tDeltaZ = (stepZ != 0)? (gridCellSize / math::fabs(rayDir.y)): std::numeric_limits<float>::max();
+
+	float tNextX = std::numeric_limits<float>::max();
+	float tNextZ = std::numeric_limits<float>::max();
+
+	if (stepX != 0) tNextX = (gridMins.x + (cellX + (stepX > 0)) * gridCellSize - rayPos.x) / rayDir.x;
+	if (stepZ != 0) tNextZ = (gridMins.y + (cellZ + (stepZ > 0)) * gridCellSize - rayPos.y) / rayDir.y;
+
+	for (int n = gridSizeX + gridSizeZ; n >= 0; n--) {
+		AddGridCellCandidates(cellX, cellZ, pIdx, pAllyTeam);
+
+		if (cellX == lastCellX && cellZ == lastCellZ)
+			break;
+
+		if (tNextX < tNextZ) {
+			cellX += stepX;
+			tNextX += tDeltaX;
+		} else {
+			cellZ += stepZ;
+			tNextZ += tDeltaZ;
+		}
+
+		if (cellX < 0 || cellX >= gridSizeX)
+			break;
+		if (cellZ < 0 || cellZ >= gridSizeZ)
+			break;
+	}
+}
+
+
+void CInterceptHandler::AddGridCellCandidates(int cellX, int cellZ, unsigned int pIdx, int pAllyTeam)
+{
+	const unsigned int cellIdx = cellZ * gridSizeX + cellX;
+
+	for (unsigned int i = gridCellOffsets[cellIdx], n = gridCellOffsets[cellIdx + 1]; i < n; i++) {
+		AddCandidate(gridCellItems[i], pIdx, pAllyTeam);
+	}
+}
+
+void CInterceptHandler::AddCandidate(unsigned int wIdx, unsigned int pIdx, int pAllyTeam)
+{
+	// interceptors can be reached through more than one cell
+	if (interceptorStamps[wIdx] == pIdx)
+		return;
+
+	interceptorStamps[wIdx] = pIdx;
+
+	// allied pairs are rejected by TestInterceptPair anyway, but this
+	// keeps them out of the sort (table-lookup instead of TeamHandler)
+	if (pAllyTeam >= 0 && pAllyTeam < numAllyTeams && enemyAllyTeams[pAllyTeam * numAllyTeams + interceptorAllyTeams[wIdx]] == 0)
+		return;
+
+	candidatePairs.push_back((std::uint64_t(wIdx) << 32) | pIdx);
+}
+
+
+void CInterceptHandler::TestInterceptPair(CWeapon* w, CWeaponProjectile* p)
+{
+	const WeaponDef* wDef = w->weaponDef;
+	const CUnit* wOwner = w->owner;
+
+	assert(wDef->interceptor || wDef->isShield);
+
+	if (!p->CanBeInterceptedBy(wDef))
+		return;
+	if (w->HasIncomingProjectile(p->id))
+		return;
+
+	const int pAllyTeam = p->GetAllyteamID();
+
+	if (teamHandler.IsValidAllyTeam(pAllyTeam) && teamHandler.Ally(wOwner->allyteam, pAllyTeam))
+		return;
+
+	// note: will be called every Update so long as gadget does not return true
+	if (!eventHandler.AllowWeaponInterceptTarget(wOwner, w, p))
+		return;
+
+	// there are four cases when an interceptor <w> should fire at a projectile <p>:
+	//     1. p's target position inside w's interception circle (w's owner can move!)
+	//     2. p's current position inside w's interception circle
+	//     3. p's projected impact position inside w's interception circle
+	//     4. p's trajectory intersects w's interception circle
+	//
+	// these checks all need to be evaluated periodically, not just
+	// when a projectile is created and handed to AddInterceptTarget
+	const float weaponDist = w->aimFromPos.distance(p->pos);
+	const float impactDist = CGround::LineGroundCol(p->pos, p->pos + p->dir * weaponDist);
+
+	const float3& pImpactPos = p->pos + p->dir * impactDist;
+	const float3& pTargetPos = p->GetTargetPos();
+	const float3  pWeaponVec = p->pos - w->aimFromPos;
+
+	if (w->aimFromPos.SqDistance2D(pTargetPos) < Square(wDef->coverageRange)) {
+		w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
+		w->AddIncomingProjectile(p->id);
+		return; // 1
+	}
+
+	if (false /*wDef->noFlyThroughIntercept*/) {
+		// <w> is just a static interceptor and fires only at projectiles
+		// TARGETED within its current interception area; any projectiles
+		// CROSSING its interception area aren't targeted
+		//XXX implement in lua?
+		return;
+	}
+
+	if (pWeaponVec.SqLength2D() < Square(wDef->coverageRange)) {
+		w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
+		w->AddIncomingProjectile(p->id);
+		return; // 2
+	}
+
+	if (w->aimFromPos.SqDistance2D(pImpactPos) < Square(wDef->coverageRange)) {
+		const float3 pTargetDir = (pTargetPos - p->pos).SafeNormalize();
+		const float3 pImpactDir = (pImpactPos - p->pos).SafeNormalize();
+
+		// the projected impact position can briefly shift into the covered
+		// area during transition from vertical to horizontal flight, so we
+		// perform an extra test (NOTE: assumes non-parabolic trajectory)
+		if (pTargetDir.dot(pImpactDir) >= 0.999f) {
+			w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
+			w->AddIncomingProjectile(p->id);
+			return; // 3
+		}
+	}
+
+	const float3 pMinSepPos = p->pos + p->dir * Clamp(-(pWeaponVec.dot(p->dir)), 0.0f, impactDist);
+	const float3 pMinSepVec = w->aimFromPos - pMinSepPos;
+
+	if (pMinSepVec.SqLength() < Square(wDef->coverageRange)) {
+		w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
+		w->AddIncomingProjectile(p->id);
+		return; // 4
+	}
+}
+
+
 
 void CInterceptHandler::AddInterceptorWeapon(CWeapon* weapon)
 {
@@ -4,8 +4,12 @@
 #define INTERCEPT_HANDLER_H
 
 #include <deque>
+#include <vector>
+#include <cinttypes>
+
 #include "System/Misc/NonCopyable.h"
 #include "System/Object.h"
+#include "System/type2.h"
 
 class CWeapon;
 class CWeaponProjectile;
@@ -26,9 +30,45 @@ public:
 
 	void DependentDied(CObject* o) override;
 
+private:
+	void BuildInterceptorGrid();
+	void GatherCandidates(const CWeaponProjectile* p, unsigned int pIdx);
+
+	void AddGridCellCandidates(int cellX, int cellZ, unsigned int pIdx, int pAllyTeam);
+	void AddCandidate(unsigned int wIdx, unsigned int pIdx, int pAllyTeam);
+
+	void TestInterceptPair(CWeapon* w, CWeaponProjectile* p);
+
 private:
 	std::deque<CWeapon*> interceptors;
 	std::deque<CWeaponProjectile*> interceptables;
+
+	// uniform grid over the union of all interceptor coverage-areas,
+	// rebuilt by every Update since interceptor owners can move; only
+	// used to cull (interceptor, interceptable) pairs that can not pass
+	// any of the coverage tests, all others are tested as before
+	std::vector<unsigned int> gridCellOffsets;
+	std::vector<unsigned int> gridCellItems;
+	// interceptors whose coverage spans too many cells to insert
+	std::vector<unsigned int> gridGlobalItems;
+
+	std::vector<int> interceptorAllyTeams;
+	std::vector<unsigned int> interceptorStamps;
+
+	// [a * numAllyTeams + b] is 0 iff allyteams a and b are allied
+	std::vector<std::uint8_t> enemyAllyTeams;
+
+	// sorted (interceptor-index << 32 | interceptable-index) keys
+	std::vector<std::uint64_t> candidatePairs;
+
+	float2 gridMins;
+	float2 gridMaxs;
+
+	float gridCellSize = 0.0f;
+
+	int gridSizeX = 0;
+	int gridSizeZ = 0;
+	int numAllyTeams = 0;
 };
 
 extern CInterceptHandler interceptHandler;
@@ -33,6 +33,7 @@ void CModInfo::ResetState()
 		allowSepAxisCollisionTest  = false;
 		allowGroundUnitGravity     = true;
 		allowHoverUnitStrafing     = true;
+		allowLocalAvoidance        = false;
 	}
 	{
 		constructionDecay      = true;
@@ -97,6 +98,8 @@ void CModInfo::ResetState()
 		pfUpdateRate     = 0.007f;
 
 		allowTake = true;
+
+		teamStatsMaxHistory = 0;
 	}
 }
 
@@ -136,6 +139,8 @@ void CModInfo::Init(const std::string& modFileName)
 		pfUpdateRate = system.GetFloat("pathFinderUpdateRate", pfUpdateRate);
 
 		allowTake = system.GetBool("allowTake", allowTake);
+
+		teamStatsMaxHistory = std::max(system.GetInt("teamStatsMaxHistory", teamStatsMaxHistory), 0);
 	}
 
 	{
@@ -152,6 +157,7 @@ void CModInfo::Init(const std::string& modFileName)
 		allowSepAxisCollisionTest = movementTbl.GetBool("allowSepAxisCollisionTest", allowSepAxisCollisionTest);
 		allowGroundUnitGravity = movementTbl.GetBool("allowGroundUnitGravity", allowGroundUnitGravity);
 		allowHoverUnitStrafing = movementTbl.GetBool("allowHoverUnitStrafing", (pathFinderSystem == QTPFS_TYPE));
+		allowLocalAvoidance = movementTbl.GetBool("allowLocalAvoidance", allowLocalAvoidance);
 	}
 
 	{
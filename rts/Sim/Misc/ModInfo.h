@@ -51,6 +51,7 @@ public:
 	bool allowSepAxisCollisionTest;  //< determines if (ground-)units perform collision-testing via the SAT
 	bool allowGroundUnitGravity;     //< determines if (ground-)units experience gravity during regular movement
 	bool allowHoverUnitStrafing;     //< determines if (hover-)units carry their momentum sideways when turning
+	bool allowLocalAvoidance;        //< determines if (ground-)units steer around each other via reciprocal velocity-obstacles
 
 	// Build behaviour
 	/// Should constructions without builders decay?
@@ -163,6 +164,10 @@ public:
 	float pfUpdateRate;
 
 	bool allowTake;
+
+	/// maximum number of statistics snapshots kept per team (0 = no limit);
+	/// when reached, every other snapshot is dropped (halving resolution)
+	int teamStatsMaxHistory;
 };
 
 extern CModInfo modInfo;
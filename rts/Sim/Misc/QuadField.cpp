@@ -9,6 +9,7 @@
 #include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "System/ContainerUtil.h"
+#include "System/Threading/ThreadPool.h"
 
 #ifndef UNIT_TEST
 	#include "Sim/Features/Feature.h"
@@ -17,6 +18,11 @@
 	#include "Sim/Weapons/PlasmaRepulser.h"
 #endif
 
+// GetQuads* (unlike the Get*Exact functions, which mark objects via tempNum)
+// only read the quad-field, so each thread gets its own set of index vectors
+// to make these safe to call from worker threads, e.g. by TraceRay
+static std::array<QueryVectorCache<int>, ThreadPool::MAX_THREADS> tempQuads;
+
 CR_BIND(CQuadField, )
 CR_REG_METADATA(CQuadField, (
 	CR_MEMBER(baseQuads),
@@ -29,8 +35,7 @@ CR_REG_METADATA(CQuadField, (
 	CR_IGNORED(tempUnits),
 	CR_IGNORED(tempFeatures),
 	CR_IGNORED(tempProjectiles),
-	CR_IGNORED(tempSolids),
-	CR_IGNORED(tempQuads)
+	CR_IGNORED(tempSolids)
 ))
 
 CR_BIND(CQuadField::Quad, )
@@ -121,8 +126,10 @@ void CQuadField::Init(int2 mapDims, int quadSize)
 	invQuadSize = {1.0f / quadSizeX, 1.0f / quadSizeZ};
 
 	baseQuads.resize(numQuadsX * numQuadsZ);
-	tempQuads.ReserveAll(numQuadsX * numQuadsZ);
-	tempQuads.ReleaseAll();
+	for (QueryVectorCache<int>& threadQuads: tempQuads) {
+		threadQuads.ReserveAll(numQuadsX * numQuadsZ);
+		threadQuads.ReleaseAll();
+	}
 
 #ifndef UNIT_TEST
 	for (Quad& quad: baseQuads) {
@@ -143,7 +150,15 @@ void CQuadField::Kill()
 	tempFeatures.ReleaseAll();
 	tempProjectiles.ReleaseAll();
 	tempSolids.ReleaseAll();
-	tempQuads.ReleaseAll();
+
+	for (QueryVectorCache<int>& threadQuads: tempQuads) {
+		threadQuads.ReleaseAll();
+	}
+}
+
+void CQuadField::ReleaseVector(std::vector<int>* v)
+{
+	tempQuads[ThreadPool::GetThreadNum()].ReleaseVector(v);
 }
 
 
@@ -167,7 +182,7 @@ void CQuadField::GetQuads(QuadFieldQuery& qfq, float3 pos, float radius)
 {
 	pos.AssertNaNs();
 	pos.ClampInBounds();
-	qfq.quads = tempQuads.ReserveVector();
+	qfq.quads = tempQuads[ThreadPool::GetThreadNum()].ReserveVector();
 
 	const int2 min = WorldPosToQuadField(pos - radius);
 	const int2 max = WorldPosToQuadField(pos + radius);
@@ -197,7 +212,7 @@ void CQuadField::GetQuadsRectangle(QuadFieldQuery& qfq, const float3& mins, cons
 {
 	mins.AssertNaNs();
 	maxs.AssertNaNs();
-	qfq.quads = tempQuads.ReserveVector();
+	qfq.quads = tempQuads[ThreadPool::GetThreadNum()].ReserveVector();
 
 	const int2 min = WorldPosToQuadField(mins);
 	const int2 max = WorldPosToQuadField(maxs);
@@ -224,7 +239,7 @@ void CQuadField::GetQuadsOnRay(QuadFieldQuery& qfq, const float3& start, const f
 	dir.AssertNaNs();
 	start.AssertNaNs();
 
-	auto& queryQuads = *(qfq.quads = tempQuads.ReserveVector());
+	auto& queryQuads = *(qfq.quads = tempQuads[ThreadPool::GetThreadNum()].ReserveVector());
 
 	const float3 to = start + (dir * length);
 
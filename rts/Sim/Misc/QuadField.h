@@ -171,7 +171,7 @@ public:
 	void ReleaseVector(std::vector<CFeature*>* v    ) { tempFeatures.ReleaseVector(v); }
 	void ReleaseVector(std::vector<CProjectile*>* v ) { tempProjectiles.ReleaseVector(v); }
 	void ReleaseVector(std::vector<CSolidObject*>* v) { tempSolids.ReleaseVector(v); }
-	void ReleaseVector(std::vector<int>* v          ) { tempQuads.ReleaseVector(v); }
+	void ReleaseVector(std::vector<int>* v          );
 
 	struct Quad {
 	public:
@@ -239,11 +239,11 @@ private:
 	std::vector<Quad> baseQuads;
 
 	// preallocated vectors for Get*Exact functions
+	// (quad-index vectors are kept per thread, see QuadField.cpp)
 	QueryVectorCache<CUnit*> tempUnits;
 	QueryVectorCache<CFeature*> tempFeatures;
 	QueryVectorCache<CProjectile*> tempProjectiles;
 	QueryVectorCache<CSolidObject*> tempSolids;
-	QueryVectorCache<int> tempQuads;
 
 	float2 invQuadSize;
 
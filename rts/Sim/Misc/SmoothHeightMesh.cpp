@@ -1,39 +1,51 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
 #include <vector>
 #include <cassert>
-#include <limits>
 
 #include "SmoothHeightMesh.h"
 
 #include "Map/Ground.h"
 #include "Map/ReadMap.h"
+#include "Sim/Misc/GlobalConstants.h"
 #include "System/float3.h"
 #include "System/SpringMath.h"
 #include "System/TimeProfiler.h"
 #include "System/Threading/ThreadPool.h"
 
 
+// side-length (in mesh cells) of the tiles that incremental rebuilds work on
+#define SMOOTH_MESH_TILE_SIZE 32
+// frames between launching tile rebuilds, and between launch and swap
+#define SMOOTH_MESH_UPDATE_RATE (GAME_SPEED / 2)
+
+#define SMOOTH_MESH_BLUR_SIZE 3
+#define SMOOTH_MESH_NUM_BLURS 3
+
 
 SmoothHeightMesh smoothGround;
 
 
 static float Interpolate(float x, float y, const int maxx, const int maxy, const float res, const float* heightmap)
 {
-	x = Clamp(x / res, 0.0f, maxx - 1.0f);
-	y = Clamp(y / res, 0.0f, maxy - 1.0f);
+	// rows are (maxx + 1) cells wide, see SmoothHeightMesh::GetMeshIndex
+	const int lineSize = maxx + 1;
+
+	x = Clamp(x / res, 0.0f, float(maxx));
+	y = Clamp(y / res, 0.0f, float(maxy));
 	const int sx = x;
 	const int sy = y;
 	const float dx = (x - sx);
 	const float dy = (y - sy);
 
-	const int sxp1 = std::min(sx + 1, maxx - 1);
-	const int syp1 = std::min(sy + 1, maxy - 1);
+	const int sxp1 = std::min(sx + 1, maxx);
+	const int syp1 = std::min(sy + 1, maxy);
 
-	const float& h1 = heightmap[sx   + sy   * maxx];
-	const float& h2 = heightmap[sxp1 + sy   * maxx];
-	const float& h3 = heightmap[sx   + syp1 * maxx];
-	const float& h4 = heightmap[sxp1 + syp1 * maxx];
+	const float& h1 = heightmap[sx   + sy   * lineSize];
+	const float& h2 = heightmap[sxp1 + sy   * lineSize];
+	const float& h3 = heightmap[sx   + syp1 * lineSize];
+	const float& h4 = heightmap[sxp1 + syp1 * lineSize];
 
 	const float hi1 = mix(h1, h2, dx);
 	const float hi2 = mix(h3, h4, dx);
@@ -49,341 +61,146 @@ void SmoothHeightMesh::Init(float mx, float my, float res, float smoothRad)
 	resolution = res;
 	smoothRadius = std::max(1.0f, smoothRad);
 
+	numTilesX = (maxx + SMOOTH_MESH_TILE_SIZE) / SMOOTH_MESH_TILE_SIZE;
+	numTilesY = (maxy + SMOOTH_MESH_TILE_SIZE) / SMOOTH_MESH_TILE_SIZE;
+	jobSwapFrame = -1;
+
 	MakeSmoothMesh();
 }
 
 void SmoothHeightMesh::Kill() {
+	WaitTileJobs();
+
+	tileJobs.clear();
+	jobTileIndices.clear();
 
 	mesh.clear();
 	origMesh.clear();
 }
 
 
-
-float SmoothHeightMesh::GetHeight(float x, float y)
-{
-	assert(!mesh.empty());
-	return Interpolate(x, y, maxx, maxy, resolution, &mesh[0]);
-}
-
-float SmoothHeightMesh::GetHeightAboveWater(float x, float y)
+void SmoothHeightMesh::Update(int frameNum)
 {
-	assert(!mesh.empty());
-	return std::max(0.0f, Interpolate(x, y, maxx, maxy, resolution, &mesh[0]));
-}
-
+	if (jobSwapFrame >= 0 && frameNum >= jobSwapFrame)
+		ApplyTileJobs();
 
+	if (jobSwapFrame >= 0)
+		return;
+	if ((frameNum % SMOOTH_MESH_UPDATE_RATE) != 0)
+		return;
+	if (heightMapVersion == readMap->GetHeightMapChangeTracker().GetVersion())
+		return;
 
-float SmoothHeightMesh::SetHeight(int index, float h)
-{
-	return (mesh[index] = h);
+	QueueTileJobs(frameNum);
 }
 
-float SmoothHeightMesh::AddHeight(int index, float h)
-{
-	return (mesh[index] += h);
-}
 
-float SmoothHeightMesh::SetMaxHeight(int index, float h)
+void SmoothHeightMesh::InitTileJob(TileJob& job, int tileIdx) const
 {
-	return (mesh[index] = std::max(h, mesh[index]));
-}
+	const int winSize = smoothRadius / resolution;
 
+	job.SetRect(tileIdx % numTilesX, tileIdx / numTilesX, SMOOTH_MESH_TILE_SIZE, maxx, maxy, winSize, SMOOTH_MESH_BLUR_SIZE, SMOOTH_MESH_NUM_BLURS);
+	job.maxHeight = readMap->GetCurrMaxHeight();
 
+	// snapshot the heightmap, workers must not read it while the sim changes it
+	job.heights.clear();
+	job.heights.reserve(job.GetNumInputCells());
 
-inline static void FindMaximumColumnHeights(
-	const int maxx,
-	const int maxy,
-	const int winSize,
-	const float resolution,
-	std::vector<float>& colsMaxima,
-	std::vector<int>& maximaRows
-) {
-	// initialize the algorithm: find the maximum
-	// height per column and the corresponding row
-	for (int y = 0; y <= std::min(maxy, winSize); ++y) {
-		for (int x = 0; x <= maxx; ++x)  {
-			const float curx = x * resolution;
-			const float cury = y * resolution;
-			const float curh = CGround::GetHeightAboveWater(curx, cury);
-
-			if (curh > colsMaxima[x]) {
-				colsMaxima[x] = curh;
-				maximaRows[x] = y;
-			}
+	for (int y = job.iy1; y <= job.iy2; ++y) {
+		for (int x = job.ix1; x <= job.ix2; ++x) {
+			job.heights.push_back(CGround::GetHeightAboveWater(x * resolution, y * resolution));
 		}
 	}
 }
 
-inline static void AdvanceMaximaRows(
-	const int y,
-	const int maxx,
-	const float resolution,
-	const std::vector<float>& colsMaxima,
-	      std::vector<int>& maximaRows
-) {
-	const float cury = y * resolution;
-
-	// try to advance rows if they're equal to current maximum but are further away
-	for (int x = 0; x <= maxx; ++x) {
-		if (maximaRows[x] == (y - 1)) {
-			const float curx = x * resolution;
-			const float curh = CGround::GetHeightAboveWater(curx, cury);
-
-			if (curh == colsMaxima[x]) {
-				maximaRows[x] = y;
-			}
-
-			assert(curh <= colsMaxima[x]);
-		}
-	}
+void SmoothHeightMesh::RunTileJob(TileJob& job, int winSize)
+{
+	job.Smooth(winSize, SMOOTH_MESH_BLUR_SIZE, SMOOTH_MESH_NUM_BLURS);
 }
 
 
+void SmoothHeightMesh::QueueTileJobs(int frameNum)
+{
+	SCOPED_TIMER("Sim::SmoothHeightMesh::QueueTiles");
 
-inline static void FindRadialMaximum(
-	int y,
-	int maxx,
-	int winSize,
-	float resolution,
-	const std::vector<float>& colsMaxima,
-	      std::vector<float>& mesh
-) {
-	const float cury = y * resolution;
-
-	for (int x = 0; x <= maxx; ++x) {
-		float maxRowHeight = -std::numeric_limits<float>::max();
-
-		// find current maximum within radius smoothRadius
-		// (in every column stack) along the current row
-		const int startx = std::max(x - winSize, 0);
-		const int endx = std::min(maxx, x + winSize);
-
-		for (int i = startx; i <= endx; ++i) {
-			assert(i >= 0);
-			assert(i <= maxx);
-			assert(CGround::GetHeightReal(i * resolution, cury) <= colsMaxima[i]);
+	const int winSize = smoothRadius / resolution;
+	// every mesh cell within this many cells of a changed one is affected
+	const int border = winSize + SMOOTH_MESH_BLUR_SIZE * SMOOTH_MESH_NUM_BLURS;
 
-			maxRowHeight = std::max(colsMaxima[i], maxRowHeight);
-		}
+	jobTileIndices.clear();
 
-#ifndef NDEBUG
-		const float curx = x * resolution;
-		assert(maxRowHeight <= std::max(readMap->GetCurrMaxHeight(), 0.0f));
-		assert(maxRowHeight >= CGround::GetHeightAboveWater(curx, cury));
+	readMap->GetHeightMapChangeTracker().ForEachChangedRect(heightMapVersion, [&](const SRectangle& r) {
+		const int mx1 = int((r.x1 * SQUARE_SIZE) / resolution) - border;
+		const int my1 = int((r.z1 * SQUARE_SIZE) / resolution) - border;
+		const int mx2 = int((r.x2 * SQUARE_SIZE) / resolution) + border + 1;
+		const int my2 = int((r.z2 * SQUARE_SIZE) / resolution) + border + 1;
 
-	#ifdef SMOOTHMESH_CORRECTNESS_CHECK
-		// naive algorithm
-		float maxRowHeightAlt = -std::numeric_limits<float>::max();
+		const int tx1 = Clamp(mx1 / SMOOTH_MESH_TILE_SIZE, 0, numTilesX - 1);
+		const int ty1 = Clamp(my1 / SMOOTH_MESH_TILE_SIZE, 0, numTilesY - 1);
+		const int tx2 = Clamp(mx2 / SMOOTH_MESH_TILE_SIZE, 0, numTilesX - 1);
+		const int ty2 = Clamp(my2 / SMOOTH_MESH_TILE_SIZE, 0, numTilesY - 1);
 
-		for (float y1 = cury - smoothRadius; y1 <= cury + smoothRadius; y1 += resolution) {
-			for (float x1 = curx - smoothRadius; x1 <= curx + smoothRadius; x1 += resolution) {
-				maxRowHeightAlt = std::max(maxRowHeightAlt, CGround::GetHeightAboveWater(x1, y1));
+		for (int ty = ty1; ty <= ty2; ty++) {
+			for (int tx = tx1; tx <= tx2; tx++) {
+				jobTileIndices.push_back(ty * numTilesX + tx);
 			}
 		}
+	});
 
-		assert(maxRowHeightAlt == maxRowHeight);
-	#endif
-#endif
-
-		mesh[x + y * maxx] = maxRowHeight;
-	}
-}
-
+	// neighboring rectangles share tiles
+	std::sort(jobTileIndices.begin(), jobTileIndices.end());
+	jobTileIndices.erase(std::unique(jobTileIndices.begin(), jobTileIndices.end()), jobTileIndices.end());
 
+	tileJobs.clear();
+	tileJobs.resize(jobTileIndices.size());
+	tileJobResults.clear();
+	tileJobResults.reserve(jobTileIndices.size());
 
-inline static void FixRemainingMaxima(
-	const int y,
-	const int maxx,
-	const int maxy,
-	const int winSize,
-	const float resolution,
-	std::vector<float>& colsMaxima,
-	std::vector<int>& maximaRows
-) {
-	// fix remaining maximums after a pass
-	const int nextrow = y + winSize + 1;
-	const float nextrowy = nextrow * resolution;
-
-	for (int x = 0; x <= maxx; ++x) {
-#ifdef _DEBUG
-		for (int y1 = std::max(0, y - winSize); y1 <= std::min(maxy, y + winSize); ++y1) {
-			assert(CGround::GetHeightReal(x * resolution, y1 * resolution) <= colsMaxima[x]);
-		}
-#endif
-		const float curx = x * resolution;
-
-		if (maximaRows[x] <= (y - winSize)) {
-			// find a new maximum if the old one left the window
-			colsMaxima[x] = -std::numeric_limits<float>::max();
-
-			for (int y1 = std::max(0, y - winSize + 1); y1 <= std::min(maxy, nextrow); ++y1) {
-				const float h = CGround::GetHeightAboveWater(curx, y1 * resolution);
-
-				if (h > colsMaxima[x]) {
-					colsMaxima[x] = h;
-					maximaRows[x] = y1;
-				} else if (colsMaxima[x] == h) {
-					// if equal, move as far down as possible
-					maximaRows[x] = y1;
-				}
-			}
-		} else if (nextrow <= maxy) {
-			// else, just check if a new maximum has entered the window
-			const float h = CGround::GetHeightAboveWater(curx, nextrowy);
+	for (size_t i = 0; i < jobTileIndices.size(); i++) {
+		TileJob& job = tileJobs[i];
 
-			if (h > colsMaxima[x]) {
-				colsMaxima[x] = h;
-				maximaRows[x] = nextrow;
-			}
-		}
+		InitTileJob(job, jobTileIndices[i]);
 
-		assert(maximaRows[x] <= nextrow);
-		assert(maximaRows[x] >= y - winSize + 1);
+		auto task = std::make_shared<std::packaged_task<void()>>([&job, winSize]() { RunTileJob(job, winSize); });
 
-#ifdef _DEBUG
-		for (int y1 = std::max(0, y - winSize + 1); y1 <= std::min(maxy, y + winSize + 1); ++y1) {
-			assert(colsMaxima[x] >= CGround::GetHeightReal(curx, y1 * resolution));
-		}
-#endif
+		tileJobResults.emplace_back(task->get_future());
+		ThreadPool::Enqueue([task]() { (*task)(); });
 	}
-}
-
-
-
-inline static void BlurHorizontal(
-	const int maxx,
-	const int maxy,
-	const int blurSize,
-	const float resolution,
-	const std::vector<float>& mesh,
-	      std::vector<float>& smoothed
-) {
-	const float n = 2.0f * blurSize + 1.0f;
-	const float recipn = 1.0f / n;
-	const int lineSize = maxx + 1;
-
-	for_mt(0, maxy+1, [&](const int y) {
-		float avg = 0.0f;
-
-		for (int x = 0; x <= 2 * blurSize; ++x) {
-			avg += mesh[x + y * lineSize];
-		}
-
-		for (int x = 0; x <= maxx; ++x) {
-			const int idx = x + y * lineSize;
-
-			if (x <= blurSize || x > (maxx - blurSize)) {
-				// map-border case
-				smoothed[idx] = 0.0f;
-
-				const int xstart = std::max(x - blurSize, 0);
-				const int xend   = std::min(x + blurSize, maxx);
-
-				for (int x1 = xstart; x1 <= xend; ++x1) {
-					smoothed[idx] += mesh[x1 + y * lineSize];
-				}
-
-				const float gh = CGround::GetHeightAboveWater(x * resolution, y * resolution);
-				const float sh = smoothed[idx] / (xend - xstart + 1);
-
-				smoothed[idx] = std::min(readMap->GetCurrMaxHeight(), std::max(gh, sh));
-			} else {
-				// non-border case
-				avg += mesh[idx + blurSize] - mesh[idx - blurSize - 1];
-
-				const float gh = CGround::GetHeightAboveWater(x * resolution, y * resolution);
-				const float sh = recipn * avg;
 
-				smoothed[idx] = std::min(readMap->GetCurrMaxHeight(), std::max(gh, sh));
-			}
-
-			assert(smoothed[idx] <= std::max(readMap->GetCurrMaxHeight(), 0.0f));
-			assert(smoothed[idx] >=          readMap->GetCurrMinHeight()       );
-		}
-	});
+	// results become visible at a fixed frame regardless of when workers finish
+	jobSwapFrame = frameNum + SMOOTH_MESH_UPDATE_RATE;
 }
 
-inline static void BlurVertical(
-	const int maxx,
-	const int maxy,
-	const int blurSize,
-	const float resolution,
-	const std::vector<float>& mesh,
-	      std::vector<float>& smoothed
-) {
-	const float n = 2.0f * blurSize + 1.0f;
-	const float recipn = 1.0f / n;
-	const int lineSize = maxx + 1;
-
-	for_mt(0, maxx+1, [&](const int x) {
-		float avg = 0.0f;
-
-		for (int y = 0; y <= 2 * blurSize; ++y) {
-			avg += mesh[x + y * lineSize];
-		}
-
-		for (int y = 0; y <= maxy; ++y) {
-			const int idx = x + y * lineSize;
-
-			if (y <= blurSize || y > (maxy - blurSize)) {
-				// map-border case
-				smoothed[idx] = 0.0f;
-
-				const int ystart = std::max(y - blurSize, 0);
-				const int yend   = std::min(y + blurSize, maxy);
-
-				for (int y1 = ystart; y1 <= yend; ++y1) {
-					smoothed[idx] += mesh[x + y1 * lineSize];
-				}
-
-				const float gh = CGround::GetHeightAboveWater(x * resolution, y * resolution);
-				const float sh = smoothed[idx] / (yend - ystart + 1);
+void SmoothHeightMesh::ApplyTileJobs()
+{
+	SCOPED_TIMER("Sim::SmoothHeightMesh::ApplyTiles");
 
-				smoothed[idx] = std::min(readMap->GetCurrMaxHeight(), std::max(gh, sh));
-			} else {
-				// non-border case
-				avg += mesh[x + (y + blurSize) * lineSize] - mesh[x + (y - blurSize - 1) * lineSize];
+	// blocks only if the workers have fallen behind
+	WaitTileJobs();
 
-				const float gh = CGround::GetHeightAboveWater(x * resolution, y * resolution);
-				const float sh = recipn * avg;
+	for (const TileJob& job: tileJobs) {
+		const int rowSize = job.x2 - job.x1 + 1;
 
-				smoothed[idx] = std::min(readMap->GetCurrMaxHeight(), std::max(gh, sh));
-			}
+		for (int y = job.y1; y <= job.y2; ++y) {
+			const float* src = &job.result[(y - job.y1) * rowSize];
 
-			assert(smoothed[idx] <= std::max(readMap->GetCurrMaxHeight(), 0.0f));
-			assert(smoothed[idx] >=          readMap->GetCurrMinHeight()       );
+			std::copy(src, src + rowSize, &mesh[GetMeshIndex(job.x1, y)]);
+			std::copy(src, src + rowSize, &origMesh[GetMeshIndex(job.x1, y)]);
 		}
-	});
-}
-
+	}
 
+	tileJobs.clear();
+	jobSwapFrame = -1;
+}
 
-inline static void CheckInvariants(
-	int y,
-	int maxx,
-	int maxy,
-	int winSize,
-	float resolution,
-	const std::vector<float>& colsMaxima,
-	const std::vector<int>& maximaRows
-) {
-	// check invariants
-	if (y < maxy) {
-		for (int x = 0; x <= maxx; ++x) {
-			assert(maximaRows[x] > y - winSize);
-			assert(maximaRows[x] <= maxy);
-			assert(colsMaxima[x] <= std::max(readMap->GetCurrMaxHeight(), 0.0f));
-			assert(colsMaxima[x] >=          readMap->GetCurrMinHeight()       );
-		}
-	}
-	for (int y1 = std::max(0, y - winSize + 1); y1 <= std::min(maxy, y + winSize + 1); ++y1) {
-		for (int x1 = 0; x1 <= maxx; ++x1) {
-			assert(CGround::GetHeightReal(x1 * resolution, y1 * resolution) <= colsMaxima[x1]);
-		}
+void SmoothHeightMesh::WaitTileJobs()
+{
+	for (std::future<void>& result: tileJobResults) {
+		result.get();
 	}
-}
 
+	tileJobResults.clear();
+}
 
 
 void SmoothHeightMesh::MakeSmoothMesh()
@@ -398,43 +215,61 @@ void SmoothHeightMesh::MakeSmoothMesh()
 	//   row-width (number of height-value corners per row) is (maxx + 1)
 	//   col-height (number of height-value corners per col) is (maxy + 1)
 	//
-	//   1st row has indices [maxx*(  0) + (  0), maxx*(1) + (  0)] inclusive
-	//   2nd row has indices [maxx*(  1) + (  1), maxx*(2) + (  1)] inclusive
-	//   3rd row has indices [maxx*(  2) + (  2), maxx*(3) + (  2)] inclusive
-	//   ...
-	//   Nth row has indices [maxx*(N-1) + (N-1), maxx*(N) + (N-1)] inclusive
-	//
-	// use sliding window of maximums to reduce computational complexity
-	const     int winSize = smoothRadius / resolution;
-	constexpr int blurSize = 3;
+	// built from the same tiles as incremental rebuilds, such that those
+	// produce exactly the values a full rebuild would (no seams at their
+	// borders, and the mesh does not depend on when it was last rebuilt)
+	const int winSize = smoothRadius / resolution;
 
 	assert(mesh.empty());
 	mesh.resize((maxx + 1) * (maxy + 1), 0.0f);
 	origMesh.resize((maxx + 1) * (maxy + 1), 0.0f);
 
-	colsMaxima.clear();
-	colsMaxima.resize(maxx + 1, -std::numeric_limits<float>::max());
-	maximaRows.clear();
-	maximaRows.resize(maxx + 1, -1);
+	tileJobs.clear();
+	tileJobs.resize(numTilesX * numTilesY);
 
-	FindMaximumColumnHeights(maxx, maxy, winSize, resolution, colsMaxima, maximaRows);
+	for (int tileIdx = 0; tileIdx < (numTilesX * numTilesY); tileIdx++) {
+		InitTileJob(tileJobs[tileIdx], tileIdx);
+	}
 
-	for (int y = 0; y <= maxy; ++y) {
-		AdvanceMaximaRows(y, maxx, resolution, colsMaxima, maximaRows);
-		FindRadialMaximum(y, maxx, winSize, resolution, colsMaxima, mesh);
-		FixRemainingMaxima(y, maxx, maxy, winSize, resolution, colsMaxima, maximaRows);
+	for_mt(0, tileJobs.size(), [&](const int i) {
+		RunTileJob(tileJobs[i], winSize);
+	});
 
-#ifdef _DEBUG
-		CheckInvariants(y, maxx, maxy, winSize, resolution, colsMaxima, maximaRows);
-#endif
-	}
+	ApplyTileJobs();
 
-	// actually smooth with approximate Gaussian blur passes
-	for (int numBlurs = 3; numBlurs > 0; --numBlurs) {
-		BlurHorizontal(maxx, maxy, blurSize, resolution, mesh, origMesh); mesh.swap(origMesh);
-		BlurVertical(maxx, maxy, blurSize, resolution, mesh, origMesh); mesh.swap(origMesh);
-	}
+	heightMapVersion = readMap->GetHeightMapChangeTracker().GetVersion();
+}
 
-	// <mesh> now contains the final smoothed heightmap, save it in origMesh
-	std::copy(mesh.begin(), mesh.end(), origMesh.begin());
+
+
+float SmoothHeightMesh::GetHeight(float x, float y)
+{
+	assert(!mesh.empty());
+	return Interpolate(x, y, maxx, maxy, resolution, &mesh[0]);
+}
+
+float SmoothHeightMesh::GetHeightAboveWater(float x, float y)
+{
+	assert(!mesh.empty());
+	return std::max(0.0f, Interpolate(x, y, maxx, maxy, resolution, &mesh[0]));
+}
+
+
+
+float SmoothHeightMesh::SetHeight(int index, float h)
+{
+	return (mesh[index] = h);
+}
+
+float SmoothHeightMesh::AddHeight(int index, float h)
+{
+	return (mesh[index] += h);
 }
+
+float SmoothHeightMesh::SetMaxHeight(int index, float h)
+{
+	return (mesh[index] = std::max(h, mesh[index]));
+}
+
+
+
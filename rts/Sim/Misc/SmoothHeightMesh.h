@@ -3,18 +3,27 @@
 #ifndef SMOOTH_HEIGHT_MESH_H
 #define SMOOTH_HEIGHT_MESH_H
 
+#include <cinttypes>
+#include <future>
 #include <vector>
 
-class CGround;
+#include "SmoothHeightMeshTile.h"
 
 /**
  * Provides a GetHeight(x, y) of its own that smooths the mesh.
+ *
+ * Tiles of the mesh covering terrain changed since the last rebuild (as
+ * reported by readMap's heightmap-change tracker) are rebuilt by worker
+ * threads from a snapshot of the heightmap taken at a sim-frame boundary
+ * and swapped in at a later, fixed frame so that synced readers always
+ * see the same mesh on every client.
  */
 class SmoothHeightMesh
 {
 public:
 	void Init(float mx, float my, float res, float smoothRad);
 	void Kill();
+	void Update(int frameNum);
 
 	float GetHeight(float x, float y);
 	float GetHeightAboveWater(float x, float y);
@@ -28,12 +37,24 @@ public:
 	float GetFMaxY() const { return fmaxy; }
 	float GetResolution() const { return resolution; }
 
+	// mesh coordinates range over [0, maxx] x [0, maxy]
+	int GetMeshIndex(int x, int y) const { return (x + y * (maxx + 1)); }
+
 	const float* GetMeshData() const { return &mesh[0]; }
 	const float* GetOriginalMeshData() const { return &origMesh[0]; }
 
 private:
+	typedef SmoothHeightMeshTile TileJob;
+
 	void MakeSmoothMesh();
 
+	void InitTileJob(TileJob& job, int tileIdx) const;
+	void QueueTileJobs(int frameNum);
+	void ApplyTileJobs();
+	void WaitTileJobs();
+
+	static void RunTileJob(TileJob& job, int winSize);
+
 	int maxx = 0;
 	int maxy = 0;
 	float fmaxx = 0.0f;
@@ -44,8 +65,18 @@ private:
 	std::vector<float> mesh;
 	std::vector<float> origMesh;
 
-	std::vector<float> colsMaxima;
-	std::vector<int> maximaRows;
+	int numTilesX = 0;
+	int numTilesY = 0;
+	int jobSwapFrame = -1;
+
+	// version of the heightmap-change tracker the mesh (or the
+	// tiles currently being rebuilt) reflects
+	std::uint32_t heightMapVersion = 0;
+
+	std::vector<int> jobTileIndices;
+
+	std::vector<TileJob> tileJobs;
+	std::vector<std::future<void>> tileJobResults;
 };
 
 extern SmoothHeightMesh smoothGround;
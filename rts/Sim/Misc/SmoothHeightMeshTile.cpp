@@ -0,0 +1,121 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <limits>
+
+#include "SmoothHeightMeshTile.h"
+
+
+void SmoothHeightMeshTile::SetRect(int tx, int ty, int tileSize, int maxx, int maxy, int winSize, int blurSize, int numBlurs)
+{
+	const int border = winSize + blurSize * numBlurs;
+
+	x1 = tx * tileSize;
+	y1 = ty * tileSize;
+	x2 = std::min(x1 + tileSize - 1, maxx);
+	y2 = std::min(y1 + tileSize - 1, maxy);
+
+	ix1 = std::max(x1 - border,    0);
+	iy1 = std::max(y1 - border,    0);
+	ix2 = std::min(x2 + border, maxx);
+	iy2 = std::min(y2 + border, maxy);
+}
+
+
+void SmoothHeightMeshTile::Smooth(int winSize, int blurSize, int numBlurs)
+{
+	// the blurs run on the output expanded by their total radius such that
+	// the truncated windows at its edges do not reach the output itself; E
+	// only ever gets clamped by the input rectangle where that is clamped
+	// to the mesh bounds, at which point windows are truncated as they are
+	// for every other tile
+	const int blurBorder = blurSize * numBlurs;
+
+	const int iw = ix2 - ix1 + 1;
+
+	const int ex1 = std::max(x1 - blurBorder, ix1);
+	const int ey1 = std::max(y1 - blurBorder, iy1);
+	const int ex2 = std::min(x2 + blurBorder, ix2);
+	const int ey2 = std::min(y2 + blurBorder, iy2);
+	const int ew = ex2 - ex1 + 1;
+	const int eh = ey2 - ey1 + 1;
+
+	const auto InputHeight = [&](int x, int y) { return heights[(y - iy1) * iw + (x - ix1)]; };
+
+	std::vector<float> colsMaxima(iw * eh);
+	std::vector<float> curMesh(ew * eh);
+	std::vector<float> tmpMesh(ew * eh);
+
+	// column maxima over [y - winSize, y + winSize] for every row of E
+	for (int y = ey1; y <= ey2; ++y) {
+		const int wy1 = std::max(y - winSize, iy1);
+		const int wy2 = std::min(y + winSize, iy2);
+
+		for (int x = ix1; x <= ix2; ++x) {
+			float h = -std::numeric_limits<float>::max();
+
+			for (int yy = wy1; yy <= wy2; ++yy) {
+				h = std::max(h, InputHeight(x, yy));
+			}
+
+			colsMaxima[(y - ey1) * iw + (x - ix1)] = h;
+		}
+	}
+
+	// row maxima of the column maxima, i.e. maximum within the square window
+	for (int y = ey1; y <= ey2; ++y) {
+		for (int x = ex1; x <= ex2; ++x) {
+			const int wx1 = std::max(x - winSize, ix1);
+			const int wx2 = std::min(x + winSize, ix2);
+
+			float h = -std::numeric_limits<float>::max();
+
+			for (int xx = wx1; xx <= wx2; ++xx) {
+				h = std::max(h, colsMaxima[(y - ey1) * iw + (xx - ix1)]);
+			}
+
+			curMesh[(y - ey1) * ew + (x - ex1)] = h;
+		}
+	}
+
+	// approximate Gaussian blur, never below the terrain nor above its maximum
+	for (int n = numBlurs; n > 0; --n) {
+		for (int y = ey1; y <= ey2; ++y) {
+			for (int x = ex1; x <= ex2; ++x) {
+				const int wx1 = std::max(x - blurSize, ex1);
+				const int wx2 = std::min(x + blurSize, ex2);
+
+				float sum = 0.0f;
+
+				for (int xx = wx1; xx <= wx2; ++xx) {
+					sum += curMesh[(y - ey1) * ew + (xx - ex1)];
+				}
+
+				tmpMesh[(y - ey1) * ew + (x - ex1)] = std::min(maxHeight, std::max(InputHeight(x, y), sum / (wx2 - wx1 + 1)));
+			}
+		}
+		for (int y = ey1; y <= ey2; ++y) {
+			const int wy1 = std::max(y - blurSize, ey1);
+			const int wy2 = std::min(y + blurSize, ey2);
+
+			for (int x = ex1; x <= ex2; ++x) {
+				float sum = 0.0f;
+
+				for (int yy = wy1; yy <= wy2; ++yy) {
+					sum += tmpMesh[(yy - ey1) * ew + (x - ex1)];
+				}
+
+				curMesh[(y - ey1) * ew + (x - ex1)] = std::min(maxHeight, std::max(InputHeight(x, y), sum / (wy2 - wy1 + 1)));
+			}
+		}
+	}
+
+	result.clear();
+	result.reserve((x2 - x1 + 1) * (y2 - y1 + 1));
+
+	for (int y = y1; y <= y2; ++y) {
+		for (int x = x1; x <= x2; ++x) {
+			result.push_back(curMesh[(y - ey1) * ew + (x - ex1)]);
+		}
+	}
+}
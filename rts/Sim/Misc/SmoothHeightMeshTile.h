@@ -0,0 +1,43 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef SMOOTH_HEIGHT_MESH_TILE_H
+#define SMOOTH_HEIGHT_MESH_TILE_H
+
+#include <vector>
+
+/**
+ * One square tile of the smoothed height-mesh, computed from a snapshot
+ * of the heightmap around it (radial maximum followed by box-blurs that
+ * are clamped to the terrain).
+ *
+ * Every output cell only depends on the input within the smoothing and
+ * blur radii and windows are clamped to the mesh bounds, never to the
+ * snapshot, so building the mesh tile by tile yields exactly the same
+ * values as building it in one piece.
+ *
+ * Mesh coordinates are inclusive and range over [0, maxx] x [0, maxy].
+ */
+struct SmoothHeightMeshTile {
+public:
+	// sets the output and (snapshot) input rectangles of tile <tx, ty>
+	void SetRect(int tx, int ty, int tileSize, int maxx, int maxy, int winSize, int blurSize, int numBlurs);
+
+	// <heights> must hold the input rectangle, row-major
+	void Smooth(int winSize, int blurSize, int numBlurs);
+
+	int GetNumInputCells() const { return ((ix2 - ix1 + 1) * (iy2 - iy1 + 1)); }
+
+public:
+	// output rectangle
+	int x1, y1, x2, y2;
+	// input rectangle, output expanded by the smoothing and blur radii
+	int ix1, iy1, ix2, iy2;
+
+	float maxHeight;
+
+	std::vector<float> heights;
+	// output rectangle, row-major
+	std::vector<float> result;
+};
+
+#endif
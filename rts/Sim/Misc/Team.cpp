@@ -4,6 +4,7 @@
 
 #include "TeamHandler.h"
 #include "GlobalSynced.h"
+#include "ModInfo.h"
 #include "ExternalAI/SkirmishAIHandler.h"
 #include "Game/Players/Player.h"
 #include "Game/Players/PlayerHandler.h"
@@ -48,6 +49,7 @@ CR_REG_METADATA(CTeam, (
 	CR_MEMBER(resPrevReceived),
 	CR_MEMBER(resPrevExcess),
 	CR_MEMBER(nextHistoryEntry),
+	CR_MEMBER(currentStats),
 	CR_MEMBER(statHistory),
 	CR_MEMBER(modParams),
 	CR_IGNORED(highlight)
@@ -71,8 +73,6 @@ CTeam::CTeam():
 	nextHistoryEntry(0),
 	highlight(0.0f)
 {
-	statHistory.reserve(1024);
-	statHistory.push_back(TeamStatistics());
 }
 
 void CTeam::SetDefaultStartPos()
@@ -304,8 +304,6 @@ void CTeam::ResetResourceState()
 
 void CTeam::SlowUpdate()
 {
-	TeamStatistics& currentStats = GetCurrentStats();
-
 	float eShare = 0.0f;
 	float mShare = 0.0f;
 
@@ -383,10 +381,10 @@ void CTeam::SlowUpdate()
 
 	if (nextHistoryEntry <= gs->frameNum) {
 		currentStats.frame = gs->frameNum;
-		statHistory.push_back(currentStats);
+		statHistory.Append(currentStats, modInfo.teamStatsMaxHistory);
 
 		nextHistoryEntry = gs->frameNum + (TeamStatistics::statsPeriod * GAME_SPEED);
-		GetCurrentStats().frame = nextHistoryEntry;
+		currentStats.frame = nextHistoryEntry;
 	}
 }
 
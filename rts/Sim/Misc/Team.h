@@ -9,6 +9,7 @@
 
 #include "TeamBase.h"
 #include "TeamStatistics.h"
+#include "TeamStatsHistory.h"
 #include "Sim/Misc/Resource.h"
 #include "System/Color.h"
 #include "ExternalAI/SkirmishAIKey.h"
@@ -50,8 +51,8 @@ public:
 	unsigned int GetNumUnits() const { return numUnits; }
 	bool AtUnitLimit() const { return (numUnits >= maxUnits); }
 
-	const TeamStatistics& GetCurrentStats() const { return statHistory.back(); }
-	      TeamStatistics& GetCurrentStats()       { return statHistory.back(); }
+	const TeamStatistics& GetCurrentStats() const { return currentStats; }
+	      TeamStatistics& GetCurrentStats()       { return currentStats; }
 
 	CTeam& operator = (const TeamBase& base) {
 		TeamBase::operator = (base);
@@ -94,7 +95,11 @@ public:
 	SResourcePack resPrevExcess;
 
 	int nextHistoryEntry;
-	std::vector<TeamStatistics> statHistory;
+
+	// running totals since game start; appended to statHistory once
+	// per TeamStatistics::statsPeriod (history does not include them)
+	TeamStatistics currentStats;
+	CTeamStatsHistory statHistory;
 
 	/// mod controlled parameters
 	LuaRulesParams::Params  modParams;
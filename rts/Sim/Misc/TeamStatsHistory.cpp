@@ -0,0 +1,168 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "TeamStatsHistory.h"
+
+#include <cassert>
+#include <cstring>
+
+CR_BIND(CTeamStatsHistory, )
+CR_REG_METADATA(CTeamStatsHistory, (
+	CR_MEMBER(fields),
+	CR_MEMBER(keyOffsets),
+	CR_MEMBER(lastValues),
+	CR_MEMBER(numEntries)
+))
+
+static_assert((sizeof(TeamStatistics) % sizeof(std::uint32_t)) == 0, "");
+
+
+static inline std::uint32_t ZigZagEncode(std::int32_t v) { return ((std::uint32_t(v) << 1) ^ std::uint32_t(v >> 31)); }
+static inline std::int32_t ZigZagDecode(std::uint32_t v) { return (std::int32_t(v >> 1) ^ -std::int32_t(v & 1)); }
+
+static inline void WriteVarInt(std::vector<std::uint8_t>& bytes, std::uint32_t v)
+{
+	while (v >= 0x80) {
+		bytes.push_back((v & 0x7F) | 0x80);
+		v >>= 7;
+	}
+
+	bytes.push_back(v);
+}
+
+static inline std::uint32_t ReadVarInt(const std::vector<std::uint8_t>& bytes, size_t& offset)
+{
+	std::uint32_t v = 0;
+
+	for (unsigned int shift = 0; ; shift += 7) {
+		const std::uint8_t b = bytes[offset++];
+
+		v |= (std::uint32_t(b & 0x7F) << shift);
+
+		if ((b & 0x80) == 0)
+			break;
+	}
+
+	return v;
+}
+
+
+
+std::array<std::uint32_t, CTeamStatsHistory::NUM_FIELDS> CTeamStatsHistory::Pack(const TeamStatistics& stats)
+{
+	std::array<std::uint32_t, NUM_FIELDS> values;
+	// TeamStatistics is packed and has a ctor, copy it as raw bytes
+	std::memcpy(values.data(), static_cast<const void*>(&stats), sizeof(TeamStatistics));
+	return values;
+}
+
+TeamStatistics CTeamStatsHistory::Unpack(const std::array<std::uint32_t, NUM_FIELDS>& values)
+{
+	TeamStatistics stats;
+	std::memcpy(static_cast<void*>(&stats), values.data(), sizeof(TeamStatistics));
+	return stats;
+}
+
+
+void CTeamStatsHistory::Clear()
+{
+	for (auto& bytes: fields) {
+		bytes.clear();
+	}
+
+	keyOffsets.clear();
+	lastValues.fill(0);
+
+	numEntries = 0;
+}
+
+void CTeamStatsHistory::Append(const TeamStatistics& stats, unsigned int maxSize)
+{
+	if (maxSize != 0 && numEntries >= maxSize)
+		Thin();
+
+	const std::array<std::uint32_t, NUM_FIELDS> values = Pack(stats);
+	const bool keyFrame = ((numEntries % KEYFRAME_RATE) == 0);
+
+	for (unsigned int n = 0; n < NUM_FIELDS; n++) {
+		// keyframes are coded against zero so Get() can start decoding there
+		const std::uint32_t prev = keyFrame? 0: lastValues[n];
+
+		if (keyFrame)
+			keyOffsets.push_back(fields[n].size());
+
+		WriteVarInt(fields[n], ZigZagEncode(std::int32_t(values[n] - prev)));
+	}
+
+	lastValues = values;
+	numEntries += 1;
+}
+
+void CTeamStatsHistory::Thin()
+{
+	std::vector<TeamStatistics> entries;
+	entries.reserve(numEntries);
+
+	ForEach(0, numEntries, [&](const TeamStatistics& stats) { entries.push_back(stats); });
+	Clear();
+
+	// stats are cumulative, dropping a snapshot loses resolution but not totals
+	for (size_t i = 0; i < entries.size(); i++) {
+		if ((i & 1) == 0 && (i + 1) != entries.size())
+			continue;
+
+		Append(entries[i]);
+	}
+}
+
+
+TeamStatistics CTeamStatsHistory::Get(size_t idx) const
+{
+	assert(idx < numEntries);
+
+	if ((idx + 1) == numEntries)
+		return (Back());
+
+	std::array<std::uint32_t, NUM_FIELDS> values;
+	std::array<size_t, NUM_FIELDS> offsets;
+
+	Seek(idx - (idx % KEYFRAME_RATE), values, offsets);
+
+	for (size_t i = idx - (idx % KEYFRAME_RATE); i <= idx; i++) {
+		DecodeNext(i, values, offsets);
+	}
+
+	return (Unpack(values));
+}
+
+void CTeamStatsHistory::Seek(size_t keyIdx, std::array<std::uint32_t, NUM_FIELDS>& values, std::array<size_t, NUM_FIELDS>& offsets) const
+{
+	assert((keyIdx % KEYFRAME_RATE) == 0);
+
+	values.fill(0);
+
+	for (unsigned int n = 0; n < NUM_FIELDS; n++) {
+		offsets[n] = keyOffsets[(keyIdx / KEYFRAME_RATE) * NUM_FIELDS + n];
+	}
+}
+
+void CTeamStatsHistory::DecodeNext(size_t idx, std::array<std::uint32_t, NUM_FIELDS>& values, std::array<size_t, NUM_FIELDS>& offsets) const
+{
+	if ((idx % KEYFRAME_RATE) == 0)
+		values.fill(0);
+
+	for (unsigned int n = 0; n < NUM_FIELDS; n++) {
+		values[n] += std::uint32_t(ZigZagDecode(ReadVarInt(fields[n], offsets[n])));
+	}
+}
+
+
+size_t CTeamStatsHistory::GetNumBytes() const
+{
+	size_t numBytes = 0;
+
+	for (const auto& bytes: fields) {
+		numBytes += bytes.size();
+	}
+
+	return numBytes;
+}
@@ -0,0 +1,84 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef TEAM_STATS_HISTORY_H
+#define TEAM_STATS_HISTORY_H
+
+#include <array>
+#include <cinttypes>
+#include <vector>
+
+#include "TeamStatistics.h"
+#include "System/creg/creg_cond.h"
+
+// closed (periodic) TeamStatistics snapshots of one team, stored as one
+// byte-stream per 4-byte field; each value is the zig-zag varint of its
+// difference to the same field of the previous snapshot (cumulative stats
+// change little between snapshots, mostly-constant ones shrink to a byte)
+//
+// differences are taken between raw bit-patterns, so floats round-trip
+// exactly (this is synced state, Lua can read it back)
+class CTeamStatsHistory
+{
+	CR_DECLARE_STRUCT(CTeamStatsHistory)
+
+public:
+	static constexpr unsigned int NUM_FIELDS = sizeof(TeamStatistics) / sizeof(std::uint32_t);
+	// every KEYFRAME_RATE'th snapshot is coded against zero; Get() decodes
+	// at most this many values per field
+	static constexpr unsigned int KEYFRAME_RATE = 16;
+
+	void Clear();
+	// appends <stats> in constant (amortized) time; if <maxSize> is non-zero
+	// and exceeded, every other snapshot is dropped beforehand (the newest is
+	// always retained) which halves the resolution of the existing history
+	void Append(const TeamStatistics& stats, unsigned int maxSize = 0);
+
+	TeamStatistics Get(size_t idx) const;
+	TeamStatistics Back() const { return (Unpack(lastValues)); }
+
+	// decodes snapshots [begin, end) in order, <f> is called with each
+	template<typename F> void ForEach(size_t begin, size_t end, F&& f) const {
+		std::array<std::uint32_t, NUM_FIELDS> values;
+		std::array<size_t, NUM_FIELDS> offsets;
+
+		if (begin >= end)
+			return;
+
+		Seek(begin - (begin % KEYFRAME_RATE), values, offsets);
+
+		for (size_t i = begin - (begin % KEYFRAME_RATE); i < end; i++) {
+			DecodeNext(i, values, offsets);
+
+			if (i >= begin)
+				f(Unpack(values));
+		}
+	}
+
+	size_t size() const { return numEntries; }
+	bool empty() const { return (numEntries == 0); }
+
+	// frame of the newest snapshot, -1 if none
+	int GetLastFrame() const { return ((numEntries > 0)? Unpack(lastValues).frame: -1); }
+	// encoded size in bytes (excluding keyframe offsets)
+	size_t GetNumBytes() const;
+
+private:
+	void Thin();
+
+	void Seek(size_t keyIdx, std::array<std::uint32_t, NUM_FIELDS>& values, std::array<size_t, NUM_FIELDS>& offsets) const;
+	void DecodeNext(size_t idx, std::array<std::uint32_t, NUM_FIELDS>& values, std::array<size_t, NUM_FIELDS>& offsets) const;
+
+	static std::array<std::uint32_t, NUM_FIELDS> Pack(const TeamStatistics& stats);
+	static TeamStatistics Unpack(const std::array<std::uint32_t, NUM_FIELDS>& values);
+
+private:
+	std::array<std::vector<std::uint8_t>, NUM_FIELDS> fields;
+	// per-field byte offsets of each keyframe, [keyIdx * NUM_FIELDS + field]
+	std::vector<std::uint32_t> keyOffsets;
+
+	std::array<std::uint32_t, NUM_FIELDS> lastValues = {{0}};
+
+	unsigned int numEntries = 0;
+};
+
+#endif
@@ -89,6 +89,7 @@ CR_REG_METADATA(CGroundMoveType, (
 	CR_MEMBER(waypointDir),
 	CR_MEMBER(flatFrontDir),
 	CR_MEMBER(lastAvoidanceDir),
+	CR_MEMBER(localAvoidanceVec),
 	CR_MEMBER(mainHeadingPos),
 	CR_MEMBER(skidRotVector),
 
@@ -1267,6 +1268,15 @@ float3 CGroundMoveType::GetObstacleAvoidanceDir(const float3& desiredDir) {
 	if (WantToStop())
 		return flatFrontDir;
 
+	// velocity-obstacle stage already ran for all units this frame
+	if (modInfo.allowLocalAvoidance) {
+		const float3 avoidanceVec = desiredDir * std::max(wantedSpeed, 0.1f) + localAvoidanceVec;
+		const float3 avoidanceDir = (avoidanceVec * XZVector).SafeNormalize();
+
+		// keep the desired direction if the correction cancels it out
+		return (lastAvoidanceDir = mix(avoidanceDir, desiredDir, avoidanceDir == ZeroVector));
+	}
+
 	// Speed-optimizer. Reduces the times this system is run.
 	if (gs->frameNum < nextObstacleAvoidanceFrame)
 		return lastAvoidanceDir;
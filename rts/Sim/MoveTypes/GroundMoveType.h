@@ -89,9 +89,12 @@ public:
 	const SyncedFloat3& GetNextWayPoint() const { return nextWayPoint; }
 
 	const float3& GetFlatFrontDir() const { return flatFrontDir; }
+	const float3& GetWayPointDir() const { return waypointDir; }
 	const float3& GetGroundNormal(const float3&) const;
 	float GetGroundHeight(const float3&) const;
 
+	void SetLocalAvoidanceVec(const float3& v) { localAvoidanceVec = v; }
+
 private:
 	float3 GetObstacleAvoidanceDir(const float3& desiredDir);
 	float3 Here() const;
@@ -170,6 +173,7 @@ private:
 	float3 waypointDir;
 	float3 flatFrontDir;
 	float3 lastAvoidanceDir;
+	float3 localAvoidanceVec;               /// velocity correction from CLocalAvoidance (if enabled)
 	float3 mainHeadingPos;
 	float3 skidRotVector;                   /// vector orthogonal to skidDir
 
@@ -985,14 +985,7 @@ bool CHoverAirMoveType::CanLandAt(const float3& pos) const
 	const int2 os = {owner->xsize, owner->zsize};
 	const int2 mp = owner->GetMapPos(pos);
 
-	for (int z = mp.y; z < (mp.y + os.y); z++) {
-		for (int x = mp.x; x < (mp.x + os.x); x++) {
-			if (groundBlockingObjectMap.GroundBlocked(x, z, owner))
-				return false;
-		}
-	}
-
-	return true;
+	return (groundBlockingObjectMap.IsFootprintFree(mp.x, mp.y, mp.x + os.x, mp.y + os.y, owner));
 }
 
 void CHoverAirMoveType::ForceHeading(short h)
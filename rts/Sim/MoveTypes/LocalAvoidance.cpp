@@ -0,0 +1,415 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <array>
+
+#include "LocalAvoidance.h"
+#include "GroundMoveType.h"
+#include "MoveDefHandler.h"
+#include "MoveMath/MoveMath.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "Sim/Misc/ModInfo.h"
+#include "Sim/Misc/QuadField.h"
+#include "Sim/Units/Unit.h"
+#include "Sim/Units/UnitHandler.h"
+#include "System/SpringMath.h"
+#include "System/TimeProfiler.h"
+#include "System/Threading/ThreadPool.h"
+
+// look-ahead (in frames) over which velocities must stay collision-free
+#define LOCAL_AVOIDANCE_TIME_HORIZON (GAME_SPEED * 1.0f)
+// maximum number of (nearest) neighbors considered per agent
+#define LOCAL_AVOIDANCE_MAX_NEIGHBORS 16
+// share of the avoidance effort taken by each of two moving agents
+#define LOCAL_AVOIDANCE_RECIPROCITY 0.5f
+#define LOCAL_AVOIDANCE_EPSILON 0.00001f
+
+
+CLocalAvoidance localAvoidance;
+
+static std::array<CLocalAvoidance::ThreadData, ThreadPool::MAX_THREADS> avoidanceThreadData;
+
+
+static inline float Dot(const float2& a, const float2& b) { return (a.x * b.x + a.y * b.y); }
+static inline float Det(const float2& a, const float2& b) { return (a.x * b.y - a.y * b.x); }
+static inline float SqLen(const float2& a) { return (Dot(a, a)); }
+
+static inline float2 Normalized(const float2& a) {
+	const float len = math::sqrt(SqLen(a));
+
+	if (len <= LOCAL_AVOIDANCE_EPSILON)
+		return (float2(0.0f, 0.0f));
+
+	return (a / len);
+}
+
+
+// solves the 1D linear program on half-plane <planeIdx> subject to all
+// half-planes preceding it and the maximum-speed circle; see van den Berg
+// et al., "Reciprocal n-Body Collision Avoidance" (the RVO2 formulation)
+static bool LinearProgram1(
+	const std::vector<CLocalAvoidance::HalfPlane>& planes,
+	unsigned int planeIdx,
+	float maxSpeed,
+	const float2& optVel,
+	bool optDir,
+	float2& result
+) {
+	const CLocalAvoidance::HalfPlane& plane = planes[planeIdx];
+
+	const float dotProduct = Dot(plane.point, plane.dir);
+	const float discriminant = Square(dotProduct) + Square(maxSpeed) - SqLen(plane.point);
+
+	// max-speed circle fully invalidates this half-plane
+	if (discriminant < 0.0f)
+		return false;
+
+	const float discriminantSqrt = math::sqrt(discriminant);
+
+	float tLeft  = -dotProduct - discriminantSqrt;
+	float tRight = -dotProduct + discriminantSqrt;
+
+	for (unsigned int i = 0; i < planeIdx; ++i) {
+		const float denominator = Det(plane.dir, planes[i].dir);
+		const float numerator = Det(planes[i].dir, plane.point - planes[i].point);
+
+		// (almost) parallel half-planes
+		if (math::fabs(denominator) <= LOCAL_AVOIDANCE_EPSILON) {
+			if (numerator < 0.0f)
+				return false;
+
+			continue;
+		}
+
+		const float t = numerator / denominator;
+
+		if (denominator >= 0.0f) {
+			tRight = std::min(tRight, t);
+		} else {
+			tLeft = std::max(tLeft, t);
+		}
+
+		if (tLeft > tRight)
+			return false;
+	}
+
+	if (optDir) {
+		result = plane.point + plane.dir * ((Dot(optVel, plane.dir) > 0.0f)? tRight: tLeft);
+		return true;
+	}
+
+	result = plane.point + plane.dir * Clamp(Dot(plane.dir, optVel - plane.point), tLeft, tRight);
+	return true;
+}
+
+// returns the index of the first half-plane that could not be satisfied, or planes.size()
+static unsigned int LinearProgram2(
+	const std::vector<CLocalAvoidance::HalfPlane>& planes,
+	float maxSpeed,
+	const float2& optVel,
+	bool optDir,
+	float2& result
+) {
+	if (optDir) {
+		// optVel is a unit-direction in this case
+		result = optVel * maxSpeed;
+	} else if (SqLen(optVel) > Square(maxSpeed)) {
+		result = Normalized(optVel) * maxSpeed;
+	} else {
+		result = optVel;
+	}
+
+	for (unsigned int i = 0; i < planes.size(); ++i) {
+		if (Det(planes[i].dir, planes[i].point - result) <= 0.0f)
+			continue;
+
+		const float2 tempResult = result;
+
+		if (!LinearProgram1(planes, i, maxSpeed, optVel, optDir, result)) {
+			result = tempResult;
+			return i;
+		}
+	}
+
+	return planes.size();
+}
+
+// infeasible case; minimizes the maximum penetration into the violated half-planes
+static void LinearProgram3(
+	const std::vector<CLocalAvoidance::HalfPlane>& planes,
+	std::vector<CLocalAvoidance::HalfPlane>& projPlanes,
+	unsigned int beginPlaneIdx,
+	float maxSpeed,
+	float2& result
+) {
+	float distance = 0.0f;
+
+	for (unsigned int i = beginPlaneIdx; i < planes.size(); ++i) {
+		if (Det(planes[i].dir, planes[i].point - result) <= distance)
+			continue;
+
+		projPlanes.clear();
+
+		for (unsigned int j = 0; j < i; ++j) {
+			CLocalAvoidance::HalfPlane plane;
+
+			const float determinant = Det(planes[i].dir, planes[j].dir);
+
+			if (math::fabs(determinant) <= LOCAL_AVOIDANCE_EPSILON) {
+				// same direction, j is implied by i
+				if (Dot(planes[i].dir, planes[j].dir) > 0.0f)
+					continue;
+
+				plane.point = (planes[i].point + planes[j].point) * 0.5f;
+			} else {
+				plane.point = planes[i].point + planes[i].dir * (Det(planes[j].dir, planes[i].point - planes[j].point) / determinant);
+			}
+
+			plane.dir = Normalized(planes[j].dir - planes[i].dir);
+			projPlanes.push_back(plane);
+		}
+
+		const float2 tempResult = result;
+
+		// should in principle never fail; if it does (numerical error) keep the previous result
+		if (LinearProgram2(projPlanes, maxSpeed, float2(-planes[i].dir.y, planes[i].dir.x), true, result) < projPlanes.size())
+			result = tempResult;
+
+		distance = Det(planes[i].dir, planes[i].point - result);
+	}
+}
+
+
+
+void CLocalAvoidance::Update(const std::vector<CUnit*>& activeUnits)
+{
+	if (!modInfo.allowLocalAvoidance)
+		return;
+
+	SCOPED_TIMER("Sim::Unit::MoveType::LocalAvoidance");
+
+	GatherAgents(activeUnits);
+
+	// agents only read the snapshot and write their own slot
+	for_mt(0, agents.size(), [&](const int i) {
+		SolveAgent(i, avoidanceThreadData[ThreadPool::GetThreadNum()]);
+	});
+
+	ApplyAgents();
+}
+
+
+void CLocalAvoidance::GatherAgents(const std::vector<CUnit*>& activeUnits)
+{
+	agents.clear();
+	agents.reserve(activeUnits.size());
+	agentIndices.clear();
+	agentIndices.resize(unitHandler.MaxUnits(), -1);
+
+	maxAgentRadius = 0.0f;
+
+	for (CUnit* unit: activeUnits) {
+		CGroundMoveType* gmt = dynamic_cast<CGroundMoveType*>(unit->moveType);
+
+		if (gmt == nullptr)
+			continue;
+		if (unit->GetTransporter() != nullptr)
+			continue;
+		if (unit->IsInAir() || unit->IsFlying())
+			continue;
+
+		const MoveDef* md = unit->moveDef;
+		const bool moving = !gmt->WantToStop();
+
+		Agent agent;
+		agent.unit = unit;
+		agent.moveType = gmt;
+
+		agent.pos = {unit->pos.x, unit->pos.z};
+		agent.vel = {unit->speed.x, unit->speed.z};
+		agent.prefVel = {0.0f, 0.0f};
+
+		if (moving) {
+			const float3& wpDir = gmt->GetWayPointDir();
+			const float wpSign = Sign(int(!gmt->IsReversing()));
+
+			agent.prefVel = float2(wpDir.x, wpDir.z) * (gmt->GetWantedSpeed() * wpSign);
+		}
+
+		agent.radius = md->CalcFootPrintMinExteriorRadius();
+		agent.maxSpeed = std::max(gmt->GetMaxSpeed(), gmt->GetMaxReverseSpeed());
+
+		agent.unitID = unit->id;
+		agent.allyTeam = unit->allyteam;
+
+		agent.moving = moving;
+		agent.movable = !gmt->IsPushResistant();
+		agent.avoidMobiles = md->avoidMobilesOnPath;
+
+		agentIndices[unit->id] = agents.size();
+		agents.push_back(agent);
+
+		maxAgentRadius = std::max(maxAgentRadius, agent.radius);
+	}
+
+	agentVels.clear();
+	agentVels.resize(agents.size(), float2(0.0f, 0.0f));
+}
+
+void CLocalAvoidance::GatherNeighbors(unsigned int agentIdx, std::vector<int>& neighbors) const
+{
+	const Agent& agent = agents[agentIdx];
+
+	// anything farther away can not be reached within the time horizon
+	const float searchRadius = agent.radius + maxAgentRadius + agent.maxSpeed * LOCAL_AVOIDANCE_TIME_HORIZON;
+
+	const int qsx = quadField.GetQuadSizeX();
+	const int qsz = quadField.GetQuadSizeZ();
+	const int qxMin = Clamp(int((agent.pos.x - searchRadius) / qsx), 0, quadField.GetNumQuadsX() - 1);
+	const int qxMax = Clamp(int((agent.pos.x + searchRadius) / qsx), 0, quadField.GetNumQuadsX() - 1);
+	const int qzMin = Clamp(int((agent.pos.y - searchRadius) / qsz), 0, quadField.GetNumQuadsZ() - 1);
+	const int qzMax = Clamp(int((agent.pos.y + searchRadius) / qsz), 0, quadField.GetNumQuadsZ() - 1);
+
+	neighbors.clear();
+
+	// read-only access; the quadfield is not modified until the movetypes update
+	for (int qz = qzMin; qz <= qzMax; ++qz) {
+		for (int qx = qxMin; qx <= qxMax; ++qx) {
+			for (const CUnit* unit: quadField.GetQuadAt(qx, qz).units) {
+				const int nbrIdx = agentIndices[unit->id];
+
+				if (nbrIdx < 0 || nbrIdx == int(agentIdx))
+					continue;
+
+				const Agent& nbr = agents[nbrIdx];
+
+				if (SqLen(nbr.pos - agent.pos) >= Square(searchRadius))
+					continue;
+
+				// do not bother steering around idling movable units, same
+				// as the legacy avoidance (collision handling pushes them)
+				if (nbr.movable && (!agent.avoidMobiles || (!nbr.moving && nbr.allyTeam == agent.allyTeam)))
+					continue;
+				if (CMoveMath::IsNonBlocking(*agent.unit->moveDef, nbr.unit, agent.unit))
+					continue;
+				if (!CMoveMath::CrushResistant(*agent.unit->moveDef, nbr.unit))
+					continue;
+
+				neighbors.push_back(nbrIdx);
+			}
+		}
+	}
+
+	// units overlapping several quads are seen more than once
+	std::sort(neighbors.begin(), neighbors.end());
+	neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+
+	if (neighbors.size() <= LOCAL_AVOIDANCE_MAX_NEIGHBORS)
+		return;
+
+	// keep the nearest; ties are broken by (unique) agent index for sync
+	const auto nbrCmp = [&](int a, int b) {
+		const float da = SqLen(agents[a].pos - agent.pos);
+		const float db = SqLen(agents[b].pos - agent.pos);
+		return ((da < db) || (da == db && a < b));
+	};
+
+	std::partial_sort(neighbors.begin(), neighbors.begin() + LOCAL_AVOIDANCE_MAX_NEIGHBORS, neighbors.end(), nbrCmp);
+	neighbors.resize(LOCAL_AVOIDANCE_MAX_NEIGHBORS);
+}
+
+void CLocalAvoidance::SolveAgent(unsigned int agentIdx, ThreadData& threadData)
+{
+	const Agent& agent = agents[agentIdx];
+
+	// idling agents only act as obstacles
+	if (!agent.moving)
+		return;
+
+	GatherNeighbors(agentIdx, threadData.neighbors);
+
+	std::vector<HalfPlane>& halfPlanes = threadData.halfPlanes;
+	halfPlanes.clear();
+
+	constexpr float invTimeHorizon = 1.0f / LOCAL_AVOIDANCE_TIME_HORIZON;
+
+	for (const int nbrIdx: threadData.neighbors) {
+		const Agent& nbr = agents[nbrIdx];
+
+		const float2 relPos = nbr.pos - agent.pos;
+		const float2 relVel = agent.vel - nbr.vel;
+
+		const float distSq = SqLen(relPos);
+		const float radiusSum = agent.radius + nbr.radius;
+		const float radiusSumSq = Square(radiusSum);
+
+		HalfPlane plane;
+		float2 u;
+
+		if (distSq > radiusSumSq) {
+			// no collision yet; project onto the truncated velocity-obstacle cone
+			const float2 w = relVel - relPos * invTimeHorizon;
+			const float wLenSq = SqLen(w);
+			const float dotProduct = Dot(w, relPos);
+
+			if (dotProduct < 0.0f && Square(dotProduct) > radiusSumSq * wLenSq) {
+				// project on cut-off circle
+				const float wLen = math::sqrt(wLenSq);
+				const float2 unitW = (wLen > LOCAL_AVOIDANCE_EPSILON)? (w / wLen): float2(0.0f, 0.0f);
+
+				plane.dir = float2(unitW.y, -unitW.x);
+				u = unitW * (radiusSum * invTimeHorizon - wLen);
+			} else {
+				// project on the nearest leg
+				const float leg = math::sqrt(distSq - radiusSumSq);
+
+				if (Det(relPos, w) > 0.0f) {
+					plane.dir = float2(relPos.x * leg - relPos.y * radiusSum, relPos.x * radiusSum + relPos.y * leg) / distSq;
+				} else {
+					plane.dir = -float2(relPos.x * leg + relPos.y * radiusSum, -relPos.x * radiusSum + relPos.y * leg) / distSq;
+				}
+
+				u = plane.dir * Dot(relVel, plane.dir) - relVel;
+			}
+		} else {
+			// already overlapping; resolve within a single frame
+			const float2 w = relVel - relPos;
+			const float wLen = math::sqrt(SqLen(w));
+			const float2 unitW = (wLen > LOCAL_AVOIDANCE_EPSILON)? (w / wLen): float2(0.0f, 0.0f);
+
+			plane.dir = float2(unitW.y, -unitW.x);
+			u = unitW * (radiusSum - wLen);
+		}
+
+		// moving neighbors take their share of the effort, the rest is ours
+		plane.point = agent.vel + u * (nbr.moving? LOCAL_AVOIDANCE_RECIPROCITY: 1.0f);
+		halfPlanes.push_back(plane);
+	}
+
+	float2& newVel = agentVels[agentIdx];
+
+	const unsigned int failedPlaneIdx = LinearProgram2(halfPlanes, agent.maxSpeed, agent.prefVel, false, newVel);
+
+	if (failedPlaneIdx < halfPlanes.size())
+		LinearProgram3(halfPlanes, threadData.projPlanes, failedPlaneIdx, agent.maxSpeed, newVel);
+}
+
+void CLocalAvoidance::ApplyAgents()
+{
+	for (size_t i = 0; i < agents.size(); ++i) {
+		const Agent& agent = agents[i];
+
+		if (!agent.moving) {
+			agent.moveType->SetLocalAvoidanceVec(ZeroVector);
+			continue;
+		}
+
+		// store the deviation from the preferred velocity; the movetype
+		// applies it on top of whatever direction it wants this frame
+		const float2 devVel = agentVels[i] - agent.prefVel;
+
+		agent.moveType->SetLocalAvoidanceVec(float3(devVel.x, 0.0f, devVel.y));
+	}
+
+	agentIndices.clear();
+}
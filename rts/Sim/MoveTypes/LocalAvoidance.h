@@ -0,0 +1,75 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LOCAL_AVOIDANCE_H
+#define LOCAL_AVOIDANCE_H
+
+#include <vector>
+
+#include "System/type2.h"
+
+class CUnit;
+class CGroundMoveType;
+
+// short-range reciprocal (ORCA-style) velocity-obstacle avoidance for
+// ground units; runs once per frame before the movetype updates and is
+// only enabled if modInfo.allowLocalAvoidance is set
+//
+// all agents are snapshotted serially, new velocities are then solved
+// in parallel (each agent writes only to its own slot) and applied to
+// the movetypes serially again, so the result does not depend on the
+// number of threads nor on their scheduling
+class CLocalAvoidance {
+public:
+	struct HalfPlane {
+		float2 point;
+		float2 dir;
+	};
+
+	// per-thread scratch buffers for the solver
+	struct ThreadData {
+		std::vector<int> neighbors;
+		std::vector<HalfPlane> halfPlanes;
+		std::vector<HalfPlane> projPlanes;
+	};
+
+public:
+	void Update(const std::vector<CUnit*>& activeUnits);
+
+private:
+	struct Agent {
+		const CUnit* unit;
+		CGroundMoveType* moveType;
+
+		float2 pos;
+		float2 vel;
+		float2 prefVel;
+
+		float radius;
+		float maxSpeed;
+
+		int unitID;
+		int allyTeam;
+
+		bool moving;
+		bool movable;
+		bool avoidMobiles;
+	};
+
+	void GatherAgents(const std::vector<CUnit*>& activeUnits);
+	void GatherNeighbors(unsigned int agentIdx, std::vector<int>& neighbors) const;
+	void SolveAgent(unsigned int agentIdx, ThreadData& threadData);
+	void ApplyAgents();
+
+private:
+	std::vector<Agent> agents;
+	std::vector<float2> agentVels;
+
+	// unit-id to agents-index (or -1) lookup, valid during Update only
+	std::vector<int> agentIndices;
+
+	float maxAgentRadius = 0.0f;
+};
+
+extern CLocalAvoidance localAvoidance;
+
+#endif
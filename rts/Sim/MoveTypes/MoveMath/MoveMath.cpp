@@ -6,6 +6,7 @@
 #include "Map/MapInfo.h"
 #include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/GroundBlockingObjectMap.h"
+#include "Sim/Misc/ModInfo.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/MoveTypes/MoveType.h"
 #include "Sim/Objects/SolidObject.h"
@@ -15,6 +16,8 @@
 bool CMoveMath::noHoverWaterMove = false;
 float CMoveMath::waterDamageCost = 0.0f;
 
+CSpeedModCache CMoveMath::speedModCache;
+
 static constexpr int FOOTPRINT_XSTEP = 2;
 static constexpr int FOOTPRINT_ZSTEP = 2;
 
@@ -45,13 +48,45 @@ float CMoveMath::yLevel(const MoveDef& moveDef, const float3& pos)
 
 
 
+void CMoveMath::InitSpeedModCache()
+{
+	speedModCache.Init(moveDefHandler.GetNumMoveDefs(), mapDims.hmapx, mapDims.hmapy);
+	UpdateSpeedModCache(0, 0, mapDims.mapx - 1, mapDims.mapy - 1);
+}
+
+void CMoveMath::KillSpeedModCache()
+{
+	speedModCache.Kill();
+}
+
+void CMoveMath::UpdateSpeedModCache(int x1, int z1, int x2, int z2)
+{
+	// UpdateSlopemap also refreshes the half-res cells bordering a changed
+	// area, callers such as RecalcArea do not pad their rectangles for this
+	speedModCache.Update((x1 >> 1) - 1, (z1 >> 1) - 1, (x2 >> 1) + 1, (z2 >> 1) + 1, [](unsigned int pathType, int hx, int hz) {
+		return (CalcPosSpeedMod(*moveDefHandler.GetMoveDefByPathType(pathType), hx, hz));
+	});
+}
+
+
 /* calculate the local speed-modifier for this MoveDef */
 float CMoveMath::GetPosSpeedMod(const MoveDef& moveDef, unsigned xSquare, unsigned zSquare)
 {
 	if (xSquare >= mapDims.mapx || zSquare >= mapDims.mapy)
 		return 0.0f;
 
-	const int square = (xSquare >> 1) + ((zSquare >> 1) * mapDims.hmapx);
+	const unsigned int hxSquare = xSquare >> 1;
+	const unsigned int hzSquare = zSquare >> 1;
+
+	if (speedModCache.Valid(moveDef.pathType))
+		return (speedModCache.Get(moveDef.pathType, hxSquare + hzSquare * mapDims.hmapx));
+
+	return (CalcPosSpeedMod(moveDef, hxSquare, hzSquare));
+}
+
+float CMoveMath::CalcPosSpeedMod(const MoveDef& moveDef, unsigned int hxSquare, unsigned int hzSquare)
+{
+	const int square = hxSquare + hzSquare * mapDims.hmapx;
 	const int squareTerrType = readMap->GetTypeMapSynced()[square];
 
 	const float height  = readMap->GetMIPHeightMapSynced(1)[square];
@@ -75,6 +110,10 @@ float CMoveMath::GetPosSpeedMod(const MoveDef& moveDef, unsigned xSquare, unsign
 	if (xSquare >= mapDims.mapx || zSquare >= mapDims.mapy)
 		return 0.0f;
 
+	// without directional pathing only ships care about moveDir
+	if (!modInfo.allowDirectionalPathing && moveDef.speedModClass != MoveDef::Ship)
+		return (GetPosSpeedMod(moveDef, xSquare, zSquare));
+
 	const int square = (xSquare >> 1) + ((zSquare >> 1) * mapDims.hmapx);
 	const int squareTerrType = readMap->GetTypeMapSynced()[square];
 
@@ -121,6 +160,10 @@ CMoveMath::BlockType CMoveMath::IsBlockedNoSpeedModCheck(const MoveDef& moveDef,
 		const int zOffset = z * mapDims.mapx;
 
 		for (int x = xmin; x <= xmax; x += FOOTPRINT_XSTEP) {
+			// most squares are empty, skip them without touching their cells
+			if (groundBlockingObjectMap.GetCellBlockBits(zOffset + x) == 0)
+				continue;
+
 			const CGroundBlockingObjectMap::BlockingMapCell& cell = groundBlockingObjectMap.GetCellUnsafeConst(zOffset + x);
 
 			for (size_t i = 0, n = cell.size(); i < n; i++) {
@@ -254,6 +297,9 @@ CMoveMath::BlockType CMoveMath::SquareIsBlocked(const MoveDef& moveDef, int xSqu
 	if (static_cast<unsigned>(xSquare) >= mapDims.mapx || static_cast<unsigned>(zSquare) >= mapDims.mapy)
 		return BLOCK_IMPASSABLE;
 
+	if (groundBlockingObjectMap.GetCellBlockBits(zSquare * mapDims.mapx + xSquare) == 0)
+		return BLOCK_NONE;
+
 	BlockType r = BLOCK_NONE;
 
 	const CGroundBlockingObjectMap::BlockingMapCell& cell = groundBlockingObjectMap.GetCellUnsafeConst(zSquare * mapDims.mapx + xSquare);
@@ -281,6 +327,10 @@ CMoveMath::BlockType CMoveMath::RangeIsBlocked(const MoveDef& moveDef, int xmin,
 		const int zOffset = z * mapDims.mapx;
 
 		for (int x = xmin; x <= xmax; x += FOOTPRINT_XSTEP) {
+			// most squares are empty, skip them without touching their cells
+			if (groundBlockingObjectMap.GetCellBlockBits(zOffset + x) == 0)
+				continue;
+
 			const CGroundBlockingObjectMap::BlockingMapCell& cell = groundBlockingObjectMap.GetCellUnsafeConst(zOffset + x);
 
 			for (size_t i = 0, n = cell.size(); i < n; i++) {
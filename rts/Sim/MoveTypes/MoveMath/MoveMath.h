@@ -3,6 +3,7 @@
 #ifndef MOVEMATH_H
 #define MOVEMATH_H
 
+#include "SpeedModCache.h"
 #include "Map/ReadMap.h"
 #include "System/float3.h"
 #include "System/Misc/BitwiseEnum.h"
@@ -20,6 +21,17 @@ protected:
 	static float ShipSpeedMod(const MoveDef& moveDef, float height, float slope);
 	static float ShipSpeedMod(const MoveDef& moveDef, float height, float slope, float dirSlopeMod);
 
+	// uncached (non-directional) speed-modifier, takes half-res coordinates
+	static float CalcPosSpeedMod(const MoveDef& moveDef, unsigned int hxSquare, unsigned int hzSquare);
+
+public:
+	// the per-MoveDef speed-modifier grids; initialized once all MoveDefs
+	// and the map are loaded, then kept in sync with terrain changes
+	static void InitSpeedModCache();
+	static void KillSpeedModCache();
+	// takes inclusive map-square coordinates
+	static void UpdateSpeedModCache(int x1, int z1, int x2, int z2);
+
 public:
 	// gives the y-coordinate the unit will "stand on"
 	static float yLevel(const MoveDef& moveDef, const float3& pos);
@@ -76,6 +88,9 @@ public:
 public:
 	static bool noHoverWaterMove;
 	static float waterDamageCost;
+
+private:
+	static CSpeedModCache speedModCache;
 };
 
 
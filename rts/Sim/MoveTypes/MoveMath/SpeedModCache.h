@@ -0,0 +1,68 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef SPEEDMOD_CACHE_H
+#define SPEEDMOD_CACHE_H
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+// precomputed per-layer (one layer per MoveDef pathType) grid of
+// speed-modifiers; the grid resolution is that of the half-res maps
+// (type, slope and mip-1 height) the modifiers are derived from
+class CSpeedModCache {
+public:
+	void Init(unsigned int nLayers, unsigned int xs, unsigned int zs) {
+		numLayers = nLayers;
+		xsize = xs;
+		zsize = zs;
+
+		speedMods.clear();
+		speedMods.resize(numLayers * xsize * zsize, 0.0f);
+	}
+	void Kill() {
+		speedMods.clear();
+
+		numLayers = 0;
+		xsize = 0;
+		zsize = 0;
+	}
+
+	bool Valid(unsigned int layer) const { return (layer < numLayers); }
+
+	float Get(unsigned int layer, unsigned int idx) const {
+		assert(layer < numLayers);
+		assert(idx < (xsize * zsize));
+		return speedMods[layer * (xsize * zsize) + idx];
+	}
+
+	// recalculates the (inclusive) cell-rectangle [x1,x2]*[z1,z2] of
+	// every layer, calcFunc is called as calcFunc(layer, x, z)
+	template<typename F> void Update(int x1, int z1, int x2, int z2, F&& calcFunc) {
+		x1 = std::max(x1, 0); x2 = std::min(x2, int(xsize) - 1);
+		z1 = std::max(z1, 0); z2 = std::min(z2, int(zsize) - 1);
+
+		for (unsigned int layer = 0; layer < numLayers; layer++) {
+			float* layerMods = &speedMods[layer * (xsize * zsize)];
+
+			for (int z = z1; z <= z2; z++) {
+				for (int x = x1; x <= x2; x++) {
+					layerMods[z * xsize + x] = calcFunc(layer, x, z);
+				}
+			}
+		}
+	}
+
+	unsigned int GetNumLayers() const { return numLayers; }
+	unsigned int GetSizeX() const { return xsize; }
+	unsigned int GetSizeZ() const { return zsize; }
+
+private:
+	std::vector<float> speedMods;
+
+	unsigned int numLayers = 0;
+	unsigned int xsize = 0;
+	unsigned int zsize = 0;
+};
+
+#endif
@@ -1231,12 +1231,8 @@ float3 CStrafeAirMoveType::FindLandingPos(float3 landPos)
 	const int2 os = {owner->xsize, owner->zsize};
 	const int2 mp = owner->GetMapPos(landPos = landPos.cClampInBounds());
 
-	for (int z = mp.y; z < (mp.y + os.y); z++) {
-		for (int x = mp.x; x < (mp.x + os.x); x++) {
-			if (groundBlockingObjectMap.GroundBlocked(x, z, owner))
-				return -OnesVector;
-		}
-	}
+	if (!groundBlockingObjectMap.IsFootprintFree(mp.x, mp.y, mp.x + os.x, mp.y + os.y, owner))
+		return -OnesVector;
 
 	// FIXME: better compare against ud->maxHeightDif?
 	if (CGround::GetSlope(landPos.x, landPos.z) > 0.03f)
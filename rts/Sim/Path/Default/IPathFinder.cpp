@@ -118,6 +118,10 @@ IPath::SearchResult IPathFinder::GetPath(
 	const int2 goalBlock = {int(pfDef.goalSquareX / BLOCK_SIZE), int(pfDef.goalSquareZ / BLOCK_SIZE)};
 	const CPathCache::CacheItem& ci = GetCache(mStartBlock, goalBlock, pfDef.sqGoalRadius, moveDef.pathType, pfDef.synced);
 
+	// only the estimators have an actual cache
+	if (BLOCK_SIZE != 1)
+		pathTelemetry.AddCacheLookup(ci.pathType != -1);
+
 	if (ci.pathType != -1) {
 		path = ci.path;
 		return ci.result;
@@ -126,6 +130,8 @@ IPath::SearchResult IPathFinder::GetPath(
 	// start up a new search
 	const IPath::SearchResult result = InitSearch(moveDef, pfDef, owner);
 
+	pathTelemetry.AddSearch(GetTelemetryLevel(), testedBlocks);
+
 	// if search was successful, generate new path and cache it
 	if (result == IPath::Ok || result == IPath::GoalOutOfRange) {
 		FinishSearch(moveDef, pfDef, path);
@@ -9,6 +9,7 @@
 #include "PathCache.h"
 #include "PathConstants.h"
 #include "PathDataTypes.h"
+#include "Sim/Path/PathTelemetry.h"
 
 struct MoveDef;
 class CPathFinderDef;
@@ -36,6 +37,14 @@ public:
 	int2 BlockIdxToPos(const unsigned idx) const { return int2(idx % nbrOfBlocks.x, idx / nbrOfBlocks.x); }
 	int  BlockPosToIdx(const int2 pos) const { return (pos.y * nbrOfBlocks.x + pos.x); }
 
+	CPathTelemetry::ResolutionLevel GetTelemetryLevel() const {
+		switch (BLOCK_SIZE) {
+			case                   1: return CPathTelemetry::RES_MAXRES;
+			case MEDRES_PE_BLOCKSIZE: return CPathTelemetry::RES_MEDRES;
+			default                 : return CPathTelemetry::RES_LOWRES;
+		}
+	}
+
 
 	/**
 	 * Gives a path from given starting location to target defined in
@@ -38,6 +38,12 @@ static constexpr unsigned int PATH_HEATMAP_XSCALE =  1; // wrt. mapDims.hmapx
 static constexpr unsigned int PATH_HEATMAP_ZSCALE =  1; // wrt. mapDims.hmapy
 static constexpr unsigned int PATH_FLOWMAP_XSCALE = 32; // wrt. mapDims.mapx
 static constexpr unsigned int PATH_FLOWMAP_ZSCALE = 32; // wrt. mapDims.mapy
+static constexpr unsigned int PATH_TRAFFIC_SCALE  = MEDRES_PE_BLOCKSIZE; // wrt. mapDims.map{x,y}
+static constexpr unsigned int PATH_TRAFFIC_UPDATE_RATE = GAME_SPEED / 2;
+
+// queued estimator blocks older than this many frames are repaired
+// before any others, regardless of how many paths cross them
+static constexpr int MAX_BLOCK_REPAIR_DELAY = GAME_SPEED * 10;
 
 
 // PE-only flags (indices)
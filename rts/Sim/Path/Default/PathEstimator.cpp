@@ -2,12 +2,13 @@
 
 #include "System/Platform/Win/win32.h"
 
-#include "minizip/zip.h"
+#include <cstring>
 
 #include "PathEstimator.h"
 #include "PathFinder.h"
 #include "PathFinderDef.h"
 // #include "PathFlowMap.hpp"
+#include "PathHeatMap.hpp"
 #include "PathLog.h"
 #include "PathMemPool.h"
 #include "Game/GlobalUnsynced.h"
@@ -20,15 +21,14 @@
 #include "System/Threading/ThreadPool.h" // for_mt
 #include "System/TimeProfiler.h"
 #include "System/Config/ConfigHandler.h"
-#include "System/FileSystem/Archives/IArchive.h"
-#include "System/FileSystem/ArchiveLoader.h"
 #include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/FileSystem/FileQueryFlags.h"
+#include "System/FileSystem/MappedFile.h"
 #include "System/Platform/Threading.h"
 #include "System/SafeUtil.h"
 #include "System/StringUtil.h"
-#include "System/Sync/SHA512.hpp"
+#include "System/Sync/HsiehHash.h"
 
 #define ENABLE_NETLOG_CHECKSUM 1
 
@@ -44,7 +44,7 @@ static const std::string GetPathCacheDir() {
 }
 
 static const std::string GetCacheFileName(const std::string& fileHashCode, const std::string& peFileName, const std::string& mapFileName) {
-	return (GetPathCacheDir() + mapFileName + "." + peFileName + "-" + fileHashCode + ".zip");
+	return (GetPathCacheDir() + mapFileName + "." + peFileName + "-" + fileHashCode + ".bin");
 }
 
 
@@ -84,7 +84,32 @@ void CPathEstimator::Init(IPathFinder* pf, unsigned int BLOCK_SIZE, const std::s
 
 		updatedBlocks.clear();
 		consumedBlocks.clear();
+		repairBlocks.clear();
 		offsetBlocksSortedByCost.clear();
+
+		blockChangeStamps.clear();
+		blockChangeStamps.resize(blockStates.GetSize(), 0);
+		blockRepairStamps.clear();
+		blockRepairStamps.resize(blockStates.GetSize(), 0);
+		blockQueueFrames.clear();
+		blockQueueFrames.resize(blockStates.GetSize(), 0);
+
+		blockRepairStamp = 0;
+		blockChangeMargin = 0;
+
+		blockRowChecksums.clear();
+		blockRowChecksums.resize(moveDefHandler.GetNumMoveDefs() * nbrOfBlocks.y, 0);
+		layerChecksums.clear();
+		layerChecksums.resize(moveDefHandler.GetNumMoveDefs(), 0);
+		missingLayers.clear();
+
+		// MoveMath tests the footprint around each square, PF searches
+		// can additionally step PATH_NODE_SPACING squares past a block
+		for (unsigned int i = 0; i < moveDefHandler.GetNumMoveDefs(); i++) {
+			const MoveDef* md = moveDefHandler.GetMoveDefByPathType(i);
+			missingLayers.push_back(i);
+			blockChangeMargin = std::max(blockChangeMargin, std::max(md->xsizeh, md->zsizeh) + int(PATH_NODE_SPACING) + 1);
+		}
 	}
 
 	CPathEstimator*  childPE = this;
@@ -161,7 +186,13 @@ void CPathEstimator::InitEstimator(const std::string& peFileName, const std::str
 	// Not much point in multithreading these...
 	InitBlocks();
 
-	if (!ReadFile(peFileName, mapFileName)) {
+	// only layers of MoveDefs not present in the cache-file are calculated
+	const bool haveAllLayers = ReadFile(peFileName, mapFileName);
+	// cached layers are checked (and repaired) here, while loading, so no
+	// client ever reads unverified data or repairs it at some local time
+	const bool repairedLayers = VerifyCachedLayers();
+
+	if (!haveAllLayers) {
 		// start extra threads if applicable, but always keep the total
 		// memory-footprint made by CPathFinder instances within bounds
 		const unsigned int minMemFootPrint = sizeof(CPathFinder) + parentPathFinder->GetMemFootPrint();
@@ -170,11 +201,9 @@ void CPathEstimator::InitEstimator(const std::string& peFileName, const std::str
 		const unsigned int reqMemFootPrint = minMemFootPrint * (numExtraThreads + 1);
 
 		char calcMsg[512];
-		const char* fmtStrs[4] = {
+		const char* fmtStrs[2] = {
 			"[%s] creating PE%u cache with %u PF threads (%u MB)",
 			"[%s] creating PE%u cache with %u PF thread (%u MB)",
-			"[%s] writing PE%u cache-file %s-%x",
-			"[%s] written PE%u cache-file %s-%x",
 		};
 
 		{
@@ -200,16 +229,26 @@ void CPathEstimator::InitEstimator(const std::string& peFileName, const std::str
 		}
 
 
-		sprintf(calcMsg, fmtStrs[2], __func__, BLOCK_SIZE, peFileName.c_str(), fileHashCode);
+		CalcLayerChecksums();
+	}
+
+	if (!haveAllLayers || repairedLayers) {
+		char calcMsg[512];
+		const char* fmtStrs[2] = {
+			"[%s] writing PE%u cache-file %s-%x",
+			"[%s] written PE%u cache-file %s-%x",
+		};
+
+		sprintf(calcMsg, fmtStrs[0], __func__, BLOCK_SIZE, peFileName.c_str(), fileHashCode);
 		loadscreen->SetLoadMessage(calcMsg, true);
 
 		WriteFile(peFileName, mapFileName);
 
-		sprintf(calcMsg, fmtStrs[3], __func__, BLOCK_SIZE, peFileName.c_str(), fileHashCode);
+		sprintf(calcMsg, fmtStrs[1], __func__, BLOCK_SIZE, peFileName.c_str(), fileHashCode);
 		loadscreen->SetLoadMessage(calcMsg, true);
 	}
 
-	// calculate checksum over block-offsets and vertex-costs
+	// combine the checksums of all layers
 	pathChecksum = CalcChecksum();
 
 	// switch to runtime wanted IPathFinder (maybe PF or PE)
@@ -267,8 +306,8 @@ void CPathEstimator::CalculateBlockOffsets(unsigned int blockIdx, unsigned int t
 		clientNet->Send(CBaseNetProtocol::Get().SendCPUUsage(BLOCK_SIZE | (blockIdx << 8)));
 	}
 
-	for (unsigned int i = 0; i < moveDefHandler.GetNumMoveDefs(); i++) {
-		const MoveDef* md = moveDefHandler.GetMoveDefByPathType(i);
+	for (const unsigned int pathType: missingLayers) {
+		const MoveDef* md = moveDefHandler.GetMoveDefByPathType(pathType);
 
 		blockStates.peNodeOffsets[md->pathType][blockIdx] = FindBlockPosOffset(*md, blockPos.x, blockPos.y);
 	}
@@ -289,8 +328,8 @@ void CPathEstimator::EstimatePathCosts(unsigned int blockIdx, unsigned int threa
 		loadscreen->SetLoadMessage(calcMsg, (blockIdx != 0));
 	}
 
-	for (unsigned int i = 0; i < moveDefHandler.GetNumMoveDefs(); i++) {
-		const MoveDef* md = moveDefHandler.GetMoveDefByPathType(i);
+	for (const unsigned int pathType: missingLayers) {
+		const MoveDef* md = moveDefHandler.GetMoveDefByPathType(pathType);
 
 		CalcVertexPathCosts(*md, blockPos, threadNum);
 	}
@@ -441,6 +480,37 @@ void CPathEstimator::CalcVertexPathCost(
 }
 
 
+/**
+ * Recalculates only those vertex costs owned by block whose search-area
+ * (block itself plus child block) changed since they were last computed,
+ * other previously searched costs are reused as-is
+ */
+unsigned int CPathEstimator::RepairVertexPathCosts(const MoveDef& moveDef, int2 block)
+{
+	const unsigned int blockIdx = BlockPosToIdx(block);
+	const std::uint32_t repairStamp = blockRepairStamps[blockIdx];
+
+	unsigned int numRepairs = 0;
+
+	for (unsigned int pathDir: {PATHDIR_LEFT, PATHDIR_LEFT_UP, PATHDIR_UP, PATHDIR_RIGHT_UP}) {
+		const int2 childBlock = block + PE_DIRECTION_VECTORS[pathDir];
+
+		std::uint32_t changeStamp = blockChangeStamps[blockIdx];
+
+		if (static_cast<unsigned int>(childBlock.x) < nbrOfBlocks.x && static_cast<unsigned int>(childBlock.y) < nbrOfBlocks.y)
+			changeStamp = std::max(changeStamp, blockChangeStamps[BlockPosToIdx(childBlock)]);
+
+		if (changeStamp <= repairStamp)
+			continue;
+
+		CalcVertexPathCost(moveDef, block, pathDir);
+		numRepairs += 1;
+	}
+
+	return numRepairs;
+}
+
+
 /**
  * Mark affected blocks as obsolete
  */
@@ -455,27 +525,97 @@ void CPathEstimator::MapChanged(unsigned int x1, unsigned int z1, unsigned int x
 	const int lowerZ = Clamp(int(z1 / BLOCK_SIZE) - 1, 0, int(nbrOfBlocks.y - 1));
 	const int upperZ = Clamp(int(z2 / BLOCK_SIZE) + 1, 0, int(nbrOfBlocks.y - 1));
 
+	// blocks whose own offsets and vertex costs may be affected; the
+	// vertex costs between two blocks outside this set stay valid, so
+	// the surrounding ring only needs its edges into the set repaired
+	const int lowerChangeX = Clamp((int(x1) - blockChangeMargin) / int(BLOCK_SIZE), 0, int(nbrOfBlocks.x - 1));
+	const int upperChangeX = Clamp((int(x2) + blockChangeMargin) / int(BLOCK_SIZE), 0, int(nbrOfBlocks.x - 1));
+	const int lowerChangeZ = Clamp((int(z1) - blockChangeMargin) / int(BLOCK_SIZE), 0, int(nbrOfBlocks.y - 1));
+	const int upperChangeZ = Clamp((int(z2) + blockChangeMargin) / int(BLOCK_SIZE), 0, int(nbrOfBlocks.y - 1));
+
+	for (int z = lowerChangeZ; z <= upperChangeZ; z++) {
+		for (int x = lowerChangeX; x <= upperChangeX; x++) {
+			blockChangeStamps[BlockPosToIdx(int2(x, z))] = blockRepairStamp + 1;
+		}
+	}
+
 	// mark the blocks inside the rectangle, enqueue them
 	// from upper to lower because of the placement of the
 	// bi-directional vertices
 	for (int z = upperZ; z >= lowerZ; z--) {
 		for (int x = upperX; x >= lowerX; x--) {
-			const int idx = BlockPosToIdx(int2(x, z));
+			QueueBlockUpdate(int2(x, z));
+		}
+	}
+}
 
-			if ((blockStates.nodeMask[idx] & PATHOPT_OBSOLETE) != 0)
-				continue;
 
-			updatedBlocks.emplace_back(x, z);
-			blockStates.nodeMask[idx] |= PATHOPT_OBSOLETE;
-		}
+void CPathEstimator::QueueBlockUpdate(int2 blockPos)
+{
+	const int idx = BlockPosToIdx(blockPos);
+
+	if ((blockStates.nodeMask[idx] & PATHOPT_OBSOLETE) != 0)
+		return;
+
+	updatedBlocks.push_back(blockPos);
+	blockStates.nodeMask[idx] |= PATHOPT_OBSOLETE;
+	blockQueueFrames[idx] = gs->frameNum;
+}
+
+
+/**
+ * Move the numBlocks most important queued blocks to the front of
+ * updatedBlocks, leaving the order of the remaining ones unchanged
+ */
+void CPathEstimator::SortUpdatedBlocks(const PathHeatMap* heatMap, unsigned int numBlocks)
+{
+	if (updatedBlocks.size() <= numBlocks)
+		return;
+
+	repairBlocks.clear();
+	repairBlocks.reserve(updatedBlocks.size());
+
+	for (unsigned int n = 0; n < updatedBlocks.size(); n++) {
+		const int2 pos = updatedBlocks[n];
+		const int2 sqr = pos * BLOCK_SIZE;
+		const int idx = BlockPosToIdx(pos);
+
+		repairBlocks.push_back({
+			(gs->frameNum - blockQueueFrames[idx]) > MAX_BLOCK_REPAIR_DELAY,
+			heatMap->GetPathTraffic(sqr.x, sqr.y, sqr.x + BLOCK_SIZE - 1, sqr.y + BLOCK_SIZE - 1),
+			n
+		});
+	}
+
+	// overdue blocks first, then the busiest; queue order breaks ties
+	std::partial_sort(repairBlocks.begin(), repairBlocks.begin() + numBlocks, repairBlocks.end(), [](const SRepairBlock& a, const SRepairBlock& b) {
+		if (a.overdue != b.overdue)
+			return (a.overdue > b.overdue);
+		if (a.traffic != b.traffic)
+			return (a.traffic > b.traffic);
+
+		return (a.queueIdx < b.queueIdx);
+	});
+
+	// keep the unselected blocks in queue order behind the selected ones
+	std::sort(repairBlocks.begin() + numBlocks, repairBlocks.end(), [](const SRepairBlock& a, const SRepairBlock& b) {
+		return (a.queueIdx < b.queueIdx);
+	});
+
+	std::deque<int2> sortedBlocks;
+
+	for (const SRepairBlock& rb: repairBlocks) {
+		sortedBlocks.push_back(updatedBlocks[rb.queueIdx]);
 	}
+
+	updatedBlocks.swap(sortedBlocks);
 }
 
 
 /**
  * Update some obsolete blocks using the FIFO-principle
  */
-void CPathEstimator::Update()
+void CPathEstimator::Update(const PathHeatMap* heatMap)
 {
 	pathCache[0]->Update();
 	pathCache[1]->Update();
@@ -513,6 +653,11 @@ void CPathEstimator::Update()
 	consumedBlocks.clear();
 	consumedBlocks.reserve(consumeBlocks);
 
+	// changes registered from here on are newer than this repair
+	blockRepairStamp += 1;
+
+	SortUpdatedBlocks(heatMap, (blocksToUpdate + numMoveDefs - 1) / numMoveDefs);
+
 	// get blocks to update
 	while (!updatedBlocks.empty()) {
 		const int2& pos = updatedBlocks.front();
@@ -533,13 +678,15 @@ void CPathEstimator::Update()
 			consumedBlocks.emplace_back(pos, md);
 		}
 
-		// inform dependent estimator that costs were updated and it should do the same
+		// inform dependent estimator that the terrain within this block
+		// changed and it should update as well; blocks that were queued
+		// only because they border a change are skipped
 		// FIXME?
 		//   adjacent med-res PE blocks will cause a low-res block to be updated twice
 		//   (in addition to the overlap that already exists because MapChanged() adds
 		//   boundary blocks)
-		if (true && nextPathEstimator != nullptr)
-			nextPathEstimator->MapChanged(pos.x * BLOCK_SIZE, pos.y * BLOCK_SIZE, pos.x * BLOCK_SIZE, pos.y * BLOCK_SIZE);
+		if (nextPathEstimator != nullptr && blockChangeStamps[idx] > blockRepairStamps[idx])
+			nextPathEstimator->MapChanged(pos.x * BLOCK_SIZE, pos.y * BLOCK_SIZE, (pos.x + 1) * BLOCK_SIZE - 1, (pos.y + 1) * BLOCK_SIZE - 1);
 
 		updatedBlocks.pop_front(); // must happen _after_ last usage of the `pos` reference!
 		blockStates.nodeMask[idx] &= ~PATHOPT_OBSOLETE;
@@ -550,20 +697,56 @@ void CPathEstimator::Update()
 		SCOPED_TIMER("Sim::Path::Estimator::FindOffset");
 		for_mt(0, consumedBlocks.size(), [&](const int n) {
 			// copy the next block in line
-			const SingleBlock sb = consumedBlocks[n];
+			SingleBlock& sb = consumedBlocks[n];
 			const int blockN = BlockPosToIdx(sb.blockPos);
 			const MoveDef* currBlockMD = sb.moveDef;
-			blockStates.peNodeOffsets[currBlockMD->pathType][blockN] = FindBlockPosOffset(*currBlockMD, sb.blockPos.x, sb.blockPos.y);
+			const int2 blockOffset = FindBlockPosOffset(*currBlockMD, sb.blockPos.x, sb.blockPos.y);
+
+			sb.offsetChanged = (int2(blockStates.peNodeOffsets[currBlockMD->pathType][blockN]) != blockOffset);
+			blockStates.peNodeOffsets[currBlockMD->pathType][blockN] = blockOffset;
 		});
 	}
 
+	// a moved offset invalidates all vertices ending at this block,
+	// including those stored at (and repaired with) its neighbors
+	for (const SingleBlock& sb: consumedBlocks) {
+		if (sb.offsetChanged)
+			blockChangeStamps[BlockPosToIdx(sb.blockPos)] = blockRepairStamp;
+	}
+
+	unsigned int numRepairedVertices = 0;
+
 	// CalcVertexPathCosts (not threadsafe)
 	{
 		SCOPED_TIMER("Sim::Path::Estimator::CalcVertexPathCosts");
 		for (unsigned int n = 0; n < consumedBlocks.size(); ++n) {
-			CalcVertexPathCosts(*consumedBlocks[n].moveDef, consumedBlocks[n].blockPos);
+			numRepairedVertices += RepairVertexPathCosts(*consumedBlocks[n].moveDef, consumedBlocks[n].blockPos);
+		}
+	}
+
+	for (const SingleBlock& sb: consumedBlocks) {
+		blockRepairStamps[BlockPosToIdx(sb.blockPos)] = blockRepairStamp;
+	}
+
+	for (const SingleBlock& sb: consumedBlocks) {
+		if (!sb.offsetChanged)
+			continue;
+
+		// neighbors owning a vertex into this block that were not part of
+		// this repair (e.g. were consumed earlier) must be queued again
+		for (unsigned int pathDir: {PATHDIR_LEFT, PATHDIR_LEFT_UP, PATHDIR_UP, PATHDIR_RIGHT_UP}) {
+			const int2 nbPos = sb.blockPos - PE_DIRECTION_VECTORS[pathDir];
+
+			if (static_cast<unsigned int>(nbPos.x) >= nbrOfBlocks.x || static_cast<unsigned int>(nbPos.y) >= nbrOfBlocks.y)
+				continue;
+			if (blockRepairStamps[BlockPosToIdx(nbPos)] == blockRepairStamp)
+				continue;
+
+			QueueBlockUpdate(nbPos);
 		}
 	}
+
+	vertexCostsVersion += (numRepairedVertices != 0);
 }
 
 
@@ -935,9 +1118,40 @@ bool CPathEstimator::RemoveCacheFile(const std::string& peFileName, const std::s
 	return (FileSystem::Remove(GetCacheFileName(IntToString(fileHashCode, "%x"), peFileName, mapFileName)));
 }
 
-/**
- * Try to read offset and vertices data from file, return false on failure
+/*
+ * cache-file layout (native byte-order, only ever read back by the same build):
+ *   header {magic, version, hashCode, blockSize, numBlocks{X,Z}, numLayers}
+ *   layer-table {moveDefHash, layerChecksum, dataOffset}[numLayers]
+ *   per layer (page-aligned):
+ *     rowChecksums[numBlocksZ], nodeOffsets[numBlocks], vertexCosts[numBlocks * PATH_DIRECTION_VERTICES]
+ *
+ * layers are keyed by MoveDef checksum so changing one MoveDef does not
+ * invalidate the data of all others; layerChecksum is the hash over the
+ * row-checksums, against which every row is verified while loading
  */
+static constexpr std::uint32_t CACHE_FILE_MAGIC = 0x31434550; // "PEC1"
+static constexpr std::uint32_t CACHE_PAGE_SIZE = 4096;
+
+struct CacheFileHeader {
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint32_t hashCode;
+	std::uint32_t blockSize;
+	std::uint32_t numBlocksX;
+	std::uint32_t numBlocksZ;
+	std::uint32_t numLayers;
+	std::uint32_t padding;
+};
+
+struct CacheLayerEntry {
+	std::uint32_t moveDefHash;
+	std::uint32_t layerChecksum;
+	std::uint64_t dataOffset;
+};
+
+static size_t AlignToPage(size_t n) { return ((n + CACHE_PAGE_SIZE - 1) & ~size_t(CACHE_PAGE_SIZE - 1)); }
+
+
 bool CPathEstimator::ReadFile(const std::string& peFileName, const std::string& mapFileName)
 {
 	const std::string hashHexString = IntToString(fileHashCode, "%x");
@@ -948,9 +1162,9 @@ bool CPathEstimator::ReadFile(const std::string& peFileName, const std::string&
 	if (!FileSystem::FileExists(cacheFileName))
 		return false;
 
-	std::unique_ptr<IArchive> upfile(archiveLoader.OpenArchive(dataDirsAccess.LocateFile(cacheFileName), "sdz"));
+	CMappedFile cacheFile;
 
-	if (upfile == nullptr || !upfile->IsOpen()) {
+	if (!cacheFile.Open(dataDirsAccess.LocateFile(cacheFileName))) {
 		FileSystem::Remove(cacheFileName);
 		return false;
 	}
@@ -959,47 +1173,75 @@ bool CPathEstimator::ReadFile(const std::string& peFileName, const std::string&
 	sprintf(calcMsg, "Reading Estimate PathCosts [%d]", BLOCK_SIZE);
 	loadscreen->SetLoadMessage(calcMsg);
 
-	const unsigned fid = upfile->FindFile("pathinfo");
-	if (fid >= upfile->NumFiles()) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
+	const std::uint8_t* fileData = cacheFile.GetData();
+	const size_t fileSize = cacheFile.GetSize();
 
-	std::vector<std::uint8_t> buffer;
+	CacheFileHeader header;
 
-	if (!upfile->GetFile(fid, buffer) || buffer.size() < 4) {
+	if (fileSize < sizeof(header)) {
 		FileSystem::Remove(cacheFileName);
 		return false;
 	}
 
-	const unsigned int filehash = *(reinterpret_cast<unsigned int*>(&buffer[0]));
-	const unsigned int blockSize = blockStates.GetSize() * sizeof(short2);
-	unsigned int pos = sizeof(unsigned);
+	std::memcpy(&header, fileData, sizeof(header));
 
-	if (filehash != fileHashCode) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
+	const bool validHeader =
+		(header.magic == CACHE_FILE_MAGIC) &&
+		(header.version == PATHESTIMATOR_VERSION) &&
+		(header.hashCode == fileHashCode) &&
+		(header.blockSize == BLOCK_SIZE) &&
+		(header.numBlocksX == nbrOfBlocks.x) &&
+		(header.numBlocksZ == nbrOfBlocks.y) &&
+		(fileSize >= (sizeof(header) + header.numLayers * sizeof(CacheLayerEntry)));
 
-	if (buffer.size() < (pos + blockSize * moveDefHandler.GetNumMoveDefs())) {
+	if (!validHeader) {
 		FileSystem::Remove(cacheFileName);
 		return false;
 	}
 
-	// read center-offset data
-	for (int pathType = 0; pathType < moveDefHandler.GetNumMoveDefs(); ++pathType) {
-		std::memcpy(&blockStates.peNodeOffsets[pathType][0], &buffer[pos], blockSize);
-		pos += blockSize;
+	const size_t numBlocks = blockStates.GetSize();
+	const size_t rowBytes = nbrOfBlocks.y * sizeof(std::uint32_t);
+	const size_t offsetBytes = numBlocks * sizeof(short2);
+	const size_t costBytes = numBlocks * PATH_DIRECTION_VERTICES * sizeof(float);
+
+	for (unsigned int n = 0; n < header.numLayers; n++) {
+		CacheLayerEntry entry;
+		std::memcpy(&entry, fileData + sizeof(header) + n * sizeof(entry), sizeof(entry));
+
+		if (entry.dataOffset > fileSize || (fileSize - entry.dataOffset) < (rowBytes + offsetBytes + costBytes))
+			continue;
+
+		const std::uint8_t* layerData = fileData + entry.dataOffset;
+
+		// the row-checksums are trusted only if they hash to the layer's
+		// checksum, the rows themselves are checked by VerifyCachedLayers
+		if (HsiehHash(layerData, rowBytes, 0) != entry.layerChecksum)
+			continue;
+
+		// several MoveDefs may share the same layer
+		for (unsigned int pathType = 0; pathType < moveDefHandler.GetNumMoveDefs(); pathType++) {
+			if (layerChecksums[pathType] != 0)
+				continue;
+			if (moveDefHandler.GetMoveDefByPathType(pathType)->CalcCheckSum() != entry.moveDefHash)
+				continue;
+
+			std::memcpy(&blockRowChecksums[pathType * nbrOfBlocks.y], layerData, rowBytes);
+			std::memcpy(&blockStates.peNodeOffsets[pathType][0], layerData + rowBytes, offsetBytes);
+			std::memcpy(&vertexCosts[pathType * numBlocks * PATH_DIRECTION_VERTICES], layerData + rowBytes + offsetBytes, costBytes);
+
+			layerChecksums[pathType] = entry.layerChecksum;
+		}
 	}
 
-	// read vertex-cost data
-	if (buffer.size() < (pos + vertexCosts.size() * sizeof(float))) {
-		FileSystem::Remove(cacheFileName);
-		return false;
+	missingLayers.clear();
+
+	for (unsigned int pathType = 0; pathType < moveDefHandler.GetNumMoveDefs(); pathType++) {
+		if (layerChecksums[pathType] == 0)
+			missingLayers.push_back(pathType);
 	}
 
-	std::memcpy(&vertexCosts[0], &buffer[pos], vertexCosts.size() * sizeof(float));
-	return true;
+	LOG("[PathEstimator::%s] read %u of %u layers", __func__, unsigned(moveDefHandler.GetNumMoveDefs() - missingLayers.size()), moveDefHandler.GetNumMoveDefs());
+	return (missingLayers.empty());
 }
 
 
@@ -1017,99 +1259,176 @@ bool CPathEstimator::WriteFile(const std::string& peFileName, const std::string&
 
 	LOG("[PathEstimator::%s] hash=%s file=\"%s\" (exists=%d)", __func__, hashHexString.c_str(), cacheFileName.c_str(), FileSystem::FileExists(cacheFileName));
 
-	// open file for writing in a suitable location
-	zipFile file = zipOpen(dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE).c_str(), APPEND_STATUS_CREATE);
-
-	if (file == nullptr)
-		return false;
-
-	zipOpenNewFileInZip(file, "pathinfo", nullptr, nullptr, 0, nullptr, 0, nullptr, Z_DEFLATED, Z_BEST_COMPRESSION);
+	const size_t numLayers = moveDefHandler.GetNumMoveDefs();
+	const size_t numBlocks = blockStates.GetSize();
+	const size_t rowBytes = nbrOfBlocks.y * sizeof(std::uint32_t);
+	const size_t offsetBytes = numBlocks * sizeof(short2);
+	const size_t costBytes = numBlocks * PATH_DIRECTION_VERTICES * sizeof(float);
+	const size_t layerBytes = AlignToPage(rowBytes + offsetBytes + costBytes);
+	const size_t tableBytes = AlignToPage(sizeof(CacheFileHeader) + numLayers * sizeof(CacheLayerEntry));
+
+	std::vector<std::uint8_t> buffer(tableBytes + numLayers * layerBytes, 0);
+
+	const CacheFileHeader header = {
+		CACHE_FILE_MAGIC,
+		PATHESTIMATOR_VERSION,
+		fileHashCode,
+		BLOCK_SIZE,
+		std::uint32_t(nbrOfBlocks.x),
+		std::uint32_t(nbrOfBlocks.y),
+		std::uint32_t(numLayers),
+		0
+	};
+
+	std::memcpy(&buffer[0], &header, sizeof(header));
+
+	for (unsigned int pathType = 0; pathType < numLayers; pathType++) {
+		const CacheLayerEntry entry = {
+			moveDefHandler.GetMoveDefByPathType(pathType)->CalcCheckSum(),
+			layerChecksums[pathType],
+			tableBytes + pathType * layerBytes
+		};
 
-	// write hash-code (NOTE: this also affects the CRC!)
-	zipWriteInFileInZip(file, (const void*) &fileHashCode, 4);
+		std::uint8_t* layerData = &buffer[entry.dataOffset];
 
-	// write center-offsets
-	for (int pathType = 0; pathType < moveDefHandler.GetNumMoveDefs(); ++pathType) {
-		zipWriteInFileInZip(file, (const void*) &blockStates.peNodeOffsets[pathType][0], blockStates.peNodeOffsets[pathType].size() * sizeof(short2));
+		std::memcpy(&buffer[sizeof(header) + pathType * sizeof(entry)], &entry, sizeof(entry));
+		std::memcpy(layerData, &blockRowChecksums[pathType * nbrOfBlocks.y], rowBytes);
+		std::memcpy(layerData + rowBytes, &blockStates.peNodeOffsets[pathType][0], offsetBytes);
+		std::memcpy(layerData + rowBytes + offsetBytes, &vertexCosts[pathType * numBlocks * PATH_DIRECTION_VERTICES], costBytes);
 	}
 
-	// write vertex-costs
-	zipWriteInFileInZip(file, vertexCosts.data(), vertexCosts.size() * sizeof(float));
+	const std::string filePath = dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE);
 
-	zipCloseFileInZip(file);
-	zipClose(file, nullptr);
+	FILE* out = fopen(filePath.c_str(), "wb");
 
+	if (out == nullptr)
+		return false;
 
-	// get the CRC over the written path data
-	std::unique_ptr<IArchive> upfile(archiveLoader.OpenArchive(dataDirsAccess.LocateFile(cacheFileName), "sdz"));
+	const size_t numBytes = fwrite(buffer.data(), 1, buffer.size(), out);
 
-	if (upfile == nullptr || !upfile->IsOpen()) {
+	if ((fclose(out) == EOF) || (numBytes != buffer.size())) {
 		FileSystem::Remove(cacheFileName);
 		return false;
 	}
 
-	assert(upfile->FindFile("pathinfo") < upfile->NumFiles());
-  return true;
+	return true;
 }
 
 
-std::uint32_t CPathEstimator::CalcChecksum() const
+std::uint32_t CPathEstimator::CalcBlockRowChecksum(unsigned int pathType, unsigned int blockRow) const
 {
-	std::uint32_t chksum = 0;
-	std::uint64_t nbytes = vertexCosts.size() * sizeof(float);
-	std::uint64_t offset = 0;
+	const size_t numBlocks = blockStates.GetSize();
+	const size_t rowBlockIdx = blockRow * nbrOfBlocks.x;
 
-	#if (ENABLE_NETLOG_CHECKSUM == 1)
-	std::array<char, 128 + sha512::SHA_LEN * 2 + 1> msgBuffer;
+	const short2* rowOffsets = &blockStates.peNodeOffsets[pathType][rowBlockIdx];
+	const float* rowCosts = &vertexCosts[(pathType * numBlocks + rowBlockIdx) * PATH_DIRECTION_VERTICES];
 
-	sha512::hex_digest hexChars;
-	sha512::raw_digest shaBytes;
-	sha512::msg_vector rawBytes;
-	#endif
+	std::uint32_t hash = 0;
+	hash = HsiehHash(rowOffsets, nbrOfBlocks.x * sizeof(short2), hash);
+	hash = HsiehHash(rowCosts, nbrOfBlocks.x * PATH_DIRECTION_VERTICES * sizeof(float), hash);
+	return hash;
+}
 
-	#if (ENABLE_NETLOG_CHECKSUM == 1)
-	for (const auto& pathTypeOffsets: blockStates.peNodeOffsets) {
-		nbytes += (pathTypeOffsets.size() * sizeof(short2));
+void CPathEstimator::CalcLayerChecksums()
+{
+	// freshly calculated layers are valid by definition
+	for (const unsigned int pathType: missingLayers) {
+		for_mt(0, nbrOfBlocks.y, [&](const int blockRow) {
+			blockRowChecksums[pathType * nbrOfBlocks.y + blockRow] = CalcBlockRowChecksum(pathType, blockRow);
+		});
+
+		layerChecksums[pathType] = HsiehHash(&blockRowChecksums[pathType * nbrOfBlocks.y], nbrOfBlocks.y * sizeof(std::uint32_t), 0);
 	}
 
-	rawBytes.clear();
-	rawBytes.resize(nbytes);
+	missingLayers.clear();
+}
+
 
-	for (const auto& pathTypeOffsets: blockStates.peNodeOffsets) {
-		nbytes = pathTypeOffsets.size() * sizeof(short2);
-		offset += nbytes;
+/**
+ * Compares every row of the layers read from the cache-file against its
+ * checksum; corrupted rows are recalculated exactly like InitEstimator
+ * would so the result matches what every other client has, after which
+ * the layer checksums are rederived from the data actually in memory
+ * (returns true if any row had to be repaired)
+ */
+bool CPathEstimator::VerifyCachedLayers()
+{
+	const unsigned int numLayers = moveDefHandler.GetNumMoveDefs();
 
-		std::memcpy(&rawBytes[offset - nbytes], pathTypeOffsets.data(), nbytes);
+	std::vector<std::uint8_t> cachedLayers(numLayers, 1);
+	std::vector<std::uint32_t> rowChecksums(numLayers * nbrOfBlocks.y, 0);
+	std::vector<int2> corruptRows;
+
+	for (const unsigned int pathType: missingLayers) {
+		cachedLayers[pathType] = 0;
 	}
 
-	{
-		nbytes = vertexCosts.size() * sizeof(float);
-		offset += nbytes;
+	for_mt(0, numLayers * nbrOfBlocks.y, [&](const int i) {
+		if (cachedLayers[i / nbrOfBlocks.y] == 0)
+			return;
 
-		std::memcpy(&rawBytes[offset - nbytes], vertexCosts.data(), nbytes);
+		rowChecksums[i] = CalcBlockRowChecksum(i / nbrOfBlocks.y, i % nbrOfBlocks.y);
+	});
 
-		sha512::calc_digest(rawBytes, shaBytes); // hash(offsets|costs)
-		sha512::dump_digest(shaBytes, hexChars); // hexify(hash)
+	for (unsigned int pathType = 0; pathType < numLayers; pathType++) {
+		if (cachedLayers[pathType] == 0)
+			continue;
+
+		for (int blockRow = 0; blockRow < nbrOfBlocks.y; blockRow++) {
+			if (rowChecksums[pathType * nbrOfBlocks.y + blockRow] == blockRowChecksums[pathType * nbrOfBlocks.y + blockRow])
+				continue;
 
-		SNPRINTF(msgBuffer.data(), msgBuffer.size(), "[PE::%s][BLK_SIZE=%d][SHA_DATA=%s]", __func__, BLOCK_SIZE, hexChars.data());
-		CLIENT_NETLOG(gu->myPlayerNum, LOG_LEVEL_INFO, msgBuffer.data());
+			LOG_L(L_WARNING, "[PathEstimator::%s] PE%u cache-row %u of layer %u is corrupt, recalculating", __func__, BLOCK_SIZE, blockRow, pathType);
+			corruptRows.emplace_back(pathType, blockRow);
+		}
 	}
-	#endif
 
-	// make path-estimator checksum part of synced state s.t. when
-	// a client has a corrupted or stale cache it desyncs from the
-	// start, not minutes later
-	for (size_t i = 0, n = shaBytes.size() / 4; i < n; i += 1) {
-		const uint16_t hi = (shaBytes[i * 4 + 0] << 8) | (shaBytes[i * 4 + 1] << 0);
-		const uint16_t lo = (shaBytes[i * 4 + 2] << 8) | (shaBytes[i * 4 + 3] << 0);
+	// vertices of a row end in the next one, so all offsets go first
+	for (const int2 row: corruptRows) {
+		const MoveDef* md = moveDefHandler.GetMoveDefByPathType(row.x);
 
-		const SyncedUint su = (hi << 16) | (lo << 0);
+		for (int x = 0; x < nbrOfBlocks.x; x++) {
+			blockStates.peNodeOffsets[row.x][row.y * nbrOfBlocks.x + x] = FindBlockPosOffset(*md, x, row.y);
+		}
+	}
 
-		// copy first four bytes to reduced checksum
-		if (chksum == 0)
-			chksum = su;
+	// pathFinders[0] is still the max-res PF used by InitEstimator
+	for (const int2 row: corruptRows) {
+		const MoveDef* md = moveDefHandler.GetMoveDefByPathType(row.x);
+
+		for (int x = 0; x < nbrOfBlocks.x; x++) {
+			CalcVertexPathCosts(*md, int2(x, row.y), 0);
+		}
+
+		rowChecksums[row.x * nbrOfBlocks.y + row.y] = CalcBlockRowChecksum(row.x, row.y);
 	}
 
+	for (unsigned int pathType = 0; pathType < numLayers; pathType++) {
+		if (cachedLayers[pathType] == 0)
+			continue;
+
+		std::copy(rowChecksums.begin() + pathType * nbrOfBlocks.y, rowChecksums.begin() + (pathType + 1) * nbrOfBlocks.y, blockRowChecksums.begin() + pathType * nbrOfBlocks.y);
+
+		layerChecksums[pathType] = HsiehHash(&blockRowChecksums[pathType * nbrOfBlocks.y], nbrOfBlocks.y * sizeof(std::uint32_t), 0);
+	}
+
+	return (!corruptRows.empty());
+}
+
+
+std::uint32_t CPathEstimator::CalcChecksum() const
+{
+	// layer checksums are hashes over the row checksums, which were all
+	// (re)computed from the loaded or calculated data by InitEstimator
+	const std::uint32_t chksum = HsiehHash(layerChecksums.data(), layerChecksums.size() * sizeof(std::uint32_t), 0);
+
+	#if (ENABLE_NETLOG_CHECKSUM == 1)
+	std::array<char, 128> msgBuffer;
+
+	SNPRINTF(msgBuffer.data(), msgBuffer.size(), "[PE::%s][BLK_SIZE=%d][LAYER_DATA=%08x]", __func__, BLOCK_SIZE, chksum);
+	CLIENT_NETLOG(gu->myPlayerNum, LOG_LEVEL_INFO, msgBuffer.data());
+	#endif
+
 	return chksum;
 }
 
@@ -1121,15 +1440,13 @@ std::uint32_t CPathEstimator::CalcHash(const char* caller) const
 {
 	const unsigned int hmChecksum = readMap->CalcHeightmapChecksum();
 	const unsigned int tmChecksum = readMap->CalcTypemapChecksum();
-	const unsigned int mdChecksum = moveDefHandler.GetCheckSum();
 	const unsigned int bmChecksum = groundBlockingObjectMap.CalcChecksum();
-	const unsigned int peHashCode = (hmChecksum + tmChecksum + mdChecksum + bmChecksum + BLOCK_SIZE + PATHESTIMATOR_VERSION);
+	const unsigned int peHashCode = (hmChecksum + tmChecksum + bmChecksum + BLOCK_SIZE + PATHESTIMATOR_VERSION);
 
 	LOG("[PathEstimator::%s][%s] BLOCK_SIZE=%u", __func__, caller, BLOCK_SIZE);
 	LOG("[PathEstimator::%s][%s] PATHESTIMATOR_VERSION=%u", __func__, caller, PATHESTIMATOR_VERSION);
 	LOG("[PathEstimator::%s][%s] heightMapChecksum=%x", __func__, caller, hmChecksum);
 	LOG("[PathEstimator::%s][%s] typeMapChecksum=%x", __func__, caller, tmChecksum);
-	LOG("[PathEstimator::%s][%s] moveDefChecksum=%x", __func__, caller, mdChecksum);
 	LOG("[PathEstimator::%s][%s] blockMapChecksum=%x", __func__, caller, bmChecksum);
 	LOG("[PathEstimator::%s][%s] estimatorHashCode=%x", __func__, caller, peHashCode);
 
@@ -23,6 +23,7 @@ class CPathEstimatorDef;
 class CPathFinderDef;
 class CPathCache;
 class CSolidObject;
+class PathHeatMap;
 
 class CPathEstimator: public IPathFinder {
 public:
@@ -56,8 +57,10 @@ public:
 
 	/**
 	 * called every frame
+	 * queued blocks crossed by more paths (as counted by heatMap) are
+	 * repaired first, unless others have waited MAX_BLOCK_REPAIR_DELAY
 	 */
-	void Update();
+	void Update(const PathHeatMap* heatMap);
 
 	IPathFinder* GetParent() override { return parentPathFinder; }
 
@@ -66,6 +69,11 @@ public:
 	 * path data.
 	 */
 	std::uint32_t GetPathChecksum() const { return pathChecksum; }
+	/**
+	 * Returns a counter that is incremented whenever Update recalculates
+	 * the vertex costs of any block.
+	 */
+	std::uint32_t GetVertexCostsVersion() const { return vertexCostsVersion; }
 
 
 	const std::vector<float>& GetVertexCosts() const { return vertexCosts; }
@@ -117,10 +125,18 @@ private:
 	int2 FindBlockPosOffset(const MoveDef&, unsigned int, unsigned int) const;
 	void CalcVertexPathCosts(const MoveDef&, int2, unsigned int threadNum = 0);
 	void CalcVertexPathCost(const MoveDef&, int2, unsigned int pathDir, unsigned int threadNum = 0);
+	unsigned int RepairVertexPathCosts(const MoveDef&, int2);
+
+	void QueueBlockUpdate(int2 blockPos);
+	void SortUpdatedBlocks(const PathHeatMap* heatMap, unsigned int numBlocks);
 
 	bool ReadFile(const std::string& peFileName, const std::string& mapFileName);
 	bool WriteFile(const std::string& peFileName, const std::string& mapFileName);
 
+	std::uint32_t CalcBlockRowChecksum(unsigned int pathType, unsigned int blockRow) const;
+	void CalcLayerChecksums();
+	bool VerifyCachedLayers();
+
 	std::uint32_t CalcChecksum() const;
 	std::uint32_t CalcHash(const char* caller) const;
 
@@ -137,6 +153,11 @@ private:
 
 	std::uint32_t pathChecksum = 0;
 	std::uint32_t fileHashCode = 0;
+	std::uint32_t vertexCostsVersion = 0;
+	std::uint32_t blockRepairStamp = 0;
+
+	// squares around a changed area that can influence offsets and vertex costs
+	int blockChangeMargin = 0;
 
 	std::atomic<std::int64_t> offsetBlockNum = {0};
 	std::atomic<std::int64_t> costBlockNum = {0};
@@ -153,6 +174,21 @@ private:
 	/// blocks that may need an update due to map changes
 	std::deque<int2> updatedBlocks;
 
+	/// per block, blockRepairStamp when its squares or offset last changed
+	std::vector<std::uint32_t> blockChangeStamps;
+	/// per block, blockRepairStamp when its vertex costs were last repaired
+	/// (a vertex cost is still valid if neither end changed since then)
+	std::vector<std::uint32_t> blockRepairStamps;
+	/// per block, frame at which it was (last) queued into updatedBlocks
+	std::vector<std::int32_t> blockQueueFrames;
+
+	/// per pathType and block-row, checksum over its offsets and vertex costs
+	std::vector<std::uint32_t> blockRowChecksums;
+	/// per pathType, checksum over its blockRowChecksums
+	std::vector<std::uint32_t> layerChecksums;
+	/// pathTypes that were not found in the cache-file
+	std::vector<unsigned int> missingLayers;
+
 	struct SOffsetBlock {
 		float cost;
 		int2 offset;
@@ -161,10 +197,17 @@ private:
 	struct SingleBlock {
 		int2 blockPos;
 		const MoveDef* moveDef;
+		bool offsetChanged = false;
 		SingleBlock(const int2& pos, const MoveDef* md) : blockPos(pos), moveDef(md) {}
 	};
+	struct SRepairBlock {
+		bool overdue;
+		unsigned int traffic;
+		unsigned int queueIdx;
+	};
 
 	std::vector<SingleBlock> consumedBlocks;
+	std::vector<SRepairBlock> repairBlocks;
 	std::vector<SOffsetBlock> offsetBlocksSortedByCost;
 };
 
@@ -0,0 +1,258 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#include "PathFlowField.h"
+#include "PathConstants.h"
+#include "PathEstimator.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "Sim/Misc/GlobalSynced.h"
+#include "Sim/MoveTypes/MoveDefHandler.h"
+#include "Sim/MoveTypes/MoveMath/MoveMath.h"
+#include "System/Log/ILog.h"
+#include "System/SpringMath.h"
+
+// number of requests to the same goal-block (per path-type) within
+// MAX_REQUEST_WINDOW_SECS after which a field is created for it
+#define MIN_GROUP_REQUESTS        8
+#define MAX_REQUEST_WINDOW_SECS   2
+#define MAX_FIELD_LIFETIME_SECS  10
+#define MAX_FIELD_MEMORY_BYTES   (16 * 1024 * 1024)
+
+static constexpr std::uint8_t PATHDIR_NONE = PATH_DIRECTIONS;
+
+
+void CPathFlowField::Build(const CPathEstimator* pe, const MoveDef& moveDef, int2 gb, bool synced)
+{
+	const std::vector<float>& vertexCosts = pe->GetVertexCosts();
+	const std::vector<short2>& nodeOffsets = pe->blockStates.peNodeOffsets[moveDef.pathType];
+
+	numBlocks = pe->GetNumBlocks();
+	goalBlock = gb;
+
+	blockCosts.clear();
+	blockCosts.resize(numBlocks.x * numBlocks.y, PATHCOST_INFINITY);
+	blockDirs.clear();
+	blockDirs.resize(numBlocks.x * numBlocks.y, PATHDIR_NONE);
+
+	typedef std::pair<float, unsigned int> OpenBlock;
+
+	// ties are broken by block index, which keeps the field sync-safe
+	std::vector<OpenBlock> openBlocks;
+	openBlocks.reserve(numBlocks.x * numBlocks.y);
+	openBlocks.emplace_back(0.0f, pe->BlockPosToIdx(goalBlock));
+
+	blockCosts[openBlocks.back().second] = 0.0f;
+
+	const unsigned int vertexBaseIdx = moveDef.pathType * numBlocks.x * numBlocks.y * PATH_DIRECTION_VERTICES;
+
+	while (!openBlocks.empty()) {
+		std::pop_heap(openBlocks.begin(), openBlocks.end(), std::greater<OpenBlock>());
+
+		const OpenBlock ob = openBlocks.back();
+		const int2 obPos = pe->BlockIdxToPos(ob.second);
+
+		openBlocks.pop_back();
+
+		// already settled with a lower cost
+		if (ob.first > blockCosts[ob.second])
+			continue;
+
+		// units stepping into this block pay its extra cost, as in TestBlock
+		const short2 obSquare = nodeOffsets[ob.second];
+		const float extraCost = pe->blockStates.GetNodeExtraCost(obSquare.x, obSquare.y, synced);
+
+		for (unsigned int pathDir = 0; pathDir < PATH_DIRECTIONS; pathDir++) {
+			const int2 nbPos = obPos + PE_DIRECTION_VECTORS[pathDir];
+
+			if (static_cast<unsigned int>(nbPos.x) >= numBlocks.x)
+				continue;
+			if (static_cast<unsigned int>(nbPos.y) >= numBlocks.y)
+				continue;
+
+			// vertex costs are bi-directional, so the (ob --> nb) entry
+			// also holds the cost of the forward step from nb to ob
+			const unsigned int nbIdx = pe->BlockPosToIdx(nbPos);
+			const unsigned int vcIdx = vertexBaseIdx + ob.second * PATH_DIRECTION_VERTICES + GetBlockVertexOffset(pathDir, numBlocks.x);
+			const float vertexCost = vertexCosts[vcIdx];
+
+			if (vertexCost >= PATHCOST_INFINITY)
+				continue;
+
+			const float nbCost = ob.first + vertexCost + extraCost;
+
+			if (nbCost >= blockCosts[nbIdx])
+				continue;
+
+			blockCosts[nbIdx] = nbCost;
+			// direction from nb back towards ob
+			blockDirs[nbIdx] = (pathDir + (PATH_DIRECTIONS >> 1)) % PATH_DIRECTIONS;
+
+			openBlocks.emplace_back(nbCost, nbIdx);
+			std::push_heap(openBlocks.begin(), openBlocks.end(), std::greater<OpenBlock>());
+		}
+	}
+}
+
+IPath::SearchResult CPathFlowField::GetPath(const CPathEstimator* pe, const MoveDef& moveDef, const float3& startPos, IPath::Path& path) const
+{
+	const std::vector<short2>& nodeOffsets = pe->blockStates.peNodeOffsets[moveDef.pathType];
+
+	const int2 strtBlock = {
+		Clamp(int(startPos.x / pe->BLOCK_PIXEL_SIZE), 0, numBlocks.x - 1),
+		Clamp(int(startPos.z / pe->BLOCK_PIXEL_SIZE), 0, numBlocks.y - 1),
+	};
+
+	const unsigned int strtBlockIdx = pe->BlockPosToIdx(strtBlock);
+	const unsigned int goalBlockIdx = pe->BlockPosToIdx(goalBlock);
+
+	if (blockCosts[strtBlockIdx] >= PATHCOST_INFINITY)
+		return IPath::Error;
+
+	unsigned int numNodes = 1;
+
+	for (unsigned int blockIdx = strtBlockIdx; blockIdx != goalBlockIdx; numNodes++) {
+		blockIdx = pe->BlockPosToIdx(pe->BlockIdxToPos(blockIdx) + PE_DIRECTION_VECTORS[blockDirs[blockIdx]]);
+	}
+
+	// waypoints are stored in reverse, the goal comes first
+	path.path.clear();
+	path.path.resize(numNodes);
+
+	for (unsigned int blockIdx = strtBlockIdx, n = numNodes; n > 0; n--) {
+		const short2 square = nodeOffsets[blockIdx];
+
+		path.path[n - 1] = {square.x * SQUARE_SIZE * 1.0f, CMoveMath::yLevel(moveDef, square.x, square.y), square.y * SQUARE_SIZE * 1.0f};
+
+		if (blockIdx != goalBlockIdx)
+			blockIdx = pe->BlockPosToIdx(pe->BlockIdxToPos(blockIdx) + PE_DIRECTION_VECTORS[blockDirs[blockIdx]]);
+	}
+
+	path.pathGoal = path.path[0];
+	path.pathCost = blockCosts[strtBlockIdx];
+	return IPath::Ok;
+}
+
+
+
+void CPathFlowFieldCache::Kill()
+{
+	if (numFieldBuilds > 0)
+		LOG("[%s] fieldBuilds=%u fieldReads=%u", __func__, numFieldBuilds, numFieldReads);
+
+	flowFields.clear();
+	goalRequests.clear();
+
+	pathEstimator = nullptr;
+	memFootPrint = 0;
+	numFieldBuilds = 0;
+	numFieldReads = 0;
+}
+
+void CPathFlowFieldCache::Update()
+{
+	for (auto it = goalRequests.begin(); it != goalRequests.end(); ) {
+		if ((gs->frameNum - it->second.firstFrame) > (GAME_SPEED * MAX_REQUEST_WINDOW_SECS)) {
+			it = goalRequests.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for (auto it = flowFields.begin(); it != flowFields.end(); ) {
+		const CPathFlowField& field = it->second;
+
+		// stale fields are discarded, not rebuilt; groups that keep
+		// requesting paths to the same goal will trigger a new build
+		if ((gs->frameNum - field.lastUseFrame) > (GAME_SPEED * MAX_FIELD_LIFETIME_SECS) || field.costsVersion != pathEstimator->GetVertexCostsVersion()) {
+			memFootPrint -= field.GetMemFootPrint();
+			it = flowFields.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void CPathFlowFieldCache::Invalidate()
+{
+	flowFields.clear();
+	memFootPrint = 0;
+}
+
+
+const CPathFlowField* CPathFlowFieldCache::GetFlowField(const MoveDef& moveDef, const float3& goalPos, bool synced)
+{
+	const int2 numBlocks = pathEstimator->GetNumBlocks();
+	const int2 goalBlock = {
+		Clamp(int(goalPos.x / pathEstimator->BLOCK_PIXEL_SIZE), 0, numBlocks.x - 1),
+		Clamp(int(goalPos.z / pathEstimator->BLOCK_PIXEL_SIZE), 0, numBlocks.y - 1),
+	};
+
+	const std::uint64_t hash = GetHash(goalBlock, moveDef.pathType);
+	const auto fieldIter = flowFields.find(hash);
+
+	if (fieldIter != flowFields.end() && fieldIter->second.costsVersion == pathEstimator->GetVertexCostsVersion()) {
+		numFieldReads += 1;
+		fieldIter->second.lastUseFrame = gs->frameNum;
+		return &fieldIter->second;
+	}
+
+	RequestCounter& counter = goalRequests[hash];
+
+	if (counter.numRequests == 0 || (gs->frameNum - counter.firstFrame) > (GAME_SPEED * MAX_REQUEST_WINDOW_SECS))
+		counter = {gs->frameNum, 0};
+
+	if ((counter.numRequests += 1) < MIN_GROUP_REQUESTS)
+		return nullptr;
+
+	if (fieldIter != flowFields.end()) {
+		memFootPrint -= fieldIter->second.GetMemFootPrint();
+		flowFields.erase(fieldIter);
+	}
+
+	FreeMemory(numBlocks.x * numBlocks.y * (sizeof(float) + sizeof(std::uint8_t)));
+
+	CPathFlowField& field = flowFields[hash];
+
+	field.Build(pathEstimator, moveDef, goalBlock, synced);
+	field.costsVersion = pathEstimator->GetVertexCostsVersion();
+	field.lastUseFrame = gs->frameNum;
+
+	memFootPrint += field.GetMemFootPrint();
+	numFieldBuilds += 1;
+	numFieldReads += 1;
+
+	goalRequests.erase(hash);
+	return &field;
+}
+
+
+std::uint64_t CPathFlowFieldCache::GetHash(int2 goalBlock, int pathType) const
+{
+	const int2 numBlocks = pathEstimator->GetNumBlocks();
+	const std::uint64_t index = goalBlock.y * numBlocks.x + goalBlock.x;
+
+	return (index + pathType * std::uint64_t(numBlocks.x * numBlocks.y));
+}
+
+void CPathFlowFieldCache::FreeMemory(size_t reqMemFootPrint)
+{
+	while (!flowFields.empty() && (memFootPrint + reqMemFootPrint) > MAX_FIELD_MEMORY_BYTES) {
+		auto lruIter = flowFields.begin();
+
+		// evict the least recently used field, lowest hash first on ties
+		for (auto it = flowFields.begin(); it != flowFields.end(); ++it) {
+			if (it->second.lastUseFrame > lruIter->second.lastUseFrame)
+				continue;
+			if (it->second.lastUseFrame == lruIter->second.lastUseFrame && it->first > lruIter->first)
+				continue;
+
+			lruIter = it;
+		}
+
+		memFootPrint -= lruIter->second.GetMemFootPrint();
+		flowFields.erase(lruIter);
+	}
+}
@@ -0,0 +1,103 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef PATH_FLOWFIELD_H
+#define PATH_FLOWFIELD_H
+
+#include <cinttypes>
+#include <vector>
+
+#include "IPath.h"
+#include "System/float3.h"
+#include "System/type2.h"
+#include "System/UnorderedMap.hpp"
+
+class CPathEstimator;
+struct MoveDef;
+
+/**
+ * Integrated cost-to-goal over the block graph of a path estimator,
+ * computed by one reverse Dijkstra pass from a single goal block.
+ * Any number of units sharing that goal can read their block-level
+ * path from it without running a search of their own.
+ */
+class CPathFlowField
+{
+public:
+	void Build(const CPathEstimator* pe, const MoveDef& moveDef, int2 goalBlock, bool synced);
+
+	/**
+	 * Walks the field downhill from the block containing startPos and
+	 * stores the visited block-centers in path (goal first, like the
+	 * estimator's own FinishSearch).
+	 * @return Error if the goal is not reachable from startPos
+	 */
+	IPath::SearchResult GetPath(const CPathEstimator* pe, const MoveDef& moveDef, const float3& startPos, IPath::Path& path) const;
+
+	size_t GetMemFootPrint() const { return (blockCosts.size() * sizeof(float) + blockDirs.size() * sizeof(std::uint8_t)); }
+
+public:
+	std::uint32_t costsVersion = 0;
+	std::int32_t lastUseFrame = 0;
+
+private:
+	// cost of the cheapest path from each block to goalBlock
+	std::vector<float> blockCosts;
+	// PATHDIR_* index of the next block along that path
+	std::vector<std::uint8_t> blockDirs;
+
+	int2 numBlocks;
+	int2 goalBlock;
+};
+
+
+/**
+ * Creates flow-fields for goals that many units are requesting paths
+ * to within a short time-window and keeps them around while they are
+ * being used, subject to a memory budget. Fields become stale (and are
+ * discarded) whenever the estimator recalculates any vertex costs.
+ *
+ * Every decision here depends only on the sequence of requests, so a
+ * synced instance takes the same decisions on all clients.
+ */
+class CPathFlowFieldCache
+{
+public:
+	void Init(const CPathEstimator* pe) { pathEstimator = pe; }
+	void Kill();
+
+	void Update();
+	void Invalidate();
+
+	/**
+	 * Registers a path-request to the block containing goalPos and returns
+	 * the corresponding field if enough requests shared this goal recently,
+	 * otherwise nullptr.
+	 */
+	const CPathFlowField* GetFlowField(const MoveDef& moveDef, const float3& goalPos, bool synced);
+
+	size_t GetMemFootPrint() const { return memFootPrint; }
+	size_t GetNumFlowFields() const { return flowFields.size(); }
+
+private:
+	std::uint64_t GetHash(int2 goalBlock, int pathType) const;
+
+	void FreeMemory(size_t reqMemFootPrint);
+
+private:
+	struct RequestCounter {
+		std::int32_t firstFrame;
+		std::int32_t numRequests;
+	};
+
+	const CPathEstimator* pathEstimator = nullptr;
+
+	spring::unordered_map<std::uint64_t, CPathFlowField> flowFields; // ints are sync-safe keys
+	spring::unordered_map<std::uint64_t, RequestCounter> goalRequests;
+
+	size_t memFootPrint = 0;
+
+	std::uint32_t numFieldBuilds = 0;
+	std::uint32_t numFieldReads = 0;
+};
+
+#endif
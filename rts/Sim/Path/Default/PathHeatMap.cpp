@@ -1,5 +1,7 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
+
 #include "PathHeatMap.hpp"
 #include "PathConstants.h"
 #include "PathManager.h"
@@ -32,6 +34,14 @@ void PathHeatMap::Init(unsigned int scalex, unsigned int scalez) {
 	heatMapOffset = 0;
 
 	heatMap.resize(xsize * zsize);
+
+	trafficXSize = (mapDims.mapx + PATH_TRAFFIC_SCALE - 1) / PATH_TRAFFIC_SCALE;
+	trafficZSize = (mapDims.mapy + PATH_TRAFFIC_SCALE - 1) / PATH_TRAFFIC_SCALE;
+
+	pathTraffic.clear();
+	pathTraffic.resize(trafficXSize * trafficZSize, 0);
+	trafficStamps.clear();
+	trafficStamps.resize(trafficXSize * trafficZSize, 0);
 }
 
 unsigned int PathHeatMap::GetHeatMapIndex(unsigned int hmx, unsigned int hmz) const {
@@ -95,6 +105,56 @@ void PathHeatMap::UpdateHeatValue(unsigned int x, unsigned int y, unsigned int v
 	}
 }
 
+void PathHeatMap::UpdatePathTraffic(const CPathManager* pm) {
+	std::fill(pathTraffic.begin(), pathTraffic.end(), 0);
+	std::fill(trafficStamps.begin(), trafficStamps.end(), 0);
+
+	unsigned int pathStamp = 0;
+
+	const auto AddPathTraffic = [&](const IPath::path_list_type& points) {
+		for (const float3& p: points) {
+			const unsigned int tx = std::min(unsigned(std::max(0.0f, p.x) / (SQUARE_SIZE * PATH_TRAFFIC_SCALE)), trafficXSize - 1);
+			const unsigned int tz = std::min(unsigned(std::max(0.0f, p.z) / (SQUARE_SIZE * PATH_TRAFFIC_SCALE)), trafficZSize - 1);
+			const unsigned int ti = tz * trafficXSize + tx;
+
+			// count each path at most once per cell
+			pathTraffic[ti] += (trafficStamps[ti] != pathStamp);
+			trafficStamps[ti] = pathStamp;
+		}
+	};
+
+	// unsynced paths must not influence the (synced) estimator repair order
+	for (const auto& p: pm->GetPathMap()) {
+		const CPathManager::MultiPath& mp = p.second;
+
+		if (!mp.peDef.synced)
+			continue;
+
+		pathStamp += 1;
+
+		AddPathTraffic(mp.maxResPath.path);
+		AddPathTraffic(mp.medResPath.path);
+		AddPathTraffic(mp.lowResPath.path);
+	}
+}
+
+unsigned int PathHeatMap::GetPathTraffic(unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2) const {
+	unsigned int traffic = 0;
+
+	x1 = std::min(x1 / PATH_TRAFFIC_SCALE, trafficXSize - 1);
+	z1 = std::min(z1 / PATH_TRAFFIC_SCALE, trafficZSize - 1);
+	x2 = std::min(x2 / PATH_TRAFFIC_SCALE, trafficXSize - 1);
+	z2 = std::min(z2 / PATH_TRAFFIC_SCALE, trafficZSize - 1);
+
+	for (unsigned int z = z1; z <= z2; z++) {
+		for (unsigned int x = x1; x <= x2; x++) {
+			traffic += pathTraffic[z * trafficXSize + x];
+		}
+	}
+
+	return traffic;
+}
+
 float PathHeatMap::GetHeatCost(unsigned int x, unsigned int z, const MoveDef& md, unsigned int ownerID) const {
 	float c = 0.0f;
 
@@ -23,6 +23,8 @@ public:
 	void Kill() {
 		heatMap.clear();
 		pathSquares.clear();
+		pathTraffic.clear();
+		trafficStamps.clear();
 	}
 
 	void Update() { ++heatMapOffset; }
@@ -42,6 +44,11 @@ public:
 
 	float GetHeatCost(unsigned int x, unsigned int z, const MoveDef&, unsigned int ownerID) const;
 
+	/// recounts the synced paths crossing each PATH_TRAFFIC_SCALE^2 area
+	void UpdatePathTraffic(const CPathManager* pm);
+	/// number of synced paths crossing the square-rectangle [x1,x2]*[z1,z2]
+	unsigned int GetPathTraffic(unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2) const;
+
 private:
 	struct HeatCell {
 		unsigned int value = 0;
@@ -53,6 +60,13 @@ private:
 	std::vector<HeatCell> heatMap;
 	std::vector<int2> pathSquares;
 
+	// resolution is (mapx/PATH_TRAFFIC_SCALE)*(mapy/PATH_TRAFFIC_SCALE)
+	std::vector<unsigned int> pathTraffic;
+	std::vector<unsigned int> trafficStamps;
+
+	unsigned int trafficXSize = 0;
+	unsigned int trafficZSize = 0;
+
 	unsigned int xscale = 0, xsize = 0;
 	unsigned int zscale = 0, zsize = 0;
 
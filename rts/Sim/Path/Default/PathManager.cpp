@@ -9,6 +9,8 @@
 #include "PathLog.h"
 #include "PathMemPool.h"
 #include "Map/MapInfo.h"
+#include "Sim/Path/PathTelemetry.h"
+#include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/ModInfo.h"
 #include "Sim/Objects/SolidObject.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
@@ -46,6 +48,9 @@ CPathManager::~CPathManager()
 {
 	// Finalize is not called in case of forced exit
 	if (maxResPF != nullptr) {
+		flowFieldCaches[0].Kill();
+		flowFieldCaches[1].Kill();
+
 		lowResPE->Kill();
 		medResPE->Kill();
 		maxResPF->Kill();
@@ -85,6 +90,9 @@ std::int64_t CPathManager::Finalize() {
 		maxResPF->Init(false);
 		medResPE->Init(maxResPF, MEDRES_PE_BLOCKSIZE, "pe" , mapInfo->map.name);
 		lowResPE->Init(medResPE, LOWRES_PE_BLOCKSIZE, "pe2", mapInfo->map.name);
+
+		flowFieldCaches[0].Init(medResPE);
+		flowFieldCaches[1].Init(medResPE);
 	}
 
 	const spring_time dt = spring_gettime() - t0;
@@ -349,6 +357,31 @@ IPath::SearchResult CPathManager::ArrangePath(
 }
 
 
+IPath::SearchResult CPathManager::ArrangeFlowFieldPath(
+	MultiPath* newPath,
+	const MoveDef* moveDef,
+	const float3& startPos,
+	const float3& goalPos
+) {
+	const CPathFinderDef* pfDef = &newPath->peDef;
+
+	// same estimate as ArrangePath; paths that a raw or max-res search
+	// would handle are cheap enough to keep requesting individually
+	const float heurGoalDist2D = pfDef->Heuristic(startPos.x / SQUARE_SIZE, startPos.z / SQUARE_SIZE, 1) + math::fabs(goalPos.y - startPos.y) / SQUARE_SIZE;
+
+	if (heurGoalDist2D <= (MAXRES_SEARCH_DISTANCE * modInfo.pfRawDistMult))
+		return IPath::Error;
+
+	const CPathFlowField* flowField = flowFieldCaches[pfDef->synced].GetFlowField(*moveDef, goalPos, pfDef->synced);
+
+	if (flowField == nullptr)
+		return IPath::Error;
+
+	// the med-res waypoints are refined into max-res segments by NextWayPoint
+	return (flowField->GetPath(medResPE, *moveDef, startPos, newPath->medResPath));
+}
+
+
 /*
 Request a new multipath, store the result and return a handle-id to it.
 */
@@ -368,6 +401,8 @@ unsigned int CPathManager::RequestPath(
 	startPos.ClampInBounds();
 	goalPos.ClampInBounds();
 
+	CPathTelemetry::ScopedRequest telemetry(caller, moveDef->pathType, startPos, goalPos);
+
 	// Create an estimator definition.
 	goalRadius = std::max<float>(goalRadius, PATH_NODE_SPACING * SQUARE_SIZE); //FIXME do on a per PE & PF level?
 	assert(moveDef == moveDefHandler.GetMoveDefByPathType(moveDef->pathType));
@@ -380,7 +415,14 @@ unsigned int CPathManager::RequestPath(
 	if (caller != nullptr)
 		caller->UnBlock();
 
-	const IPath::SearchResult result = ArrangePath(&newPath, moveDef, startPos, goalPos, caller);
+	IPath::SearchResult result = ArrangeFlowFieldPath(&newPath, moveDef, startPos, goalPos);
+
+	// no field for this goal (yet), or the goal is unreachable through it
+	if (result != IPath::Ok) {
+		result = ArrangePath(&newPath, moveDef, startPos, goalPos, caller);
+	} else {
+		pathTelemetry.AddLevel(CPathTelemetry::RES_FLOW);
+	}
 
 	unsigned int pathID = 0;
 
@@ -410,6 +452,7 @@ unsigned int CPathManager::RequestPath(
 	if (caller != nullptr)
 		caller->Block();
 
+	telemetry.SetResult(pathID != 0);
 	return pathID;
 }
 
@@ -604,6 +647,8 @@ void CPathManager::TerrainChange(unsigned int x1, unsigned int z1, unsigned int
 	if (!IsFinalized())
 		return;
 
+	// flow-fields are discarded as soon as the estimator has recalculated
+	// the affected vertex costs (see CPathFlowFieldCache::Update)
 	medResPE->MapChanged(x1, z1, x2, z2);
 
 	// low-res PE will be informed via (medRes)PE::Update
@@ -620,11 +665,20 @@ void CPathManager::Update()
 	SCOPED_TIMER("Sim::Path");
 	assert(IsFinalized());
 
+	UpdateTerrainChanges();
+
 	pathFlowMap->Update();
 	pathHeatMap->Update();
 
-	medResPE->Update();
-	lowResPE->Update();
+	// repair order of queued estimator blocks depends on path traffic
+	if ((gs->frameNum % PATH_TRAFFIC_UPDATE_RATE) == 0 && (!medResPE->updatedBlocks.empty() || !lowResPE->updatedBlocks.empty()))
+		pathHeatMap->UpdatePathTraffic(this);
+
+	medResPE->Update(pathHeatMap);
+	lowResPE->Update(pathHeatMap);
+
+	flowFieldCaches[0].Update();
+	flowFieldCaches[1].Update();
 }
 
 // used to deposit heat on the heat-map as a unit moves along its path
@@ -735,6 +789,8 @@ bool CPathManager::SetNodeExtraCost(unsigned int x, unsigned int z, float cost,
 	maxResBuf.SetNodeExtraCost(x, z, cost, synced);
 	medResBuf.SetNodeExtraCost(x, z, cost, synced);
 	lowResBuf.SetNodeExtraCost(x, z, cost, synced);
+
+	flowFieldCaches[synced].Invalidate();
 	return true;
 }
 
@@ -753,6 +809,8 @@ bool CPathManager::SetNodeExtraCosts(const float* costs, unsigned int sizex, uns
 	maxResBuf.SetNodeExtraCosts(costs, sizex, sizez, synced);
 	medResBuf.SetNodeExtraCosts(costs, sizex, sizez, synced);
 	lowResBuf.SetNodeExtraCosts(costs, sizex, sizez, synced);
+
+	flowFieldCaches[synced].Invalidate();
 	return true;
 }
 
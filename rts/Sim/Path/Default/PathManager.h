@@ -8,6 +8,7 @@
 #include "Sim/Path/IPathManager.h"
 #include "IPath.h"
 #include "PathFinderDef.h"
+#include "PathFlowField.h"
 #include "System/UnorderedMap.hpp"
 
 class CSolidObject;
@@ -154,6 +155,7 @@ public:
 	const PathHeatMap* GetPathHeatMap() const { return pathHeatMap; }
 
 	const spring::unordered_map<unsigned int, MultiPath>& GetPathMap() const { return pathMap; }
+	const CPathFlowFieldCache& GetFlowFieldCache(bool synced) const { return flowFieldCaches[synced]; }
 
 private:
 	IPath::SearchResult ArrangePath(
@@ -163,6 +165,12 @@ private:
 		const float3& goalPos,
 		CSolidObject* caller
 	) const;
+	IPath::SearchResult ArrangeFlowFieldPath(
+		MultiPath* newPath,
+		const MoveDef* moveDef,
+		const float3& startPos,
+		const float3& goalPos
+	);
 
 	MultiPath* GetMultiPath(int pathID) { return (const_cast<MultiPath*>(GetMultiPathConst(pathID))); }
 
@@ -194,6 +202,9 @@ private:
 	PathFlowMap* pathFlowMap;
 	PathHeatMap* pathHeatMap;
 
+	// med-res block-graph fields for large groups sharing a goal; [0] = !synced, [1] = synced
+	CPathFlowFieldCache flowFieldCaches[2];
+
 	spring::unordered_map<unsigned int, MultiPath> pathMap;
 
 	unsigned int nextPathID;
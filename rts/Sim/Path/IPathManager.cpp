@@ -3,6 +3,8 @@
 #include "IPathManager.h"
 #include "Default/PathManager.h"
 #include "QTPFS/PathManager.hpp"
+#include "Map/ReadMap.h"
+#include "Sim/Objects/SolidObject.h"
 #include "System/Log/ILog.h"
 
 IPathManager nullPathManager;
@@ -34,3 +36,9 @@ void IPathManager::FreeInstance(IPathManager* pm) {
 	pathManager = &nullPathManager;
 }
 
+
+void IPathManager::UpdateTerrainChanges() {
+	readMap->GetHeightMapChangeTracker().ForEachChangedRect(heightMapVersion, [this](const SRectangle& r) {
+		TerrainChange(r.x1, r.z1, r.x2, r.z2, TERRAINCHANGE_DAMAGE_RECALCULATION);
+	});
+}
@@ -164,12 +164,22 @@ public:
 	 */
 	virtual void TerrainChange(unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2, unsigned int type) {}
 
+	/**
+	 * Passes every heightmap change since the previous call on to
+	 * TerrainChange, polled from the heightmap-change tracker; called
+	 * by implementations at the start of their Update.
+	 */
+	void UpdateTerrainChanges();
+
 	virtual bool SetNodeExtraCosts(const float* costs, unsigned int sizex, unsigned int sizez, bool synced) { return false; }
 	virtual bool SetNodeExtraCost(unsigned int x, unsigned int z, float cost, bool synced) { return false; }
 	virtual float GetNodeExtraCost(unsigned int x, unsigned int z, bool synced) const { return 0.0f; }
 	virtual const float* GetNodeExtraCosts(bool synced) const { return nullptr; }
 
 	virtual int2 GetNumQueuedUpdates() const { return (int2(0, 0)); }
+
+protected:
+	std::uint32_t heightMapVersion = 0;
 };
 
 extern IPathManager* pathManager;
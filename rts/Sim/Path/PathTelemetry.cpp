@@ -0,0 +1,205 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <fstream>
+
+#include "PathTelemetry.h"
+#include "Sim/Misc/GlobalSynced.h"
+#include "Sim/MoveTypes/MoveDefHandler.h"
+#include "Sim/Units/Unit.h"
+#include "Sim/Units/CommandAI/BuilderCAI.h"
+#include "Sim/Units/CommandAI/FactoryCAI.h"
+#include "Sim/Units/CommandAI/MobileCAI.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
+#include "System/Log/ILog.h"
+
+CPathTelemetry pathTelemetry;
+
+static thread_local CPathTelemetry::Sample* activeSample = nullptr;
+static thread_local unsigned int activeCallerType = CPathTelemetry::CALLER_UNKNOWN;
+
+
+CPathTelemetry::ScopedCaller::ScopedCaller(CallerType type): prevType(activeCallerType) { activeCallerType = type; }
+CPathTelemetry::ScopedCaller::~ScopedCaller() { activeCallerType = prevType; }
+
+
+CPathTelemetry::ScopedRequest::ScopedRequest(
+	const CSolidObject* caller,
+	unsigned int pathType,
+	const float3& startPos,
+	const float3& goalPos
+): prevSample(activeSample), startTime(spring_gettime()) {
+	sample.pathType = pathType;
+	sample.callerType = GetCallerType(caller);
+	sample.distance = startPos.distance2D(goalPos);
+
+	activeSample = &sample;
+}
+
+CPathTelemetry::ScopedRequest::~ScopedRequest() {
+	sample.wallTime = spring_gettime() - startTime;
+
+	activeSample = prevSample;
+
+	pathTelemetry.AddSample(sample);
+}
+
+
+
+void CPathTelemetry::Init(unsigned int _numPathTypes)
+{
+	numPathTypes = _numPathTypes;
+
+	stats.clear();
+	stats.resize(numPathTypes * CALLER_COUNT);
+}
+
+void CPathTelemetry::Kill()
+{
+	stats.clear();
+	numPathTypes = 0;
+}
+
+void CPathTelemetry::Reset()
+{
+	Init(numPathTypes);
+}
+
+
+void CPathTelemetry::AddSample(const Sample& sample)
+{
+	// requests might arrive before Init (or after Kill)
+	if (sample.pathType >= numPathTypes)
+		return;
+
+	Stats& s = stats[sample.pathType * CALLER_COUNT + sample.callerType];
+
+	const std::int64_t wallTime = sample.wallTime.toMicroSecsi();
+
+	s.numRequests += 1;
+	s.numFailures += (!sample.succeeded);
+	s.numNodes += sample.numNodes;
+	s.maxNodes = std::max(s.maxNodes, std::uint64_t(sample.numNodes));
+	s.numCacheHits += sample.numCacheHits;
+	s.numCacheMisses += sample.numCacheMisses;
+
+	for (unsigned int level = 0; level < RES_COUNT; level++) {
+		s.numLevelSearches[level] += ((sample.resLevels >> level) & 1);
+	}
+
+	s.sumWallTime += wallTime;
+	s.maxWallTime = std::max(s.maxWallTime, wallTime);
+
+	s.sumDistance += sample.distance;
+	s.maxDistance = std::max(s.maxDistance, sample.distance);
+}
+
+void CPathTelemetry::AddSearch(ResolutionLevel level, unsigned int numNodes)
+{
+	if (activeSample == nullptr)
+		return;
+
+	activeSample->numNodes += numNodes;
+	activeSample->resLevels |= (1 << level);
+}
+
+void CPathTelemetry::AddCacheLookup(bool cacheHit)
+{
+	if (activeSample == nullptr)
+		return;
+
+	activeSample->numCacheHits += ( cacheHit);
+	activeSample->numCacheMisses += (!cacheHit);
+}
+
+void CPathTelemetry::AddLevel(ResolutionLevel level)
+{
+	if (activeSample == nullptr)
+		return;
+
+	activeSample->resLevels |= (1 << level);
+}
+
+
+bool CPathTelemetry::Dump(const std::string& fileName) const
+{
+	// user-supplied name, keep it inside the write-dir like other dumps
+	const std::string filePath = dataDirsAccess.LocateFile(fileName, FileQueryFlags::WRITE);
+
+	if (filePath.empty()) {
+		LOG_L(L_WARNING, "[PathTelemetry::%s] invalid file name \"%s\"", __func__, fileName.c_str());
+		return false;
+	}
+
+	std::ofstream file(filePath.c_str(), std::ios::out);
+
+	if (!file.is_open()) {
+		LOG_L(L_WARNING, "[PathTelemetry::%s] could not open file \"%s\"", __func__, filePath.c_str());
+		return false;
+	}
+
+	file << "frame: " << gs->frameNum << "\n";
+	file << "pathTypes: " << numPathTypes << "\n";
+
+	for (unsigned int pathType = 0; pathType < numPathTypes; pathType++) {
+		const MoveDef* moveDef = moveDefHandler.GetMoveDefByPathType(pathType);
+
+		for (unsigned int callerType = 0; callerType < CALLER_COUNT; callerType++) {
+			const Stats& s = GetStats(pathType, callerType);
+
+			if (s.numRequests == 0)
+				continue;
+
+			file << "moveDef: " << moveDef->name << " (pathType: " << pathType << "), caller: " << GetCallerName(callerType) << "\n";
+			file << "\trequests: " << s.numRequests << ", failures: " << s.numFailures << "\n";
+			file << "\tnodes: " << s.numNodes << " (avg: " << (s.numNodes / double(s.numRequests)) << ", max: " << s.maxNodes << ")\n";
+			file << "\tcacheHits: " << s.numCacheHits << ", cacheMisses: " << s.numCacheMisses << "\n";
+			file << "\twallTime: " << (s.sumWallTime * 0.001) << "ms (avg: " << (s.sumWallTime / double(s.numRequests)) << "us, max: " << s.maxWallTime << "us)\n";
+			file << "\tdistance: avg " << (s.sumDistance / s.numRequests) << ", max " << s.maxDistance << "\n";
+			file << "\tlevels:";
+
+			for (unsigned int level = 0; level < RES_COUNT; level++) {
+				file << " " << GetLevelName(level) << "=" << s.numLevelSearches[level];
+			}
+
+			file << "\n";
+		}
+	}
+
+	LOG("[PathTelemetry::%s] wrote \"%s\"", __func__, filePath.c_str());
+	return true;
+}
+
+
+unsigned int CPathTelemetry::GetCallerType(const CSolidObject* caller)
+{
+	if (caller == nullptr)
+		return activeCallerType;
+
+	const CUnit* unit = dynamic_cast<const CUnit*>(caller);
+
+	if (unit == nullptr || unit->commandAI == nullptr)
+		return CALLER_OTHERUNIT;
+
+	// NB: builders are also mobile, so test those first
+	if (dynamic_cast<const CBuilderCAI*>(unit->commandAI) != nullptr)
+		return CALLER_BUILDERCAI;
+	if (dynamic_cast<const CMobileCAI*>(unit->commandAI) != nullptr)
+		return CALLER_MOBILECAI;
+	if (dynamic_cast<const CFactoryCAI*>(unit->commandAI) != nullptr)
+		return CALLER_FACTORYCAI;
+
+	return CALLER_OTHERUNIT;
+}
+
+const char* CPathTelemetry::GetCallerName(unsigned int type)
+{
+	constexpr const char* names[CALLER_COUNT] = {"mobileCAI", "builderCAI", "factoryCAI", "otherUnit", "lua", "ai", "unknown"};
+	return names[type];
+}
+
+const char* CPathTelemetry::GetLevelName(unsigned int level)
+{
+	constexpr const char* names[RES_COUNT] = {"maxRes", "medRes", "lowRes", "flow", "qtpfs"};
+	return names[level];
+}
@@ -0,0 +1,133 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef PATH_TELEMETRY_H
+#define PATH_TELEMETRY_H
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cinttypes>
+
+#include "System/float3.h"
+#include "System/Misc/SpringTime.h"
+
+class CSolidObject;
+
+// per-MoveDef and per-caller aggregates of path-request costs, fed by
+// both path managers; purely unsynced bookkeeping, nothing read back
+// here can influence the simulation
+class CPathTelemetry {
+public:
+	enum CallerType {
+		CALLER_MOBILECAI  = 0,
+		CALLER_BUILDERCAI = 1,
+		CALLER_FACTORYCAI = 2,
+		CALLER_OTHERUNIT  = 3, // unit without a (mobile) CAI, or non-unit object
+		CALLER_LUA        = 4, // Spring.RequestPath
+		CALLER_AI         = 5, // skirmish-AI callback
+		CALLER_UNKNOWN    = 6, // no owner and no scoped caller-type
+		CALLER_COUNT      = 7,
+	};
+
+	enum ResolutionLevel {
+		RES_MAXRES = 0, // CPathFinder
+		RES_MEDRES = 1, // medium-resolution CPathEstimator
+		RES_LOWRES = 2, // low-resolution CPathEstimator
+		RES_FLOW   = 3, // CPathFlowField
+		RES_QTPFS  = 4,
+		RES_COUNT  = 5,
+	};
+
+	struct Sample {
+		unsigned int pathType = 0;
+		unsigned int callerType = CALLER_UNKNOWN;
+
+		unsigned int numNodes = 0;
+		unsigned int numCacheHits = 0;
+		unsigned int numCacheMisses = 0;
+		// bitmask of ResolutionLevel's searched
+		unsigned int resLevels = 0;
+
+		float distance = 0.0f;
+		bool succeeded = false;
+
+		spring_time wallTime;
+	};
+
+	struct Stats {
+		std::uint64_t numRequests = 0;
+		std::uint64_t numFailures = 0;
+		std::uint64_t numNodes = 0;
+		std::uint64_t maxNodes = 0;
+		std::uint64_t numCacheHits = 0;
+		std::uint64_t numCacheMisses = 0;
+
+		std::array<std::uint64_t, RES_COUNT> numLevelSearches = {{0}};
+
+		// microseconds
+		std::int64_t sumWallTime = 0;
+		std::int64_t maxWallTime = 0;
+
+		double sumDistance = 0.0;
+		float maxDistance = 0.0f;
+	};
+
+	// sets the caller-type for owner-less requests made by the
+	// current thread while in scope (Lua and AI both pass null)
+	struct ScopedCaller {
+		ScopedCaller(CallerType type);
+		~ScopedCaller();
+	private:
+		unsigned int prevType;
+	};
+
+	// collects the searches made by one request of the default
+	// path manager; its path-finders report to whichever request
+	// is active on their thread (if any, estimator precalculation
+	// threads never have one)
+	struct ScopedRequest {
+		ScopedRequest(const CSolidObject* caller, unsigned int pathType, const float3& startPos, const float3& goalPos);
+		~ScopedRequest();
+
+		void SetResult(bool ok) { sample.succeeded = ok; }
+	private:
+		Sample sample;
+		Sample* prevSample;
+		spring_time startTime;
+	};
+
+public:
+	void Init(unsigned int numPathTypes);
+	void Kill();
+	void Reset();
+
+	void AddSample(const Sample& sample);
+	// called by the default path-finders, no-ops outside a ScopedRequest
+	void AddSearch(ResolutionLevel level, unsigned int numNodes);
+	void AddCacheLookup(bool cacheHit);
+	void AddLevel(ResolutionLevel level);
+
+	// writes every non-empty aggregate in plain-text; returns false
+	// if the file could not be opened
+	bool Dump(const std::string& fileName) const;
+
+	static unsigned int GetCallerType(const CSolidObject* caller);
+
+	static const char* GetCallerName(unsigned int type);
+	static const char* GetLevelName(unsigned int level);
+
+	unsigned int GetNumPathTypes() const { return numPathTypes; }
+
+	const Stats& GetStats(unsigned int pathType, unsigned int callerType) const {
+		return stats[pathType * CALLER_COUNT + callerType];
+	}
+
+private:
+	std::vector<Stats> stats;
+
+	unsigned int numPathTypes = 0;
+};
+
+extern CPathTelemetry pathTelemetry;
+
+#endif
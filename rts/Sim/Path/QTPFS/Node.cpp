@@ -20,43 +20,6 @@ unsigned int QTPFS::QTNode::MAX_DEPTH;
 
 
 
-void QTPFS::INode::SetPathCost(unsigned int type, float cost) {
-	#ifndef QTPFS_ENABLE_MICRO_OPTIMIZATION_HACKS
-	switch (type) {
-		case NODE_PATH_COST_F: { fCost = cost; return; } break;
-		case NODE_PATH_COST_G: { gCost = cost; return; } break;
-		case NODE_PATH_COST_H: { hCost = cost; return; } break;
-	}
-
-	assert(false);
-	#else
-	assert(&gCost == &fCost + 1);
-	assert(&hCost == &gCost + 1);
-	assert(type <= NODE_PATH_COST_H);
-
-	*(&fCost + type) = cost;
-	#endif
-}
-
-float QTPFS::INode::GetPathCost(unsigned int type) const {
-	#ifndef QTPFS_ENABLE_MICRO_OPTIMIZATION_HACKS
-	switch (type) {
-		case NODE_PATH_COST_F: { return fCost; } break;
-		case NODE_PATH_COST_G: { return gCost; } break;
-		case NODE_PATH_COST_H: { return hCost; } break;
-	}
-
-	assert(false);
-	return 0.0f;
-	#else
-	assert(&gCost == &fCost + 1);
-	assert(&hCost == &gCost + 1);
-	assert(type <= NODE_PATH_COST_H);
-
-	return *(&fCost + type);
-	#endif
-}
-
 float QTPFS::INode::GetDistance(const INode* n, unsigned int type) const {
 	const float dx = float(xmid() * SQUARE_SIZE) - float(n->xmid() * SQUARE_SIZE);
 	const float dz = float(zmid() * SQUARE_SIZE) - float(n->zmid() * SQUARE_SIZE);
@@ -198,9 +161,7 @@ void QTPFS::QTNode::Init(
 	assert(MIN_SIZE_Z > 0);
 
 	nodeNumber = nn;
-	heapIndex = -1u;
 
-	searchState  =   0;
 	currMagicNum =   0;
 	prevMagicNum = -1u;
 
@@ -215,18 +176,14 @@ void QTPFS::QTNode::Init(
 	assert(xsize() != 0);
 	assert(zsize() != 0);
 
-	fCost = 0.0f;
-	gCost = 0.0f;
-	hCost = 0.0f;
-
 	speedModSum =  0.0f;
 	speedModAvg =  0.0f;
 	moveCostAvg = -1.0f;
 
-	prevNode = nullptr;
-
-	neighbors.clear();
-	netpoints.clear();
+	// any previous range was released by Split or Merge
+	neighborsIndex = -1u;
+	numNeighbors = 0;
+	maxNeighbors = 0;
 }
 
 
@@ -234,10 +191,8 @@ void QTPFS::QTNode::Init(
 std::uint64_t QTPFS::QTNode::GetMemFootPrint(const NodeLayer& nl) const {
 	std::uint64_t memFootPrint = sizeof(QTNode);
 
-	if (IsLeaf()) {
-		memFootPrint += (neighbors.size() * sizeof(decltype(neighbors)::value_type));
-		memFootPrint += (netpoints.size() * sizeof(decltype(netpoints)::value_type));
-	} else {
+	// neighbor-edges are accounted for by the layer
+	if (!IsLeaf()) {
 		for (unsigned int i = 0; i < QTNODE_CHILD_COUNT; i++) {
 			memFootPrint += (nl.GetPoolNode(childBaseIndex + i)->GetMemFootPrint(nl));
 		}
@@ -251,7 +206,7 @@ std::uint64_t QTPFS::QTNode::GetCheckSum(const NodeLayer& nl) const {
 
 	{
 		const unsigned char* minByte = reinterpret_cast<const unsigned char*>(&nodeNumber);
-		const unsigned char* maxByte = reinterpret_cast<const unsigned char*>(&hCost) + sizeof(hCost);
+		const unsigned char* maxByte = reinterpret_cast<const unsigned char*>(&nodeNumber) + sizeof(nodeNumber);
 
 		assert(minByte < maxByte);
 
@@ -330,8 +285,7 @@ bool QTPFS::QTNode::Split(NodeLayer& nl, unsigned int depth, bool forced) {
 
 	childBaseIndex = childIndices[0];
 
-	neighbors.clear();
-	netpoints.clear();
+	nl.FreeNodeNeighbors(this);
 
 	nl.SetNumLeafNodes(nl.GetNumLeafNodes() + (4 - 1));
 	assert(!IsLeaf());
@@ -342,12 +296,12 @@ bool QTPFS::QTNode::Merge(NodeLayer& nl) {
 	if (IsLeaf())
 		return false;
 
-	neighbors.clear();
-	// netpoints.clear();
-
 	// get rid of our children completely
 	for (unsigned int i = 0; i < QTNODE_CHILD_COUNT; i++) {
-		nl.GetPoolNode(childBaseIndex + i)->Merge(nl);
+		INode* child = nl.GetPoolNode(childBaseIndex + i);
+
+		child->Merge(nl);
+		nl.FreeNodeNeighbors(child);
 	}
 
 	// NOTE: return indices in reverse order (BL, BR, TR, TL) of allocation by Split
@@ -679,52 +633,31 @@ void QTPFS::QTNode::Serialize(std::fstream& fStream, NodeLayer& nodeLayer, unsig
 	}
 }
 
-unsigned int QTPFS::QTNode::GetNeighbors(const std::vector<INode*>& nodes, std::vector<INode*>& ngbs) {
-	#ifdef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
-	UpdateNeighborCache(nodes);
-	#endif
-
-	if (!neighbors.empty()) {
-		ngbs.clear();
-		ngbs.resize(neighbors.size());
-
-		std::copy(neighbors.begin(), neighbors.end(), ngbs.begin());
-	}
-
-	return (neighbors.size());
-}
-
-const std::vector<QTPFS::INode*>& QTPFS::QTNode::GetNeighbors(const std::vector<INode*>& nodes) {
-	#ifdef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
-	UpdateNeighborCache(nodes);
-	#endif
-	return neighbors;
-}
-
-// this is *either* called from ::GetNeighbors when the conservative
+// this is *either* called from PathSearch when the conservative
 // update-scheme is enabled, *or* from PM::ExecQueuedNodeLayerUpdates
 // (never both)
-bool QTPFS::QTNode::UpdateNeighborCache(const std::vector<INode*>& nodes) {
+bool QTPFS::QTNode::UpdateNeighborCache(NodeLayer& nl) {
 	assert(IsLeaf());
-	assert(!nodes.empty());
+	assert(!nl.GetNodes().empty());
 
 	if (prevMagicNum != currMagicNum) {
 		prevMagicNum = currMagicNum;
 
+		const std::vector<INode*>& nodes = nl.GetNodes();
+
+		// the layer's scratch-buffers, copied into our range below
+		std::vector<INode*>& neighbors = nl.GetTempNeighbors();
+		std::vector<float2>& netpoints = nl.GetTempNetpoints();
+
 		unsigned int ngbRels = 0;
 		unsigned int maxNgbs = GetMaxNumNeighbors();
 
+		neighbors.clear();
+		netpoints.clear();
+
 		// regenerate our neighbor cache
 		if (maxNgbs > 0) {
-			neighbors.clear();
-			neighbors.reserve(maxNgbs + 4);
-
-			netpoints.clear();
-			netpoints.reserve(1 + maxNgbs * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE + 4);
 			// NOTE: caching ETP's breaks QTPFS_ORTHOPROJECTED_EDGE_TRANSITIONS
-			// NOTE: [0] is a reserved index and must always be valid
-			netpoints.emplace_back();
-
 			INode* ngb = nullptr;
 
 			if (xmin() > 0) {
@@ -872,6 +805,7 @@ bool QTPFS::QTNode::UpdateNeighborCache(const std::vector<INode*>& nodes) {
 			#endif
 		}
 
+		nl.SetNodeNeighbors(this, neighbors, netpoints);
 		return true;
 	}
 
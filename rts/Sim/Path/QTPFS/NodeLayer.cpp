@@ -1,5 +1,6 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
 #include <limits>
 
 #include "NodeLayer.hpp"
@@ -53,6 +54,10 @@ void QTPFS::NodeLayer::Init(unsigned int layerNum) {
 		std::reverse(nodeIndcs.begin(), nodeIndcs.end());
 	}
 
+	nodeNeighbors.clear();
+	nodeNetpoints.clear();
+	numFreeNeighbors = 0;
+
 	curSpeedMods.resize(xsize * zsize,  0);
 	oldSpeedMods.resize(xsize * zsize,  0);
 	oldSpeedBins.resize(xsize * zsize, -1);
@@ -62,6 +67,10 @@ void QTPFS::NodeLayer::Init(unsigned int layerNum) {
 void QTPFS::NodeLayer::Clear() {
 	nodeGrid.clear();
 
+	nodeNeighbors.clear();
+	nodeNetpoints.clear();
+	numFreeNeighbors = 0;
+
 	curSpeedMods.clear();
 	oldSpeedMods.clear();
 	oldSpeedBins.clear();
@@ -74,6 +83,118 @@ void QTPFS::NodeLayer::Clear() {
 
 
 
+void QTPFS::NodeLayer::FreeMemory() {
+	Clear();
+
+	// swap with empties, clear() keeps the capacity
+	nodeGrid = {};
+	nodeIndcs = {};
+	nodeNeighbors = {};
+	nodeNetpoints = {};
+	tmpNeighbors = {};
+	tmpNetpoints = {};
+
+	curSpeedMods = {};
+	oldSpeedMods = {};
+	oldSpeedBins = {};
+	curSpeedBins = {};
+
+	for (std::vector<QTNode>& chunk: poolNodes) {
+		std::vector<QTNode>().swap(chunk);
+	}
+
+	#ifdef QTPFS_STAGGERED_LAYER_UPDATES
+	layerUpdates = {};
+	#endif
+
+	numLeafNodes = 0;
+}
+
+
+
+void QTPFS::NodeLayer::SetNodeNeighbors(INode* n, const std::vector<INode*>& ngbs, const std::vector<float2>& netpoints) {
+	assert(netpoints.size() == (ngbs.size() * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE));
+
+	unsigned int idx = n->GetNeighborsIndex();
+	unsigned int cap = n->GetMaxNeighbors();
+
+	// reuse the current range if it is large enough, otherwise append a new one
+	if (ngbs.size() > cap) {
+		FreeNodeNeighbors(n);
+
+		idx = nodeNeighbors.size();
+		cap = ngbs.size();
+
+		nodeNeighbors.resize(idx + cap, nullptr);
+		nodeNetpoints.resize((idx + cap) * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE);
+	}
+
+	n->SetNeighborRange(idx, ngbs.size(), cap);
+
+	if (ngbs.empty())
+		return;
+
+	std::copy(ngbs.begin(), ngbs.end(), nodeNeighbors.begin() + idx);
+	std::copy(netpoints.begin(), netpoints.end(), nodeNetpoints.begin() + idx * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE);
+}
+
+void QTPFS::NodeLayer::FreeNodeNeighbors(INode* n) {
+	numFreeNeighbors += n->GetMaxNeighbors();
+	n->SetNeighborRange(-1u, 0, 0);
+}
+
+void QTPFS::NodeLayer::CompactNodeNeighbors() {
+	if (numFreeNeighbors <= (nodeNeighbors.size() >> 1))
+		return;
+
+	std::vector<INode*>& leafs = tmpNeighbors;
+
+	leafs.clear();
+	leafs.reserve(numLeafNodes);
+
+	// every leaf is visited once per square it covers; keep only the first
+	for (unsigned int i = 0, n = nodeGrid.size(); i < n; i++) {
+		INode* leaf = nodeGrid[i];
+
+		if (leaf->xmin() != (i % xsize) || leaf->zmin() != (i / xsize))
+			continue;
+		if (leaf->GetMaxNeighbors() == 0)
+			continue;
+
+		leafs.push_back(leaf);
+	}
+
+	// moving ranges down in ascending order never overwrites a live one
+	std::sort(leafs.begin(), leafs.end(), [](const INode* a, const INode* b) {
+		return (a->GetNeighborsIndex() < b->GetNeighborsIndex());
+	});
+
+	unsigned int numNeighbors = 0;
+
+	for (INode* leaf: leafs) {
+		const unsigned int srcIdx = leaf->GetNeighborsIndex();
+		const unsigned int numNgbs = leaf->GetNumNeighbors();
+
+		std::copy(nodeNeighbors.begin() + srcIdx, nodeNeighbors.begin() + srcIdx + numNgbs, nodeNeighbors.begin() + numNeighbors);
+		std::copy(
+			nodeNetpoints.begin() + (srcIdx                ) * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE,
+			nodeNetpoints.begin() + (srcIdx + numNgbs      ) * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE,
+			nodeNetpoints.begin() + (         numNeighbors ) * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE
+		);
+
+		leaf->SetNeighborRange(numNeighbors, numNgbs, numNgbs);
+		numNeighbors += numNgbs;
+	}
+
+	nodeNeighbors.resize(numNeighbors);
+	nodeNetpoints.resize(numNeighbors * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE);
+	numFreeNeighbors = 0;
+
+	leafs.clear();
+}
+
+
+
 #ifdef QTPFS_STAGGERED_LAYER_UPDATES
 void QTPFS::NodeLayer::QueueUpdate(const SRectangle& r, const MoveDef* md) {
 	layerUpdates.emplace_back();
@@ -263,7 +384,7 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdate(unsigned int currFrameNum, un
 				zspan = std::max(zspan, 1u);
 
 				n->SetMagicNumber(currMagicNum);
-				n->GetNeighbors(nodeGrid);
+				n->UpdateNeighborCache(*this);
 			}
 
 			z += zspan;
@@ -285,7 +406,7 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdate(unsigned int currFrameNum, un
 				zspan = std::max(zspan, 1u);
 
 				n->SetMagicNumber(currMagicNum);
-				n->GetNeighbors(nodeGrid);
+				n->UpdateNeighborCache(*this);
 			}
 
 			z += zspan;
@@ -307,7 +428,7 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdate(unsigned int currFrameNum, un
 				zspan = std::max(zspan, 1u);
 
 				n->SetMagicNumber(currMagicNum);
-				n->GetNeighbors(nodeGrid);
+				n->UpdateNeighborCache(*this);
 			}
 
 			z += zspan;
@@ -329,7 +450,7 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdate(unsigned int currFrameNum, un
 				zspan = std::max(zspan, 1u);
 
 				n->SetMagicNumber(currMagicNum);
-				n->GetNeighbors(nodeGrid);
+				n->UpdateNeighborCache(*this);
 			}
 
 			z += zspan;
@@ -364,10 +485,12 @@ void QTPFS::NodeLayer::ExecNodeNeighborCacheUpdates(const SRectangle& ur, unsign
 			//   during initialization, currMagicNum == 0 which nodes start with already 
 			//   (does not matter because prevMagicNum == -1, so updates are not no-ops)
 			n->SetMagicNumber(currMagicNum);
-			n->UpdateNeighborCache(nodeGrid);
+			n->UpdateNeighborCache(*this);
 		}
 
 		z += zspan;
 	}
+
+	CompactNodeNeighbors();
 }
 
@@ -102,7 +102,31 @@ namespace QTPFS {
 		const std::vector<SpeedModType>& GetOldSpeedMods() const { return oldSpeedMods; }
 		const std::vector<SpeedModType>& GetCurSpeedMods() const { return curSpeedMods; }
 
-		std::vector<INode*>& GetNodes() { return nodeGrid; }
+		const std::vector<INode*>& GetNodes() const { return nodeGrid; }
+		      std::vector<INode*>& GetNodes()       { return nodeGrid; }
+
+		// neighbor-edges of leaf node n, see INode::UpdateNeighborCache;
+		// netpoints are stored QTPFS_MAX_NETPOINTS_PER_NODE_EDGE per edge
+		INode* const* GetNodeNeighbors(const INode* n) const {
+			if (n->GetNumNeighbors() == 0)
+				return nullptr;
+			return (nodeNeighbors.data() + n->GetNeighborsIndex());
+		}
+		const float2* GetNodeNetpoints(const INode* n) const {
+			if (n->GetNumNeighbors() == 0)
+				return nullptr;
+			return (nodeNetpoints.data() + n->GetNeighborsIndex() * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE);
+		}
+
+		std::vector<INode*>& GetTempNeighbors() { return tmpNeighbors; }
+		std::vector<float2>& GetTempNetpoints() { return tmpNetpoints; }
+
+		void SetNodeNeighbors(INode* n, const std::vector<INode*>& ngbs, const std::vector<float2>& netpoints);
+		void FreeNodeNeighbors(INode* n);
+		void CompactNodeNeighbors();
+
+		// releases all memory held by this layer, Init must be called before reuse
+		void FreeMemory();
 
 		void RegisterNode(INode* n);
 
@@ -126,6 +150,8 @@ namespace QTPFS {
 				memFootPrint += (poolNodes[i].size() * sizeof(QTNode));
 			}
 			memFootPrint += (nodeIndcs.size() * sizeof(decltype(nodeIndcs)::value_type));
+			memFootPrint += (nodeNeighbors.size() * sizeof(decltype(nodeNeighbors)::value_type));
+			memFootPrint += (nodeNetpoints.size() * sizeof(decltype(nodeNetpoints)::value_type));
 			return memFootPrint;
 		}
 
@@ -135,6 +161,14 @@ namespace QTPFS {
 		std::vector<QTNode> poolNodes[16];
 		std::vector<unsigned int> nodeIndcs;
 
+		// shared by all leaf nodes, each owns a contiguous range; ranges that
+		// become too small are moved to the end and the arrays are compacted
+		// once more than half of them is unused
+		std::vector<INode*> nodeNeighbors;
+		std::vector<float2> nodeNetpoints;
+		std::vector<INode*> tmpNeighbors;
+		std::vector<float2> tmpNetpoints;
+
 		std::vector<SpeedModType> curSpeedMods;
 		std::vector<SpeedModType> oldSpeedMods;
 		std::vector<SpeedBinType> curSpeedBins;
@@ -161,6 +195,7 @@ namespace QTPFS {
 
 		unsigned int layerNumber = 0;
 		unsigned int numLeafNodes = 0;
+		unsigned int numFreeNeighbors = 0;
 		unsigned int updateCounter = 0;
 
 		unsigned int xsize = 0;
@@ -16,11 +16,6 @@ namespace QTPFS {
 		REL_NGB_EDGE_B = 4, // bottom-edge neighbor
 		REL_NGB_EDGE_L = 8, // left-edge neighbor
 	};
-	enum {
-		NODE_STATE_OPEN   = 0,
-		NODE_STATE_CLOSED = 1,
-		NODE_STATE_OFFSET = 2,
-	};
 	enum {
 		NODE_DIST_EUCLIDEAN = 0,
 		NODE_DIST_MANHATTAN = 1,
@@ -31,11 +26,6 @@ namespace QTPFS {
 		NODE_IDX_BR = 2,
 		NODE_IDX_BL = 3,
 	};
-	enum {
-		NODE_PATH_COST_F = 0,
-		NODE_PATH_COST_G = 1,
-		NODE_PATH_COST_H = 2,
-	};
 	enum {
 		PATH_SEARCH_ASTAR    = 0,
 		PATH_SEARCH_DIJKSTRA = 1,
@@ -18,6 +18,7 @@
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/MoveTypes/MoveMath/MoveMath.h"
 #include "Sim/Objects/SolidObject.h"
+#include "Sim/Path/PathTelemetry.h"
 #include "System/Config/ConfigHandler.h"
 #include "System/FileSystem/ArchiveScanner.h"
 #include "System/FileSystem/FileSystem.h"
@@ -107,6 +108,8 @@ namespace QTPFS {
 
 	unsigned int PathManager::LAYERS_PER_UPDATE;
 	unsigned int PathManager::MAX_TEAM_SEARCHES;
+	unsigned int PathManager::MAX_LAYER_MEMORY;
+	unsigned int PathManager::LAYER_IDLE_TIME;
 
 	std::vector<NodeLayer> PathManager::nodeLayers;
 	std::vector<QTNode*> PathManager::nodeTrees;
@@ -123,8 +126,14 @@ QTPFS::PathManager::PathManager() {
 }
 
 QTPFS::PathManager::~PathManager() {
+	if (numLayerEvictions > 0)
+		LOG("[QTPFS::PathManager::%s] layerEvictions=%u layerRebuilds=%u", __func__, numLayerEvictions, numLayerRebuilds);
+
 	for (unsigned int layerNum = 0; layerNum < nodeLayers.size(); layerNum++) {
-		nodeTrees[layerNum]->Merge(nodeLayers[layerNum]);
+		// evicted layers have no tree left to merge
+		if (nodeTrees[layerNum] != nullptr)
+			nodeTrees[layerNum]->Merge(nodeLayers[layerNum]);
+
 		nodeLayers[layerNum].Clear();
 
 		for (auto searchesIt = pathSearches[layerNum].begin(); searchesIt != pathSearches[layerNum].end(); ++searchesIt) {
@@ -148,7 +157,10 @@ QTPFS::PathManager::~PathManager() {
 	numCurrExecutedSearches.clear();
 	numPrevExecutedSearches.clear();
 
-	PathSearch::FreeGlobalQueue();
+	layerUseFrames.clear();
+	evictedLayers.clear();
+
+	PathSearch::FreeThreadData();
 
 	#ifdef QTPFS_ENABLE_THREADED_UPDATE
 	// at this point the thread is waiting, so notify it
@@ -182,20 +194,27 @@ std::int64_t QTPFS::PathManager::Finalize() {
 void QTPFS::PathManager::InitStatic() {
 	LAYERS_PER_UPDATE = std::max(1u, mapInfo->pfs.qtpfs_constants.layersPerUpdate);
 	MAX_TEAM_SEARCHES = std::max(1u, mapInfo->pfs.qtpfs_constants.maxTeamSearches);
+	MAX_LAYER_MEMORY  = mapInfo->pfs.qtpfs_constants.maxLayerMemory;
+	LAYER_IDLE_TIME   = std::max(1u, mapInfo->pfs.qtpfs_constants.layerIdleTime);
 }
 
 void QTPFS::PathManager::Load() {
-	// NOTE: offset *must* start at a non-zero value
-	searchStateOffset = NODE_STATE_OFFSET;
 	numTerrainChanges = 0;
 	numPathRequests   = 0;
 	maxNumLeafNodes   = 0;
+	numLayerEvictions = 0;
+	numLayerRebuilds  = 0;
 
 	nodeTrees.resize(moveDefHandler.GetNumMoveDefs(), nullptr);
 	nodeLayers.resize(moveDefHandler.GetNumMoveDefs());
 	pathCaches.resize(moveDefHandler.GetNumMoveDefs());
 	pathSearches.resize(moveDefHandler.GetNumMoveDefs());
 
+	layerUseFrames.clear();
+	layerUseFrames.resize(moveDefHandler.GetNumMoveDefs(), 0);
+	evictedLayers.clear();
+	evictedLayers.resize(moveDefHandler.GetNumMoveDefs(), 0);
+
 	// add one extra element for object-less requests
 	numCurrExecutedSearches.resize(teamHandler.ActiveTeams() + 1, 0);
 	numPrevExecutedSearches.resize(teamHandler.ActiveTeams() + 1, 0);
@@ -247,7 +266,7 @@ void QTPFS::PathManager::Load() {
 
 		{ SyncedUint tmp(pfsCheckSum); }
 
-		PathSearch::InitGlobalQueue(maxNumLeafNodes);
+		PathSearch::InitThreadData();
 	}
 
 	{
@@ -263,14 +282,20 @@ std::uint64_t QTPFS::PathManager::GetMemFootPrint() const {
 	std::uint64_t memFootPrint = sizeof(PathManager);
 
 	for (unsigned int i = 0; i < nodeLayers.size(); i++) {
-		memFootPrint += nodeLayers[i].GetMemFootPrint();
-		memFootPrint += nodeTrees[i]->GetMemFootPrint(nodeLayers[i]);
+		memFootPrint += GetLayerMemFootPrint(i);
 	}
 
 	// convert to megabytes
 	return (memFootPrint / (1024 * 1024));
 }
 
+std::uint64_t QTPFS::PathManager::GetLayerMemFootPrint(unsigned int layerNum) const {
+	if (nodeTrees[layerNum] == nullptr)
+		return (nodeLayers[layerNum].GetMemFootPrint());
+
+	return (nodeLayers[layerNum].GetMemFootPrint() + nodeTrees[layerNum]->GetMemFootPrint(nodeLayers[layerNum]));
+}
+
 
 
 void QTPFS::PathManager::SpawnSpringThreads(MemberFunc f, const SRectangle& r) {
@@ -431,10 +456,13 @@ void QTPFS::PathManager::UpdateNodeLayer(unsigned int layerNum, const SRectangle
 
 	if (!IsFinalized())
 		return;
+	// rebuilt from scratch when needed again
+	if (evictedLayers[layerNum] != 0)
+		return;
 
 	// NOTE:
 	//     this is needed for IsBlocked* --> SquareIsBlocked --> IsNonBlocking
-	//     but no point doing it in ExecuteSearch because the IsBlocked* calls
+	//     but no point doing it in ExecuteQueuedSearches because the IsBlocked* calls
 	//     are only made from NodeLayer::Update and also no point doing it here
 	//     since we are independent of a specific path --> requires redesign
 	//
@@ -469,11 +497,80 @@ void QTPFS::PathManager::UpdateNodeLayer(unsigned int layerNum, const SRectangle
 
 
 
+void QTPFS::PathManager::EvictNodeLayers() {
+	// every decision here depends on synced state only, all clients
+	// evict (and later rebuild) the same layers in the same frames
+	if ((gs->frameNum % GAME_SPEED) != 0)
+		return;
+
+	std::uint64_t memFootPrint = 0;
+
+	for (unsigned int layerNum = 0; layerNum < nodeLayers.size(); layerNum++) {
+		if (evictedLayers[layerNum] != 0)
+			continue;
+
+		memFootPrint += GetLayerMemFootPrint(layerNum);
+	}
+
+	while (memFootPrint > (MAX_LAYER_MEMORY * std::uint64_t(1024 * 1024))) {
+		unsigned int lruLayerNum = -1u;
+
+		for (unsigned int layerNum = 0; layerNum < nodeLayers.size(); layerNum++) {
+			if (evictedLayers[layerNum] != 0)
+				continue;
+			// a layer is only evicted when nothing refers to its nodes
+			if (!pathSearches[layerNum].empty())
+				continue;
+			if (!pathCaches[layerNum].GetTempPaths().empty() || !pathCaches[layerNum].GetLivePaths().empty() || !pathCaches[layerNum].GetDeadPaths().empty())
+				continue;
+			if ((gs->frameNum - layerUseFrames[layerNum]) < int(LAYER_IDLE_TIME))
+				continue;
+			if (lruLayerNum != -1u && layerUseFrames[layerNum] >= layerUseFrames[lruLayerNum])
+				continue;
+
+			lruLayerNum = layerNum;
+		}
+
+		if (lruLayerNum == -1u)
+			break;
+
+		memFootPrint -= GetLayerMemFootPrint(lruLayerNum);
+
+		nodeTrees[lruLayerNum]->Merge(nodeLayers[lruLayerNum]);
+		nodeLayers[lruLayerNum].FreeMemory();
+		// the root lived in the freed pool, RebuildNodeLayer allocates a new one
+		nodeTrees[lruLayerNum] = nullptr;
+
+		evictedLayers[lruLayerNum] = 1;
+		numLayerEvictions += 1;
+	}
+}
+
+void QTPFS::PathManager::RebuildNodeLayer(unsigned int layerNum) {
+	const spring_time t0 = spring_gettime();
+
+	evictedLayers[layerNum] = 0;
+	numLayerRebuilds += 1;
+
+	InitNodeLayer(layerNum, MAP_RECTANGLE);
+	UpdateNodeLayer(layerNum, MAP_RECTANGLE);
+
+	const spring_time t1 = spring_gettime();
+	const unsigned int mem = GetLayerMemFootPrint(layerNum) / 1024;
+
+	LOG_L(L_DEBUG, "[QTPFS::PathManager::%s] rebuilt node-layer %u (%u KB, %u leafs) in %ums", __func__, layerNum, mem, nodeLayers[layerNum].GetNumLeafNodes(), unsigned((t1 - t0).toMilliSecsi()));
+}
+
+
+
 #ifdef QTPFS_STAGGERED_LAYER_UPDATES
 void QTPFS::PathManager::QueueNodeLayerUpdates(const SRectangle& r) {
 	for (unsigned int layerNum = 0; layerNum < nodeLayers.size(); layerNum++) {
 		const MoveDef* md = moveDefHandler.GetMoveDefByPathType(layerNum);
 
+		if (evictedLayers[layerNum] != 0)
+			continue;
+
 		SRectangle mr;
 		// SRectangle ur;
 
@@ -666,6 +763,8 @@ void QTPFS::PathManager::TerrainChange(unsigned int x1, unsigned int z1,  unsign
 void QTPFS::PathManager::Update() {
 	SCOPED_TIMER("Sim::Path");
 
+	UpdateTerrainChanges();
+
 	#ifdef QTPFS_ENABLE_THREADED_UPDATE
 	streflop::streflop_init<streflop::Simple>();
 
@@ -712,7 +811,17 @@ void QTPFS::PathManager::ThreadUpdate() {
 
 		sharedPaths.clear();
 
+		if (MAX_LAYER_MEMORY > 0)
+			EvictNodeLayers();
+
 		for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
+			if (!pathSearches[pathTypeUpdate].empty()) {
+				layerUseFrames[pathTypeUpdate] = gs->frameNum;
+
+				if (evictedLayers[pathTypeUpdate] != 0)
+					RebuildNodeLayer(pathTypeUpdate);
+			}
+
 			#ifndef QTPFS_IGNORE_DEAD_PATHS
 			QueueDeadPathSearches(pathTypeUpdate);
 			#endif
@@ -751,79 +860,178 @@ void QTPFS::PathManager::ExecuteQueuedSearches(unsigned int pathType) {
 	NodeLayer& nodeLayer = nodeLayers[pathType];
 	PathCache& pathCache = pathCaches[pathType];
 
-	std::vector<IPathSearch*>& searches = pathSearches[pathType];
-	std::vector<IPathSearch*>::iterator searchesIt = searches.begin();
+	PathSearchVect& searches = pathSearches[pathType];
 
-	if (!searches.empty()) {
-		// execute pending searches collected via
-		// RequestPath and QueueDeadPathSearches
-		while (searchesIt != searches.end()) {
-			if (ExecuteSearch(searches, searchesIt, nodeLayer, pathCache, pathType)) {
-				searchStateOffset += NODE_STATE_OFFSET;
-			}
+	if (searches.empty())
+		return;
+
+	const auto PopSearch = [](PathSearchVect& v, size_t i) {
+		// ordering of still-queued searches is not relevant
+		v[i] = v.back();
+		v.pop_back();
+	};
+
+	execSearches.clear();
+	shareSearches.clear();
+	execPathHashes.clear();
+
+	// pass 1: discard searches whose temp-path is gone, set aside those that
+	// might be able to share the result of an earlier one and apply the team
+	// limits to the rest
+	for (size_t i = 0; i < searches.size(); ) {
+		IPathSearch* search = searches[i];
+
+		if (!InitSearch(search, nodeLayer, pathCache, pathType)) {
+			PopSearch(searches, i);
+			delete search;
+			continue;
+		}
+
+		#ifdef QTPFS_SEARCH_SHARED_PATHS
+		const std::uint64_t pathHash = pathCache.GetTempPath(search->GetID())->GetHash();
+
+		if (sharedPaths.find(pathHash) != sharedPaths.end() || execPathHashes.find(pathHash) != execPathHashes.end()) {
+			shareSearches.push_back(search);
+			PopSearch(searches, i);
+			continue;
 		}
+		#endif
+
+		if (LimitSearch(search)) {
+			i++;
+			continue;
+		}
+
+		#ifdef QTPFS_SEARCH_SHARED_PATHS
+		execPathHashes.insert(pathHash);
+		#endif
+
+		execSearches.push_back(search);
+		PopSearch(searches, i);
+	}
+
+	// pass 2: searches only read the layer and keep their state in per-thread
+	// tables, so any number of them can run at once; results do not depend on
+	// which thread executes what
+	searchResults.clear();
+	searchResults.resize(execSearches.size(), 0);
+
+	const auto ExecuteSearch = [&](IPathSearch* search) {
+		const spring_time t0 = spring_gettime();
+		const bool haveResult = search->Execute(numTerrainChanges);
+
+		search->SetExecTime(spring_gettime() - t0);
+		return haveResult;
+	};
+
+	#ifndef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
+	for_mt(0, execSearches.size(), [&](const int i) {
+		searchResults[i] = ExecuteSearch(execSearches[i]);
+	});
+	#else
+	// neighbor-caches are updated lazily by the searches themselves
+	for (size_t i = 0; i < execSearches.size(); i++) {
+		searchResults[i] = ExecuteSearch(execSearches[i]);
+	}
+	#endif
+
+	// pass 3: publish results in queue-order
+	for (size_t i = 0; i < execSearches.size(); i++) {
+		AddTelemetrySample(execSearches[i], pathCache.GetTempPath(execSearches[i]->GetID()), pathType, false, searchResults[i] != 0);
+		FinalizeSearch(execSearches[i], pathCache, searchResults[i] != 0);
+	}
+
+	// pass 4: searches that did not get a shared path are executed as usual
+	for (IPathSearch* search: shareSearches) {
+		#ifdef QTPFS_SEARCH_SHARED_PATHS
+		IPath* path = pathCache.GetTempPath(search->GetID());
+
+		const SharedPathMap::const_iterator sharedPathsIt = sharedPaths.find(path->GetHash());
+
+		if (sharedPathsIt != sharedPaths.end() && search->SharedFinalize(sharedPathsIt->second, path)) {
+			AddTelemetrySample(search, path, pathType, true, true);
+			delete search;
+			continue;
+		}
+		#endif
+
+		if (LimitSearch(search)) {
+			searches.push_back(search);
+			continue;
+		}
+
+		const bool haveResult = ExecuteSearch(search);
+
+		AddTelemetrySample(search, pathCache.GetTempPath(search->GetID()), pathType, false, haveResult);
+		FinalizeSearch(search, pathCache, haveResult);
 	}
 }
 
-bool QTPFS::PathManager::ExecuteSearch(
-	PathSearchVect& searches,
-	PathSearchVectIt& searchesIt,
+bool QTPFS::PathManager::InitSearch(
+	IPathSearch* search,
 	NodeLayer& nodeLayer,
 	PathCache& pathCache,
 	unsigned int pathType
 ) {
-	IPathSearch* search = *searchesIt;
 	IPath* path = pathCache.GetTempPath(search->GetID());
 
 	assert(search != nullptr);
 	assert(path != nullptr);
 
-	const auto DeleteSearch = [](IPathSearch* s, PathSearchVect& v, PathSearchVectIt& it) {
-		// ordering of still-queued searches is not relevant
-		*it = v.back();
-		v.pop_back();
-		delete s;
-	};
-
 	// temp-path might have been removed already via
 	// DeletePath before we got a chance to process it
-	if (path->GetID() == 0) {
-		DeleteSearch(search, searches, searchesIt);
+	if (path->GetID() == 0)
 		return false;
-	}
 
 	assert(search->GetID() != 0);
 	assert(path->GetID() == search->GetID());
 
 	search->Initialize(&nodeLayer, &pathCache, path->GetSourcePoint(), path->GetTargetPoint(), MAP_RECTANGLE);
 	path->SetHash(search->GetHash(mapDims.mapx * mapDims.mapy, pathType));
+	return true;
+}
 
-	{
-		#ifdef QTPFS_SEARCH_SHARED_PATHS
-		SharedPathMap::const_iterator sharedPathsIt = sharedPaths.find(path->GetHash());
+void QTPFS::PathManager::AddTelemetrySample(
+	const IPathSearch* search,
+	const IPath* path,
+	unsigned int pathType,
+	bool sharedPath,
+	bool haveResult
+) {
+	// NB: must be called before FinalizeSearch, which deletes failed paths
+	CPathTelemetry::Sample sample;
+	sample.pathType = pathType;
+	sample.callerType = search->GetCaller();
+	sample.numNodes = search->GetNumSearchedNodes() * (!sharedPath);
+	sample.numCacheHits = ( sharedPath);
+	sample.numCacheMisses = (!sharedPath);
+	sample.resLevels = (1 << CPathTelemetry::RES_QTPFS);
+	sample.distance = path->GetSourcePoint().distance2D(path->GetTargetPoint());
+	sample.succeeded = haveResult;
+	sample.wallTime = sharedPath? spring_notime: search->GetExecTime();
+
+	pathTelemetry.AddSample(sample);
+}
 
-		if (sharedPathsIt != sharedPaths.end()) {
-			if (search->SharedFinalize(sharedPathsIt->second, path)) {
-				DeleteSearch(search, searches, searchesIt);
-				return false;
-			}
-		}
-		#endif
+bool QTPFS::PathManager::LimitSearch(const IPathSearch* search) {
+	#ifdef QTPFS_LIMIT_TEAM_SEARCHES
+	const unsigned int numCurrSearches = numCurrExecutedSearches[search->GetTeam()];
+	const unsigned int numPrevSearches = numPrevExecutedSearches[search->GetTeam()];
 
-		#ifdef QTPFS_LIMIT_TEAM_SEARCHES
-		const unsigned int numCurrSearches = numCurrExecutedSearches[search->GetTeam()];
-		const unsigned int numPrevSearches = numPrevExecutedSearches[search->GetTeam()];
+	if ((numCurrSearches - numPrevSearches) >= MAX_TEAM_SEARCHES)
+		return true;
 
-		if ((numCurrSearches - numPrevSearches) >= MAX_TEAM_SEARCHES) {
-			++searchesIt; return false;
-		}
+	numCurrExecutedSearches[search->GetTeam()] += 1;
+	#endif
 
-		numCurrExecutedSearches[search->GetTeam()] += 1;
-		#endif
-	}
+	return false;
+}
+
+void QTPFS::PathManager::FinalizeSearch(IPathSearch* search, PathCache& pathCache, bool haveResult) {
+	IPath* path = pathCache.GetTempPath(search->GetID());
 
 	// removes path from temp-paths, adds it to live-paths
-	if (search->Execute(searchStateOffset, numTerrainChanges)) {
+	if (haveResult) {
 		search->Finalize(path);
 
 		#ifdef QTPFS_SEARCH_SHARED_PATHS
@@ -837,8 +1045,7 @@ bool QTPFS::PathManager::ExecuteSearch(
 		DeletePath(path->GetID());
 	}
 
-	DeleteSearch(search, searches, searchesIt);
-	return true;
+	delete search;
 }
 
 void QTPFS::PathManager::QueueDeadPathSearches(unsigned int pathType) {
@@ -881,7 +1088,7 @@ unsigned int QTPFS::PathManager::QueueSearch(
 	//     the path-owner object handed to us can never become
 	//     dangling (even with delayed execution) because ~GMT
 	//     calls DeletePath, which ensures any path is removed
-	//     from its cache before we get to ExecuteSearch
+	//     from its cache before we get to ExecuteQueuedSearches
 	IPath* newPath = new IPath();
 	IPathSearch* newSearch = new PathSearch(PATH_SEARCH_ASTAR);
 
@@ -914,6 +1121,7 @@ unsigned int QTPFS::PathManager::QueueSearch(
 		newPath->SetTargetPoint(oldPath->GetTargetPoint());
 		newSearch->SetID(oldPath->GetID());
 		newSearch->SetTeam(teamHandler.ActiveTeams());
+		newSearch->SetCaller(CPathTelemetry::GetCallerType(oldPath->GetOwner()));
 	} else {
 		// NOTE:
 		//     the unclamped end-points are temporary
@@ -927,6 +1135,7 @@ unsigned int QTPFS::PathManager::QueueSearch(
 		newPath->SetTargetPoint(targetPoint);
 		newSearch->SetID(newPath->GetID());
 		newSearch->SetTeam((object != nullptr)? object->team: teamHandler.ActiveTeams());
+		newSearch->SetCaller(CPathTelemetry::GetCallerType(object));
 	}
 
 	assert((pathCaches[moveDef->pathType].GetTempPath(newPath->GetID()))->GetID() == 0);
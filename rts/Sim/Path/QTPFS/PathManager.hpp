@@ -10,6 +10,7 @@
 #include "PathCache.hpp"
 #include "PathSearch.hpp"
 #include "System/UnorderedMap.hpp"
+#include "System/UnorderedSet.hpp"
 
 struct MoveDef;
 struct SRectangle;
@@ -72,6 +73,7 @@ namespace QTPFS {
 
 
 		const NodeLayer& GetNodeLayer(unsigned int pathType) const { return nodeLayers[pathType]; }
+		bool IsNodeLayerEvicted(unsigned int pathType) const { return (evictedLayers[pathType] != 0); }
 		const QTNode* GetNodeTree(unsigned int pathType) const { return nodeTrees[pathType]; }
 		const PathCache& GetPathCache(unsigned int pathType) const { return pathCaches[pathType]; }
 
@@ -83,6 +85,7 @@ namespace QTPFS {
 		void Load();
 
 		std::uint64_t GetMemFootPrint() const;
+		std::uint64_t GetLayerMemFootPrint(unsigned int layerNum) const;
 
 		typedef void (PathManager::*MemberFunc)(
 			unsigned int threadNum,
@@ -116,6 +119,11 @@ namespace QTPFS {
 		void InitNodeLayer(unsigned int layerNum, const SRectangle& r);
 		void UpdateNodeLayer(unsigned int layerNum, const SRectangle& r);
 
+		// budget-mode: drop layers nobody has used for a while and
+		// rebuild them when a search for their path-type is queued
+		void EvictNodeLayers();
+		void RebuildNodeLayer(unsigned int layerNum);
+
 		#ifdef QTPFS_STAGGERED_LAYER_UPDATES
 		void QueueNodeLayerUpdates(const SRectangle& r);
 		void ExecQueuedNodeLayerUpdates(unsigned int layerNum, bool flushQueue);
@@ -134,13 +142,15 @@ namespace QTPFS {
 			const bool synced
 		);
 
-		bool ExecuteSearch(
-			PathSearchVect& searches,
-			PathSearchVectIt& searchesIt,
+		bool InitSearch(
+			IPathSearch* search,
 			NodeLayer& nodeLayer,
 			PathCache& pathCache,
 			unsigned int pathType
 		);
+		bool LimitSearch(const IPathSearch* search);
+		void AddTelemetrySample(const IPathSearch* search, const IPath* path, unsigned int pathType, bool sharedPath, bool haveResult);
+		void FinalizeSearch(IPathSearch* search, PathCache& pathCache, bool haveResult);
 
 		bool IsFinalized() const { return (!nodeTrees.empty()); }
 
@@ -162,10 +172,24 @@ namespace QTPFS {
 		std::vector<unsigned int> numCurrExecutedSearches;
 		std::vector<unsigned int> numPrevExecutedSearches;
 
+		// scratch-space for ExecuteQueuedSearches
+		PathSearchVect execSearches;
+		PathSearchVect shareSearches;
+		std::vector<std::uint8_t> searchResults;
+		spring::unordered_set<std::uint64_t> execPathHashes;
+
 		static unsigned int LAYERS_PER_UPDATE;
 		static unsigned int MAX_TEAM_SEARCHES;
+		static unsigned int MAX_LAYER_MEMORY;
+		static unsigned int LAYER_IDLE_TIME;
+
+		// per layer, last frame a search was queued for it
+		std::vector<int> layerUseFrames;
+		std::vector<std::uint8_t> evictedLayers;
+
+		unsigned int numLayerEvictions;
+		unsigned int numLayerRebuilds;
 
-		unsigned int searchStateOffset;
 		unsigned int numTerrainChanges;
 		unsigned int numPathRequests;
 		unsigned int maxNumLeafNodes;
@@ -1,5 +1,6 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <array>
 #include <cassert>
 #include <limits>
 
@@ -7,7 +8,9 @@
 #include "Path.hpp"
 #include "PathCache.hpp"
 #include "NodeLayer.hpp"
+#include "Map/ReadMap.h"
 #include "Sim/Misc/GlobalConstants.h"
+#include "System/Threading/ThreadPool.h"
 
 #ifdef QTPFS_TRACE_PATH_SEARCHES
 #include "Sim/Misc/GlobalSynced.h"
@@ -15,10 +18,59 @@
 
 #include "System/float3.h"
 
-QTPFS::binary_heap<QTPFS::INode*> QTPFS::PathSearch::openNodes;
+// one instance per pool-thread, indexed by ThreadPool::GetThreadNum
+static std::array<QTPFS::SearchThreadData, ThreadPool::MAX_THREADS> searchThreadData;
 
 
 
+void QTPFS::SearchThreadData::Reset(unsigned int numLeafNodes) {
+	// a search can reach each leaf at most once
+	if (searchNodes.size() < numLeafNodes)
+		searchNodes.resize(numLeafNodes);
+
+	openNodes.reset();
+
+	nodeSlots.clear();
+	numUsedSlots = 0;
+}
+
+QTPFS::SearchNode* QTPFS::SearchThreadData::FindNode(const INode* node) {
+	const auto it = nodeSlots.find(node->zmin() * mapDims.mapx + node->xmin());
+
+	if (it == nodeSlots.end())
+		return nullptr;
+
+	return &searchNodes[it->second];
+}
+
+QTPFS::SearchNode* QTPFS::SearchThreadData::AddNode(INode* node) {
+	assert(numUsedSlots < searchNodes.size());
+	assert(FindNode(node) == nullptr);
+
+	SearchNode* searchNode = &searchNodes[numUsedSlots];
+
+	*searchNode = {};
+	searchNode->node = node;
+
+	nodeSlots[node->zmin() * mapDims.mapx + node->xmin()] = numUsedSlots++;
+	return searchNode;
+}
+
+
+
+void QTPFS::PathSearch::InitThreadData() {
+	// node tables are sized lazily, only threads that execute searches need them
+	for (SearchThreadData& data: searchThreadData) {
+		data.openNodes.reserve(1024);
+	}
+}
+
+void QTPFS::PathSearch::FreeThreadData() {
+	for (SearchThreadData& data: searchThreadData) {
+		data = {};
+	}
+}
+
 void QTPFS::PathSearch::Initialize(
 	NodeLayer* layer,
 	PathCache* cache,
@@ -42,12 +94,9 @@ void QTPFS::PathSearch::Initialize(
 	minNode = srcNode;
 }
 
-bool QTPFS::PathSearch::Execute(
-	unsigned int searchStateOffset,
-	unsigned int searchMagicNumber
-) {
-	searchState = searchStateOffset; // starts at NODE_STATE_OFFSET
+bool QTPFS::PathSearch::Execute(unsigned int searchMagicNumber) {
 	searchMagic = searchMagicNumber; // starts at numTerrainChanges
+	numSearchedNodes = 0;
 
 	haveFullPath = (srcNode == tgtNode);
 	havePartPath = false;
@@ -75,14 +124,16 @@ bool QTPFS::PathSearch::Execute(
 	// nodes can represent many terrain squares, some of which can still
 	// be passable and allow a unit to move within a node)
 	// NOTE: we need to make sure such paths do not have infinite cost!
-	if (srcNode->GetMoveCost() == QTPFS_POSITIVE_INFINITY)
-		srcNode->SetMoveCost(0.0f);
+	srcNodeBlocked = (srcNode->GetMoveCost() == QTPFS_POSITIVE_INFINITY);
+
+	searchData = &searchThreadData[ThreadPool::GetThreadNum()];
+	searchData->Reset(nodeLayer->GetNumLeafNodes());
 
 	ResetState(srcNode);
-	UpdateNode(srcNode, nullptr, 0);
 
-	while (!openNodes.empty()) {
+	while (!searchData->openNodes.empty()) {
 		IterateNodes(nodeLayer->GetNodes());
+		numSearchedNodes += 1;
 
 		#ifdef QTPFS_TRACE_PATH_SEARCHES
 		searchExec->AddIteration(searchIter);
@@ -93,12 +144,9 @@ bool QTPFS::PathSearch::Execute(
 		havePartPath = (minNode != srcNode);
 
 		if (haveFullPath)
-			openNodes.reset();
+			searchData->openNodes.reset();
 	}
 
-	if (srcNode->GetMoveCost() == 0.0f)
-		srcNode->SetMoveCost(QTPFS_POSITIVE_INFINITY);
-
 
 	#ifdef QTPFS_SUPPORT_PARTIAL_SEARCHES
 	// adjust the target-point if we only got a partial result
@@ -113,6 +161,14 @@ bool QTPFS::PathSearch::Execute(
 	}
 	#endif
 
+	if (haveFullPath || havePartPath)
+		StorePathNodes(searchData->FindNode(tgtNode));
+
+	// the thread's tables are free for the next search from here on
+	searchData = nullptr;
+	curSearchNode = nullptr;
+	minSearchNode = nullptr;
+
 	return (haveFullPath || havePartPath);
 }
 
@@ -136,25 +192,30 @@ void QTPFS::PathSearch::ResetState(INode* node) {
 		hCosts[i] = 0.0f;
 	}
 
-	openNodes.reset();
-	openNodes.push(node);
+	UpdateNode(minSearchNode = searchData->AddNode(node), nullptr, 0);
+
+	searchData->openNodes.push(minSearchNode);
 }
 
-void QTPFS::PathSearch::UpdateNode(INode* nextNode, INode* prevNode, unsigned int netPointIdx) {
+void QTPFS::PathSearch::UpdateNode(SearchNode* nextNode, SearchNode* prevNode, unsigned int netPointIdx) {
 	// NOTE:
 	//   the heuristic must never over-estimate the distance,
 	//   but this is *impossible* to achieve on a non-regular
 	//   grid on which any node only has an average move-cost
 	//   associated with it --> paths will be "nearly optimal"
-	nextNode->SetPrevNode(prevNode);
+	nextNode->prevNode = prevNode;
+	nextNode->netPoint = netPoints[netPointIdx];
+	nextNode->isClosed = false;
 	nextNode->SetPathCosts(gCosts[netPointIdx], hCosts[netPointIdx]);
-	nextNode->SetSearchState(searchState | NODE_STATE_OPEN);
-	nextNode->SetNeighborEdgeTransitionPoint(0, netPoints[netPointIdx]);
 }
 
 void QTPFS::PathSearch::IterateNodes(const std::vector<INode*>& allNodes) {
-	curNode = openNodes.top();
-	curNode->SetSearchState(searchState | NODE_STATE_CLOSED);
+	binary_heap<SearchNode*>& openNodes = searchData->openNodes;
+
+	curSearchNode = openNodes.top();
+	curSearchNode->isClosed = true;
+
+	curNode = curSearchNode->node;
 	#ifdef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
 	// in the non-conservative case, this is done from
 	// NodeLayer::ExecNodeNeighborCacheUpdates instead
@@ -170,7 +231,7 @@ void QTPFS::PathSearch::IterateNodes(const std::vector<INode*>& allNodes) {
 
 	if (curNode == tgtNode)
 		return;
-	if (curNode->AllSquaresImpassable())
+	if (IsImpassable(curNode))
 		return;
 
 	if (curNode->xmid() < searchRect.x1) return;
@@ -180,19 +241,27 @@ void QTPFS::PathSearch::IterateNodes(const std::vector<INode*>& allNodes) {
 
 	#ifdef QTPFS_SUPPORT_PARTIAL_SEARCHES
 	// remember the node with lowest h-cost in case the search fails to reach tgtNode
-	if (curNode->GetPathCost(NODE_PATH_COST_H) < minNode->GetPathCost(NODE_PATH_COST_H))
+	if (curSearchNode->hCost < minSearchNode->hCost) {
+		minSearchNode = curSearchNode;
 		minNode = curNode;
+	}
 	#endif
 
-	IterateNodeNeighbors(curNode->GetNeighbors(allNodes));
+	#ifdef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
+	curNode->UpdateNeighborCache(*nodeLayer);
+	#endif
+
+	IterateNodeNeighbors(nodeLayer->GetNodeNeighbors(curNode), nodeLayer->GetNodeNetpoints(curNode), curNode->GetNumNeighbors());
 }
 
-void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes) {
+void QTPFS::PathSearch::IterateNodeNeighbors(INode* const* nxtNodes, const float2* nxtPoints, unsigned int numNxtNodes) {
+	binary_heap<SearchNode*>& openNodes = searchData->openNodes;
+
 	// if curNode equals srcNode, this is just the original srcPoint
-	const float2& curPoint2 = curNode->GetNeighborEdgeTransitionPoint(0);
+	const float2& curPoint2 = curSearchNode->netPoint;
 	const float3  curPoint  = {curPoint2.x, 0.0f, curPoint2.y};
 
-	for (unsigned int i = 0; i < nxtNodes.size(); i++) {
+	for (unsigned int i = 0; i < numNxtNodes; i++) {
 		// NOTE:
 		//   this uses the actual distance that edges of the final path will cover,
 		//   from <curPoint> (initialized to sourcePoint) to a position on the edge
@@ -212,11 +281,13 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		//   nightmare)
 		nxtNode = nxtNodes[i];
 
-		if (nxtNode->AllSquaresImpassable())
+		if (IsImpassable(nxtNode))
 			continue;
 
-		const bool isCurrent = (nxtNode->GetSearchState() >= searchState);
-		const bool isClosed = ((nxtNode->GetSearchState() & 1) == NODE_STATE_CLOSED);
+		SearchNode* nxtSearchNode = searchData->FindNode(nxtNode);
+
+		const bool isCurrent = (nxtSearchNode != nullptr);
+		const bool isClosed = (isCurrent && nxtSearchNode->isClosed);
 		const bool isTarget = (nxtNode == tgtNode);
 
 		unsigned int netPointIdx = 0;
@@ -228,16 +299,16 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 			// to be fancy (note that this is not always the best
 			// option, it causes local and global sub-optimalities
 			// which SmoothPath can only partially address)
-			netPoints[0] = curNode->GetNeighborEdgeTransitionPoint(1 + i);
+			netPoints[0] = nxtPoints[i];
 
 			// cannot use squared-distances because that will bias paths
 			// towards smaller nodes (eg. 1^2 + 1^2 + 1^2 + 1^2 != 4^2)
 			gDists[0] = curPoint.distance({netPoints[0].x, 0.0f, netPoints[0].y});
 			hDists[0] = tgtPoint.distance({netPoints[0].x, 0.0f, netPoints[0].y});
 			gCosts[0] =
-				curNode->GetPathCost(NODE_PATH_COST_G) +
-				curNode->GetMoveCost() * gDists[0] +
-				nxtNode->GetMoveCost() * hDists[0] * int(isTarget);
+				curSearchNode->gCost +
+				GetMoveCost(curNode) * gDists[0] +
+				GetMoveCost(nxtNode) * hDists[0] * int(isTarget);
 			hCosts[0] = hDists[0] * hCostMult * int(!isTarget);
 		}
 		#else
@@ -248,14 +319,14 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		// not handle; more points means a greater degree
 		// of non-cardinality (but gets expensive quickly)
 		for (unsigned int j = 0; j < QTPFS_MAX_NETPOINTS_PER_NODE_EDGE; j++) {
-			netPoints[j] = curNode->GetNeighborEdgeTransitionPoint(1 + i * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE + j);
+			netPoints[j] = nxtPoints[i * QTPFS_MAX_NETPOINTS_PER_NODE_EDGE + j];
 
 			gDists[j] = curPoint.distance({netPoints[j].x, 0.0f, netPoints[j].y});
 			hDists[j] = tgtPoint.distance({netPoints[j].x, 0.0f, netPoints[j].y});
 			gCosts[j] =
-				curNode->GetPathCost(NODE_PATH_COST_G) +
-				curNode->GetMoveCost() * gDists[j] +
-				nxtNode->GetMoveCost() * hDists[j] * int(isTarget);
+				curSearchNode->gCost +
+				GetMoveCost(curNode) * gDists[j] +
+				GetMoveCost(nxtNode) * hDists[j] * int(isTarget);
 			hCosts[j] = hDists[j] * hCostMult * int(!isTarget);
 
 			if ((gCosts[j] + hCosts[j]) < (gCosts[netPointIdx] + hCosts[netPointIdx])) {
@@ -265,9 +336,9 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		#endif
 
 		if (!isCurrent) {
-			UpdateNode(nxtNode, curNode, netPointIdx);
+			UpdateNode(nxtSearchNode = searchData->AddNode(nxtNode), curSearchNode, netPointIdx);
 
-			openNodes.push(nxtNode);
+			openNodes.push(nxtSearchNode);
 			openNodes.check_heap_property(0);
 
 			#ifdef QTPFS_TRACE_PATH_SEARCHES
@@ -276,22 +347,34 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 
 			continue;
 		}
-		if (gCosts[netPointIdx] >= nxtNode->GetPathCost(NODE_PATH_COST_G))
+		if (gCosts[netPointIdx] >= nxtSearchNode->gCost)
 			continue;
 		if (isClosed)
-			openNodes.push(nxtNode);
+			openNodes.push(nxtSearchNode);
 
-		UpdateNode(nxtNode, curNode, netPointIdx);
+		UpdateNode(nxtSearchNode, curSearchNode, netPointIdx);
 
 		// restore ordering in case nxtNode was already open
 		// (changing the f-cost of an OPEN node messes up the
 		// queue's internal consistency; a pushed node remains
 		// OPEN until it gets popped)
-		openNodes.resort(nxtNode);
+		openNodes.resort(nxtSearchNode);
 		openNodes.check_heap_property(0);
 	}
 }
 
+void QTPFS::PathSearch::StorePathNodes(const SearchNode* tgtSearchNode) {
+	pathNodes.clear();
+	pathPoints.clear();
+
+	for (const SearchNode* n = tgtSearchNode; n != nullptr; n = n->prevNode) {
+		pathNodes.push_back(n->node);
+		pathPoints.push_back(n->netPoint);
+	}
+
+	assert(pathNodes.empty() || pathNodes.back() == srcNode);
+}
+
 void QTPFS::PathSearch::Finalize(IPath* path) {
 	TracePath(path);
 
@@ -310,13 +393,14 @@ void QTPFS::PathSearch::TracePath(IPath* path) {
 //	std::deque<float3>::const_iterator pointsIt;
 
 	if (srcNode != tgtNode) {
-		INode* tmpNode = tgtNode;
-		INode* prvNode = tmpNode->GetPrevNode();
-
 		float3 prvPoint = tgtPoint;
 
-		while ((prvNode != nullptr) && (tmpNode != srcNode)) {
-			const float2& tmpPoint2 = tmpNode->GetNeighborEdgeTransitionPoint(0);
+		// walk back from tgtNode, excluding srcNode
+		for (size_t i = 0, n = pathNodes.size() - 1; i < n; i++) {
+			const INode* tmpNode = pathNodes[i    ];
+			const INode* prvNode = pathNodes[i + 1];
+
+			const float2& tmpPoint2 = pathPoints[i];
 			const float3  tmpPoint  = {tmpPoint2.x, 0.0f, tmpPoint2.y};
 
 			assert(!math::isinf(tmpPoint.x) && !math::isinf(tmpPoint.z));
@@ -331,16 +415,7 @@ void QTPFS::PathSearch::TracePath(IPath* path) {
 			if (tmpPoint != prvPoint)
 				points.push_front(tmpPoint);
 
-			#ifndef QTPFS_SMOOTH_PATHS
-			// make sure the back-pointers can never become dangling
-			// (if smoothing IS enabled, we delay this until we reach
-			// SmoothPath() because we still need them there)
-			tmpNode->SetPrevNode(nullptr);
-			#endif
-
 			prvPoint = tmpPoint;
-			tmpNode = prvNode;
-			prvNode = tmpNode->GetPrevNode();
 		}
 	}
 
@@ -366,25 +441,12 @@ void QTPFS::PathSearch::SmoothPath(IPath* path) const {
 	if (path->NumPoints() == 2)
 		return;
 
-	assert(srcNode->GetPrevNode() == NULL);
-
 	for (unsigned int k = 0; k < QTPFS_MAX_SMOOTHING_ITERATIONS; k++) {
 		if (!SmoothPathIter(path)) {
 			// all waypoints stopped moving
 			break;
 		}
 	}
-
-	INode* n0 = tgtNode;
-	INode* n1 = tgtNode;
-
-	while (n1 != srcNode) {
-		n0 = n1;
-		n1 = n0->GetPrevNode();
-
-		// reset back-pointers
-		n0->SetPrevNode(NULL);
-	}
 }
 
 bool QTPFS::PathSearch::SmoothPathIter(IPath* path) const {
@@ -395,12 +457,10 @@ bool QTPFS::PathSearch::SmoothPathIter(IPath* path) const {
 	unsigned int ni = path->NumPoints();
 	unsigned int nm = 0;
 
-	INode* n0 = tgtNode;
-	INode* n1 = tgtNode;
+	for (size_t k = 0, n = pathNodes.size() - 1; k < n; k++) {
+		const INode* n0 = pathNodes[k    ];
+		const INode* n1 = pathNodes[k + 1];
 
-	while (n1 != srcNode) {
-		n0 = n1;
-		n1 = n0->GetPrevNode();
 		ni -= 1;
 
 		assert(n1->GetNeighborRelation(n0) != 0);
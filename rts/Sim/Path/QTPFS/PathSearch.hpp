@@ -10,6 +10,8 @@
 #include "NodeHeap.hpp"
 
 #include "System/float3.h"
+#include "System/Misc/SpringTime.h"
+#include "System/UnorderedMap.hpp"
 
 namespace QTPFS {
 	struct PathCache;
@@ -65,12 +67,65 @@ namespace QTPFS {
 	}
 
 
+	// state of a single node within one search
+	struct SearchNode {
+		bool operator <  (const SearchNode* n) const { return (fCost <  n->fCost); }
+		bool operator >  (const SearchNode* n) const { return (fCost >  n->fCost); }
+		bool operator == (const SearchNode* n) const { return (fCost == n->fCost); }
+		bool operator <= (const SearchNode* n) const { return (fCost <= n->fCost); }
+		bool operator >= (const SearchNode* n) const { return (fCost >= n->fCost); }
+
+		void SetHeapIndex(unsigned int n) { heapIndex = n; }
+		unsigned int GetHeapIndex() const { return heapIndex; }
+		float GetHeapPriority() const { return fCost; }
+
+		void SetPathCosts(float g, float h) { fCost = g + h; gCost = g; hCost = h; }
+
+		INode* node = nullptr;
+		// points back to previous node in path
+		SearchNode* prevNode = nullptr;
+
+		// edge transition-point through which node was entered
+		float2 netPoint;
+
+		float fCost = 0.0f;
+		float gCost = 0.0f;
+		float hCost = 0.0f;
+
+		// NOTE:
+		//     storing the heap-index is an *UGLY* break of abstraction,
+		//     but the only way to keep the cost of resorting acceptable
+		unsigned int heapIndex = -1u;
+
+		bool isClosed = false;
+	};
+
+	// search state owned by one (pool-)thread and re-used by every search it executes
+	struct SearchThreadData {
+		void Reset(unsigned int numLeafNodes);
+
+		// returns nullptr if <node> was not yet reached by the current search
+		SearchNode* FindNode(const INode* node);
+		SearchNode* AddNode(INode* node);
+
+		// all searches executed by this thread share one queue, without clear()'s
+		binary_heap<SearchNode*> openNodes;
+
+		// sparse table, maps the index of a node's top-left square to its slot
+		spring::unordered_map<unsigned int, unsigned int> nodeSlots;
+
+		// slots never move during a search since their number is bounded by
+		// the layer's leaf-count, so the heap can hold pointers into this
+		std::vector<SearchNode> searchNodes;
+
+		unsigned int numUsedSlots = 0;
+	};
+
+
 	// NOTE:
-	//     we could support "time-sliced" execution, but we would have
-	//     to isolate each query from modifying another's INode members
-	//     (*Cost, nodeState, etc.) --> memory-intensive
-	//     also, terrain changes could invalidate partial paths without
-	//     buffering the *entire* heightmap each frame --> not efficient
+	//     we could support "time-sliced" execution, but terrain changes
+	//     could invalidate partial paths without buffering the *entire*
+	//     heightmap each frame --> not efficient
 	// NOTE:
 	//     with time-sliced execution, {src,tgt,cur,nxt}Node can become
 	//     dangling
@@ -79,8 +134,9 @@ namespace QTPFS {
 			: searchID(0)
 			, searchTeam(0)
 			, searchType(pathSearchType)
-			, searchState(0)
 			, searchMagic(0)
+			, searchCaller(0)
+			, numSearchedNodes(0)
 			{}
 		virtual ~IPathSearch() {}
 
@@ -91,10 +147,8 @@ namespace QTPFS {
 			const float3& targetPoint,
 			const SRectangle& searchArea
 		) = 0;
-		virtual bool Execute(
-			unsigned int searchStateOffset = 0,
-			unsigned int searchMagicNumber = 0
-		) = 0;
+		// NOTE: may be called concurrently for searches on the same layer
+		virtual bool Execute(unsigned int searchMagicNumber = 0) = 0;
 		virtual void Finalize(IPath* path) = 0;
 		virtual bool SharedFinalize(const IPath* srcPath, IPath* dstPath) { return false; }
 		virtual PathSearchTrace::Execution* GetExecutionTrace() { return NULL; }
@@ -103,16 +157,26 @@ namespace QTPFS {
 
 		void SetID(unsigned int n) { searchID = n; }
 		void SetTeam(unsigned int n) { searchTeam = n; }
+		void SetCaller(unsigned int n) { searchCaller = n; }
+		void SetExecTime(spring_time t) { execTime = t; }
 		unsigned int GetID() const { return searchID; }
 		unsigned int GetTeam() const { return searchTeam; }
+		unsigned int GetCaller() const { return searchCaller; }
+		unsigned int GetNumSearchedNodes() const { return numSearchedNodes; }
+		spring_time GetExecTime() const { return execTime; }
 
 	protected:
 		unsigned int searchID;     // links us to the temp-path that this search will finalize
 		unsigned int searchTeam;   // which team queued this search
 
 		unsigned int searchType;   // indicates if Dijkstra (h==0) or A* (h!=0) search is employed
-		unsigned int searchState;  // offset that identifies nodes as part of current search
 		unsigned int searchMagic;  // used to signal nodes they should update their neighbor-set
+
+		// telemetry only, see PathTelemetry
+		unsigned int searchCaller;
+		unsigned int numSearchedNodes;
+
+		spring_time execTime;
 	};
 
 
@@ -128,11 +192,15 @@ namespace QTPFS {
 			, curNode(NULL)
 			, nxtNode(NULL)
 			, minNode(NULL)
+			, searchData(NULL)
+			, curSearchNode(NULL)
+			, minSearchNode(NULL)
 			, hCostMult(0.0f)
 			, haveFullPath(false)
 			, havePartPath(false)
+			, srcNodeBlocked(false)
 			{}
-		~PathSearch() { openNodes.reset(); }
+		~PathSearch() {}
 
 		void Initialize(
 			NodeLayer* layer,
@@ -141,33 +209,33 @@ namespace QTPFS {
 			const float3& targetPoint,
 			const SRectangle& searchArea
 		) override;
-		bool Execute(
-			unsigned int searchStateOffset = 0,
-			unsigned int searchMagicNumber = 0
-		) override;
+		bool Execute(unsigned int searchMagicNumber = 0) override;
 		void Finalize(IPath* path) override;
 		bool SharedFinalize(const IPath* srcPath, IPath* dstPath) override;
 		PathSearchTrace::Execution* GetExecutionTrace() override { return searchExec; }
 
 		const std::uint64_t GetHash(std::uint64_t N, std::uint32_t k) const override;
 
-		static void InitGlobalQueue(unsigned int n) { openNodes.reserve(n); }
-		static void FreeGlobalQueue() { openNodes.clear(); }
+		static void InitThreadData();
+		static void FreeThreadData();
 
 	private:
 		void ResetState(INode* node);
-		void UpdateNode(INode* nextNode, INode* prevNode, unsigned int netPointIdx);
+		void UpdateNode(SearchNode* nextNode, SearchNode* prevNode, unsigned int netPointIdx);
 
 		void IterateNodes(const std::vector<INode*>& allNodes);
-		void IterateNodeNeighbors(const std::vector<INode*>& nxtNodes);
+		void IterateNodeNeighbors(INode* const* nxtNodes, const float2* nxtPoints, unsigned int numNxtNodes);
+
+		void StorePathNodes(const SearchNode* tgtSearchNode);
 
 		void TracePath(IPath* path);
 		void SmoothPath(IPath* path) const;
 		bool SmoothPathIter(IPath* path) const;
 
-		// global queue: allocated once, re-used by all searches without clear()'s
-		// this relies on INode::operator< to sort the INode*'s by increasing f-cost
-		static binary_heap<INode*> openNodes;
+		// the source-node may be impassable, in which case it is treated
+		// as free of cost for this search only (without modifying it)
+		bool IsImpassable(const INode* node) const { return (node != srcNode && node->AllSquaresImpassable()); }
+		float GetMoveCost(const INode* node) const { return ((node == srcNode && srcNodeBlocked)? 0.0f: node->GetMoveCost()); }
 
 		NodeLayer* nodeLayer;
 		PathCache* pathCache;
@@ -182,6 +250,17 @@ namespace QTPFS {
 		INode *curNode, *nxtNode;
 		INode *minNode;
 
+		// owned by the thread executing us, only valid during Execute
+		SearchThreadData* searchData;
+
+		SearchNode *curSearchNode;
+		SearchNode *minSearchNode;
+
+		// {tgt,...,src}Node and their transition-points; filled in
+		// by Execute s.t. Finalize does not depend on searchData
+		std::vector<INode*> pathNodes;
+		std::vector<float2> pathPoints;
+
 		float3 srcPoint;
 		float3 tgtPoint;
 
@@ -196,6 +275,7 @@ namespace QTPFS {
 
 		bool haveFullPath;
 		bool havePartPath;
+		bool srcNodeBlocked;
 	};
 }
 
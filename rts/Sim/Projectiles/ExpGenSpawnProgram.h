@@ -0,0 +1,383 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef EXP_GEN_SPAWN_PROGRAM_H
+#define EXP_GEN_SPAWN_PROGRAM_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <cinttypes>
+#include <vector>
+
+#include "System/float3.h"
+#include "System/SafeUtil.h"
+
+// flat program of typed operations that initializes the members of one
+// CEG spawnable, compiled once (at CEG load-time) from the byte-code
+// emitted by CCustomExplosionGenerator::ParseExplosionCode
+//
+// all terms that do not depend on randomness, damage or spawn-index are
+// folded into constant stores; the values written and the sequence of
+// random numbers drawn are exactly those of the byte-code interpreter
+class CExpGenSpawnProgram {
+public:
+	// byte-code op-codes
+	enum {
+		OP_END      =  0,
+		OP_STOREI   =  1, // int
+		OP_STOREF   =  2, // float
+		OP_ADD      =  4,
+		OP_RAND     =  5,
+		OP_DAMAGE   =  6,
+		OP_INDEX    =  7,
+		OP_LOADP    =  8, // load a void* into the pointer register
+		OP_STOREP   =  9, // store the pointer register into a void*
+		OP_DIR      = 10, // store the float3 direction
+		OP_SAWTOOTH = 11, // Performs a modulo to create a sawtooth wave
+		OP_DISCRETE = 12, // Floors the value to a multiple of its parameter
+		OP_SINE     = 13, // Uses val as the phase of a sine wave
+		OP_YANK     = 14, // Moves the input value into a buffer, returns zero
+		OP_MULTIPLY = 15, // Multiplies with buffer value
+		OP_ADDBUFF  = 16, // Adds buffer value
+		OP_POW      = 17, // Power with code as exponent
+		OP_POWBUFF  = 18, // Power with buffer as exponent
+	};
+
+	// parser clamps buffer indices to [0, 16]
+	static constexpr unsigned int NUM_BUFFER_SLOTS = 17;
+
+private:
+	// compiled op-codes
+	enum {
+		EXEC_LOADK,
+		EXEC_ADDK,
+		EXEC_MULK,
+		EXEC_POWK,
+		EXEC_RAND,
+		EXEC_DAMAGE,
+		EXEC_INDEX,
+		EXEC_SAWTOOTH,
+		EXEC_DISCRETE,
+		EXEC_SINE,
+		EXEC_YANK,
+		EXEC_MULBUF,
+		EXEC_ADDBUF,
+		EXEC_POWBUF,
+		EXEC_STORE_I8,
+		EXEC_STORE_I16,
+		EXEC_STORE_I32,
+		EXEC_STORE_I64,
+		EXEC_STORE_F32,
+		EXEC_STORE_F64,
+		EXEC_STOREK_I8,
+		EXEC_STOREK_I16,
+		EXEC_STOREK_I32,
+		EXEC_STOREK_I64,
+		EXEC_STOREK_F32,
+		EXEC_STOREK_F64,
+		EXEC_STOREP,
+		EXEC_DIR,
+	};
+
+	struct Op {
+		std::uint8_t code;
+		std::uint8_t slot;
+		std::uint16_t offset;
+
+		union {
+			float f;
+			std::int32_t i;
+			void* p;
+		} arg;
+	};
+
+public:
+	void Compile(const char* code) {
+		// state of the interpreter's registers as far as it is known
+		// at compile-time; the buffer starts out zero-filled
+		float val = 0.0f;
+		float buffer[NUM_BUFFER_SLOTS] = {0.0f};
+		void* ptr = nullptr;
+
+		bool valKnown = true;
+		bool bufferKnown[NUM_BUFFER_SLOTS];
+
+		std::fill(&bufferKnown[0], &bufferKnown[0] + NUM_BUFFER_SLOTS, true);
+
+		// whether the run-time val-register holds <val>; while val is known
+		// the register is always zero since every op that makes val known
+		// again (store, yank) also zeroes it at run-time
+		bool valSynced = true;
+
+		ops.clear();
+
+		const auto ReadF = [&]() { float v; std::memcpy(&v, code, sizeof(v)); code += sizeof(v); return v; };
+		const auto ReadI = [&]() { std::int32_t v; std::memcpy(&v, code, sizeof(v)); code += sizeof(v); return v; };
+		const auto ReadU8 = [&]() { std::uint8_t v; std::memcpy(&v, code, sizeof(v)); code += sizeof(v); return v; };
+		const auto ReadU16 = [&]() { std::uint16_t v; std::memcpy(&v, code, sizeof(v)); code += sizeof(v); return v; };
+		const auto ReadP = [&]() { void* v; std::memcpy(&v, code, sizeof(v)); code += sizeof(v); return v; };
+
+		const auto AddOp = [&](std::uint8_t c, std::uint16_t offset, std::uint8_t slot) -> Op& {
+			ops.emplace_back();
+			ops.back().code = c;
+			ops.back().slot = slot;
+			ops.back().offset = offset;
+			ops.back().arg.p = nullptr;
+			return ops.back();
+		};
+		// materializes the folded value before an op that reads val at run-time
+		const auto SyncVal = [&]() {
+			if (!valKnown || valSynced)
+				return;
+
+			AddOp(EXEC_LOADK, 0, 0).arg.f = val;
+			valSynced = true;
+		};
+		const auto AddValOp = [&](std::uint8_t c, float k) {
+			SyncVal();
+			AddOp(c, 0, 0).arg.f = k;
+			valKnown = false;
+		};
+
+		for (;;) {
+			switch (*(code++)) {
+				case OP_END: {
+					return;
+				}
+				case OP_STOREI: {
+					const std::uint8_t size = ReadU8();
+					const std::uint16_t offset = ReadU16();
+
+					// unknown sizes store nothing but still reset val like the
+					// interpreter; the register is already zero if val is known
+					if (size != 1 && size != 2 && size != 4 && size != 8) {
+						if (!valKnown)
+							AddOp(EXEC_LOADK, 0, 0).arg.f = 0.0f;
+
+						val = 0.0f;
+						valKnown = true;
+						valSynced = true;
+						break;
+					}
+
+					const std::uint8_t sizeIdx = (size == 1)? 0: ((size == 2)? 1: ((size == 4)? 2: 3));
+
+					if (valKnown) {
+						AddOp(EXEC_STOREK_I8 + sizeIdx, offset, 0).arg.i = (int) val;
+					} else {
+						AddOp(EXEC_STORE_I8 + sizeIdx, offset, 0);
+					}
+
+					val = 0.0f;
+					valKnown = true;
+					valSynced = true;
+				} break;
+				case OP_STOREF: {
+					const std::uint8_t size = ReadU8();
+					const std::uint16_t offset = ReadU16();
+
+					if (size != 4 && size != 8) {
+						if (!valKnown)
+							AddOp(EXEC_LOADK, 0, 0).arg.f = 0.0f;
+
+						val = 0.0f;
+						valKnown = true;
+						valSynced = true;
+						break;
+					}
+
+					if (valKnown) {
+						AddOp((size == 4)? EXEC_STOREK_F32: EXEC_STOREK_F64, offset, 0).arg.f = val;
+					} else {
+						AddOp((size == 4)? EXEC_STORE_F32: EXEC_STORE_F64, offset, 0);
+					}
+
+					val = 0.0f;
+					valKnown = true;
+					valSynced = true;
+				} break;
+
+				case OP_ADD: {
+					const float k = ReadF();
+
+					if (valKnown) {
+						val += k;
+						valSynced = false;
+					} else {
+						AddOp(EXEC_ADDK, 0, 0).arg.f = k;
+					}
+				} break;
+				case OP_RAND  : { AddValOp(EXEC_RAND  , ReadF()); } break;
+				case OP_DAMAGE: { AddValOp(EXEC_DAMAGE, ReadF()); } break;
+				case OP_INDEX : { AddValOp(EXEC_INDEX , ReadF()); } break;
+
+				case OP_LOADP: {
+					ptr = ReadP();
+				} break;
+				case OP_STOREP: {
+					AddOp(EXEC_STOREP, ReadU16(), 0).arg.p = ptr;
+					ptr = nullptr;
+				} break;
+
+				case OP_DIR: {
+					AddOp(EXEC_DIR, ReadU16(), 0);
+				} break;
+
+				case OP_SAWTOOTH: {
+					const float k = ReadF();
+
+					if (valKnown) {
+						val -= k * math::floor(val / k);
+						valSynced = false;
+					} else {
+						AddOp(EXEC_SAWTOOTH, 0, 0).arg.f = k;
+					}
+				} break;
+				case OP_DISCRETE: {
+					const float k = ReadF();
+
+					if (valKnown) {
+						val = k * math::floor(spring::SafeDivide(val, k));
+						valSynced = false;
+					} else {
+						AddOp(EXEC_DISCRETE, 0, 0).arg.f = k;
+					}
+				} break;
+				case OP_SINE: {
+					const float k = ReadF();
+
+					if (valKnown) {
+						val = k * math::sin(val);
+						valSynced = false;
+					} else {
+						AddOp(EXEC_SINE, 0, 0).arg.f = k;
+					}
+				} break;
+				case OP_POW: {
+					const float k = ReadF();
+
+					if (valKnown) {
+						val = math::pow(val, k);
+						valSynced = false;
+					} else {
+						AddOp(EXEC_POWK, 0, 0).arg.f = k;
+					}
+				} break;
+
+				case OP_YANK: {
+					const std::int32_t slot = ReadI();
+
+					if ((bufferKnown[slot] = valKnown)) {
+						buffer[slot] = val;
+					} else {
+						AddOp(EXEC_YANK, 0, slot);
+					}
+
+					val = 0.0f;
+					valKnown = true;
+					valSynced = true;
+				} break;
+				case OP_MULTIPLY: {
+					const std::int32_t slot = ReadI();
+
+					if (valKnown && bufferKnown[slot]) {
+						val *= buffer[slot];
+						valSynced = false;
+					} else if (bufferKnown[slot]) {
+						AddOp(EXEC_MULK, 0, 0).arg.f = buffer[slot];
+					} else {
+						SyncVal();
+						AddOp(EXEC_MULBUF, 0, slot);
+						valKnown = false;
+					}
+				} break;
+				case OP_ADDBUFF: {
+					const std::int32_t slot = ReadI();
+
+					if (valKnown && bufferKnown[slot]) {
+						val += buffer[slot];
+						valSynced = false;
+					} else if (bufferKnown[slot]) {
+						AddOp(EXEC_ADDK, 0, 0).arg.f = buffer[slot];
+					} else {
+						SyncVal();
+						AddOp(EXEC_ADDBUF, 0, slot);
+						valKnown = false;
+					}
+				} break;
+				case OP_POWBUFF: {
+					const std::int32_t slot = ReadI();
+
+					if (valKnown && bufferKnown[slot]) {
+						val = math::pow(val, buffer[slot]);
+						valSynced = false;
+					} else if (bufferKnown[slot]) {
+						AddOp(EXEC_POWK, 0, 0).arg.f = buffer[slot];
+					} else {
+						SyncVal();
+						AddOp(EXEC_POWBUF, 0, slot);
+						valKnown = false;
+					}
+				} break;
+
+				default: {
+					assert(false);
+				} break;
+			}
+		}
+	}
+
+	template<typename RNG>
+	void Execute(char* instance, float damage, int spawnIndex, const float3& dir, RNG& rng) const {
+		float val = 0.0f;
+		float buffer[NUM_BUFFER_SLOTS];
+
+		for (const Op& op: ops) {
+			switch (op.code) {
+				case EXEC_LOADK   : { val  = op.arg.f;                         } break;
+				case EXEC_ADDK    : { val += op.arg.f;                         } break;
+				case EXEC_MULK    : { val *= op.arg.f;                         } break;
+				case EXEC_POWK    : { val  = math::pow(val, op.arg.f);         } break;
+				case EXEC_RAND    : { val += rng.NextFloat() * op.arg.f;       } break;
+				case EXEC_DAMAGE  : { val += damage * op.arg.f;                } break;
+				case EXEC_INDEX   : { val += spawnIndex * op.arg.f;            } break;
+				case EXEC_SAWTOOTH: { val -= op.arg.f * math::floor(val / op.arg.f); } break;
+				case EXEC_DISCRETE: { val  = op.arg.f * math::floor(spring::SafeDivide(val, op.arg.f)); } break;
+				case EXEC_SINE    : { val  = op.arg.f * math::sin(val);        } break;
+
+				case EXEC_YANK    : { buffer[op.slot] = val; val = 0.0f;       } break;
+				case EXEC_MULBUF  : { val *= buffer[op.slot];                  } break;
+				case EXEC_ADDBUF  : { val += buffer[op.slot];                  } break;
+				case EXEC_POWBUF  : { val  = math::pow(val, buffer[op.slot]);  } break;
+
+				case EXEC_STORE_I8 : { *(std::int8_t* ) (instance + op.offset) = (int) val; val = 0.0f; } break;
+				case EXEC_STORE_I16: { *(std::int16_t*) (instance + op.offset) = (int) val; val = 0.0f; } break;
+				case EXEC_STORE_I32: { *(std::int32_t*) (instance + op.offset) = (int) val; val = 0.0f; } break;
+				case EXEC_STORE_I64: { *(std::int64_t*) (instance + op.offset) = (int) val; val = 0.0f; } break;
+				case EXEC_STORE_F32: { *(float* ) (instance + op.offset) = val; val = 0.0f; } break;
+				case EXEC_STORE_F64: { *(double*) (instance + op.offset) = val; val = 0.0f; } break;
+
+				case EXEC_STOREK_I8 : { *(std::int8_t* ) (instance + op.offset) = op.arg.i; } break;
+				case EXEC_STOREK_I16: { *(std::int16_t*) (instance + op.offset) = op.arg.i; } break;
+				case EXEC_STOREK_I32: { *(std::int32_t*) (instance + op.offset) = op.arg.i; } break;
+				case EXEC_STOREK_I64: { *(std::int64_t*) (instance + op.offset) = op.arg.i; } break;
+				case EXEC_STOREK_F32: { *(float* ) (instance + op.offset) = op.arg.f; } break;
+				case EXEC_STOREK_F64: { *(double*) (instance + op.offset) = op.arg.f; } break;
+
+				case EXEC_STOREP: { *(void**) (instance + op.offset) = op.arg.p; } break;
+				case EXEC_DIR   : { *reinterpret_cast<float3*>(instance + op.offset) = dir; } break;
+
+				default: {
+					assert(false);
+				} break;
+			}
+		}
+	}
+
+	size_t GetNumOps() const { return ops.size(); }
+
+private:
+	std::vector<Op> ops;
+};
+
+#endif
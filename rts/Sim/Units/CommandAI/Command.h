@@ -6,6 +6,7 @@
 #include <string>
 #include <climits> // INT_MAX
 #include <cstring> // memset
+#include <utility> // std::move
 
 #include "System/creg/creg_cond.h"
 #include "System/float3.h"
@@ -164,6 +165,9 @@ public:
 	Command(const Command& c) {
 		*this = c;
 	}
+	Command(Command&& c) noexcept {
+		*this = std::move(c);
+	}
 
 	Command& operator = (const Command& c) {
 		memcpy(&id[0], &c.id[0], sizeof(id));
@@ -172,6 +176,7 @@ public:
 		CopyParams(c);
 		return *this;
 	}
+	Command& operator = (Command&& c) noexcept;
 
 	Command(const float3& pos) {
 		memset(&params[0], 0, sizeof(params));
@@ -31,7 +31,6 @@
 #include "System/SafeUtil.h"
 #include "System/StringUtil.h"
 #include "System/creg/STL_Set.h"
-#include "System/creg/STL_Deque.h"
 #include <assert.h>
 
 // number of SlowUpdate calls that a target (unit) must
@@ -53,7 +52,9 @@ CR_BIND(CCommandQueue, )
 CR_REG_METADATA(CCommandQueue, (
 	CR_MEMBER(queue),
 	CR_MEMBER(queueType),
-	CR_MEMBER(tagCounter)
+	CR_MEMBER(tagCounter),
+	CR_MEMBER(headIndex),
+	CR_MEMBER(numCommands)
 ))
 
 CR_BIND_DERIVED(CCommandAI, CObject, )
@@ -757,6 +758,17 @@ void CCommandAI::GiveCommand(const Command& c, int playerNum, bool fromSynced, b
 	GiveCommandReal(c, fromSynced); // send to the sub-classes
 }
 
+void CCommandAI::GiveCommands(const Command* cmds, size_t numCmds, int playerNum, bool fromSynced, bool fromLua)
+{
+	// each command can still be rejected, cancel others or clear the
+	// queue; reserving only saves the per-command regrowth on appends
+	commandQue.reserve(commandQue.size() + numCmds);
+
+	for (size_t i = 0; i < numCmds; i++) {
+		GiveCommand(cmds[i], playerNum, fromSynced, fromLua);
+	}
+}
+
 
 void CCommandAI::GiveCommandReal(const Command& c, bool fromSynced)
 {
@@ -41,6 +41,8 @@ public:
 	// these both feed into GiveCommandReal()
 	void GiveCommand(const Command& c,                bool fromSynced = true              ); // sim
 	void GiveCommand(const Command& c, int playerNum, bool fromSynced       , bool fromLua); // net,Lua
+	// batched form of the above, grows the queue at most once per batch
+	void GiveCommands(const Command* cmds, size_t numCmds, int playerNum, bool fromSynced, bool fromLua);
 
 	void ClearTargetLock(const Command& fc);
 	void WeaponFired(CWeapon* weapon, const bool searchForNewTarget);
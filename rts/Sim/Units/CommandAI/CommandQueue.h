@@ -3,10 +3,76 @@
 #ifndef _COMMAND_QUEUE_H
 #define _COMMAND_QUEUE_H
 
-#include <deque>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
 #include "Command.h"
 
-/// A wrapper class for std::deque<Command> to keep track of commands
+class CCommandQueue;
+
+/// random-access iterator over a CCommandQueue, addresses commands by
+/// their logical index (0 is front) rather than by raw buffer position
+template<typename Q, typename T> class CCommandQueueIterator {
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef T value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef T* pointer;
+		typedef T& reference;
+
+		CCommandQueueIterator(): queue(nullptr), index(0) {}
+		CCommandQueueIterator(Q* q, std::ptrdiff_t i): queue(q), index(i) {}
+
+		// iterator to const_iterator
+		template<typename Q2, typename T2>
+		CCommandQueueIterator(const CCommandQueueIterator<Q2, T2>& it): queue(it.queue), index(it.index) {}
+
+		reference operator * () const { return (*queue)[index]; }
+		pointer operator -> () const { return &(*queue)[index]; }
+		reference operator [] (difference_type n) const { return (*queue)[index + n]; }
+
+		CCommandQueueIterator& operator ++ () { ++index; return *this; }
+		CCommandQueueIterator& operator -- () { --index; return *this; }
+		CCommandQueueIterator operator ++ (int) { CCommandQueueIterator it = *this; ++index; return it; }
+		CCommandQueueIterator operator -- (int) { CCommandQueueIterator it = *this; --index; return it; }
+
+		CCommandQueueIterator& operator += (difference_type n) { index += n; return *this; }
+		CCommandQueueIterator& operator -= (difference_type n) { index -= n; return *this; }
+
+		CCommandQueueIterator operator + (difference_type n) const { return {queue, index + n}; }
+		CCommandQueueIterator operator - (difference_type n) const { return {queue, index - n}; }
+
+		friend CCommandQueueIterator operator + (difference_type n, const CCommandQueueIterator& it) { return (it + n); }
+
+		template<typename Q2, typename T2>
+		difference_type operator - (const CCommandQueueIterator<Q2, T2>& it) const { return (index - it.index); }
+
+		template<typename Q2, typename T2> bool operator == (const CCommandQueueIterator<Q2, T2>& it) const { return (index == it.index); }
+		template<typename Q2, typename T2> bool operator != (const CCommandQueueIterator<Q2, T2>& it) const { return (index != it.index); }
+		template<typename Q2, typename T2> bool operator <  (const CCommandQueueIterator<Q2, T2>& it) const { return (index <  it.index); }
+		template<typename Q2, typename T2> bool operator >  (const CCommandQueueIterator<Q2, T2>& it) const { return (index >  it.index); }
+		template<typename Q2, typename T2> bool operator <= (const CCommandQueueIterator<Q2, T2>& it) const { return (index <= it.index); }
+		template<typename Q2, typename T2> bool operator >= (const CCommandQueueIterator<Q2, T2>& it) const { return (index >= it.index); }
+
+	public:
+		Q* queue;
+		std::ptrdiff_t index;
+};
+
+
+/// A ring-buffer of Command's (power-of-two capacity) that keeps track of tags;
+/// parameters stay inline up to MAX_COMMAND_PARAMS, so walking a queue of build
+/// or move orders touches a single contiguous allocation
+///
+/// unlike the std::deque this used to wrap, growing the buffer invalidates
+/// references to queued commands; push_* and insert copy their argument first
+/// so (re)queueing a command that lives in the same queue is safe, but anything
+/// else read from such a reference (e.g. front()) must be copied before pushing
 class CCommandQueue {
 
 	friend class CCommandAI;
@@ -28,17 +94,20 @@ class CCommandQueue {
 		/// limit to a float's integer range
 		static const int maxTagValue = (1 << 24); // 16777216
 
-		typedef std::deque<Command> basis;
+		typedef std::size_t size_type;
 
-		typedef basis::size_type              size_type;
-		typedef basis::iterator               iterator;
-		typedef basis::const_iterator         const_iterator;
-		typedef basis::reverse_iterator       reverse_iterator;
-		typedef basis::const_reverse_iterator const_reverse_iterator;
+		typedef CCommandQueueIterator<      CCommandQueue,       Command> iterator;
+		typedef CCommandQueueIterator<const CCommandQueue, const Command> const_iterator;
+		typedef std::reverse_iterator<iterator>                           reverse_iterator;
+		typedef std::reverse_iterator<const_iterator>                     const_reverse_iterator;
 
-		inline bool empty() const { return queue.empty(); }
+		inline bool empty() const { return (numCommands == 0); }
 
-		inline size_type size() const { return queue.size(); }
+		inline size_type size() const { return numCommands; }
+		inline size_type capacity() const { return queue.size(); }
+
+		/// grows the buffer once ahead of a batch of push_back's
+		inline void reserve(size_type n);
 
 		inline void push_back(const Command& cmd);
 		inline void push_front(const Command& cmd);
@@ -47,49 +116,52 @@ class CCommandQueue {
 
 		inline void pop_back()
 		{
-			queue.pop_back();
+			assert(!empty());
+			// reset the slot so its pooled parameters (if any) are released now
+			Slot(--numCommands) = Command();
 		}
 		inline void pop_front()
 		{
-			queue.pop_front();
+			assert(!empty());
+			Slot(0) = Command();
+			headIndex = (headIndex + 1) & (capacity() - 1);
+			numCommands -= 1;
 		}
 
 		inline iterator erase(iterator pos)
 		{
-			return queue.erase(pos);
-		}
-		inline iterator erase(iterator first, iterator last)
-		{
-			return queue.erase(first, last);
+			return (erase(pos, pos + 1));
 		}
+		inline iterator erase(iterator first, iterator last);
 		inline void clear()
 		{
-			queue.clear();
+			erase(begin(), end());
+			headIndex = 0;
 		}
 
-		inline iterator       end()         { return queue.end(); }
-		inline const_iterator end()   const { return queue.end(); }
-		inline iterator       begin()       { return queue.begin(); }
-		inline const_iterator begin() const { return queue.begin(); }
+		inline iterator       end()         { return {this, std::ptrdiff_t(numCommands)}; }
+		inline const_iterator end()   const { return {this, std::ptrdiff_t(numCommands)}; }
+		inline iterator       begin()       { return {this, 0}; }
+		inline const_iterator begin() const { return {this, 0}; }
 
-		inline reverse_iterator       rend()         { return queue.rend(); }
-		inline const_reverse_iterator rend()   const { return queue.rend(); }
-		inline reverse_iterator       rbegin()       { return queue.rbegin(); }
-		inline const_reverse_iterator rbegin() const { return queue.rbegin(); }
+		inline reverse_iterator       rend()         { return reverse_iterator(begin()); }
+		inline const_reverse_iterator rend()   const { return const_reverse_iterator(begin()); }
+		inline reverse_iterator       rbegin()       { return reverse_iterator(end()); }
+		inline const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
 
-		inline       Command& back()        { return queue.back(); }
-		inline const Command& back()  const { return queue.back(); }
-		inline       Command& front()       { return queue.front(); }
-		inline const Command& front() const { return queue.front(); }
+		inline       Command& back()        { return Slot(numCommands - 1); }
+		inline const Command& back()  const { return Slot(numCommands - 1); }
+		inline       Command& front()       { return Slot(0); }
+		inline const Command& front() const { return Slot(0); }
 
-		inline       Command& at(size_type i)       { return queue.at(i); }
-		inline const Command& at(size_type i) const { return queue.at(i); }
+		inline       Command& at(size_type i)       { return (CheckIndex(i), Slot(i)); }
+		inline const Command& at(size_type i) const { return (CheckIndex(i), Slot(i)); }
 
-		inline       Command& operator[](size_type i)       { return queue[i]; }
-		inline const Command& operator[](size_type i) const { return queue[i]; }
+		inline       Command& operator[](size_type i)       { return Slot(i); }
+		inline const Command& operator[](size_type i) const { return Slot(i); }
 
 	private:
-		CCommandQueue() : queueType(CommandQueueType), tagCounter(0) {};
+		CCommandQueue() : queueType(CommandQueueType), tagCounter(0), headIndex(0), numCommands(0) {};
 		CCommandQueue(const CCommandQueue&);
 		CCommandQueue& operator=(const CCommandQueue&);
 
@@ -97,10 +169,24 @@ class CCommandQueue {
 		inline int GetNextTag();
 		inline void SetQueueType(QueueType type) { queueType = type; }
 
+		inline       Command& Slot(size_type i)       { return queue[(headIndex + i) & (capacity() - 1)]; }
+		inline const Command& Slot(size_type i) const { return queue[(headIndex + i) & (capacity() - 1)]; }
+
+		inline void CheckIndex(size_type i) const {
+			if (i >= numCommands)
+				throw std::out_of_range("CCommandQueue::at");
+		}
+
+		inline void Grow(size_type minCapacity);
+
 	private:
-		std::deque<Command> queue;
+		/// ring-storage; capacity is always zero or a power of two
+		std::vector<Command> queue;
 		QueueType queueType;
 		int tagCounter;
+
+		unsigned int headIndex;
+		unsigned int numCommands;
 };
 
 
@@ -114,25 +200,120 @@ inline int CCommandQueue::GetNextTag()
 }
 
 
+inline void CCommandQueue::Grow(size_type minCapacity)
+{
+	size_type newCapacity = std::max(capacity(), size_type(16));
+
+	while (newCapacity < minCapacity)
+		newCapacity <<= 1;
+
+	if (newCapacity == capacity())
+		return;
+
+	std::vector<Command> newQueue(newCapacity);
+
+	// linearize; Command's move-ctor hands over pooled parameter pages
+	for (size_type i = 0; i < numCommands; i++) {
+		newQueue[i] = std::move(Slot(i));
+	}
+
+	queue.swap(newQueue);
+	headIndex = 0;
+}
+
+
+inline void CCommandQueue::reserve(size_type n)
+{
+	if (n > capacity())
+		Grow(n);
+}
+
+
 inline void CCommandQueue::push_back(const Command& cmd)
 {
-	queue.push_back(cmd);
-	queue.back().SetTag(GetNextTag());
+	Command tmpCmd = cmd;
+	tmpCmd.SetTag(GetNextTag());
+
+	reserve(numCommands + 1);
+	Slot(numCommands++) = std::move(tmpCmd);
 }
 
 
 inline void CCommandQueue::push_front(const Command& cmd)
 {
-	queue.push_front(cmd);
-	queue.front().SetTag(GetNextTag());
+	Command tmpCmd = cmd;
+	tmpCmd.SetTag(GetNextTag());
+
+	reserve(numCommands + 1);
+	headIndex = (headIndex - 1) & (capacity() - 1);
+	numCommands += 1;
+	Slot(0) = std::move(tmpCmd);
 }
 
 
 inline CCommandQueue::iterator CCommandQueue::insert(iterator pos, const Command& cmd)
 {
+	const size_type idx = pos.index;
+
 	Command tmpCmd = cmd;
 	tmpCmd.SetTag(GetNextTag());
-	return queue.insert(pos, tmpCmd);
+
+	assert(idx <= numCommands);
+	reserve(numCommands + 1);
+
+	// open the gap by shifting whichever side of it is shorter
+	if (idx < (numCommands >> 1)) {
+		headIndex = (headIndex - 1) & (capacity() - 1);
+		numCommands += 1;
+
+		for (size_type i = 0; i < idx; i++) {
+			Slot(i) = std::move(Slot(i + 1));
+		}
+	} else {
+		numCommands += 1;
+
+		for (size_type i = numCommands - 1; i > idx; i--) {
+			Slot(i) = std::move(Slot(i - 1));
+		}
+	}
+
+	Slot(idx) = std::move(tmpCmd);
+	return {this, std::ptrdiff_t(idx)};
+}
+
+
+inline CCommandQueue::iterator CCommandQueue::erase(iterator first, iterator last)
+{
+	const size_type idx = first.index;
+	const size_type num = last.index - first.index;
+
+	assert(idx + num <= numCommands);
+
+	if (num == 0)
+		return first;
+
+	// close the gap by shifting whichever side of it is shorter; vacated
+	// slots are reset so that pooled parameter pages are released at once
+	if (idx < (numCommands - idx - num)) {
+		for (size_type i = idx; i > 0; i--) {
+			Slot(i - 1 + num) = std::move(Slot(i - 1));
+		}
+		for (size_type i = 0; i < num; i++) {
+			Slot(i) = Command();
+		}
+
+		headIndex = (headIndex + num) & (capacity() - 1);
+	} else {
+		for (size_type i = idx; i < (numCommands - num); i++) {
+			Slot(i) = std::move(Slot(i + num));
+		}
+		for (size_type i = numCommands - num; i < numCommands; i++) {
+			Slot(i) = Command();
+		}
+	}
+
+	numCommands -= num;
+	return {this, std::ptrdiff_t(idx)};
 }
 
 
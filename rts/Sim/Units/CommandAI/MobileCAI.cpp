@@ -540,11 +540,14 @@ void CMobileCAI::ExecuteFight(Command& c)
 		CUnit* enemy = CGameHelper::GetClosestValidTarget(curPosOnLine, searchRadius, owner->allyteam, this);
 
 		if (enemy != nullptr) {
+			// <c> is the queue's front, pushing can grow (and move) the queue
+			const unsigned char opts = c.GetOpts();
+
 			PushOrUpdateReturnFight();
 
 			// make the attack-command inherit <c>'s options
 			// NOTE: see AirCAI::ExecuteFight why we do not set INTERNAL_ORDER
-			commandQue.push_front(Command(CMD_ATTACK, c.GetOpts(), enemy->id));
+			commandQue.push_front(Command(CMD_ATTACK, opts, enemy->id));
 
 			inCommand = false;
 			tempOrder = true;
@@ -1784,6 +1787,8 @@ void CMobileCAI::UnloadUnits_Drop(Command& c)
 	std::vector<float3> dropSpots;
 
 	const bool canUnload = FindEmptyDropSpots(startingDropPos, startingDropPos + approachVector * std::max(16.0f, c.GetParam(3)), dropSpots);
+	// <c> is popped here and its slot may move once the queue grows
+	const unsigned char opts = c.GetOpts();
 
 	StopMoveAndFinishCommand();
 
@@ -1792,7 +1797,7 @@ void CMobileCAI::UnloadUnits_Drop(Command& c)
 		auto di = dropSpots.rbegin();
 
 		for (; ti != transportees.end() && di != dropSpots.rend(); ++ti, ++di) {
-			commandQue.push_front(Command(CMD_UNLOAD_UNIT, c.GetOpts() | INTERNAL_ORDER, *di));
+			commandQue.push_front(Command(CMD_UNLOAD_UNIT, opts | INTERNAL_ORDER, *di));
 		}
 
 		SlowUpdate();
@@ -656,16 +656,6 @@ void CUnit::Update()
 	outOfMapTime *= (!pos.IsInBounds());
 }
 
-void CUnit::UpdateWeapons()
-{
-	if (!CanUpdateWeapons())
-		return;
-
-	for (CWeapon* w: weapons) {
-		w->Update();
-	}
-}
-
 void CUnit::UpdateTransportees()
 {
 	for (TransportedUnit& tu: transportedUnits) {
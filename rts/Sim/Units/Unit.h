@@ -175,8 +175,6 @@ public:
 	void UpdateLosStatus(int allyTeam);
 	unsigned short CalcLosStatus(int allyTeam) const;
 
-	void UpdateWeapons();
-
 	void SlowUpdateWeapons();
 	void SlowUpdateKamikaze(bool scanForTargets);
 	void SlowUpdateCloak(bool stunCheck);
@@ -9,6 +9,7 @@
 #include "UnitDefHandler.h"
 #include "UnitDef.h"
 #include "Lua/LuaParser.h"
+#include "Rendering/Models/IModelParser.h"
 #include "System/Exceptions.h"
 #include "System/Log/ILog.h"
 #include "System/StringUtil.h"
@@ -75,6 +76,10 @@ int CUnitDefHandler::PushNewUnitDef(const std::string& unitName, const LuaTable&
 		// force-initialize the real* members
 		newDef.SetNoCost(true);
 		newDef.SetNoCost(noCost);
+
+		// parse the model on a worker while the remaining defs are processed
+		if (modelLoader.PrefetchDefModels())
+			newDef.PreloadModel();
 	} catch (const content_error& err) {
 		LOG_L(L_ERROR, "%s", err.what());
 		return 0;
@@ -1,5 +1,6 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
 #include <cassert>
 
 #include "UnitHandler.h"
@@ -11,14 +12,17 @@
 #include "UnitTypes/Factory.h"
 
 #include "CommandAI/BuilderCAI.h"
+#include "Sim/Features/FeatureHandler.h"
 #include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/TeamHandler.h"
+#include "Sim/MoveTypes/LocalAvoidance.h"
 #include "Sim/MoveTypes/MoveType.h"
 #include "Sim/Weapons/Weapon.h"
 #include "System/EventHandler.h"
 #include "System/Log/ILog.h"
 #include "System/SpringMath.h"
 #include "System/TimeProfiler.h"
+#include "System/Threading/ThreadPool.h"
 #include "System/creg/STL_Deque.h"
 #include "System/creg/STL_Set.h"
 
@@ -33,8 +37,13 @@ CR_REG_METADATA(CUnitHandler, (
 	CR_MEMBER(unitsToBeRemoved),
 
 	CR_MEMBER(builderCAIs),
+	CR_IGNORED(fireStageWeapons),
+	CR_IGNORED(fireStageResults),
+
+	CR_MEMBER(slowUpdateSlots),
+	CR_MEMBER(slowUpdateSlotCosts),
+	CR_MEMBER(slowUpdateUnitSlots),
 
-	CR_MEMBER(activeSlowUpdateUnit),
 	CR_MEMBER(activeUpdateUnit),
 
 	CR_MEMBER(maxUnits),
@@ -95,9 +104,17 @@ void CUnitHandler::Init() {
 		maxUnitRadius = 0.0f;
 	}
 	{
-		activeSlowUpdateUnit = 0;
 		activeUpdateUnit = 0;
 	}
+	{
+		for (auto& slot: slowUpdateSlots) {
+			slot.clear();
+		}
+
+		slowUpdateSlotCosts.fill(0);
+		slowUpdateUnitSlots.clear();
+		slowUpdateUnitSlots.resize(maxUnits, 0);
+	}
 	{
 		units.resize(maxUnits, nullptr);
 		activeUnits.reserve(maxUnits);
@@ -141,6 +158,10 @@ void CUnitHandler::Kill()
 		activeUnits.clear();
 		unitsToBeRemoved.clear();
 
+		for (auto& slot: slowUpdateSlots) {
+			slot.clear();
+		}
+
 		// only iterated by unsynced code, GetBuilderCAIs has no synced callers
 		builderCAIs.clear();
 	}
@@ -181,10 +202,9 @@ void CUnitHandler::InsertActiveUnit(CUnit* unit)
 	assert(insertionPos < activeUnits.size());
 	activeUnits.insert(activeUnits.begin() + insertionPos, unit);
 
-	// do not (slow)update the same unit twice if the new one
-	// gets inserted behind our current iterator position and
-	// right-shifts the rest
-	activeSlowUpdateUnit += (insertionPos <= activeSlowUpdateUnit);
+	// do not update the same unit twice if the new one gets
+	// inserted behind our current iterator position and right-
+	// shifts the rest
 	activeUpdateUnit += (insertionPos <= activeUpdateUnit);
 
 	#else
@@ -192,6 +212,8 @@ void CUnitHandler::InsertActiveUnit(CUnit* unit)
 	#endif
 
 	units[unit->id] = unit;
+
+	InsertSlowUpdateUnit(unit);
 }
 
 
@@ -279,11 +301,10 @@ void CUnitHandler::DeleteUnit(CUnit* delUnit)
 
 	teamHandler.Team(delUnitTeam)->RemoveUnit(delUnit, CTeam::RemoveDied);
 
-	if (activeSlowUpdateUnit > std::distance(activeUnits.begin(), it))
-		--activeSlowUpdateUnit;
-
 	activeUnits.erase(it);
 
+	RemoveSlowUpdateUnit(delUnit);
+
 	spring::VectorErase(GetUnitsByTeamAndDef(delUnitTeam,           0), delUnit);
 	spring::VectorErase(GetUnitsByTeamAndDef(delUnitTeam, delUnitType), delUnit);
 
@@ -301,6 +322,8 @@ void CUnitHandler::UpdateUnitMoveTypes()
 {
 	SCOPED_TIMER("Sim::Unit::MoveType");
 
+	localAvoidance.Update(activeUnits);
+
 	for (activeUpdateUnit = 0; activeUpdateUnit < activeUnits.size(); ++activeUpdateUnit) {
 		CUnit* unit = activeUnits[activeUpdateUnit];
 		AMoveType* moveType = unit->moveType;
@@ -331,26 +354,117 @@ void CUnitHandler::UpdateUnitLosStates()
 }
 
 
+// estimated relative SlowUpdate costs, by unit-type; these must only
+// depend on synced data (the slot assignment is part of the simulation)
+// so measured timings can not be used
+#define SLOWUPDATE_COST_BASE      2
+#define SLOWUPDATE_COST_WEAPON    2 // target-search per weapon
+#define SLOWUPDATE_COST_BUILDER   6 // CBuilderCAI area repair/reclaim/resurrect scans
+#define SLOWUPDATE_COST_FACTORY   3
+#define SLOWUPDATE_COST_TRANSPORT 1
+
+// maximum number of units moved between slots per rebalancing step
+#define SLOWUPDATE_MAX_MOVES 8
+
+static unsigned int CalcSlowUpdateCost(const CUnit* unit)
+{
+	const UnitDef* ud = unit->unitDef;
+
+	unsigned int cost = SLOWUPDATE_COST_BASE;
+
+	for (unsigned int i = 0; i < MAX_WEAPONS_PER_UNIT && ud->HasWeapon(i); i++) {
+		cost += SLOWUPDATE_COST_WEAPON;
+	}
+
+	cost += (SLOWUPDATE_COST_BUILDER   * ud->IsMobileBuilderUnit());
+	cost += (SLOWUPDATE_COST_FACTORY   * ud->IsFactoryUnit());
+	cost += (SLOWUPDATE_COST_TRANSPORT * ud->IsTransportUnit());
+
+	return cost;
+}
+
+
+void CUnitHandler::InsertSlowUpdateUnit(CUnit* unit)
+{
+	// cheapest slot; ties are broken by index so all clients agree
+	const auto iter = std::min_element(slowUpdateSlotCosts.begin(), slowUpdateSlotCosts.end());
+	const unsigned int slot = iter - slowUpdateSlotCosts.begin();
+
+	slowUpdateSlots[slot].push_back(unit);
+	slowUpdateSlotCosts[slot] += CalcSlowUpdateCost(unit);
+	slowUpdateUnitSlots[unit->id] = slot;
+}
+
+void CUnitHandler::RemoveSlowUpdateUnit(CUnit* unit)
+{
+	const unsigned int slot = slowUpdateUnitSlots[unit->id];
+
+	// keep the order within the slot
+	const auto iter = std::find(slowUpdateSlots[slot].begin(), slowUpdateSlots[slot].end(), unit);
+
+	assert(iter != slowUpdateSlots[slot].end());
+
+	slowUpdateSlots[slot].erase(iter);
+	slowUpdateSlotCosts[slot] -= CalcSlowUpdateCost(unit);
+}
+
+void CUnitHandler::BalanceSlowUpdateSlots()
+{
+	// unit deaths can leave the slots unbalanced; move the most recently
+	// inserted units out of the costliest slot into the cheapest one (a
+	// moved unit gets one SlowUpdate interval that is shorter or longer
+	// than UNIT_SLOWUPDATE_RATE frames)
+	for (unsigned int n = 0; n < SLOWUPDATE_MAX_MOVES; n++) {
+		const auto minIter = std::min_element(slowUpdateSlotCosts.begin(), slowUpdateSlotCosts.end());
+		const auto maxIter = std::max_element(slowUpdateSlotCosts.begin(), slowUpdateSlotCosts.end());
+
+		const unsigned int minSlot = minIter - slowUpdateSlotCosts.begin();
+		const unsigned int maxSlot = maxIter - slowUpdateSlotCosts.begin();
+		const unsigned int costDif = *maxIter - *minIter;
+
+		std::vector<CUnit*>& srcUnits = slowUpdateSlots[maxSlot];
+		std::vector<CUnit*>& dstUnits = slowUpdateSlots[minSlot];
+
+		const auto pred = [&](const CUnit* u) { return (CalcSlowUpdateCost(u) < costDif); };
+		const auto iter = std::find_if(srcUnits.rbegin(), srcUnits.rend(), pred);
+
+		// nothing left that would reduce the imbalance
+		if (iter == srcUnits.rend())
+			break;
+
+		CUnit* unit = *iter;
+		const unsigned int cost = CalcSlowUpdateCost(unit);
+
+		srcUnits.erase(std::next(iter).base());
+		dstUnits.push_back(unit);
+
+		slowUpdateSlotCosts[maxSlot] -= cost;
+		slowUpdateSlotCosts[minSlot] += cost;
+		slowUpdateUnitSlots[unit->id] = minSlot;
+	}
+}
+
 void CUnitHandler::SlowUpdateUnits()
 {
 	SCOPED_TIMER("Sim::Unit::SlowUpdate");
-	assert(activeSlowUpdateUnit >= 0);
 
-	// reset the iterator every <UNIT_SLOWUPDATE_RATE> frames
-	if ((gs->frameNum % UNIT_SLOWUPDATE_RATE) == 0)
-		activeSlowUpdateUnit = 0;
+	const unsigned int slot = gs->frameNum % UNIT_SLOWUPDATE_RATE;
 
-	// stagger the SlowUpdate's
-	for (size_t n = (activeUnits.size() / UNIT_SLOWUPDATE_RATE) + 1; (activeSlowUpdateUnit < activeUnits.size() && n != 0); ++activeSlowUpdateUnit) {
-		CUnit* unit = activeUnits[activeSlowUpdateUnit];
+	if (slot == 0)
+		BalanceSlowUpdateSlots();
+
+	std::vector<CUnit*>& slotUnits = slowUpdateSlots[slot];
+
+	// units created during SlowUpdate may be inserted into this slot, but
+	// are not SlowUpdate'd until its next turn (the vector may reallocate)
+	for (size_t i = 0, n = slotUnits.size(); i < n; ++i) {
+		CUnit* unit = slotUnits[i];
 
 		unit->SanityCheck();
 		unit->SlowUpdate();
 		unit->SlowUpdateWeapons();
 		unit->SlowUpdateLocalModel();
 		unit->SanityCheck();
-
-		n--;
 	}
 }
 
@@ -375,8 +489,53 @@ void CUnitHandler::UpdateUnitWeapons()
 {
 	SCOPED_TIMER("Sim::Unit::Weapon");
 
+	fireStageWeapons.clear();
+
+	// stage 1: targeting and aiming (runs scripts), serial
 	for (activeUpdateUnit = 0; activeUpdateUnit < activeUnits.size(); ++activeUpdateUnit) {
-		activeUnits[activeUpdateUnit]->UpdateWeapons();
+		CUnit* unit = activeUnits[activeUpdateUnit];
+
+		if (!unit->CanUpdateWeapons())
+			continue;
+
+		for (CWeapon* w: unit->weapons) {
+			if (w->UpdatePreFire())
+				fireStageWeapons.push_back(w);
+		}
+	}
+
+	if (fireStageWeapons.empty())
+		return;
+
+	// scripts may have moved pieces; resolve their matrices now so the
+	// ray vs. piece-tree tests in stage 2 only ever read from them (this
+	// includes features, which TraceRay tests as well)
+	for (const CUnit* unit: activeUnits) {
+		if (unit->collisionVolume.DefaultToPieceTree())
+			unit->localModel.UpdateDirtyPieceMatrices();
+	}
+
+	featureHandler.UpdateDirtyPieceMatrices();
+
+	// stage 2: line-of-fire tests, read-only and hence parallel; every
+	// weapon writes only its own slot so the results do not depend on
+	// how the work was split among threads
+	fireStageResults.clear();
+	fireStageResults.resize(fireStageWeapons.size(), 0);
+
+	for_mt(0, fireStageWeapons.size(), [&](const int i) {
+		fireStageResults[i] = fireStageWeapons[i]->TestFire();
+	});
+
+	// stage 3: firing, serial and in stage 1 order to keep sync
+	for (size_t i = 0; i < fireStageWeapons.size(); i++) {
+		CWeapon* w = fireStageWeapons[i];
+
+		// owner can have been stunned by a weapon fired before this one
+		if (!w->owner->CanUpdateWeapons())
+			continue;
+
+		w->UpdatePostFire(fireStageResults[i] != 0);
 	}
 }
 
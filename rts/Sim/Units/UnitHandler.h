@@ -13,6 +13,7 @@
 struct UnitDef;
 class CUnit;
 class CBuilderCAI;
+class CWeapon;
 
 class CUnitHandler
 {
@@ -79,6 +80,9 @@ private:
 	void QueueDeleteUnits();
 	void DeleteUnit(CUnit* unit);
 	void DeleteUnits();
+	void InsertSlowUpdateUnit(CUnit* unit);
+	void RemoveSlowUpdateUnit(CUnit* unit);
+	void BalanceSlowUpdateSlots();
 	void SlowUpdateUnits();
 	void UpdateUnitMoveTypes();
 	void UpdateUnitLosStates();
@@ -96,8 +100,19 @@ private:
 
 	spring::unordered_map<unsigned int, CBuilderCAI*> builderCAIs;
 
+	///< not saved, weapons that passed UpdatePreFire this frame (in update
+	///< order) and their TestFire results; chars since written concurrently
+	std::vector<CWeapon*> fireStageWeapons;
+	std::vector<unsigned char> fireStageResults;
+
+
+	///< units by SlowUpdate slot; slot N is SlowUpdate'd on frames where
+	///< (frameNum % UNIT_SLOWUPDATE_RATE) == N, units are assigned to the
+	///< slot with the lowest estimated total cost (see CalcSlowUpdateCost)
+	std::array<std::vector<CUnit*>, UNIT_SLOWUPDATE_RATE> slowUpdateSlots;
+	std::array<unsigned int, UNIT_SLOWUPDATE_RATE> slowUpdateSlotCosts;
+	std::vector<unsigned char> slowUpdateUnitSlots;                     ///< indexed by unit ID
 
-	size_t activeSlowUpdateUnit = 0;  ///< first unit of batch that will be SlowUpdate'd this frame
 	size_t activeUpdateUnit = 0;      ///< first unit of batch that will be SlowUpdate'd this frame
 
 
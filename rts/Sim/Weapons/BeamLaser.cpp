@@ -186,10 +186,21 @@ void CBeamLaser::UpdateSweep()
 	reloadStatus = gs->frameNum + int(reloadTime / owner->reloadSpeed);
 }
 
-void CBeamLaser::Update()
+bool CBeamLaser::UpdatePreFire()
 {
 	UpdatePosAndMuzzlePos();
-	CWeapon::Update();
+
+	if (CWeapon::UpdatePreFire())
+		return true;
+
+	// no post-fire stage this frame, but sweeps continue regardless
+	UpdateSweep();
+	return false;
+}
+
+void CBeamLaser::UpdatePostFire(bool haveLineOfFire)
+{
+	CWeapon::UpdatePostFire(haveLineOfFire);
 	UpdateSweep();
 }
 
@@ -13,7 +13,8 @@ class CBeamLaser: public CWeapon
 public:
 	CBeamLaser(CUnit* owner = nullptr, const WeaponDef* def = nullptr);
 
-	void Update() override final;
+	bool UpdatePreFire() override final;
+	void UpdatePostFire(bool haveLineOfFire) override final;
 	void Init() override final;
 
 private:
@@ -11,7 +11,7 @@ class CNoWeapon: public CWeapon
 public:
 	CNoWeapon(CUnit* owner = nullptr, const WeaponDef* def = nullptr): CWeapon(owner, def) {}
 
-	void Update() override final {}
+	bool UpdatePreFire() override final { return false; }
 	void SlowUpdate() override final {}
 	void Init() override final {}
 
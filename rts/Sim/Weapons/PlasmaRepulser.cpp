@@ -139,7 +139,7 @@ bool CPlasmaRepulser::CanIntercept(unsigned interceptedType, int allyTeam) const
 }
 
 
-void CPlasmaRepulser::Update()
+bool CPlasmaRepulser::UpdatePreFire()
 {
 	rechargeDelay -= (rechargeDelay > 0);
 	hitFrameCount -= (hitFrameCount > 0);
@@ -163,6 +163,7 @@ void CPlasmaRepulser::Update()
 	segmentCollections[this].UpdateColor();
 	#endif
 	sscPool.UpdateCollection(this);
+	return false;
 }
 
 // Returns true if the projectile is destroyed.
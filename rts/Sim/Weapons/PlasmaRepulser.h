@@ -20,7 +20,8 @@ public:
 	void DependentDied(CObject* o) override final;
 	bool HaveFreeLineOfFire(const float3 srcPos, const float3 tgtPos, const SWeaponTarget& trg) const override final { return true; }
 
-	void Update() override final;
+	// shields never fire, so everything happens in the first stage
+	bool UpdatePreFire() override final;
 	void SlowUpdate() override final;
 
 
@@ -277,7 +277,7 @@ float CWeapon::GetPredictedImpactTime(float3 p) const
 }
 
 
-void CWeapon::Update()
+bool CWeapon::UpdatePreFire()
 {
 	// update conditional cause last SlowUpdate maybe longer away than UNIT_SLOWUPDATE_RATE
 	// i.e. when the unit got stunned (neither is SlowUpdate exactly called at UNIT_SLOWUPDATE_RATE, it's only called `close` to that)
@@ -295,10 +295,23 @@ void CWeapon::Update()
 	currentTargetPos = GetLeadTargetPos(currentTarget);
 
 	if (!UpdateStockpile())
-		return;
+		return false;
 
 	UpdateAim();
-	UpdateFire();
+	return true;
+}
+
+bool CWeapon::TestFire() const
+{
+	if (!CanFire(false, false, false))
+		return false;
+
+	return (TryTarget(currentTargetPos, currentTarget, true));
+}
+
+void CWeapon::UpdatePostFire(bool haveLineOfFire)
+{
+	UpdateFire(haveLineOfFire);
 	UpdateSalvo();
 }
 
@@ -401,12 +414,18 @@ bool CWeapon::CanFire(bool ignoreAngleGood, bool ignoreTargetType, bool ignoreRe
 	return true;
 }
 
-void CWeapon::UpdateFire()
+void CWeapon::UpdateFire(bool haveLineOfFire)
 {
-	if (!CanFire(false, false, false))
+	if (!haveLineOfFire)
 		return;
 
-	if (!TryTarget(currentTargetPos, currentTarget, true))
+	// checked again since TestFire, weapons that fired in between may
+	// have stunned our owner or killed our target (dead units are only
+	// deleted, and currentTarget reset, after the frame so TestTarget
+	// has to reject them here unless fireAtKilled is set)
+	if (!CanFire(false, false, false))
+		return;
+	if (!TestTarget(currentTargetPos, currentTarget))
 		return;
 
 	// pre-check if we got enough resources (so CobBlockShot gets only called when really possible to shoot)
@@ -29,7 +29,13 @@ public:
 	void SetWeaponNum(int num) { weaponNum = num; }
 	void DependentDied(CObject* o) override;
 	virtual void SlowUpdate();
-	virtual void Update();
+
+	// per-frame update in three stages, each run for all weapons before
+	// the next starts (see CUnitHandler::UpdateUnitWeapons); TestFire is
+	// called from worker threads and must not write anything
+	virtual bool UpdatePreFire();
+	bool TestFire() const;
+	virtual void UpdatePostFire(bool haveLineOfFire);
 
 public:
 	bool Attack(const SWeaponTarget& newTarget);
@@ -110,7 +116,7 @@ protected:
 
 private:
 	void UpdateAim();
-	void UpdateFire();
+	void UpdateFire(bool haveLineOfFire);
 	bool UpdateStockpile();
 	void UpdateSalvo();
 
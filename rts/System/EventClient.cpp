@@ -38,6 +38,20 @@ bool CEventClient::WantsEvent(const std::string& eventName)
 }
 
 
+void CEventClient::Explosions(const std::vector<ExplosionEvent>& events, std::vector<bool>& noGfx)
+{
+	for (size_t i = 0; i < events.size(); i++) {
+		if (noGfx[i])
+			continue;
+
+		const ExplosionEvent& e = events[i];
+
+		// discard return-value from clients lacking full-read access
+		noGfx[i] = (Explosion(e.weaponDefID, e.projectileID, e.pos, e.owner) && GetFullRead());
+	}
+}
+
+
 /******************************************************************************/
 /******************************************************************************/
 //
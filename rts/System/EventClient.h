@@ -39,6 +39,13 @@ class LuaMaterial;
 #endif
 
 
+struct ExplosionEvent {
+	int weaponDefID;
+	int projectileID;
+	float3 pos;
+	const CUnit* owner;
+};
+
 enum DbgTimingInfoType {
 	TIMING_VIDEO,
 	TIMING_SIM,
@@ -193,6 +200,9 @@ class CEventClient
 		                              const CWeapon* weapon, int oldCount) {}
 
 		virtual bool Explosion(int weaponID, int projectileID, const float3& pos, const CUnit* owner) { return false; }
+		// batched form of Explosion; events claimed by an earlier client are
+		// skipped, a client with full read-access claims by returning true
+		virtual void Explosions(const std::vector<ExplosionEvent>& events, std::vector<bool>& noGfx);
 
 
 		virtual bool CommandFallback(const CUnit* unit, const Command& cmd) { return false; }
@@ -128,7 +128,7 @@ class CEventHandler
 		void ProjectileCreated(const CProjectile* proj, int allyTeam);
 		void ProjectileDestroyed(const CProjectile* proj, int allyTeam);
 
-		bool Explosion(int weaponDefID, int projectileID, const float3& pos, const CUnit* owner);
+		void Explosions(const std::vector<ExplosionEvent>& events, std::vector<bool>& noGfx);
 
 		void StockpileChanged(const CUnit* unit,
 		                      const CWeapon* weapon, int oldCount);
@@ -674,25 +674,22 @@ inline void CEventHandler::UnsyncedHeightMapUpdate(const SRectangle& rect)
 
 
 
-inline bool CEventHandler::Explosion(int weaponDefID, int projectileID, const float3& pos, const CUnit* owner)
+inline void CEventHandler::Explosions(const std::vector<ExplosionEvent>& events, std::vector<bool>& noGfx)
 {
 	auto& clients = listExplosion;
 
+	noGfx.clear();
+	noGfx.resize(events.size(), false);
+
 	for (size_t i = 0; i < clients.size(); ) {
 		CEventClient* ec = clients[i];
 
-		// discard return-value from clients lacking full-read access
-		// (redundant for synced gadgets; watchWeaponDefs is checked)
+		// redundant for synced gadgets; watchWeaponDefs is checked
 		// NOTE: the call-in may remove itself from the client list
-		if (!ec->Explosion(weaponDefID, projectileID, pos, owner) || !ec->GetFullRead()) {
-			i += (i < clients.size() && ec == clients[i]);
-			continue;
-		}
+		ec->Explosions(events, noGfx);
 
-		return true;
+		i += (i < clients.size() && ec == clients[i]);
 	}
-
-	return false;
 }
 
 
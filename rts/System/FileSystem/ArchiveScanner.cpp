@@ -3,6 +3,8 @@
 #include <algorithm>
 #include <array>
 #include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <memory>
 
 #include <sys/types.h>
@@ -18,6 +20,7 @@
 #include "DataDirsAccess.h"
 #include "FileSystem.h"
 #include "FileQueryFlags.h"
+#include "MappedFile.h"
 #include "Lua/LuaParser.h"
 #include "System/ContainerUtil.h"
 #include "System/StringUtil.h"
@@ -51,7 +54,9 @@ LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_ARCHIVESCANNER)
  * but mapping them all, every time to make the list is)
  */
 
-constexpr static int INTERNAL_VER = 16;
+constexpr static int INTERNAL_VER = 17;
+// "SAC" + format revision, precedes INTERNAL_VER in the cache header
+constexpr static uint32_t CACHE_MAGIC = 0x02434153;
 
 
 /*
@@ -172,7 +177,7 @@ CArchiveScanner::ArchiveData::ArchiveData(const LuaTable& archiveTable, bool fro
 	// (at time of this writing they use name only)
 	//
 	// NOTE when changing this, this function is used both by the code that
-	// reads ArchiveCache.lua and the code that reads modinfo.lua from the mod.
+	// reads modinfo.lua from the mod and by the old Lua-based ArchiveCache.
 	// so make sure it doesn't keep adding stuff to the name everytime
 	// Spring/unitsync is loaded.
 	//
@@ -388,7 +393,7 @@ CArchiveScanner::CArchiveScanner()
 {
 	Clear();
 	// the "cache" dir is created in DataDirLocater
-	ReadCacheData(cachefile = FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(INTERNAL_VER, "ArchiveCache%i.lua"));
+	ReadCacheData(cachefile = FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(INTERNAL_VER, "ArchiveCache%i.bin"));
 	ScanAllDirs();
 }
 
@@ -418,6 +423,10 @@ void CArchiveScanner::Clear()
 	brokenArchives.reserve(16);
 	brokenArchivesIndex.clear();
 	brokenArchivesIndex.reserve(16);
+	scannedDirs.clear();
+	scannedDirs.reserve(64);
+	scannedDirsIndex.clear();
+	scannedDirsIndex.reserve(64);
 	cachefile.clear();
 }
 
@@ -432,7 +441,7 @@ void CArchiveScanner::Reload()
 
 	// ctor
 	Clear();
-	ReadCacheData(cachefile = FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(INTERNAL_VER, "ArchiveCache%i.lua"));
+	ReadCacheData(cachefile = FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(INTERNAL_VER, "ArchiveCache%i.bin"));
 	ScanAllDirs();
 }
 
@@ -532,28 +541,55 @@ void CArchiveScanner::ScanDir(const std::string& curPath, std::deque<std::string
 	std::deque<std::string> subDirs = {curPath};
 
 	while (!subDirs.empty()) {
-		const std::string& subDir = FileSystem::EnsurePathSepAtEnd(subDirs.front());
-		const std::vector<std::string>& foundFiles = dataDirsAccess.FindFiles(subDir, "*", FileQueryFlags::INCLUDE_DIRS);
+		const std::string subDir = FileSystem::EnsurePathSepAtEnd(subDirs.front());
 
 		subDirs.pop_front();
 
-		for (const std::string& fileName: foundFiles) {
-			const std::string& fileNameNoSep = FileSystem::EnsureNoPathSepAtEnd(fileName);
-			const std::string& lcFilePath = StringToLower(FileSystem::GetDirectory(fileNameNoSep));
+		ScannedDir& sd = GetAddScannedDir(subDir);
 
-			// Exclude archive files found inside directory archives (.sdd)
-			if (lcFilePath.find(".sdd") != std::string::npos)
-				continue;
+		// entries can only be added, removed or renamed by changing the mtime
+		// of their parent, so an unchanged directory is not listed again (and
+		// its entries not stat'ed); since mtime has a resolution of a second,
+		// listings taken in the same second as the last change are not trusted
+		// relative paths are listed across all data-dirs and always re-listed
+		const uint32_t modified = FileSystem::IsAbsolutePath(subDir)? FileSystemAbstraction::GetFileModificationTime(FileSystem::EnsureNoPathSepAtEnd(subDir)): 0;
 
-			// Is this an archive we should look into?
-			if (archiveLoader.IsArchiveFile(fileNameNoSep)) {
-				foundArchives.push_front(fileNameNoSep); // push in reverse order!
-				continue;
-			}
-			if (FileSystem::DirExists(fileNameNoSep)) {
-				subDirs.push_back(fileNameNoSep);
+		if (modified == 0 || modified != sd.modified || modified >= sd.listed) {
+			const std::vector<std::string>& foundFiles = dataDirsAccess.FindFiles(subDir, "*", FileQueryFlags::INCLUDE_DIRS);
+
+			sd.path = subDir;
+			sd.archives.clear();
+			sd.subDirs.clear();
+			sd.modified = modified;
+			sd.listed = std::time(nullptr);
+
+			for (const std::string& fileName: foundFiles) {
+				const std::string& fileNameNoSep = FileSystem::EnsureNoPathSepAtEnd(fileName);
+				const std::string& lcFilePath = StringToLower(FileSystem::GetDirectory(fileNameNoSep));
+
+				// Exclude archive files found inside directory archives (.sdd)
+				if (lcFilePath.find(".sdd") != std::string::npos)
+					continue;
+
+				// Is this an archive we should look into?
+				if (archiveLoader.IsArchiveFile(fileNameNoSep)) {
+					sd.archives.push_back(fileNameNoSep);
+					continue;
+				}
+				if (FileSystem::DirExists(fileNameNoSep)) {
+					sd.subDirs.push_back(fileNameNoSep);
+				}
 			}
 		}
+
+		sd.updated = true;
+
+		for (const std::string& archive: sd.archives) {
+			foundArchives.push_front(archive); // push in reverse order!
+		}
+		for (const std::string& dir: sd.subDirs) {
+			subDirs.push_back(dir);
+		}
 	}
 }
 
@@ -637,14 +673,29 @@ CArchiveScanner::BrokenArchive& CArchiveScanner::GetAddBrokenArchive(const std::
 	return brokenArchives[baIter->second];
 }
 
+CArchiveScanner::ScannedDir& CArchiveScanner::GetAddScannedDir(const std::string& path)
+{
+	auto sdIter = scannedDirsIndex.find(path);
+	auto sdPair = std::make_pair(sdIter, false);
+
+	if (sdIter == scannedDirsIndex.end()) {
+		sdPair = scannedDirsIndex.insert(path, scannedDirs.size());
+		sdIter = sdPair.first;
+		scannedDirs.emplace_back();
+	}
+
+	return scannedDirs[sdIter->second];
+}
+
 
 void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 {
 	unsigned modifiedTime = 0;
+	size_t fileSize = 0;
 
 	assert(!isInScan);
 
-	if (CheckCachedData(fullName, modifiedTime, doChecksum))
+	if (CheckCachedData(fullName, modifiedTime, fileSize, doChecksum))
 		return;
 
 	isDirty = true;
@@ -672,6 +723,7 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 		BrokenArchive& ba = GetAddBrokenArchive(lcfn);
 		ba.name = lcfn;
 		ba.path = fpath;
+		ba.size = fileSize;
 		ba.modified = modifiedTime;
 		ba.updated = true;
 		ba.problem = "Unable to open archive";
@@ -716,6 +768,7 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 		BrokenArchive& ba = GetAddBrokenArchive(lcfn);
 		ba.name = lcfn;
 		ba.path = fpath;
+		ba.size = fileSize;
 		ba.modified = modifiedTime;
 		ba.updated = true;
 		ba.problem = error;
@@ -753,6 +806,7 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 	}
 
 	ai.path = fpath;
+	ai.size = fileSize;
 	ai.modified = modifiedTime;
 
 	// Store modinfo.lua/mapinfo.lua modified timestamp for directory archives, as only they can change.
@@ -772,7 +826,7 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 }
 
 
-bool CArchiveScanner::CheckCachedData(const std::string& fullName, unsigned& modified, bool doChecksum)
+bool CArchiveScanner::CheckCachedData(const std::string& fullName, unsigned& modified, size_t& size, bool doChecksum)
 {
 	// virtual archives do not exist on disk, and thus do not have a modification time
 	// they should still be scanned as normal archives so we only skip the cache-check
@@ -782,7 +836,7 @@ bool CArchiveScanner::CheckCachedData(const std::string& fullName, unsigned& mod
 	// if stat fails, assume the archive is not broken nor cached
 	// it would also fail in the case of virtual archives and cause
 	// warning-spam which is suppressed by the extension-test above
-	if ((modified = FileSystemAbstraction::GetFileModificationTime(fullName)) == 0)
+	if ((modified = FileSystemAbstraction::GetFileModificationTime(fullName, size)) == 0)
 		return false;
 
 	const std::string& fileName      = FileSystem::GetFilename(fullName);
@@ -797,7 +851,7 @@ bool CArchiveScanner::CheckCachedData(const std::string& fullName, unsigned& mod
 	if (baIter != brokenArchivesIndex.end()) {
 		BrokenArchive& ba = brokenArchives[baIter->second];
 
-		if (modified == ba.modified && filePath == ba.path)
+		if (modified == ba.modified && size == ba.size && filePath == ba.path)
 			return (ba.updated = true);
 	}
 
@@ -815,7 +869,7 @@ bool CArchiveScanner::CheckCachedData(const std::string& fullName, unsigned& mod
 	if (!ai.replaced.empty())
 		return true;
 
-	const bool haveValidCacheData = (modified == ai.modified && filePath == ai.path);
+	const bool haveValidCacheData = (modified == ai.modified && size == ai.size && filePath == ai.path);
 	// check if the archive data file (modinfo.lua/mapinfo.lua) has changed
 	const bool archiveDataChanged = (!ai.archiveDataPath.empty() && FileSystemAbstraction::GetFileModificationTime(ai.archiveDataPath) != ai.modifiedArchiveData);
 
@@ -973,6 +1027,140 @@ bool CArchiveScanner::GetArchiveChecksum(const std::string& archiveName, Archive
 }
 
 
+/*
+ * ArchiveCache (de)serialization
+ *
+ * The cache is a flat little-endian binary file which is mapped into
+ * memory and decoded in a single pass, parsing it as Lua used to take
+ * seconds with thousands of (rapid) archives installed. It is local
+ * to each installation and never exchanged, so no byte-swapping.
+ *
+ * layout:
+ *   u32 magic, u32 version
+ *   u32 #archives, {archive}*
+ *   u32 #brokenArchives, {brokenArchive}*
+ *   u32 #scannedDirs, {scannedDir}*
+ * strings are stored as (u32 length, chars)
+ *
+ * Anything that fails to decode, including info-items a scan could never
+ * have produced, turns the whole cache into a miss and forces a rescan.
+ */
+
+struct CacheWriter {
+	template<typename T> void Put(const T& v) {
+		const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(&v);
+		buffer.insert(buffer.end(), p, p + sizeof(T));
+	}
+
+	void PutBytes(const std::uint8_t* p, size_t n) { buffer.insert(buffer.end(), p, p + n); }
+	void PutString(const std::string& s) {
+		Put<uint32_t>(s.size());
+		PutBytes(reinterpret_cast<const std::uint8_t*>(s.data()), s.size());
+	}
+
+	std::vector<std::uint8_t> buffer;
+};
+
+struct CacheReader {
+	CacheReader(const std::uint8_t* beg, const std::uint8_t* end): cur(beg), end(end) {}
+
+	template<typename T> T Get() {
+		T v = {};
+
+		if (!(valid &= (size_t(end - cur) >= sizeof(T))))
+			return v;
+
+		std::memcpy(&v, cur, sizeof(T));
+		cur += sizeof(T);
+		return v;
+	}
+
+	void GetBytes(std::uint8_t* p, size_t n) {
+		if (!(valid &= (size_t(end - cur) >= n)))
+			return;
+
+		std::memcpy(p, cur, n);
+		cur += n;
+	}
+	std::string GetString() {
+		const uint32_t n = Get<uint32_t>();
+
+		if (!(valid &= (size_t(end - cur) >= n)))
+			return "";
+
+		const std::string s(reinterpret_cast<const char*>(cur), n);
+		cur += n;
+		return s;
+	}
+
+	const std::uint8_t* cur;
+	const std::uint8_t* end;
+
+	bool valid = true;
+};
+
+
+static void WriteArchiveData(CacheWriter& cw, const CArchiveScanner::ArchiveData& ad)
+{
+	cw.Put<uint32_t>(ad.GetInfo().size());
+
+	for (const auto& ii: ad.GetInfo()) {
+		const InfoItem& item = ii.second;
+
+		cw.PutString(item.key);
+		cw.Put<uint8_t>(item.valueType);
+
+		switch (item.valueType) {
+			case INFO_VALUE_TYPE_STRING : { cw.PutString(item.valueTypeString  ); } break;
+			case INFO_VALUE_TYPE_INTEGER: { cw.Put<int32_t>(item.value.typeInteger); } break;
+			case INFO_VALUE_TYPE_FLOAT  : { cw.Put<float>(item.value.typeFloat    ); } break;
+			case INFO_VALUE_TYPE_BOOL   : { cw.Put<uint8_t>(item.value.typeBool   ); } break;
+			default: { assert(false); } break;
+		}
+	}
+
+	// stored as-is, including the implicit base-content dependencies
+	cw.Put<uint32_t>(ad.GetDependencies().size());
+	for (const std::string& dep: ad.GetDependencies()) {
+		cw.PutString(dep);
+	}
+
+	cw.Put<uint32_t>(ad.GetReplaces().size());
+	for (const std::string& rep: ad.GetReplaces()) {
+		cw.PutString(rep);
+	}
+}
+
+static void ReadArchiveData(CacheReader& cr, CArchiveScanner::ArchiveData& ad)
+{
+	// items were written sorted by key, which makes each insertion O(1)
+	for (uint32_t i = 0, n = cr.Get<uint32_t>(); i < n && cr.valid; i++) {
+		const std::string& key = cr.GetString();
+
+		// reserved keys are never written, SetInfoItemValue* would throw
+		if (CArchiveScanner::ArchiveData::IsReservedKey(StringToLower(key))) {
+			cr.valid = false;
+			break;
+		}
+
+		switch (cr.Get<uint8_t>()) {
+			case INFO_VALUE_TYPE_STRING : { ad.SetInfoItemValueString(key, cr.GetString()); } break;
+			case INFO_VALUE_TYPE_INTEGER: { ad.SetInfoItemValueInteger(key, cr.Get<int32_t>()); } break;
+			case INFO_VALUE_TYPE_FLOAT  : { ad.SetInfoItemValueFloat(key, cr.Get<float>()); } break;
+			case INFO_VALUE_TYPE_BOOL   : { ad.SetInfoItemValueBool(key, cr.Get<uint8_t>() != 0); } break;
+			default: { cr.valid = false; } break;
+		}
+	}
+
+	for (uint32_t i = 0, n = cr.Get<uint32_t>(); i < n && cr.valid; i++) {
+		ad.GetDependencies().push_back(cr.GetString());
+	}
+	for (uint32_t i = 0, n = cr.Get<uint32_t>(); i < n && cr.valid; i++) {
+		ad.GetReplaces().push_back(cr.GetString());
+	}
+}
+
+
 void CArchiveScanner::ReadCacheData(const std::string& filename)
 {
 	std::lock_guard<decltype(scannerMutex)> lck(scannerMutex);
@@ -981,94 +1169,93 @@ void CArchiveScanner::ReadCacheData(const std::string& filename)
 		return;
 	}
 
-	LuaParser p(filename, SPRING_VFS_RAW, SPRING_VFS_BASE);
-	if (!p.Execute()) {
-		LOG_L(L_ERROR, "[AS::%s] failed to parse ArchiveCache: %s", __func__, p.GetErrorLog().c_str());
+	CMappedFile cacheFile;
+
+	if (!cacheFile.Open(filename)) {
+		LOG_L(L_ERROR, "[AS::%s] failed to open ArchiveCache \"%s\"", __func__, filename.c_str());
 		return;
 	}
 
-	const LuaTable& archiveCacheTbl = p.GetRoot();
-	const LuaTable& archivesTbl = archiveCacheTbl.SubTable("archives");
-	const LuaTable& brokenArchivesTbl = archiveCacheTbl.SubTable("brokenArchives");
+	CacheReader cr(cacheFile.GetData(), cacheFile.GetDataEnd());
 
 	// Do not load old version caches
-	const int ver = archiveCacheTbl.GetInt("internalver", (INTERNAL_VER + 1));
-	if (ver != INTERNAL_VER)
+	if (cr.Get<uint32_t>() != CACHE_MAGIC || cr.Get<uint32_t>() != INTERNAL_VER)
 		return;
 
-	for (int i = 1; archivesTbl.KeyExists(i); ++i) {
-		const LuaTable& curArchiveTbl = archivesTbl.SubTable(i);
-		const LuaTable& archivedTbl = curArchiveTbl.SubTable("archivedata");
-
-		const std::string& curArchiveName = curArchiveTbl.GetString("name", "");
-		const std::string& curArchiveNameLC = StringToLower(curArchiveName);
-		const std::string& hexDigestStr = curArchiveTbl.GetString("checksum", "");
-
-		ArchiveInfo& ai = GetAddArchiveInfo(curArchiveNameLC);
-		ArchiveInfo tmp; // used to compare against all-zero hash
-
-		ai.origName 	   = curArchiveName;
-		ai.path     	   = curArchiveTbl.GetString("path", "");
-		ai.archiveDataPath = curArchiveTbl.GetString("archiveDataPath", "");
-
-		// do not use LuaTable.GetInt() for 32-bit integers: the Spring lua
-		// library uses 32-bit floats to represent numbers, which can only
-		// represent 2^24 consecutive integers
-		ai.modified = strtoul(curArchiveTbl.GetString("modified", "0").c_str(), nullptr, 10);
-		ai.modifiedArchiveData = strtoul(curArchiveTbl.GetString("modifiedArchiveData", "0").c_str(), nullptr, 10);
-
-		// convert digest-string back to raw checksum
-		if (hexDigestStr.size() == (sha512::SHA_LEN * 2)) {
-			sha512::hex_digest hexDigest;
-			sha512::raw_digest rawDigest;
-			std::copy(hexDigestStr.begin(), hexDigestStr.end(), hexDigest.data());
-			sha512::read_digest(hexDigest, rawDigest);
-			std::memcpy(ai.checksum, rawDigest.data(), sha512::SHA_LEN);
-		}
+	try {
+		for (uint32_t i = 0, n = cr.Get<uint32_t>(); i < n && cr.valid; i++) {
+			const std::string& curArchiveName = cr.GetString();
+
+			ArchiveInfo& ai = GetAddArchiveInfo(StringToLower(curArchiveName));
+
+			ai.origName        = curArchiveName;
+			ai.path            = cr.GetString();
+			ai.replaced        = cr.GetString();
+			ai.archiveDataPath = cr.GetString();
 
-		ai.updated = false;
-		ai.hashed = (memcmp(ai.checksum, tmp.checksum, sha512::SHA_LEN) != 0);
+			ai.size                = cr.Get<uint64_t>();
+			ai.modified            = cr.Get<uint32_t>();
+			ai.modifiedArchiveData = cr.Get<uint32_t>();
 
+			cr.GetBytes(ai.checksum, sha512::SHA_LEN);
 
-		ai.archiveData = CArchiveScanner::ArchiveData(archivedTbl, true);
-		if (ai.archiveData.IsMap()) {
-			AddDependency(ai.archiveData.GetDependencies(), GetMapHelperContentName());
-		} else if (ai.archiveData.IsGame()) {
-			AddDependency(ai.archiveData.GetDependencies(), GetSpringBaseContentName());
+			// checksums are computed lazily, on first request
+			ai.updated = false;
+			ai.hashed = (cr.Get<uint8_t>() != 0);
+
+			ai.archiveData = {};
+
+			ReadArchiveData(cr, ai.archiveData);
 		}
-	}
 
-	for (int i = 1; brokenArchivesTbl.KeyExists(i); ++i) {
-		const LuaTable& curArchive = brokenArchivesTbl.SubTable(i);
-		const std::string& name = StringToLower(curArchive.GetString("name", ""));
+		for (uint32_t i = 0, n = cr.Get<uint32_t>(); i < n && cr.valid; i++) {
+			const std::string& name = StringToLower(cr.GetString());
+
+			BrokenArchive& ba = GetAddBrokenArchive(name);
+			ba.name = name;
+			ba.path = cr.GetString();
+			ba.size = cr.Get<uint64_t>();
+			ba.modified = cr.Get<uint32_t>();
+			ba.updated = false;
+			ba.problem = cr.GetString();
+		}
+
+		for (uint32_t i = 0, n = cr.Get<uint32_t>(); i < n && cr.valid; i++) {
+			const std::string& path = cr.GetString();
+
+			ScannedDir& sd = GetAddScannedDir(path);
+			sd.path = path;
+			sd.archives.clear();
+			sd.subDirs.clear();
+			sd.modified = cr.Get<uint32_t>();
+			sd.listed = cr.Get<uint32_t>();
+			sd.updated = false;
 
-		BrokenArchive& ba = GetAddBrokenArchive(name);
-		ba.name = name;
-		ba.path = curArchive.GetString("path", "");
-		ba.modified = strtoul(curArchive.GetString("modified", "0").c_str(), nullptr, 10);
-		ba.updated = false;
-		ba.problem = curArchive.GetString("problem", "unknown");
+			for (uint32_t j = 0, m = cr.Get<uint32_t>(); j < m && cr.valid; j++) {
+				sd.archives.push_back(cr.GetString());
+			}
+			for (uint32_t j = 0, m = cr.Get<uint32_t>(); j < m && cr.valid; j++) {
+				sd.subDirs.push_back(cr.GetString());
+			}
+		}
+	} catch (const std::exception& e) {
+		LOG_L(L_ERROR, "[AS::%s] exception \"%s\" parsing ArchiveCache \"%s\"", __func__, e.what(), filename.c_str());
+		cr.valid = false;
 	}
 
-	isDirty = false;
-}
+	if (!cr.valid) {
+		LOG_L(L_ERROR, "[AS::%s] ArchiveCache \"%s\" is truncated or corrupt, rescanning", __func__, filename.c_str());
 
-static inline void SafeStr(FILE* out, const char* prefix, const std::string& str)
-{
-	if (str.empty())
+		archiveInfos.clear();
+		archiveInfosIndex.clear();
+		brokenArchives.clear();
+		brokenArchivesIndex.clear();
+		scannedDirs.clear();
+		scannedDirsIndex.clear();
 		return;
-
-	if ((str.find_first_of("\\\"") != std::string::npos) || (str.find_first_of('\n') != std::string::npos )) {
-		fprintf(out, "%s[[%s]],\n", prefix, str.c_str());
-	} else {
-		fprintf(out, "%s\"%s\",\n", prefix, str.c_str());
 	}
-}
 
-void FilterDep(std::vector<std::string>& deps, const std::string& exclude)
-{
-	auto it = std::remove_if(deps.begin(), deps.end(), [&](const std::string& dep) { return (dep == exclude); });
-	deps.erase(it, deps.end());
+	isDirty = false;
 }
 
 void CArchiveScanner::WriteCacheData(const std::string& filename)
@@ -1077,25 +1264,23 @@ void CArchiveScanner::WriteCacheData(const std::string& filename)
 	if (!isDirty)
 		return;
 
-	FILE* out = fopen(filename.c_str(), "wt");
-	if (out == nullptr) {
-		LOG_L(L_ERROR, "[AS::%s] failed to write to \"%s\"!", __func__, filename.c_str());
-		return;
-	}
-
 	// First delete all outdated information
 	{
 		std::stable_sort(archiveInfos.begin(), archiveInfos.end(), [](const ArchiveInfo& a, const ArchiveInfo& b) { return (a.origName < b.origName); });
 		std::stable_sort(brokenArchives.begin(), brokenArchives.end(), [](const BrokenArchive& a, const BrokenArchive& b) { return (a.name < b.name); });
+		std::stable_sort(scannedDirs.begin(), scannedDirs.end(), [](const ScannedDir& a, const ScannedDir& b) { return (a.path < b.path); });
 
 		const auto it = std::remove_if(archiveInfos.begin(), archiveInfos.end(), [](const ArchiveInfo& i) { return (!i.updated); });
 		const auto jt = std::remove_if(brokenArchives.begin(), brokenArchives.end(), [](const BrokenArchive& i) { return (!i.updated); });
+		const auto kt = std::remove_if(scannedDirs.begin(), scannedDirs.end(), [](const ScannedDir& i) { return (!i.updated); });
 
 		archiveInfos.erase(it, archiveInfos.end());
 		brokenArchives.erase(jt, brokenArchives.end());
+		scannedDirs.erase(kt, scannedDirs.end());
 
 		archiveInfosIndex.clear();
 		brokenArchivesIndex.clear();
+		scannedDirsIndex.clear();
 
 		// rebuild index-maps
 		for (const ArchiveInfo& ai: archiveInfos) {
@@ -1104,82 +1289,70 @@ void CArchiveScanner::WriteCacheData(const std::string& filename)
 		for (const BrokenArchive& bi: brokenArchives) {
 			brokenArchivesIndex.insert(bi.name, &bi - &brokenArchives[0]);
 		}
+		for (const ScannedDir& sd: scannedDirs) {
+			scannedDirsIndex.insert(sd.path, &sd - &scannedDirs[0]);
+		}
 	}
 
+	CacheWriter cw;
+	cw.buffer.reserve(archiveInfos.size() * 512);
 
-	fprintf(out, "local archiveCache = {\n\n");
-	fprintf(out, "\tinternalver = %i,\n\n", INTERNAL_VER);
-	fprintf(out, "\tarchives = {  -- count = %u\n", unsigned(archiveInfos.size()));
+	cw.Put<uint32_t>(CACHE_MAGIC);
+	cw.Put<uint32_t>(INTERNAL_VER);
+	cw.Put<uint32_t>(archiveInfos.size());
 
 	for (const ArchiveInfo& arcInfo: archiveInfos) {
-		sha512::raw_digest rawDigest;
-		sha512::hex_digest hexDigest;
-
-		std::memcpy(rawDigest.data(), arcInfo.checksum, sha512::SHA_LEN);
-		sha512::dump_digest(rawDigest, hexDigest);
-
-		fprintf(out, "\t\t{\n");
-		SafeStr(out, "\t\t\tname = ",              arcInfo.origName);
-		SafeStr(out, "\t\t\tpath = ",              arcInfo.path);
-		fprintf(out, "\t\t\tmodified = \"%u\",\n", arcInfo.modified);
-		fprintf(out, "\t\t\tchecksum = \"%s\",\n", hexDigest.data());
-		SafeStr(out, "\t\t\treplaced = ",          arcInfo.replaced);
-
-		if (!arcInfo.archiveDataPath.empty()) {
-			SafeStr(out, "\t\t\tarchiveDataPath = ",              arcInfo.archiveDataPath);
-			fprintf(out, "\t\t\tmodifiedArchiveData = \"%u\",\n", arcInfo.modifiedArchiveData);
-		}
+		cw.PutString(arcInfo.origName);
+		cw.PutString(arcInfo.path);
+		cw.PutString(arcInfo.replaced);
+		cw.PutString(arcInfo.archiveDataPath);
 
-		// mod info?
-		const ArchiveData& archData = arcInfo.archiveData;
-		if (!archData.GetName().empty()) {
-			fprintf(out, "\t\t\tarchivedata = {\n");
+		cw.Put<uint64_t>(arcInfo.size);
+		cw.Put<uint32_t>(arcInfo.modified);
+		cw.Put<uint32_t>(arcInfo.modifiedArchiveData);
 
-			for (const auto& ii: archData.GetInfo()) {
-				if (ii.second.valueType == INFO_VALUE_TYPE_STRING) {
-					SafeStr(out, std::string("\t\t\t\t" + ii.first + " = ").c_str(), ii.second.valueTypeString);
-				} else {
-					fprintf(out, "\t\t\t\t%s = %s,\n", ii.first.c_str(), ii.second.GetValueAsString(false).c_str());
-				}
-			}
+		cw.PutBytes(arcInfo.checksum, sha512::SHA_LEN);
+		cw.Put<uint8_t>(arcInfo.hashed);
 
-			std::vector<std::string> deps = archData.GetDependencies();
-			if (archData.IsMap()) {
-				FilterDep(deps, GetMapHelperContentName());
-			} else if (archData.IsGame()) {
-				FilterDep(deps, GetSpringBaseContentName());
-			}
+		WriteArchiveData(cw, arcInfo.archiveData);
+	}
 
-			if (!deps.empty()) {
-				fprintf(out, "\t\t\t\tdepend = {\n");
-				for (const auto& dep: deps) {
-					SafeStr(out, "\t\t\t\t\t", dep);
-				}
-				fprintf(out, "\t\t\t\t},\n");
-			}
-			fprintf(out, "\t\t\t},\n");
-		}
+	cw.Put<uint32_t>(brokenArchives.size());
 
-		fprintf(out, "\t\t},\n");
+	for (const BrokenArchive& ba: brokenArchives) {
+		cw.PutString(ba.name);
+		cw.PutString(ba.path);
+		cw.Put<uint64_t>(ba.size);
+		cw.Put<uint32_t>(ba.modified);
+		cw.PutString(ba.problem);
 	}
 
-	fprintf(out, "\t},\n\n"); // close 'archives'
-	fprintf(out, "\tbrokenArchives = {  -- count = %u\n", unsigned(brokenArchives.size()));
+	cw.Put<uint32_t>(scannedDirs.size());
 
-	for (const BrokenArchive& ba: brokenArchives) {
-		fprintf(out, "\t\t{\n");
-		SafeStr(out, "\t\t\tname = ", ba.name);
-		SafeStr(out, "\t\t\tpath = ", ba.path);
-		fprintf(out, "\t\t\tmodified = \"%u\",\n", ba.modified);
-		SafeStr(out, "\t\t\tproblem = ", ba.problem);
-		fprintf(out, "\t\t},\n");
+	for (const ScannedDir& sd: scannedDirs) {
+		cw.PutString(sd.path);
+		cw.Put<uint32_t>(sd.modified);
+		cw.Put<uint32_t>(sd.listed);
+
+		cw.Put<uint32_t>(sd.archives.size());
+		for (const std::string& archive: sd.archives) {
+			cw.PutString(archive);
+		}
+		cw.Put<uint32_t>(sd.subDirs.size());
+		for (const std::string& dir: sd.subDirs) {
+			cw.PutString(dir);
+		}
+	}
+
+	FILE* out = fopen(filename.c_str(), "wb");
+	if (out == nullptr) {
+		LOG_L(L_ERROR, "[AS::%s] failed to write to \"%s\"!", __func__, filename.c_str());
+		return;
 	}
 
-	fprintf(out, "\t},\n"); // close 'brokenArchives'
-	fprintf(out, "}\n\n"); // close 'archiveCache'
-	fprintf(out, "return archiveCache\n");
+	const size_t numBytes = fwrite(cw.buffer.data(), 1, cw.buffer.size(), out);
 
-	if (fclose(out) == EOF)
+	if ((fclose(out) == EOF) || (numBytes != cw.buffer.size()))
 		LOG_L(L_ERROR, "[AS::%s] failed to write to \"%s\"!", __func__, filename.c_str());
 
 	isDirty = false;
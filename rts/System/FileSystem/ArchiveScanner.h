@@ -169,6 +169,7 @@ private:
 
 		ArchiveData archiveData;
 
+		uint64_t size = 0;
 		uint32_t modified = 0;
 		uint32_t modifiedArchiveData = 0;
 		uint8_t checksum[sha512::SHA_LEN];
@@ -181,13 +182,24 @@ private:
 		std::string path;         // FileSystem::GetDirectory(origName)
 		std::string problem;
 
+		uint64_t size = 0;
 		uint32_t modified = 0;
 		bool updated = false;
 	};
+	struct ScannedDir {
+		std::string path;                  // absolute, with trailing separator
+		std::vector<std::string> archives; // archive files found directly in path
+		std::vector<std::string> subDirs;  // directories to descend into
+
+		uint32_t modified = 0;
+		uint32_t listed = 0;               // time at which path was listed
+		bool updated = false;
+	};
 
 private:
 	ArchiveInfo& GetAddArchiveInfo(const std::string& lcfn);
 	BrokenArchive& GetAddBrokenArchive(const std::string& lcfn);
+	ScannedDir& GetAddScannedDir(const std::string& path);
 
 	void ScanDirs(const std::vector<std::string>& dirs);
 	void ScanDir(const std::string& curPath, std::deque<std::string>& foundArchives);
@@ -213,7 +225,11 @@ private:
 	 */
 	bool GetArchiveChecksum(const std::string& filename, ArchiveInfo& archiveInfo);
 
-	bool CheckCachedData(const std::string& fullName, unsigned& modified, bool doChecksum);
+	/**
+	 * Checks the archive's (mtime, size) fingerprint against the cache.
+	 * Returns true if the cached info can be used as-is.
+	 */
+	bool CheckCachedData(const std::string& fullName, unsigned& modified, size_t& size, bool doChecksum);
 
 	/**
 	 * Returns a value > 0 if the file is rated as a meta-file.
@@ -239,9 +255,11 @@ private:
 private:
 	spring::unordered_map<std::string, size_t> archiveInfosIndex;
 	spring::unordered_map<std::string, size_t> brokenArchivesIndex;
+	spring::unordered_map<std::string, size_t> scannedDirsIndex;
 
 	std::vector<ArchiveInfo> archiveInfos;
 	std::vector<BrokenArchive> brokenArchives;
+	std::vector<ScannedDir> scannedDirs;
 
 	std::string cachefile;
 
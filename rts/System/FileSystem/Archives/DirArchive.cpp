@@ -63,6 +63,14 @@ bool CDirArchive::GetFile(unsigned int fid, std::vector<std::uint8_t>& buffer)
 	return true;
 }
 
+bool CDirArchive::GetFileMapping(unsigned int fid, CMappedFile& mapping)
+{
+	assert(IsFileId(fid));
+
+	// all entries are stored raw, no need for a fallback
+	return (mapping.Open(dataDirsAccess.LocateFile(dirName + searchFiles[fid])));
+}
+
 void CDirArchive::FileInfo(unsigned int fid, std::string& name, int& size) const
 {
 	assert(IsFileId(fid));
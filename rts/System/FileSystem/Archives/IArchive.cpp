@@ -39,3 +39,13 @@ bool IArchive::GetFile(const std::string& name, std::vector<std::uint8_t>& buffe
 	return true;
 }
 
+
+bool IArchive::GetFileMapping(const std::string& name, CMappedFile& mapping)
+{
+	const unsigned int fid = FindFile(name);
+
+	if (!IsFileId(fid))
+		return false;
+
+	return (GetFileMapping(fid, mapping));
+}
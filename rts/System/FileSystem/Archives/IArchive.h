@@ -8,6 +8,7 @@
 #include <cinttypes>
 
 #include "ArchiveTypes.h"
+#include "System/FileSystem/MappedFile.h"
 #include "System/Sync/SHA512.hpp"
 #include "System/UnorderedMap.hpp"
 
@@ -82,6 +83,18 @@ public:
 	 */
 	bool GetFile(const std::string& name, std::vector<std::uint8_t>& buffer);
 
+	/**
+	 * Maps the content of a file by its ID into memory without copying it,
+	 * which is only possible for entries stored uncompressed on disk.
+	 * @param fid file ID in [0, NumFiles())
+	 * @param mapping on success, this will be a read-only view of the
+	 *   contents of the file
+	 * @return true if the file could be mapped, false if callers have to
+	 *   fall back to GetFile
+	 */
+	virtual bool GetFileMapping(unsigned int fid, CMappedFile& mapping) { return false; }
+	bool GetFileMapping(const std::string& name, CMappedFile& mapping);
+
 	std::pair<std::string, int> FileInfo(unsigned int fid) const {
 		std::pair<std::string, int> info;
 		FileInfo(fid, info.first, info.second);
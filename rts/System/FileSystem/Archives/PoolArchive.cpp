@@ -123,12 +123,11 @@ CPoolArchive::~CPoolArchive()
 	}
 }
 
-int CPoolArchive::GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer)
+std::string CPoolArchive::GetPoolFilePath(unsigned int fid) const
 {
 	assert(IsFileId(fid));
 
-	FileData* f = &files[fid];
-	FileStat* s = &stats[fid];
+	const FileData* f = &files[fid];
 
 	constexpr const char table[] = "0123456789abcdef";
 	char c_hex[32];
@@ -141,8 +140,50 @@ int CPoolArchive::GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffe
 	const std::string prefix(c_hex,      2);
 	const std::string pstfix(c_hex + 2, 30);
 
-	      std::string rpath = poolRootDir + "/pool/" + prefix + "/" + pstfix + ".gz";
-	const std::string  path = FileSystem::FixSlashes(rpath);
+	std::string rpath = poolRootDir + "/pool/" + prefix + "/" + pstfix + ".gz";
+	return (FileSystem::FixSlashes(rpath));
+}
+
+bool CPoolArchive::GetFileMapping(unsigned int fid, CMappedFile& mapping)
+{
+	assert(IsFileId(fid));
+
+	// guards the lazily calculated shasum, same as GetFileImpl
+	std::lock_guard<spring::mutex> lck(archiveLock);
+
+	FileData* f = &files[fid];
+	FileStat* s = &stats[fid];
+
+	const spring_time startTime = spring_now();
+
+	if (!mapping.Open(GetPoolFilePath(fid)))
+		return false;
+
+	const std::uint8_t* data = mapping.GetData();
+	const size_t        size = mapping.GetSize();
+
+	// entries are normally gzip'ed and need to be inflated by GetFile, only
+	// stored (raw) ones can be handed out as-is; zlib reads both formats
+	if (size != f->size || (size >= 2 && data[0] == 0x1f && data[1] == 0x8b)) {
+		mapping.Close();
+		return false;
+	}
+
+	if (memcmp(f->shasum.data(), dummyFileHash.data(), sizeof(f->shasum)) == 0)
+		sha512::calc_digest(data, size, f->shasum.data());
+
+	s->readTime = (spring_now() - startTime).toNanoSecsi();
+	return true;
+}
+
+int CPoolArchive::GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer)
+{
+	assert(IsFileId(fid));
+
+	FileData* f = &files[fid];
+	FileStat* s = &stats[fid];
+
+	const std::string path = GetPoolFilePath(fid);
 
 	const spring_time startTime = spring_now();
 
@@ -101,9 +101,13 @@ public:
 		return (memcmp(fd.shasum.data(), dummyFileHash.data(), sizeof(fd.shasum)) != 0);
 	}
 
+	bool GetFileMapping(unsigned int fid, CMappedFile& mapping) override;
+
 protected:
 	int GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer) override;
 
+	std::string GetPoolFilePath(unsigned int fid) const;
+
 	std::pair<uint64_t, uint64_t> GetSums() const {
 		std::pair<uint64_t, uint64_t> p;
 
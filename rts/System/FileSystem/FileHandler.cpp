@@ -92,6 +92,9 @@ bool CFileHandler::TryReadFromVFS(const string& fileName, int section)
 	if (vfsHandler == nullptr)
 		return (loadCode = -2, false);
 
+	if (TryMapFromVFS(fileName, section))
+		return true;
+
 	if ((loadCode = vfsHandler->LoadFile(StringToLower(fileName), fileBuffer, (CVFSHandler::Section) section)) == 1) {
 		// capacity can exceed size if FH was used to open more than one file
 		// assert(fileBuffer.size() == fileBuffer.capacity());
@@ -104,6 +107,19 @@ bool CFileHandler::TryReadFromVFS(const string& fileName, int section)
 }
 
 
+bool CFileHandler::TryMapFromVFS(const string& fileName, int section)
+{
+#ifndef TOOLS
+	// large stored entries (maps, textures) are not copied into fileBuffer
+	if ((loadCode = vfsHandler->MapFile(StringToLower(fileName), fileMapping, (CVFSHandler::Section) section, MIN_MAPPED_FILE_SIZE)) == 1) {
+		fileSize = fileMapping.GetSize();
+		return true;
+	}
+#endif
+	return false;
+}
+
+
 void CFileHandler::Open(const string& fileName, const string& modes)
 {
 	this->fileName = fileName;
@@ -130,6 +146,7 @@ void CFileHandler::Close()
 
 	ifs.close();
 	fileBuffer.clear();
+	fileMapping.Close();
 }
 
 
@@ -173,15 +190,17 @@ int CFileHandler::Read(void* buf, int length)
 		return ifs.gcount();
 	}
 
-	if (fileBuffer.empty())
+	const std::uint8_t* fileData = GetFileData();
+
+	if (fileData == nullptr)
 		return 0;
 
 	if ((length + filePos) > fileSize)
 		length = fileSize - filePos;
 
 	if (length > 0) {
-		assert(fileBuffer.size() >= (filePos + length));
-		memcpy(buf, &fileBuffer[filePos], length);
+		assert(fileSize >= (filePos + length));
+		memcpy(buf, fileData + filePos, length);
 		filePos += length;
 	}
 
@@ -218,7 +237,7 @@ void CFileHandler::Seek(int length, std::ios_base::seekdir where)
 		ifs.seekg(length, where);
 		return;
 	}
-	if (fileBuffer.empty())
+	if (GetFileData() == nullptr)
 		return;
 
 	switch (where) {
@@ -234,7 +253,7 @@ bool CFileHandler::Eof() const
 	if (ifs.is_open())
 		return ifs.eof();
 
-	if (!fileBuffer.empty())
+	if (GetFileData() != nullptr)
 		return (filePos >= fileSize);
 
 	return true;
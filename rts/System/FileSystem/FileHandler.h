@@ -8,6 +8,7 @@
 #include <fstream>
 #include <cinttypes>
 
+#include "MappedFile.h"
 #include "VFSModes.h"
 
 /**
@@ -22,6 +23,9 @@
 class CFileHandler
 {
 public:
+	// VFS files smaller than this are always read into fileBuffer
+	static constexpr int MIN_MAPPED_FILE_SIZE = 256 * 1024;
+
 	CFileHandler(const char* fileName, const char* modes = SPRING_VFS_RAW_FIRST);
 	CFileHandler(const std::string& fileName, const std::string& modes = SPRING_VFS_RAW_FIRST);
 	virtual ~CFileHandler() { Close(); }
@@ -38,6 +42,8 @@ public:
 	bool FileExists() const { return (fileSize >= 0); }
 	// true if (and only if) TryReadFromVFS succeeds
 	bool IsBuffered() const { return (!fileBuffer.empty()); }
+	// true if TryReadFromVFS succeeded by mapping a stored archive entry
+	bool IsMapped() const { return (fileMapping.IsOpen()); }
 
 	bool Eof() const;
 	int GetPos();
@@ -50,6 +56,7 @@ public:
 	static std::string GetArchiveContainingFile(const std::string& filePath, const std::string& modes);
 
 	std::vector<std::uint8_t>& GetBuffer() { return fileBuffer; }
+	const CMappedFile& GetMapping() const { return fileMapping; }
 
 	static bool InReadDir(const std::string& path);
 	static bool InWriteDir(const std::string& path);
@@ -65,9 +72,17 @@ public:
 protected:
 	CFileHandler() { Close(); } // for CGZFileHandler
 
+	const std::uint8_t* GetFileData() const {
+		if (fileMapping.IsOpen())
+			return (fileMapping.GetData());
+
+		return (fileBuffer.empty()? nullptr: fileBuffer.data());
+	}
+
 	virtual bool TryReadFromPWD(const std::string& fileName);
 	virtual bool TryReadFromRawFS(const std::string& fileName);
 	virtual bool TryReadFromVFS(const std::string& fileName, int section);
+	virtual bool TryMapFromVFS(const std::string& fileName, int section);
 
 	static bool InsertRawFiles(std::vector<std::string>& fileSet, const std::string& path, const std::string& pattern);
 	static bool InsertVFSFiles(std::vector<std::string>& fileSet, const std::string& path, const std::string& pattern, int section);
@@ -78,6 +93,8 @@ protected:
 	std::string fileName;
 	std::ifstream ifs;
 	std::vector<std::uint8_t> fileBuffer;
+	// read-only view of a file stored raw in an archive, replaces fileBuffer
+	CMappedFile fileMapping;
 
 	int filePos = 0;
 	int fileSize = -1;
@@ -185,6 +185,19 @@ unsigned int FileSystemAbstraction::GetFileModificationTime(const std::string& f
 	return info.st_mtime;
 }
 
+unsigned int FileSystemAbstraction::GetFileModificationTime(const std::string& file, size_t& size)
+{
+	struct stat info;
+
+	if (stat(file.c_str(), &info) != 0) {
+		LOG_L(L_WARNING, "[FSA::%s] error '%s' getting last modification time of file '%s'", __func__, strerror(errno), file.c_str());
+		return (size = 0);
+	}
+
+	size = info.st_size;
+	return info.st_mtime;
+}
+
 std::string FileSystemAbstraction::GetFileModificationDate(const std::string& file)
 {
 	const std::time_t t = GetFileModificationTime(file);
@@ -109,6 +109,11 @@ public:
 	static bool IsReadableFile(const std::string& file);
 
 	static unsigned int GetFileModificationTime(const std::string& file);
+	/**
+	 * Same as GetFileModificationTime, but also fetches the size with the
+	 * same stat call (for directories the size of the entry itself).
+	 */
+	static unsigned int GetFileModificationTime(const std::string& file, size_t& size);
 	/**
 	 * Returns the last file modification time formatted in a sort friendly
 	 * way, with second resolution.
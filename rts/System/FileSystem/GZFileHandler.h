@@ -21,6 +21,7 @@ private:
 	bool TryReadFromPWD(const std::string& fileName) override;
 	bool TryReadFromRawFS(const std::string& fileName) override;
 	bool TryReadFromVFS(const std::string& fileName, int section) override;
+	bool TryMapFromVFS(const std::string& fileName, int section) override { return false; }
 	bool ReadToBuffer(const std::string& path);
 	bool UncompressBuffer();
 };
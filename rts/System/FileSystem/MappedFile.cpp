@@ -0,0 +1,126 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "MappedFile.h"
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#else
+	#include <windows.h>
+#endif
+
+
+CMappedFile& CMappedFile::operator = (CMappedFile&& mf)
+{
+	if (this == &mf)
+		return *this;
+
+	Close();
+
+	std::swap(data, mf.data);
+	std::swap(size, mf.size);
+
+	#ifdef _WIN32
+	std::swap(fileHandle, mf.fileHandle);
+	std::swap(mapHandle, mf.mapHandle);
+	#endif
+
+	std::swap(isOpen, mf.isOpen);
+	return *this;
+}
+
+
+bool CMappedFile::Open(const std::string& path)
+{
+	Close();
+
+#ifndef _WIN32
+	const int fd = open(path.c_str(), O_RDONLY);
+
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+
+	if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+		close(fd);
+		return false;
+	}
+
+	// zero-length mappings are not allowed, treat empty files as open
+	if ((size = info.st_size) > 0) {
+		void* ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (ptr == MAP_FAILED) {
+			close(fd);
+			return (size = 0, false);
+		}
+
+		// entries are almost always consumed front-to-back
+		madvise(ptr, size, MADV_SEQUENTIAL);
+
+		data = reinterpret_cast<const std::uint8_t*>(ptr);
+	}
+
+	// the mapping stays valid after the descriptor is closed
+	close(fd);
+#else
+	HANDLE fh = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (fh == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fs;
+
+	if (!GetFileSizeEx(fh, &fs)) {
+		CloseHandle(fh);
+		return false;
+	}
+
+	if ((size = fs.QuadPart) > 0) {
+		HANDLE mh = CreateFileMappingA(fh, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (mh == nullptr) {
+			CloseHandle(fh);
+			return (size = 0, false);
+		}
+
+		if ((data = reinterpret_cast<const std::uint8_t*>(MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0))) == nullptr) {
+			CloseHandle(mh);
+			CloseHandle(fh);
+			return (size = 0, false);
+		}
+
+		mapHandle = mh;
+	}
+
+	fileHandle = fh;
+#endif
+
+	return (isOpen = true);
+}
+
+void CMappedFile::Close()
+{
+#ifndef _WIN32
+	if (data != nullptr)
+		munmap(const_cast<std::uint8_t*>(data), size);
+#else
+	if (data != nullptr)
+		UnmapViewOfFile(data);
+	if (mapHandle != nullptr)
+		CloseHandle(mapHandle);
+	if (fileHandle != nullptr)
+		CloseHandle(fileHandle);
+
+	mapHandle = nullptr;
+	fileHandle = nullptr;
+#endif
+
+	data = nullptr;
+	size = 0;
+
+	isOpen = false;
+}
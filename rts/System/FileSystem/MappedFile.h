@@ -0,0 +1,53 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _MAPPED_FILE_H
+#define _MAPPED_FILE_H
+
+#include <string>
+#include <utility>
+#include <cinttypes>
+
+/**
+ * Read-only memory-mapped view of a file on the real file-system.
+ * Used by archives which store (some of) their entries uncompressed
+ * to hand out their contents without copying them into a buffer.
+ */
+class CMappedFile
+{
+public:
+	CMappedFile() = default;
+	CMappedFile(const CMappedFile& mf) = delete;
+	CMappedFile(CMappedFile&& mf) { *this = std::move(mf); }
+	~CMappedFile() { Close(); }
+
+	CMappedFile& operator = (const CMappedFile& mf) = delete;
+	CMappedFile& operator = (CMappedFile&& mf);
+
+	/**
+	 * Maps the entire file at (absolute) path into memory.
+	 * @return false if the file could not be opened or mapped
+	 */
+	bool Open(const std::string& path);
+	void Close();
+
+	bool IsOpen() const { return isOpen; }
+
+	const std::uint8_t* GetData() const { return data; }
+	const std::uint8_t* GetDataEnd() const { return (data + size); }
+
+	size_t GetSize() const { return size; }
+
+private:
+	const std::uint8_t* data = nullptr;
+
+	size_t size = 0;
+
+	#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mapHandle = nullptr;
+	#endif
+
+	bool isOpen = false;
+};
+
+#endif // _MAPPED_FILE_H
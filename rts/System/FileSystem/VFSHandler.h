@@ -11,6 +11,7 @@
 #include "System/UnorderedMap.hpp"
 
 class IArchive;
+class CMappedFile;
 
 /**
  * Main API for accessing the Virtual File System (VFS).
@@ -104,6 +105,17 @@ public:
 	 */
 	int LoadFile(const std::string& filePath, std::vector<std::uint8_t>& buffer, Section section);
 
+	/**
+	 * Maps the contents of a file within the VFS into memory without
+	 * copying, if its archive stores it uncompressed.
+	 * @param filePath raw file path, for example "maps/myMap.smf",
+	 *   case-insensitive
+	 * @param minFileSize files smaller than this are not mapped
+	 * @return 1 if the file exists in the VFS and was mapped, 0 if it has
+	 *   to be read via LoadFile instead, -1 if it does not exist
+	 */
+	int MapFile(const std::string& filePath, CMappedFile& mapping, Section section, int minFileSize = 0);
+
 
 	/**
 	 * Returns all the files in the given (virtual) directory without the
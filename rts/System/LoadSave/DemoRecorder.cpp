@@ -194,17 +194,26 @@ void CDemoRecorder::SetPlayerStats(int playerNum, const PlayerStatistics& stats)
 	playerStats[playerNum] = stats;
 }
 
-/** @brief Set (overwrite) the TeamStatistics history for team teamNum */
-void CDemoRecorder::SetTeamStats(int teamNum, const std::vector<TeamStatistics>& stats)
+/** @brief Append a TeamStatistics snapshot to the history of team teamNum */
+void CDemoRecorder::AddTeamStats(int teamNum, const TeamStatistics& stats)
 {
-	assert((unsigned)teamNum < teamStats.size()); //FIXME
+	// the history grows while streaming, but once InitializeStats has fixed
+	// the team count it must match what the header will claim
+	assert(teamNum >= 0);
+	assert(fileHeader.numTeams == 0 || teamNum < fileHeader.numTeams);
 
-	teamStats[teamNum].clear();
-	teamStats[teamNum].reserve(stats.size());
+	if (teamNum >= teamStats.size())
+		teamStats.resize(teamNum + 1);
 
-	for (const auto& stat: stats) {
-		teamStats[teamNum].push_back(stat);
-	}
+	teamStats[teamNum].push_back(stats);
+}
+
+size_t CDemoRecorder::GetNumTeamStats(int teamNum) const
+{
+	if (teamNum >= teamStats.size())
+		return 0;
+
+	return (teamStats[teamNum].size());
 }
 
 
@@ -280,6 +289,10 @@ void CDemoRecorder::WriteTeamStats()
 {
 	const size_t pos = demoStreams[isServerDemo].size();
 
+	// snapshots are streamed in before the team count is known; without
+	// InitializeStats (no game end) numTeams stays 0 and they are dropped
+	teamStats.resize(fileHeader.numTeams);
+
 	// Write array of dwords indicating number of TeamStatistics per team.
 	for (std::vector<TeamStatistics>& history: teamStats) {
 		unsigned int c = swabDWord(history.size());
@@ -59,7 +59,9 @@ public:
 	void AddNewPlayer(const std::string& name, int playerNum);
 	void InitializeStats(int numPlayers, int numTeams);
 	void SetPlayerStats(int playerNum, const PlayerStatistics& stats);
-	void SetTeamStats(int teamNum, const std::vector<TeamStatistics>& stats);
+	// snapshots are streamed in as the game produces them
+	void AddTeamStats(int teamNum, const TeamStatistics& stats);
+	size_t GetNumTeamStats(int teamNum) const;
 	void SetWinningAllyTeams(const std::vector<unsigned char>& winningAllyTeams);
 
 private:
@@ -92,6 +92,30 @@ static inline unsigned count_leading_ones(unsigned int x)
 }
 
 
+/**
+ * @brief Count trailing zeros
+ * @param x Number to test, must be non-zero
+ * @return index of the least significant 1-bit of x
+ */
+static inline unsigned count_trailing_zeros64(unsigned long long x)
+{
+#ifdef __GNUC__
+	return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_WIN64)
+	unsigned long r;
+	_BitScanForward64(&r, x);
+	return r;
+#else
+	unsigned i = 0;
+	while (!(x & 0x1)) {
+		x = x >> 1;
+		++i;
+	}
+	return i;
+#endif
+}
+
+
 /**
  * quote from GCC doc "Returns one plus the index of the least significant 1-bit of x, or if x is zero, returns zero."
  */
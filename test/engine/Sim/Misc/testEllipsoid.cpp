@@ -1,9 +1,12 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include "Sim/Misc/CollisionVolumeBatch.h"
 #include "System/float3.h"
 #include "System/SpringMath.h"
 #include <stdlib.h>
 #include <time.h>
+#include <algorithm>
+#include <vector>
 
 #define CATCH_CONFIG_MAIN
 #include "lib/catch.hpp"
@@ -160,3 +163,181 @@ TEST_CASE("Ellipsoid")
 	INFO("Inaccurate ellipsoid distance approximation!");
 	CHECK(failCount < MAX_FAILS);
 }
+
+
+
+static inline float randf(float scale)
+{
+	return ((rand() / float(RAND_MAX)) * 2.0f - 1.0f) * scale;
+}
+
+// true iff segment <p0, p1> touches the axis-aligned ellipsoid
+// with center <c> and half-scales <h> (solved in double-precision)
+static bool SegmentHitsEllipsoid(const float3& p0, const float3& p1, const float3& c, const float3& h)
+{
+	const double ox = (p0.x - c.x) / double(h.x), dx = (p1.x - p0.x) / double(h.x);
+	const double oy = (p0.y - c.y) / double(h.y), dy = (p1.y - p0.y) / double(h.y);
+	const double oz = (p0.z - c.z) / double(h.z), dz = (p1.z - p0.z) / double(h.z);
+
+	const double A = dx * dx + dy * dy + dz * dz;
+	const double B = 2.0 * (ox * dx + oy * dy + oz * dz);
+	const double C = ox * ox + oy * oy + oz * oz - 1.0;
+
+	if (C <= 0.0)
+		return true;
+	if (A == 0.0)
+		return false;
+
+	const double D = B * B - 4.0 * A * C;
+
+	if (D < 0.0)
+		return false;
+
+	const double t0 = (-B - std::sqrt(D)) / (2.0 * A);
+	const double t1 = (-B + std::sqrt(D)) / (2.0 * A);
+
+	return ((t0 >= 0.0 && t0 <= 1.0) || (t1 >= 0.0 && t1 <= 1.0));
+}
+
+// signed distance between segment <p0, p1> and a sphere's surface
+static double SegmentSphereDist(const float3& p0, const float3& p1, const float3& c, float r)
+{
+	const double dx = p1.x - p0.x, wx = c.x - p0.x;
+	const double dy = p1.y - p0.y, wy = c.y - p0.y;
+	const double dz = p1.z - p0.z, wz = c.z - p0.z;
+	const double dd = dx * dx + dy * dy + dz * dz;
+	const double t = (dd > 0.0)? std::min(1.0, std::max(0.0, (wx * dx + wy * dy + wz * dz) / dd)): 0.0;
+
+	const double ex = wx - dx * t;
+	const double ey = wy - dy * t;
+	const double ez = wz - dz * t;
+
+	return (std::sqrt(ex * ex + ey * ey + ez * ez) - r);
+}
+
+
+#define BATCH_VOLUMES 1021 // not a multiple of the SIMD width
+#define BATCH_RAYS 2000
+
+TEST_CASE("CollisionVolumeBatch")
+{
+	srand(1);
+
+	std::vector<float3> centers(BATCH_VOLUMES);
+	std::vector<float3> hscales(BATCH_VOLUMES);
+
+	CollisionVolumeBatch batch;
+
+	for (unsigned int i = 0; i < BATCH_VOLUMES; i++) {
+		centers[i] = {randf(1000.0f), randf(100.0f), randf(1000.0f)};
+		hscales[i] = {1.0f + std::fabs(randf(40.0f)), 1.0f + std::fabs(randf(40.0f)), 1.0f + std::fabs(randf(40.0f))};
+
+		// bounding-sphere of an ellipsoid is its largest half-axis
+		REQUIRE(batch.AddSphere(centers[i], std::max(hscales[i].x, std::max(hscales[i].y, hscales[i].z))) == i);
+	}
+
+	REQUIRE(batch.GetNumVolumes() == BATCH_VOLUMES);
+
+	std::vector<float3> rayStarts(BATCH_RAYS);
+	std::vector<float3> rayEnds(BATCH_RAYS);
+
+	for (unsigned int r = 0; r < BATCH_RAYS; r++) {
+		rayStarts[r] = {randf(1000.0f), randf(100.0f), randf(1000.0f)};
+		rayEnds[r] = rayStarts[r] + float3(randf(600.0f), randf(60.0f), randf(600.0f)) * (r % 16 != 0);
+	}
+
+	SECTION("single-ray kernel matches scalar sphere tests") {
+		std::vector<unsigned int> hits;
+
+		for (unsigned int r = 0; r < BATCH_RAYS; r++) {
+			hits.clear();
+
+			const unsigned int numHits = batch.TestRay(rayStarts[r], rayEnds[r], hits);
+
+			REQUIRE(numHits == hits.size());
+
+			for (unsigned int k = 1; k < hits.size(); k++) {
+				REQUIRE(hits[k - 1] < hits[k]);
+			}
+
+			unsigned int k = 0;
+
+			for (unsigned int i = 0; i < BATCH_VOLUMES; i++) {
+				const bool batchHit = (k < hits.size() && hits[k] == i);
+				const float radius = std::max(hscales[i].x, std::max(hscales[i].y, hscales[i].z));
+				const double dist = SegmentSphereDist(rayStarts[r], rayEnds[r], centers[i], radius);
+
+				k += batchHit;
+
+				// skip grazing rays, the kernel runs in single-precision
+				if (std::fabs(dist) < 0.01)
+					continue;
+
+				REQUIRE(batchHit == (dist < 0.0));
+			}
+
+			REQUIRE(k == hits.size());
+		}
+	}
+
+	SECTION("broad-phase never rejects an intersected ellipsoid") {
+		std::vector<unsigned int> hits;
+
+		unsigned int numExact = 0;
+
+		for (unsigned int r = 0; r < BATCH_RAYS; r++) {
+			hits.clear();
+			batch.TestRay(rayStarts[r], rayEnds[r], hits);
+
+			for (unsigned int i = 0; i < BATCH_VOLUMES; i++) {
+				if (!SegmentHitsEllipsoid(rayStarts[r], rayEnds[r], centers[i], hscales[i]))
+					continue;
+
+				numExact += 1;
+
+				INFO("ray " << r << " missed ellipsoid " << i);
+				REQUIRE(std::find(hits.begin(), hits.end(), i) != hits.end());
+			}
+		}
+
+		REQUIRE(numExact > 0);
+	}
+
+	SECTION("multi-ray kernel matches single-ray kernel") {
+		std::vector<std::uint32_t> masks;
+		std::vector<unsigned int> hits;
+
+		for (unsigned int r0 = 0; r0 < BATCH_RAYS; r0 += CollisionVolumeBatch::MAX_RAYS) {
+			const unsigned int numRays = std::min(BATCH_RAYS - r0, CollisionVolumeBatch::MAX_RAYS);
+
+			batch.TestRays(&rayStarts[r0], &rayEnds[r0], numRays, masks);
+
+			REQUIRE(masks.size() == BATCH_VOLUMES);
+
+			for (unsigned int r = 0; r < numRays; r++) {
+				hits.clear();
+				batch.TestRay(rayStarts[r0 + r], rayEnds[r0 + r], hits);
+
+				unsigned int k = 0;
+
+				for (unsigned int i = 0; i < BATCH_VOLUMES; i++) {
+					const bool maskHit = ((masks[i] >> r) & 1) != 0;
+					const bool rayHit = (k < hits.size() && hits[k] == i);
+
+					k += rayHit;
+
+					REQUIRE(maskHit == rayHit);
+				}
+			}
+		}
+	}
+
+	SECTION("cleared batch reports nothing") {
+		std::vector<unsigned int> hits;
+
+		batch.Clear();
+
+		REQUIRE(batch.GetNumVolumes() == 0);
+		REQUIRE(batch.TestRay(-OnesVector * 2000.0f, OnesVector * 2000.0f, hits) == 0);
+	}
+}
@@ -0,0 +1,114 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "Sim/Misc/SmoothHeightMeshTile.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+// mirrors SmoothHeightMesh's parameters (radius of 40 squares at a
+// resolution of 2 squares), odd mesh sizes leave partial edge-tiles
+static constexpr int MESH_MAXX = 150;
+static constexpr int MESH_MAXY = 97;
+
+static constexpr int WIN_SIZE = 20;
+static constexpr int BLUR_SIZE = 3;
+static constexpr int NUM_BLURS = 3;
+static constexpr int TILE_SIZE = 32;
+
+
+static inline float randf() {
+	return rand() / float(RAND_MAX);
+}
+
+static void SmoothTile(SmoothHeightMeshTile& tile, const std::vector<float>& heights, int tx, int ty, int tileSize, float maxHeight)
+{
+	tile.SetRect(tx, ty, tileSize, MESH_MAXX, MESH_MAXY, WIN_SIZE, BLUR_SIZE, NUM_BLURS);
+	tile.maxHeight = maxHeight;
+	tile.heights.clear();
+
+	for (int y = tile.iy1; y <= tile.iy2; ++y) {
+		for (int x = tile.ix1; x <= tile.ix2; ++x) {
+			tile.heights.push_back(heights[x + y * (MESH_MAXX + 1)]);
+		}
+	}
+
+	tile.Smooth(WIN_SIZE, BLUR_SIZE, NUM_BLURS);
+}
+
+static void CopyTile(const SmoothHeightMeshTile& tile, std::vector<float>& mesh)
+{
+	const int rowSize = tile.x2 - tile.x1 + 1;
+
+	for (int y = tile.y1; y <= tile.y2; ++y) {
+		for (int x = tile.x1; x <= tile.x2; ++x) {
+			mesh[x + y * (MESH_MAXX + 1)] = tile.result[(y - tile.y1) * rowSize + (x - tile.x1)];
+		}
+	}
+}
+
+
+
+TEST_CASE("SmoothHeightMesh")
+{
+	srand(0);
+
+	// rolling terrain with a few sharp peaks and some ground below water
+	std::vector<float> heights((MESH_MAXX + 1) * (MESH_MAXY + 1));
+	float maxHeight = 0.0f;
+
+	for (int y = 0; y <= MESH_MAXY; ++y) {
+		for (int x = 0; x <= MESH_MAXX; ++x) {
+			float h = 100.0f + 80.0f * std::sin(x * 0.07f) * std::cos(y * 0.05f) + randf() * 10.0f;
+
+			if ((rand() % 200) == 0)
+				h += 300.0f * randf();
+
+			heights[x + y * (MESH_MAXX + 1)] = h = std::max(0.0f, h);
+			maxHeight = std::max(maxHeight, h);
+		}
+	}
+
+	const int numTilesX = (MESH_MAXX + TILE_SIZE) / TILE_SIZE;
+	const int numTilesY = (MESH_MAXY + TILE_SIZE) / TILE_SIZE;
+
+	// one tile spanning the entire mesh
+	SmoothHeightMeshTile fullTile;
+	SmoothTile(fullTile, heights, 0, 0, std::max(MESH_MAXX, MESH_MAXY) + 1, maxHeight);
+
+	REQUIRE(fullTile.x1 == 0);
+	REQUIRE(fullTile.x2 == MESH_MAXX);
+	REQUIRE(fullTile.y2 == MESH_MAXY);
+
+	std::vector<float> fullMesh(heights.size(), -1.0f);
+	CopyTile(fullTile, fullMesh);
+
+	SECTION("tile rebuilds equal a full rebuild") {
+		std::vector<float> tileMesh(heights.size(), -1.0f);
+		SmoothHeightMeshTile tile;
+
+		for (int ty = 0; ty < numTilesY; ++ty) {
+			for (int tx = 0; tx < numTilesX; ++tx) {
+				SmoothTile(tile, heights, tx, ty, TILE_SIZE, maxHeight);
+				CopyTile(tile, tileMesh);
+			}
+		}
+
+		// bit-exact, including cells at tile borders and mesh edges
+		for (size_t i = 0; i < heights.size(); i++) {
+			REQUIRE(tileMesh[i] == fullMesh[i]);
+		}
+	}
+
+	SECTION("smoothed mesh stays between terrain and maximum height") {
+		for (size_t i = 0; i < heights.size(); i++) {
+			REQUIRE(fullMesh[i] >= heights[i]);
+			REQUIRE(fullMesh[i] <= maxHeight);
+		}
+	}
+}
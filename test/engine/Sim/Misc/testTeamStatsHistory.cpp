@@ -0,0 +1,132 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <cstring>
+#include <vector>
+
+#include "Sim/Misc/TeamStatsHistory.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+static constexpr unsigned int NUM_SNAPSHOTS = 2000;
+static constexpr int STATS_PERIOD_FRAMES = TeamStatistics::statsPeriod * 30;
+
+
+static inline float randf() {
+	return rand() / float(RAND_MAX);
+}
+
+static bool Equal(const TeamStatistics& a, const TeamStatistics& b) {
+	return (std::memcmp(&a, &b, sizeof(TeamStatistics)) == 0);
+}
+
+
+// cumulative totals as accumulated by CTeam between snapshots
+static void Advance(TeamStatistics& stats, unsigned int n)
+{
+	stats.frame += STATS_PERIOD_FRAMES;
+
+	stats.metalUsed      += randf() * 300.0f;
+	stats.energyUsed     += randf() * 4000.0f;
+	stats.metalProduced  += randf() * 300.0f;
+	stats.energyProduced += randf() * 4000.0f;
+	stats.metalExcess    += ((n % 7) == 0) * randf() * 50.0f;
+	stats.energyExcess   += ((n % 5) == 0) * randf() * 900.0f;
+	stats.metalReceived  += ((n % 11) == 0) * randf() * 100.0f;
+	stats.metalSent      += ((n % 13) == 0) * randf() * 100.0f;
+	stats.damageDealt    += randf() * 10000.0f;
+	stats.damageReceived += randf() * 10000.0f;
+
+	stats.unitsProduced += rand() % 8;
+	stats.unitsDied     += rand() % 6;
+	stats.unitsKilled   += rand() % 6;
+	stats.unitsCaptured += ((n % 97) == 0);
+}
+
+
+
+TEST_CASE("TeamStatsHistory")
+{
+	srand(0);
+
+	std::vector<TeamStatistics> snapshots;
+	snapshots.reserve(NUM_SNAPSHOTS);
+
+	TeamStatistics stats;
+
+	for (unsigned int n = 0; n < NUM_SNAPSHOTS; n++) {
+		Advance(stats, n);
+		snapshots.push_back(stats);
+	}
+
+	SECTION("snapshots round-trip exactly") {
+		CTeamStatsHistory history;
+
+		for (const TeamStatistics& s: snapshots) {
+			history.Append(s);
+
+			REQUIRE(Equal(history.Back(), s));
+			REQUIRE(history.GetLastFrame() == s.frame);
+		}
+
+		REQUIRE(history.size() == NUM_SNAPSHOTS);
+
+		for (unsigned int n = 0; n < NUM_SNAPSHOTS; n += 7) {
+			REQUIRE(Equal(history.Get(n), snapshots[n]));
+		}
+
+		unsigned int n = 123;
+
+		history.ForEach(123, 1500, [&](const TeamStatistics& s) { REQUIRE(Equal(s, snapshots[n++])); });
+		REQUIRE(n == 1500);
+
+		printf("[TeamStatsHistory] %u snapshots: %u bytes raw, %u bytes encoded\n", NUM_SNAPSHOTS, unsigned(NUM_SNAPSHOTS * sizeof(TeamStatistics)), unsigned(history.GetNumBytes()));
+
+		CHECK((history.GetNumBytes() * 2) < (NUM_SNAPSHOTS * sizeof(TeamStatistics)));
+	}
+
+	SECTION("bounded history keeps the newest snapshot and exact totals") {
+		static constexpr unsigned int MAX_SIZE = 100;
+
+		CTeamStatsHistory history;
+
+		for (const TeamStatistics& s: snapshots) {
+			history.Append(s, MAX_SIZE);
+
+			REQUIRE(history.size() <= MAX_SIZE);
+			REQUIRE(Equal(history.Back(), s));
+		}
+
+		REQUIRE(history.size() >= (MAX_SIZE / 2));
+
+		// every retained snapshot is one of the originals, in order
+		unsigned int m = 0;
+
+		history.ForEach(0, history.size(), [&](const TeamStatistics& s) {
+			while (m < NUM_SNAPSHOTS && snapshots[m].frame != s.frame)
+				m++;
+
+			REQUIRE(m < NUM_SNAPSHOTS);
+			REQUIRE(Equal(s, snapshots[m]));
+		});
+	}
+
+	SECTION("cleared history starts over") {
+		CTeamStatsHistory history;
+
+		for (unsigned int n = 0; n < 40; n++) {
+			history.Append(snapshots[n]);
+		}
+
+		history.Clear();
+
+		REQUIRE(history.empty());
+		REQUIRE(history.GetLastFrame() == -1);
+
+		history.Append(snapshots[500]);
+
+		REQUIRE(history.size() == 1);
+		REQUIRE(Equal(history.Get(0), snapshots[500]));
+	}
+}
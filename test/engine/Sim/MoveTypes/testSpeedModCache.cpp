@@ -0,0 +1,382 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Sim/MoveTypes/MoveMath/SpeedModCache.h"
+#include "System/type2.h"
+#include "System/TimeProfiler.h"
+#include "System/Misc/SpringTime.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+InitSpringTime ist;
+
+
+static inline float randf() {
+	return rand() / float(RAND_MAX);
+}
+static inline float RandFloat(const float min, const float max) {
+	return min + (max - min) * randf();
+}
+
+
+// stand-in for the half-res map data and the MoveDefs that CMoveMath reads
+struct TestMap {
+	static constexpr unsigned int SIZE_X = 512;
+	static constexpr unsigned int SIZE_Z = 512;
+	static constexpr unsigned int NUM_TYPES = 8;
+
+	std::vector<float> heights;
+	std::vector<float> slopes;
+	std::vector<unsigned char> types;
+
+	std::array<float, NUM_TYPES> typeSpeeds;
+
+	void Init() {
+		heights.resize(SIZE_X * SIZE_Z);
+		slopes.resize(SIZE_X * SIZE_Z);
+		types.resize(SIZE_X * SIZE_Z);
+
+		for (unsigned int i = 0; i < SIZE_X * SIZE_Z; i++) {
+			heights[i] = RandFloat(-100.0f, 400.0f);
+			slopes[i] = RandFloat(0.0f, 1.0f);
+			types[i] = rand() % NUM_TYPES;
+		}
+		for (float& s: typeSpeeds) {
+			s = RandFloat(0.5f, 1.5f);
+		}
+	}
+};
+
+struct TestMoveDef {
+	float maxSlope;
+	float slopeMod;
+	float depth;
+};
+
+
+// mirrors CMoveMath::GroundSpeedMod * TerrainType::tankSpeed
+static float CalcSpeedMod(const TestMap& map, const TestMoveDef& md, unsigned int x, unsigned int z)
+{
+	const unsigned int square = z * TestMap::SIZE_X + x;
+
+	const float height = map.heights[square];
+	const float slope = map.slopes[square];
+
+	if (slope > md.maxSlope)
+		return 0.0f;
+	if (-height > md.depth)
+		return 0.0f;
+
+	float speedMod = 1.0f / (1.0f + slope * md.slopeMod);
+	speedMod *= ((height < 0.0f)? 0.5f: 1.0f);
+	speedMod *= std::max(0.0f, 1.0f - std::min(0.0f, height) * -0.01f);
+
+	return (speedMod * map.typeSpeeds[ map.types[square] ]);
+}
+
+
+
+TEST_CASE("SpeedModCache")
+{
+	srand(0);
+
+	TestMap map;
+	map.Init();
+
+	std::vector<TestMoveDef> moveDefs(8);
+
+	for (TestMoveDef& md: moveDefs) {
+		md.maxSlope = RandFloat(0.3f, 1.0f);
+		md.slopeMod = RandFloat(1.0f, 8.0f);
+		md.depth = RandFloat(0.0f, 50.0f);
+	}
+
+	const auto calcFunc = [&](unsigned int layer, int x, int z) { return (CalcSpeedMod(map, moveDefs[layer], x, z)); };
+
+	CSpeedModCache cache;
+
+	{
+		ScopedOnceTimer timer("SpeedModCache::Init");
+		cache.Init(moveDefs.size(), TestMap::SIZE_X, TestMap::SIZE_Z);
+		cache.Update(0, 0, TestMap::SIZE_X - 1, TestMap::SIZE_Z - 1, calcFunc);
+	}
+
+	SECTION("incremental updates match full recalculation") {
+		// terrain-deformation; change a few random rectangles
+		for (int n = 0; n < 64; n++) {
+			const int x1 = rand() % TestMap::SIZE_X;
+			const int z1 = rand() % TestMap::SIZE_Z;
+			const int x2 = x1 + rand() % 32;
+			const int z2 = z1 + rand() % 32;
+
+			for (int z = z1; z <= std::min(z2, int(TestMap::SIZE_Z) - 1); z++) {
+				for (int x = x1; x <= std::min(x2, int(TestMap::SIZE_X) - 1); x++) {
+					map.heights[z * TestMap::SIZE_X + x] += RandFloat(-20.0f, 20.0f);
+					map.slopes[z * TestMap::SIZE_X + x] = RandFloat(0.0f, 1.0f);
+				}
+			}
+
+			// rectangles may extend past the map edges
+			cache.Update(x1, z1, x2, z2, calcFunc);
+		}
+
+		for (unsigned int layer = 0; layer < moveDefs.size(); layer++) {
+			for (unsigned int z = 0; z < TestMap::SIZE_Z; z++) {
+				for (unsigned int x = 0; x < TestMap::SIZE_X; x++) {
+					REQUIRE(cache.Get(layer, z * TestMap::SIZE_X + x) == CalcSpeedMod(map, moveDefs[layer], x, z));
+				}
+			}
+		}
+	}
+
+	SECTION("lookup benchmark") {
+		static constexpr unsigned int NUM_LOOKUPS = 0xFFFFFF;
+
+		// random access (as in path-searches) and sequential access (as in block-updates)
+		std::vector<unsigned int> squares(NUM_LOOKUPS);
+
+		for (unsigned int& s: squares) {
+			s = rand() % (TestMap::SIZE_X * TestMap::SIZE_Z);
+		}
+
+		std::array<float, 4> hash;
+		hash.fill(0.0f);
+
+		{
+			ScopedOnceTimer timer("SpeedMod::calc (random)");
+			for (unsigned int i = 0; i < NUM_LOOKUPS; i++) {
+				hash[0] += CalcSpeedMod(map, moveDefs[i & 7], squares[i] % TestMap::SIZE_X, squares[i] / TestMap::SIZE_X);
+			}
+		}
+		{
+			ScopedOnceTimer timer("SpeedMod::cache (random)");
+			for (unsigned int i = 0; i < NUM_LOOKUPS; i++) {
+				hash[1] += cache.Get(i & 7, squares[i]);
+			}
+		}
+		{
+			ScopedOnceTimer timer("SpeedMod::calc (sequential)");
+			for (unsigned int i = 0; i < NUM_LOOKUPS; i++) {
+				const unsigned int s = i % (TestMap::SIZE_X * TestMap::SIZE_Z);
+				hash[2] += CalcSpeedMod(map, moveDefs[i >> 18 & 7], s % TestMap::SIZE_X, s / TestMap::SIZE_X);
+			}
+		}
+		{
+			ScopedOnceTimer timer("SpeedMod::cache (sequential)");
+			for (unsigned int i = 0; i < NUM_LOOKUPS; i++) {
+				hash[3] += cache.Get(i >> 18 & 7, i % (TestMap::SIZE_X * TestMap::SIZE_Z));
+			}
+		}
+
+		CHECK(hash[0] == Approx(hash[1]));
+		CHECK(hash[2] == Approx(hash[3]));
+	}
+}
+
+
+
+// stand-in for CGroundBlockingObjectMap's cells and their CELL_BIT_* summary
+struct TestBlockingMap {
+	enum {
+		CELL_BIT_MOBILE   = 1,
+		CELL_BIT_IMMOBILE = 2,
+	};
+	// mirrors CMoveMath::BlockTypes
+	enum {
+		BLOCK_NONE      = 0,
+		BLOCK_MOBILE    = 2,
+		BLOCK_STRUCTURE = 8,
+	};
+
+	struct Object {
+		bool mobile;
+	};
+
+	static constexpr int SIZE_X = 1024;
+	static constexpr int SIZE_Z = 1024;
+
+	std::vector< std::vector<const Object*> > cells;
+	std::vector<uint8_t> cellBlockBits;
+
+	void Init() {
+		cells.clear();
+		cells.resize(SIZE_X * SIZE_Z);
+		cellBlockBits.clear();
+		cellBlockBits.resize(SIZE_X * SIZE_Z, 0);
+	}
+
+	static uint8_t CalcObjectBlockBits(const Object* o) { return ((o->mobile)? CELL_BIT_MOBILE: CELL_BIT_IMMOBILE); }
+
+	// mirror CellInsertUnique, CellErase and UpdateCellBlockBits
+	void CellInsert(int sqr, const Object* o) {
+		if (std::find(cells[sqr].begin(), cells[sqr].end(), o) != cells[sqr].end())
+			return;
+
+		cellBlockBits[sqr] |= CalcObjectBlockBits(o);
+		cells[sqr].push_back(o);
+	}
+	void CellErase(int sqr, const Object* o) {
+		const auto it = std::find(cells[sqr].begin(), cells[sqr].end(), o);
+
+		if (it == cells[sqr].end())
+			return;
+
+		cells[sqr].erase(it);
+
+		uint8_t bits = 0;
+
+		for (const Object* c: cells[sqr]) {
+			bits |= CalcObjectBlockBits(c);
+		}
+
+		cellBlockBits[sqr] = bits;
+	}
+
+	static int ObjectBlockType(const Object* o) { return ((o->mobile)? BLOCK_MOBILE: BLOCK_STRUCTURE); }
+
+	// mirror CMoveMath::SquareIsBlocked, with and without the block-bit skip
+	template<bool useBits> int SquareIsBlocked(int x, int z) const {
+		if (useBits && cellBlockBits[z * SIZE_X + x] == 0)
+			return BLOCK_NONE;
+
+		int r = BLOCK_NONE;
+
+		for (const Object* o: cells[z * SIZE_X + x]) {
+			r |= ObjectBlockType(o);
+		}
+
+		return r;
+	}
+
+	// mirror CMoveMath::IsBlockedNoSpeedModCheck (footprint steps of 2)
+	template<bool useBits> int IsBlocked(int xSquare, int zSquare, int xsizeh, int zsizeh) const {
+		const int xmin = std::max(xSquare - xsizeh,          0);
+		const int zmin = std::max(zSquare - zsizeh,          0);
+		const int xmax = std::min(xSquare + xsizeh, SIZE_X - 1);
+		const int zmax = std::min(zSquare + zsizeh, SIZE_Z - 1);
+
+		int ret = BLOCK_NONE;
+
+		for (int z = zmin; z <= zmax; z += 2) {
+			for (int x = xmin; x <= xmax; x += 2) {
+				if (useBits && cellBlockBits[z * SIZE_X + x] == 0)
+					continue;
+
+				for (const Object* o: cells[z * SIZE_X + x]) {
+					if (((ret |= ObjectBlockType(o)) & BLOCK_STRUCTURE) == 0)
+						continue;
+
+					return ret;
+				}
+			}
+		}
+
+		return ret;
+	}
+};
+
+
+TEST_CASE("MoveMathBlockBits")
+{
+	srand(0);
+
+	// static to keep the cells off the stack
+	static TestBlockingMap map;
+	map.Init();
+
+	// roughly one object per 64 squares, each covering a 2x2..5x5 footprint
+	std::vector<TestBlockingMap::Object> objects((TestBlockingMap::SIZE_X * TestBlockingMap::SIZE_Z) / (64 * 8));
+	std::vector<int2> objectPos(objects.size());
+
+	const auto PlaceObject = [&](size_t i, bool insert) {
+		const int2 p = objectPos[i];
+		const int s = 2 + (i % 4);
+
+		for (int z = p.y; z < std::min(p.y + s, TestBlockingMap::SIZE_Z); z++) {
+			for (int x = p.x; x < std::min(p.x + s, TestBlockingMap::SIZE_X); x++) {
+				if (insert) {
+					map.CellInsert(z * TestBlockingMap::SIZE_X + x, &objects[i]);
+				} else {
+					map.CellErase(z * TestBlockingMap::SIZE_X + x, &objects[i]);
+				}
+			}
+		}
+	};
+
+	for (size_t i = 0; i < objects.size(); i++) {
+		objects[i].mobile = ((i % 3) != 0);
+		objectPos[i] = int2(rand() % TestBlockingMap::SIZE_X, rand() % TestBlockingMap::SIZE_Z);
+
+		PlaceObject(i, true);
+	}
+
+	// move a subset of the objects around as units would
+	for (int n = 0; n < 8; n++) {
+		for (size_t i = n; i < objects.size(); i += 8) {
+			PlaceObject(i, false);
+			objectPos[i] = int2(rand() % TestBlockingMap::SIZE_X, rand() % TestBlockingMap::SIZE_Z);
+			PlaceObject(i, true);
+		}
+	}
+
+	SECTION("block-bits summarize their cells") {
+		for (int sqr = 0; sqr < TestBlockingMap::SIZE_X * TestBlockingMap::SIZE_Z; sqr++) {
+			uint8_t bits = 0;
+
+			for (const TestBlockingMap::Object* o: map.cells[sqr]) {
+				bits |= TestBlockingMap::CalcObjectBlockBits(o);
+			}
+
+			REQUIRE(map.cellBlockBits[sqr] == bits);
+			REQUIRE((map.cellBlockBits[sqr] == 0) == map.cells[sqr].empty());
+		}
+	}
+
+	SECTION("IsBlocked and SquareIsBlocked benchmark") {
+		static constexpr unsigned int NUM_QUERIES = 0x3FFFFF;
+
+		std::vector<int2> squares(NUM_QUERIES);
+
+		for (int2& s: squares) {
+			s = int2(rand() % TestBlockingMap::SIZE_X, rand() % TestBlockingMap::SIZE_Z);
+		}
+
+		std::array<int, 4> hash;
+		hash.fill(0);
+
+		{
+			ScopedOnceTimer timer("MoveMath::SquareIsBlocked (cells)");
+			for (unsigned int i = 0; i < NUM_QUERIES; i++) {
+				hash[0] += map.SquareIsBlocked<false>(squares[i].x, squares[i].y);
+			}
+		}
+		{
+			ScopedOnceTimer timer("MoveMath::SquareIsBlocked (block-bits)");
+			for (unsigned int i = 0; i < NUM_QUERIES; i++) {
+				hash[1] += map.SquareIsBlocked<true>(squares[i].x, squares[i].y);
+			}
+		}
+		{
+			// footprint of a 4x4 MoveDef (xsizeh = zsizeh = 2)
+			ScopedOnceTimer timer("MoveMath::IsBlocked (cells)");
+			for (unsigned int i = 0; i < NUM_QUERIES; i++) {
+				hash[2] += map.IsBlocked<false>(squares[i].x, squares[i].y, 2, 2);
+			}
+		}
+		{
+			ScopedOnceTimer timer("MoveMath::IsBlocked (block-bits)");
+			for (unsigned int i = 0; i < NUM_QUERIES; i++) {
+				hash[3] += map.IsBlocked<true>(squares[i].x, squares[i].y, 2, 2);
+			}
+		}
+
+		CHECK(hash[0] == hash[1]);
+		CHECK(hash[2] == hash[3]);
+	}
+}
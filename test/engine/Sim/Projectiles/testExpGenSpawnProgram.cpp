@@ -0,0 +1,267 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Sim/Projectiles/ExpGenSpawnProgram.h"
+#include "System/TimeProfiler.h"
+#include "System/Misc/SpringTime.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+InitSpringTime ist;
+
+
+typedef CExpGenSpawnProgram P;
+
+struct TestRNG {
+	TestRNG(std::uint32_t seed): state(seed | 1) {}
+
+	float NextFloat() {
+		state ^= (state << 13);
+		state ^= (state >> 17);
+		state ^= (state <<  5);
+		return ((state & 0xFFFFFF) / float(0x1000000));
+	}
+
+	std::uint32_t state;
+};
+
+// stand-in for a spawnable; members are addressed by byte-offset
+struct TestInstance {
+	TestInstance() { std::memset(&bytes[0], 0, sizeof(bytes)); }
+
+	std::array<char, 256> bytes;
+};
+
+
+// the byte-code interpreter that CCustomExplosionGenerator used before
+static void ExecuteExplosionCode(const char* code, float damage, char* instance, int spawnIndex, const float3& dir, TestRNG& rng)
+{
+	float val = 0.0f;
+	float buffer[P::NUM_BUFFER_SLOTS];
+	void* ptr = nullptr;
+
+	std::memset(&buffer[0], 0, sizeof(buffer));
+
+	for (;;) {
+		switch (*(code++)) {
+			case P::OP_END: {
+				return;
+			}
+			case P::OP_STOREI: {
+				std::uint8_t  size   = *(std::uint8_t*)  code; code++;
+				std::uint16_t offset = *(std::uint16_t*) code; code += 2;
+				switch (size) {
+					case 1: { *(std::int8_t*)  (instance + offset) = (int) val; } break;
+					case 2: { *(std::int16_t*) (instance + offset) = (int) val; } break;
+					case 4: { *(std::int32_t*) (instance + offset) = (int) val; } break;
+					case 8: { *(std::int64_t*) (instance + offset) = (int) val; } break;
+					default: { /*no op*/ } break;
+				}
+				val = 0.0f;
+				break;
+			}
+			case P::OP_STOREF: {
+				std::uint8_t  size   = *(std::uint8_t*)  code; code++;
+				std::uint16_t offset = *(std::uint16_t*) code; code += 2;
+				switch (size) {
+					case 4: { *(float*)  (instance + offset) = val; } break;
+					case 8: { *(double*) (instance + offset) = val; } break;
+					default: { /*no op*/ } break;
+				}
+				val = 0.0f;
+				break;
+			}
+			case P::OP_ADD     : { val += *(float*) code; code += 4; } break;
+			case P::OP_RAND    : { val += rng.NextFloat() * (*(float*) code); code += 4; } break;
+			case P::OP_DAMAGE  : { val += damage * (*(float*) code); code += 4; } break;
+			case P::OP_INDEX   : { val += spawnIndex * (*(float*) code); code += 4; } break;
+			case P::OP_LOADP   : { ptr = *(void**) code; code += sizeof(void*); } break;
+			case P::OP_STOREP  : { *(void**) (instance + *(std::uint16_t*) code) = ptr; ptr = nullptr; code += 2; } break;
+			case P::OP_DIR     : { *reinterpret_cast<float3*>(instance + *(std::uint16_t*) code) = dir; code += 2; } break;
+			case P::OP_SAWTOOTH: { val -= (*(float*) code) * math::floor(val / (*(float*) code)); code += 4; } break;
+			case P::OP_DISCRETE: { val = (*(float*) code) * math::floor(spring::SafeDivide(val, (*(float*) code))); code += 4; } break;
+			case P::OP_SINE    : { val = (*(float*) code) * math::sin(val); code += 4; } break;
+			case P::OP_YANK    : { buffer[(*(int*) code)] = val; val = 0; code += 4; } break;
+			case P::OP_MULTIPLY: { val *= buffer[(*(int*) code)]; code += 4; } break;
+			case P::OP_ADDBUFF : { val += buffer[(*(int*) code)]; code += 4; } break;
+			case P::OP_POW     : { val = math::pow(val, (*(float*) code)); code += 4; } break;
+			case P::OP_POWBUFF : { val = math::pow(val, buffer[(*(int*) code)]); code += 4; } break;
+			default: {
+				assert(false);
+			} break;
+		}
+	}
+}
+
+
+// emits byte-code in the format of CCustomExplosionGenerator::ParseExplosionCode
+struct CodeWriter {
+	template<typename T> void Append(char op, T v) {
+		code.append(1, op);
+		code.append((const char*) &v, (const char*) &v + sizeof(v));
+	}
+
+	void Store(bool isFloat, std::uint8_t size, std::uint16_t offset) {
+		code.push_back(isFloat? P::OP_STOREF: P::OP_STOREI);
+		code.push_back(size);
+		code.append((const char*) &offset, (const char*) &offset + sizeof(offset));
+	}
+	void Dir(std::uint16_t offset) {
+		code.append(1, P::OP_DIR);
+		code.append((const char*) &offset, (const char*) &offset + sizeof(offset));
+	}
+	void Ptr(void* ptr, std::uint16_t offset) {
+		Append(P::OP_LOADP, ptr);
+		code.append(1, P::OP_STOREP);
+		code.append((const char*) &offset, (const char*) &offset + sizeof(offset));
+	}
+	void End() { code.push_back(P::OP_END); }
+
+	std::string code;
+};
+
+
+static void RandomMember(CodeWriter& cw, TestRNG& gen, std::uint16_t offset)
+{
+	const unsigned int numTerms = 1 + (gen.state % 6);
+
+	for (unsigned int n = 0; n < numTerms; n++) {
+		gen.NextFloat();
+
+		const float k = (gen.NextFloat() - 0.25f) * 8.0f;
+		const int slot = gen.state % 4;
+
+		// bias towards constant terms, these are what gets folded
+		switch (gen.state % 20) {
+			case  0: { cw.Append<float>(P::OP_RAND, k); } break;
+			case  1: { cw.Append<float>(P::OP_DAMAGE, k); } break;
+			case  2: { cw.Append<float>(P::OP_INDEX, k); } break;
+			case  3: { cw.Append<float>(P::OP_SAWTOOTH, k); } break;
+			case  4: { cw.Append<float>(P::OP_DISCRETE, k); } break;
+			case  5: { cw.Append<float>(P::OP_SINE, k); } break;
+			case  6: { cw.Append<float>(P::OP_POW, 2.0f); } break;
+			case  7: { cw.Append<int>(P::OP_YANK, slot); } break;
+			case  8: { cw.Append<int>(P::OP_MULTIPLY, slot); } break;
+			case  9: { cw.Append<int>(P::OP_ADDBUFF, slot); } break;
+			case 10: { cw.Append<int>(P::OP_POWBUFF, slot); } break;
+			default: { cw.Append<float>(P::OP_ADD, k); } break;
+		}
+	}
+
+	// 8-byte stores spill into the next member, which overwrites them
+	// in the same order in both; invalid sizes must still reset val
+	switch (gen.state % 10) {
+		case 0: { cw.Store(false, 1, offset); } break;
+		case 1: { cw.Store(false, 2, offset); } break;
+		case 2: { cw.Store(false, 4, offset); } break;
+		case 3: { cw.Store(false, 8, offset); } break;
+		case 4: { cw.Store( true, 8, offset); } break;
+		case 5: { cw.Store(false, 3, offset); } break;
+		case 6: { cw.Store( true, 2, offset); } break;
+		default: { cw.Store(true, 4, offset); } break;
+	}
+}
+
+
+
+TEST_CASE("ExpGenSpawnProgram")
+{
+	SECTION("compiled programs match the interpreter") {
+		TestRNG gen(1);
+
+		for (unsigned int n = 0; n < 2000; n++) {
+			CodeWriter cw;
+
+			for (std::uint16_t offset = 0; offset < 128; offset += 4) {
+				if ((gen.state % 7) == 0) {
+					cw.Dir(offset);
+					offset += 8;
+				} else if ((gen.state % 11) == 0) {
+					cw.Ptr(&gen, offset);
+					offset += sizeof(void*) - 4;
+				} else {
+					RandomMember(cw, gen, offset);
+				}
+			}
+
+			cw.End();
+
+			CExpGenSpawnProgram program;
+			program.Compile(cw.code.data());
+
+			for (int spawnIndex = 0; spawnIndex < 4; spawnIndex++) {
+				TestInstance a;
+				TestInstance b;
+				TestRNG rngA(n * 4 + spawnIndex + 1);
+				TestRNG rngB(n * 4 + spawnIndex + 1);
+
+				const float damage = gen.NextFloat() * 100.0f;
+				const float3 dir = {gen.NextFloat(), gen.NextFloat(), gen.NextFloat()};
+
+				ExecuteExplosionCode(cw.code.data(), damage, &a.bytes[0], spawnIndex, dir, rngA);
+				program.Execute(&b.bytes[0], damage, spawnIndex, dir, rngB);
+
+				REQUIRE(std::memcmp(&a.bytes[0], &b.bytes[0], sizeof(a.bytes)) == 0);
+				REQUIRE(rngA.state == rngB.state);
+			}
+		}
+	}
+
+	SECTION("spawn benchmark") {
+		static constexpr unsigned int NUM_INSTANCES = 10000;
+
+		// typical CEG spawn: mostly constants, a few random and index terms
+		// e.g. colormap, texture, dir, "0.3 r0.2", "4 i0.5", "-0.01", ...
+		CodeWriter cw;
+		TestRNG gen(2);
+
+		for (std::uint16_t offset = 0; offset < 96; offset += 4) {
+			switch (offset % 24) {
+				case  0: { cw.Append<float>(P::OP_ADD, 0.3f); cw.Append<float>(P::OP_RAND, 0.2f); } break;
+				case  4: { cw.Append<float>(P::OP_ADD, 4.0f); cw.Append<float>(P::OP_INDEX, 0.5f); } break;
+				case  8: { cw.Append<float>(P::OP_ADD, 0.01f); cw.Append<float>(P::OP_DAMAGE, 0.002f); } break;
+				default: { cw.Append<float>(P::OP_ADD, offset * 0.25f); cw.Append<float>(P::OP_ADD, -1.0f); } break;
+			}
+
+			cw.Store(true, 4, offset);
+		}
+
+		cw.Dir(96);
+		cw.Ptr(&gen, 112);
+		cw.Ptr(&gen, 120);
+		cw.End();
+
+		CExpGenSpawnProgram program;
+		program.Compile(cw.code.data());
+
+		std::vector<TestInstance> instancesA(NUM_INSTANCES);
+		std::vector<TestInstance> instancesB(NUM_INSTANCES);
+
+		TestRNG rngA(3);
+		TestRNG rngB(3);
+
+		{
+			ScopedOnceTimer timer("ExpGen::interpreted (10k spawns)");
+
+			for (unsigned int i = 0; i < NUM_INSTANCES; i++) {
+				ExecuteExplosionCode(cw.code.data(), 50.0f, &instancesA[i].bytes[0], i % 16, UpVector, rngA);
+			}
+		}
+		{
+			ScopedOnceTimer timer("ExpGen::compiled (10k spawns)");
+
+			for (unsigned int i = 0; i < NUM_INSTANCES; i++) {
+				program.Execute(&instancesB[i].bytes[0], 50.0f, i % 16, UpVector, rngB);
+			}
+		}
+
+		for (unsigned int i = 0; i < NUM_INSTANCES; i++) {
+			REQUIRE(std::memcmp(&instancesA[i].bytes[0], &instancesB[i].bytes[0], sizeof(TestInstance)) == 0);
+		}
+	}
+}
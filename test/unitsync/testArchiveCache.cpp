@@ -0,0 +1,218 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+	#include <direct.h>
+#else
+	#include <unistd.h>
+#endif
+
+#include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
+
+namespace us {
+	#include "../tools/unitsync/unitsync_api.h"
+};
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+InitSpringTime ist;
+
+
+// synthetic rapid-like pool of directory archives
+static constexpr int NUM_ARCHIVES = 5000;
+
+
+static bool MakeDir(const std::string& path)
+{
+#ifdef _WIN32
+	return (_mkdir(path.c_str()) == 0);
+#else
+	return (mkdir(path.c_str(), 0755) == 0);
+#endif
+}
+
+// creates a new uniquely named directory, returns "" on failure
+static std::string MakeTempDir()
+{
+#ifdef _WIN32
+	char name[] = "ArchiveCacheXXXXXX";
+
+	if (_mktemp_s(name, sizeof(name)) != 0)
+		return "";
+
+	const char* tmpDir = getenv("TEMP");
+	const std::string path = std::string((tmpDir != nullptr)? tmpDir: ".") + "/" + name;
+
+	return (MakeDir(path)? path: "");
+#else
+	const char* tmpDir = getenv("TMPDIR");
+	std::string path = std::string((tmpDir != nullptr)? tmpDir: "/tmp") + "/ArchiveCacheXXXXXX";
+
+	if (mkdtemp(&path[0]) == nullptr)
+		return "";
+
+	return path;
+#endif
+}
+
+static void RemoveDir(const std::string& path)
+{
+#ifdef _WIN32
+	_rmdir(path.c_str());
+#else
+	rmdir(path.c_str());
+#endif
+}
+
+static bool WriteFile(const std::string& path, const std::string& data)
+{
+	FILE* f = fopen(path.c_str(), "wb");
+
+	if (f == nullptr)
+		return false;
+
+	const size_t n = fwrite(data.data(), 1, data.size(), f);
+	return ((fclose(f) == 0) && (n == data.size()));
+}
+
+static std::string ReadFile(const std::string& path)
+{
+	std::string data;
+	FILE* f = fopen(path.c_str(), "rb");
+
+	if (f == nullptr)
+		return data;
+
+	char buf[4096];
+	for (size_t n = 0; (n = fread(buf, 1, sizeof(buf), f)) > 0; ) {
+		data.append(buf, n);
+	}
+
+	fclose(f);
+	return data;
+}
+
+static void SetEnv(const char* name, const std::string& value)
+{
+#ifdef _WIN32
+	_putenv_s(name, value.c_str());
+#else
+	setenv(name, value.c_str(), 1);
+#endif
+}
+
+
+static std::string CreateDataDir()
+{
+	const std::string dataDir = MakeTempDir();
+	const std::string gamesDir = dataDir + "/games";
+
+	if (dataDir.empty())
+		return "";
+	if (!MakeDir(gamesDir) || !MakeDir(dataDir + "/cache"))
+		return "";
+
+	char name[64];
+	char info[256];
+
+	for (int i = 0; i < NUM_ARCHIVES; i++) {
+		snprintf(name, sizeof(name), "/bench%04d.sdd", i);
+		snprintf(info, sizeof(info), "return {name = 'ArchiveCache Bench', version = '%d', modtype = 1, description = 'synthetic'}\n", i);
+
+		if (!MakeDir(gamesDir + name) || !WriteFile(gamesDir + name + "/modinfo.lua", info))
+			return "";
+	}
+
+	return dataDir;
+}
+
+// best-effort, anything unitsync left in the write-dir besides the cache stays
+static void RemoveDataDir(const std::string& dataDir)
+{
+	const std::string gamesDir = dataDir + "/games";
+
+	char name[64];
+
+	for (int i = 0; i < NUM_ARCHIVES; i++) {
+		snprintf(name, sizeof(name), "/bench%04d.sdd", i);
+
+		std::remove((gamesDir + name + "/modinfo.lua").c_str());
+		RemoveDir(gamesDir + name);
+	}
+
+	std::remove((dataDir + "/cache/ArchiveCache17.bin").c_str());
+
+	RemoveDir(dataDir + "/cache");
+	RemoveDir(gamesDir);
+	RemoveDir(dataDir);
+}
+
+static int ScanArchives(float* millis)
+{
+	const spring_time t0 = spring_gettime();
+
+	int numGames = -1;
+
+	if (us::Init(false, 0) != 0)
+		numGames = us::GetPrimaryModCount();
+
+	*millis = (spring_gettime() - t0).toMilliSecsf();
+
+	us::UnInit();
+	return numGames;
+}
+
+
+TEST_CASE("ArchiveCache")
+{
+	const std::string dataDir = CreateDataDir();
+	const std::string cacheFile = dataDir + "/cache/ArchiveCache17.bin";
+
+	REQUIRE(!dataDir.empty());
+
+	// first dir is the write-dir and thus gets the cache
+	SetEnv("SPRING_WRITEDIR", dataDir);
+
+	float coldTime = 0.0f;
+	float warmTime = 0.0f;
+	float corruptTime = 0.0f;
+
+	// no cache, every archive is opened and its modinfo.lua executed
+	const int coldGames = ScanArchives(&coldTime);
+	const std::string cacheData = ReadFile(cacheFile);
+
+	REQUIRE(coldGames >= NUM_ARCHIVES);
+	REQUIRE(!cacheData.empty());
+
+	// unchanged directories and archives are taken from the cache as-is
+	const int warmGames = ScanArchives(&warmTime);
+
+	CHECK(warmGames == coldGames);
+	CHECK(warmTime < coldTime);
+
+	// a cached info-item renamed to a reserved key must not abort loading
+	// the cache but make it a miss, followed by a full rescan
+	std::string corruptData = cacheData;
+	const size_t keyPos = corruptData.find("modtype");
+
+	REQUIRE(keyPos != std::string::npos);
+	corruptData.replace(keyPos, 7, "replace");
+	REQUIRE(WriteFile(cacheFile, corruptData));
+
+	const int corruptGames = ScanArchives(&corruptTime);
+
+	CHECK(corruptGames == coldGames);
+
+	LOG("[%s] %d archives: cold scan %.1fms, cached scan %.1fms, corrupt cache %.1fms", __func__, NUM_ARCHIVES, coldTime, warmTime, corruptTime);
+
+	RemoveDataDir(dataDir);
+}